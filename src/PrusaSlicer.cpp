@@ -494,6 +494,12 @@ int CLI::run(int argc, char **argv)
                 else
                     try {
                         std::string outfile_final;
+                        if (printer_technology == ptSLA)
+                            // Zip the layers as they are rasterized instead of keeping them in memory until the export.
+                            sla_archive.start_streaming_export([&sla_print, &outfile]() {
+                                // We need to finalize the filename beforehand because the export function sets the filename inside the zip metadata
+                                return sla_print.print_statistics().finalize_output_path(sla_print.output_filepath(outfile));
+                            });
                         print->process();
                         if (printer_technology == ptFFF) {
                             // The outfile is processed by a PlaceholderParser.
@@ -505,9 +511,7 @@ int CLI::run(int argc, char **argv)
                             outfile_final = fff_print.print_statistics().finalize_output_path(outfile);
                         } else {
                             outfile = sla_print.output_filepath(outfile);
-                            // We need to finalize the filename beforehand because the export function sets the filename inside the zip metadata
-                            outfile_final = sla_print.print_statistics().finalize_output_path(outfile);
-                            sla_archive.export_print(outfile_final, sla_print);
+                            outfile_final = sla_archive.finish_streaming_export(sla_print);
                         }
                         if (outfile != outfile_final && Slic3r::rename_file(outfile, outfile_final)) {
                             boost::nowide::cerr << "Renaming file " << outfile << " to " << outfile_final << " failed" << std::endl;
@@ -80,25 +80,6 @@ static int const Skip = -2;        //edge that would otherwise close a path
 #define TOLERANCE (1.0e-20)
 #define NEAR_ZERO(val) (((val) > -TOLERANCE) && ((val) < TOLERANCE))
 
-// Output polygon.
-struct OutRec {
-  int       Idx;
-  bool      IsHole;
-  bool      IsOpen;
-  //The 'FirstLeft' field points to another OutRec that contains or is the
-  //'parent' of OutRec. It is 'first left' because the ActiveEdgeList (AEL) is
-  //parsed left from the current edge (owning OutRec) until the owner OutRec
-  //is found. This field simplifies sorting the polygons into a tree structure
-  //which reflects the parent/child relationships of all polygons.
-  //This field should be renamed Parent, and will be later.
-  OutRec   *FirstLeft;
-  // Used only by void Clipper::BuildResult2(PolyTree& polytree)
-  PolyNode *PolyNd;
-  // Linked list of output points, dynamically allocated.
-  OutPt    *Pts;
-  OutPt    *BottomPt;
-};
-
 //------------------------------------------------------------------------------
 
 inline cInt Round(double val)
@@ -722,27 +703,71 @@ TEdge* ClipperBase::ProcessBound(TEdge* E, bool NextIsForward)
 }
 //------------------------------------------------------------------------------
 
+// Smallest block of edges allocated by EdgeArena.
+static constexpr size_t EdgeArenaBlockSizeMin    = 256;
+// Number of edges kept by EdgeArena::Clear() for the next operation.
+static constexpr size_t EdgeArenaRetainedSizeMax = 16384;
+// Capacity of the working vectors (local minima, joins, intersections, ...) kept by Clipper::Clear() for the next operation.
+static constexpr size_t ClipperVectorRetainedMax = 16384;
+
+// Clear a working vector of an engine reused for many operations, release its memory if it grew above max_retained items,
+// so that a single large operation does not pin its memory for the lifetime of the engine.
+template<typename T>
+static inline void release_large_buffer(std::vector<T> &buffer, size_t max_retained)
+{
+  if (buffer.capacity() > max_retained)
+    std::vector<T>().swap(buffer);
+  else
+    buffer.clear();
+}
+
+TEdge* EdgeArena::Allocate(size_t num_edges)
+{
+  // Find a large enough block between the retained blocks.
+  while (m_current < m_blocks.size() && m_blocks[m_current].size - m_used < num_edges) {
+    ++ m_current;
+    m_used = 0;
+  }
+  if (m_current == m_blocks.size()) {
+    // Allocate a new block.
+    size_t size = std::max(num_edges, EdgeArenaBlockSizeMin);
+    m_blocks.push_back({ std::unique_ptr<TEdge[]>(new TEdge[size]), size });
+    m_used = 0;
+  }
+  TEdge *edges = m_blocks[m_current].edges.get() + m_used;
+  m_used += num_edges;
+  return edges;
+}
+
+void EdgeArena::Clear()
+{
+  // Keep the first blocks up to EdgeArenaRetainedSizeMax edges, release the rest.
+  size_t num_retained = 0;
+  size_t size_retained = 0;
+  for (; num_retained < m_blocks.size() && size_retained + m_blocks[num_retained].size <= EdgeArenaRetainedSizeMax; ++ num_retained)
+    size_retained += m_blocks[num_retained].size;
+  m_blocks.erase(m_blocks.begin() + num_retained, m_blocks.end());
+  m_current = 0;
+  m_used    = 0;
+}
+//------------------------------------------------------------------------------
+
 bool ClipperBase::AddPath(const Path &pg, PolyType PolyTyp, bool Closed)
 {
   CLIPPERLIB_PROFILE_FUNC();
-  // Remove duplicate end point from a closed input path.
-  // Remove duplicate points from the end of the input path.
-  int highI = (int)pg.size() -1;
-  if (Closed) 
-    while (highI > 0 && (pg[highI] == pg[0])) 
-      --highI;
-  while (highI > 0 && (pg[highI] == pg[highI -1])) 
-    --highI;
-  if ((Closed && highI < 2) || (!Closed && highI < 1))
+  int highI = PathHighIndex(pg.begin(), pg.end(), Closed);
+  if (highI < 0)
     return false;
 
   // Allocate a new edge array.
-  std::vector<TEdge> edges(highI + 1);
+  TEdge *edges = m_edges.Allocate(highI + 1);
+  for (int i = 0; i <= highI; ++ i)
+    edges[i].Curr = pg[i];
   // Fill in the edge array.
-  bool result = AddPathInternal(pg, highI, PolyTyp, Closed, edges.data());
-  if (result)
-    // Success, remember the edge array.
-    m_edges.emplace_back(std::move(edges));
+  bool result = AddPathInternal(highI, PolyTyp, Closed, edges);
+  if (! result)
+    // Failure, return the edge array.
+    m_edges.ReleaseLast(highI + 1);
   return result;
 }
 
@@ -752,17 +777,7 @@ bool ClipperBase::AddPaths(const Paths &ppg, PolyType PolyTyp, bool Closed)
   std::vector<int> num_edges(ppg.size(), 0);
   int num_edges_total = 0;
   for (size_t i = 0; i < ppg.size(); ++ i) {
-    const Path &pg = ppg[i];
-    // Remove duplicate end point from a closed input path.
-    // Remove duplicate points from the end of the input path.
-    int highI = (int)pg.size() -1;
-    if (Closed) 
-      while (highI > 0 && (pg[highI] == pg[0])) 
-        --highI;
-    while (highI > 0 && (pg[highI] == pg[highI -1])) 
-      --highI;
-    if ((Closed && highI < 2) || (!Closed && highI < 1))
-      highI = -1;
+    int highI = PathHighIndex(ppg[i].begin(), ppg[i].end(), Closed);
     num_edges[i] = highI + 1;
     num_edges_total += highI + 1;
   }
@@ -770,25 +785,26 @@ bool ClipperBase::AddPaths(const Paths &ppg, PolyType PolyTyp, bool Closed)
     return false;
 
   // Allocate a new edge array.
-  std::vector<TEdge> edges(num_edges_total);
+  TEdge *edges = m_edges.Allocate(num_edges_total);
   // Fill in the edge array.
   bool result = false;
-  TEdge *p_edge = edges.data();
+  TEdge *p_edge = edges;
   for (Paths::size_type i = 0; i < ppg.size(); ++i)
     if (num_edges[i]) {
-      bool res = AddPathInternal(ppg[i], num_edges[i] - 1, PolyTyp, Closed, p_edge);
+      for (int j = 0; j < num_edges[i]; ++ j)
+        p_edge[j].Curr = ppg[i][j];
+      bool res = AddPathInternal(num_edges[i] - 1, PolyTyp, Closed, p_edge);
       if (res) {
         p_edge += num_edges[i];
         result = true;
       }
     }
-  if (result)
-    // At least some edges were generated. Remember the edge array.
-    m_edges.emplace_back(std::move(edges));
+  // Return the edges of the paths, which were not added.
+  m_edges.ReleaseLast(edges + num_edges_total - p_edge);
   return result;
 }
 
-bool ClipperBase::AddPathInternal(const Path &pg, int highI, PolyType PolyTyp, bool Closed, TEdge* edges)
+bool ClipperBase::AddPathInternal(int highI, PolyType PolyTyp, bool Closed, TEdge* edges)
 {
   CLIPPERLIB_PROFILE_FUNC();
 #ifdef use_lines
@@ -799,20 +815,17 @@ bool ClipperBase::AddPathInternal(const Path &pg, int highI, PolyType PolyTyp, b
     throw clipperException("AddPath: Open paths have been disabled.");
 #endif
 
-  assert(highI >= 0 && highI < pg.size());
+  assert(highI >= 1);
 
   //1. Basic (first) edge initialization ...
+  // The Curr points were filled in by the caller, InitEdge() clears the edge, thus the point is copied first.
   try
   {
-    edges[1].Curr = pg[1];
-    RangeTest(pg[0], m_UseFullRange);
-    RangeTest(pg[highI], m_UseFullRange);
-    InitEdge(&edges[0], &edges[1], &edges[highI], pg[0]);
-    InitEdge(&edges[highI], &edges[0], &edges[highI-1], pg[highI]);
-    for (int i = highI - 1; i >= 1; --i)
+    for (int i = 0; i <= highI; ++ i)
     {
-      RangeTest(pg[i], m_UseFullRange);
-      InitEdge(&edges[i], &edges[i+1], &edges[i-1], pg[i]);
+      IntPoint pt = edges[i].Curr;
+      RangeTest(pt, m_UseFullRange);
+      InitEdge(&edges[i], &edges[i == highI ? 0 : i + 1], &edges[i == 0 ? highI : i - 1], pt);
     }
   }
   catch(...)
@@ -965,8 +978,8 @@ bool ClipperBase::AddPathInternal(const Path &pg, int highI, PolyType PolyTyp, b
 void ClipperBase::Clear()
 {
   CLIPPERLIB_PROFILE_FUNC();
-  m_MinimaList.clear();
-  m_edges.clear();
+  release_large_buffer(m_MinimaList, ClipperVectorRetainedMax);
+  m_edges.Clear();
   m_UseFullRange = false;
   m_HasOpenPaths = false;
 }
@@ -1049,8 +1062,6 @@ IntRect ClipperBase::GetBounds()
 Clipper::Clipper(int initOptions) : 
   ClipperBase(),
   m_OutPtsFree(nullptr),
-  m_OutPtsChunkSize(32),
-  m_OutPtsChunkLast(32),
   m_ActiveEdges(nullptr),
   m_SortedEdges(nullptr)
 {
@@ -1068,7 +1079,7 @@ void Clipper::Reset()
 {
   CLIPPERLIB_PROFILE_FUNC();
   ClipperBase::Reset();
-  m_Scanbeam = std::priority_queue<cInt>();
+  m_Scanbeam.clear();
   m_Maxima.clear();
   m_ActiveEdges = 0;
   m_SortedEdges = 0;
@@ -1078,18 +1089,24 @@ void Clipper::Reset()
 
 //------------------------------------------------------------------------------
 
-bool Clipper::Execute(ClipType clipType, Paths &solution,
-    PolyFillType subjFillType, PolyFillType clipFillType)
+bool Clipper::ExecutePaths(ClipType clipType, PolyFillType subjFillType, PolyFillType clipFillType)
 {
-  CLIPPERLIB_PROFILE_FUNC();
   if (m_HasOpenPaths)
     throw clipperException("Error: PolyTree struct is needed for open path clipping.");
-  solution.resize(0);
   m_SubjFillType = subjFillType;
   m_ClipFillType = clipFillType;
   m_ClipType = clipType;
   m_UsingPolyTree = false;
-  bool succeeded = ExecuteInternal();
+  return ExecuteInternal();
+}
+//------------------------------------------------------------------------------
+
+bool Clipper::Execute(ClipType clipType, Paths &solution,
+    PolyFillType subjFillType, PolyFillType clipFillType)
+{
+  CLIPPERLIB_PROFILE_FUNC();
+  solution.resize(0);
+  bool succeeded = ExecutePaths(clipType, subjFillType, clipFillType);
   if (succeeded) BuildResult(solution);
   DisposeAllOutRecs();
   return succeeded;
@@ -1188,27 +1205,30 @@ OutPt* Clipper::AllocateOutPt()
     // Recycle some of the already released points.
     pt = m_OutPtsFree;
     m_OutPtsFree = pt->Next;
-  } else if (m_OutPtsChunkLast < m_OutPtsChunkSize) {
-    // Get a point from the last chunk.
-    pt = m_OutPts.back() + (m_OutPtsChunkLast ++);
-  } else {
-    // The last chunk is full. Allocate a new one.
-    m_OutPts.push_back(new OutPt[m_OutPtsChunkSize]);
-    m_OutPtsChunkLast = 1;
-    pt = m_OutPts.back();
-  }
+  } else
+    pt = m_OutPtsPool.Allocate();
   return pt;
 }
 
+void Clipper::Clear()
+{
+  ClipperBase::Clear();
+  DisposeAllOutRecs();
+  release_large_buffer(m_PolyOuts, ClipperVectorRetainedMax);
+  release_large_buffer(m_Joins, ClipperVectorRetainedMax);
+  release_large_buffer(m_GhostJoins, ClipperVectorRetainedMax);
+  release_large_buffer(m_IntersectList, ClipperVectorRetainedMax);
+  release_large_buffer(m_Maxima, ClipperVectorRetainedMax);
+  m_Scanbeam.clear(ClipperVectorRetainedMax);
+}
+//------------------------------------------------------------------------------
+
 void Clipper::DisposeAllOutRecs()
 {
-  for (OutPt *pts : m_OutPts)
-    delete[] pts;
-  for (OutRec *rec : m_PolyOuts)
-    delete rec;
-  m_OutPts.clear();
+  // The output points and polygons are recycled by the next operation.
+  m_OutPtsPool.Clear();
+  m_OutRecsPool.Clear();
   m_OutPtsFree = nullptr;
-  m_OutPtsChunkLast = m_OutPtsChunkSize;
   m_PolyOuts.clear();
 }
 //------------------------------------------------------------------------------
@@ -1989,7 +2009,7 @@ void Clipper::AppendPolygon(TEdge *e1, TEdge *e2) const
 
 OutRec* Clipper::CreateOutRec()
 {
-  OutRec* result = new OutRec;
+  OutRec* result = m_OutRecsPool.Allocate();
   result->IsHole = false;
   result->IsOpen = false;
   result->FirstLeft = 0;
@@ -3334,11 +3354,26 @@ DoublePoint GetUnitNormal(const IntPoint &pt1, const IntPoint &pt2)
 // ClipperOffset class
 //------------------------------------------------------------------------------
 
+// Number of the PolyNodes kept by ClipperOffset::Clear() for the next operation.
+static constexpr size_t ClipperOffsetPolyNodesRetainedMax = 1024;
+// Capacity (number of points) of a contour or of a working path kept by ClipperOffset::Clear() for the next operation.
+static constexpr size_t ClipperOffsetPathRetainedMax      = 4096;
+
 void ClipperOffset::Clear()
 {
-  for (int i = 0; i < m_polyNodes.ChildCount(); ++i)
-    delete m_polyNodes.Childs[i];
+  // The nodes are owned by m_polyNodesPool and recycled by the subsequent AddPath() calls.
+  // Only the nodes used since the last Clear() may have grown their contours.
   m_polyNodes.Childs.clear();
+  for (size_t i = 0; i < std::min(m_polyNodesUsed, ClipperOffsetPolyNodesRetainedMax); ++ i)
+    release_large_buffer(m_polyNodesPool[i].Contour, ClipperOffsetPathRetainedMax);
+  if (m_polyNodesPool.size() > ClipperOffsetPolyNodesRetainedMax)
+    m_polyNodesPool.resize(ClipperOffsetPolyNodesRetainedMax);
+  m_polyNodesUsed = 0;
+  // A single large offset shall not pin its working memory for the lifetime of the thread.
+  m_destPolys.clear();
+  release_large_buffer(m_srcPoly, ClipperOffsetPathRetainedMax);
+  release_large_buffer(m_destPoly, ClipperOffsetPathRetainedMax);
+  release_large_buffer(m_normals, ClipperOffsetPathRetainedMax);
   m_lowest.X = -1;
 }
 //------------------------------------------------------------------------------
@@ -3347,7 +3382,15 @@ void ClipperOffset::AddPath(const Path& path, JoinType joinType, EndType endType
 {
   int highI = (int)path.size() - 1;
   if (highI < 0) return;
-  PolyNode* newNode = new PolyNode();
+  // Take a node from the pool. It is only kept by the pool if the path is accepted.
+  if (m_polyNodesUsed == m_polyNodesPool.size())
+    m_polyNodesPool.emplace_back();
+  PolyNode* newNode = &m_polyNodesPool[m_polyNodesUsed];
+  newNode->Contour.clear();
+  newNode->Childs.clear();
+  newNode->Parent = nullptr;
+  newNode->Index = 0;
+  newNode->m_IsOpen = false;
   newNode->m_jointype = joinType;
   newNode->m_endtype = endType;
 
@@ -3386,10 +3429,8 @@ void ClipperOffset::AddPath(const Path& path, JoinType joinType, EndType endType
       path[i].X < newNode->Contour[k].X)) k = j;
   }
   if (endType == etClosedPolygon && j < 2)
-  {
-    delete newNode;
     return;
-  }
+  ++ m_polyNodesUsed;
   m_polyNodes.AddChild(*newNode);
 
   //if this path's lowest pt is lower than all the others then update m_lowest
@@ -3447,7 +3488,9 @@ void ClipperOffset::Execute(Paths& solution, double delta)
   DoOffset(delta);
   
   //now clean up 'corners' ...
-  Clipper clpr;
+  Clipper &clpr = m_clipper;
+  clpr.Clear();
+  clpr.ReverseSolution(false);
   clpr.AddPaths(m_destPolys, ptSubject, true);
   if (delta > 0)
   {
@@ -3477,7 +3520,9 @@ void ClipperOffset::Execute(PolyTree& solution, double delta)
   DoOffset(delta);
 
   //now clean up 'corners' ...
-  Clipper clpr;
+  Clipper &clpr = m_clipper;
+  clpr.Clear();
+  clpr.ReverseSolution(false);
   clpr.AddPaths(m_destPolys, ptSubject, true);
   if (delta > 0)
   {
@@ -56,6 +56,10 @@
 #include <ostream>
 #include <functional>
 #include <queue>
+#include <cassert>
+#include <iterator>
+#include <memory>
+#include <algorithm>
 
 #ifdef use_xyz
 namespace ClipperLib_Z {
@@ -271,7 +275,56 @@ enum EdgeSide { esLeft = 1, esRight = 2};
     OutPt    *Prev;
   };
 
-  struct OutRec;
+  // Output polygon.
+  struct OutRec {
+    int       Idx;
+    bool      IsHole;
+    bool      IsOpen;
+    //The 'FirstLeft' field points to another OutRec that contains or is the
+    //'parent' of OutRec. It is 'first left' because the ActiveEdgeList (AEL) is
+    //parsed left from the current edge (owning OutRec) until the owner OutRec
+    //is found. This field simplifies sorting the polygons into a tree structure
+    //which reflects the parent/child relationships of all polygons.
+    //This field should be renamed Parent, and will be later.
+    OutRec   *FirstLeft;
+    // Used only by void Clipper::BuildResult2(PolyTree& polytree)
+    PolyNode *PolyNd;
+    // Linked list of output points, dynamically allocated.
+    OutPt    *Pts;
+    OutPt    *BottomPt;
+  };
+
+  // Read only view of the points of an output polygon, in the order they are stored into ClipperLib::Path by Clipper::Execute().
+  // Passed to the callback of Clipper::ExecuteAndEmit().
+  class OutPtRange {
+  public:
+    class const_iterator {
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type        = IntPoint;
+      using difference_type   = std::ptrdiff_t;
+      using pointer           = const IntPoint*;
+      using reference         = const IntPoint&;
+      const_iterator(const OutPt *pt, int idx) : m_pt(pt), m_idx(idx) {}
+      reference       operator*()  const { return m_pt->Pt; }
+      pointer         operator->() const { return &m_pt->Pt; }
+      const_iterator& operator++() { m_pt = m_pt->Prev; ++ m_idx; return *this; }
+      const_iterator  operator++(int) { const_iterator out(*this); ++ (*this); return out; }
+      bool            operator==(const const_iterator &rhs) const { return m_idx == rhs.m_idx; }
+      bool            operator!=(const const_iterator &rhs) const { return m_idx != rhs.m_idx; }
+    private:
+      const OutPt *m_pt;
+      int          m_idx;
+    };
+    OutPtRange(const OutPt *first, int cnt) : m_first(first), m_cnt(cnt) {}
+    const_iterator begin() const { return const_iterator(m_first, 0); }
+    const_iterator end()   const { return const_iterator(m_first, m_cnt); }
+    size_t         size()  const { return size_t(m_cnt); }
+  private:
+    const OutPt *m_first;
+    int          m_cnt;
+  };
+
   struct Join {
     Join(OutPt *OutPt1, OutPt *OutPt2, IntPoint OffPt) :
       OutPt1(OutPt1), OutPt2(OutPt2), OffPt(OffPt) {}
@@ -283,6 +336,76 @@ enum EdgeSide { esLeft = 1, esRight = 2};
 
 //------------------------------------------------------------------------------
 
+// Bump allocator of the edges of the input paths.
+// Clear() rewinds the allocator keeping the blocks up to a size limit, so that a Clipper object reused
+// for many operations (see Slic3r::ClipperUtils) recycles the memory instead of going to the heap allocator.
+class EdgeArena
+{
+public:
+  // Allocate a continuous array of edges, the edges are not initialized.
+  TEdge* Allocate(size_t num_edges);
+  // Return the edges of the last Allocate() call to the arena.
+  void   ReleaseLast(size_t num_edges) { assert(m_used >= num_edges); m_used -= num_edges; }
+  void   Clear();
+private:
+  struct Block {
+    std::unique_ptr<TEdge[]> edges;
+    size_t                   size;
+  };
+  std::vector<Block> m_blocks;
+  // Index of the block being filled.
+  size_t             m_current { 0 };
+  // Number of edges taken from the block being filled.
+  size_t             m_used    { 0 };
+};
+
+// Pool of fixed size items (output points, output polygons) allocated in chunks.
+// Clear() rewinds the pool keeping up to MaxChunksRetained chunks for reuse.
+template<typename T, size_t ChunkSize, size_t MaxChunksRetained>
+class ChunkedPool
+{
+public:
+  T* Allocate() {
+    if (m_last == ChunkSize) {
+      // The current chunk is full, continue with the next one.
+      if (++ m_current == m_chunks.size())
+        m_chunks.emplace_back(new T[ChunkSize]);
+      m_last = 0;
+    }
+    return m_chunks[m_current].get() + (m_last ++);
+  }
+  void Clear() {
+    if (m_chunks.size() > MaxChunksRetained)
+      m_chunks.resize(MaxChunksRetained);
+    m_current = size_t(-1);
+    m_last    = ChunkSize;
+  }
+private:
+  std::vector<std::unique_ptr<T[]>> m_chunks;
+  // Index of the chunk being filled, size_t(-1) if none.
+  size_t                            m_current { size_t(-1) };
+  // Number of items taken from the chunk being filled.
+  size_t                            m_last    { ChunkSize };
+};
+
+// A binary max heap of Y coordinates (the same ordering as std::priority_queue<cInt>),
+// which keeps its memory when cleared.
+class Scanbeam
+{
+public:
+  void push(cInt y) { m_heap.emplace_back(y); std::push_heap(m_heap.begin(), m_heap.end()); }
+  void pop() { std::pop_heap(m_heap.begin(), m_heap.end()); m_heap.pop_back(); }
+  cInt top() const { return m_heap.front(); }
+  bool empty() const { return m_heap.empty(); }
+  void clear() { m_heap.clear(); }
+  // Clear, release the memory if the heap grew above max_retained items.
+  void clear(size_t max_retained) { if (m_heap.capacity() > max_retained) std::vector<cInt>().swap(m_heap); else m_heap.clear(); }
+private:
+  std::vector<cInt> m_heap;
+};
+
+//------------------------------------------------------------------------------
+
 //ClipperBase is the ancestor to the Clipper class. It should not be
 //instantiated directly. This class simply abstracts the conversion of sets of
 //polygon coordinates into edge objects that are stored in a LocalMinima list.
@@ -293,6 +416,63 @@ public:
   ~ClipperBase() { Clear(); }
   bool AddPath(const Path &pg, PolyType PolyTyp, bool Closed);
   bool AddPaths(const Paths &ppg, PolyType PolyTyp, bool Closed);
+  // Add a path given by a random access range of points providing x() and y() accessors (for example Slic3r::Points).
+  // The edges are initialized directly from the points, the path is not converted to ClipperLib::Path first.
+  template<typename PointIterator>
+  bool AddPath(PointIterator begin, PointIterator end, PolyType PolyTyp, bool Closed)
+  {
+    int highI = PathHighIndex(begin, end, Closed);
+    if (highI < 0)
+      return false;
+    // Allocate a new edge array.
+    TEdge *edges = m_edges.Allocate(highI + 1);
+    for (int i = 0; i <= highI; ++ i)
+      edges[i].Curr = IntPoint(begin[i].x(), begin[i].y());
+    // Fill in the edge array.
+    bool result = AddPathInternal(highI, PolyTyp, Closed, edges);
+    if (! result)
+      // Failure, return the edge array.
+      m_edges.ReleaseLast(highI + 1);
+    return result;
+  }
+  // Add paths given by a range of ranges of points providing x() and y() accessors,
+  // for example Slic3r::Polygons wrapped by Slic3r::ClipperUtils::PolygonsProvider.
+  // All the edges are allocated at once, the paths are not converted to ClipperLib::Paths first.
+  template<typename PathsProvider>
+  bool AddPaths(const PathsProvider &paths_provider, PolyType PolyTyp, bool Closed)
+  {
+    std::vector<int> num_edges;
+    int num_edges_total = 0;
+    for (const auto &path : paths_provider) {
+      int highI = PathHighIndex(path.begin(), path.end(), Closed);
+      num_edges.emplace_back(highI + 1);
+      num_edges_total += highI + 1;
+    }
+    if (num_edges_total == 0)
+      return false;
+
+    // Allocate a new edge array.
+    TEdge *edges = m_edges.Allocate(num_edges_total);
+    // Fill in the edge array.
+    bool result = false;
+    TEdge *p_edge = edges;
+    size_t i = 0;
+    for (const auto &path : paths_provider) {
+      int cnt = num_edges[i ++];
+      if (cnt) {
+        auto it = path.begin();
+        for (int j = 0; j < cnt; ++ j, ++ it)
+          p_edge[j].Curr = IntPoint(it->x(), it->y());
+        if (AddPathInternal(cnt - 1, PolyTyp, Closed, p_edge)) {
+          p_edge += cnt;
+          result = true;
+        }
+      }
+    }
+    // Return the edges of the paths, which were not added.
+    m_edges.ReleaseLast(edges + num_edges_total - p_edge);
+    return result;
+  }
   void Clear();
   IntRect GetBounds();
   // By default, when three or more vertices are collinear in input polygons (subject or clip), the Clipper object removes the 'inner' vertices before clipping.
@@ -300,7 +480,21 @@ public:
   bool PreserveCollinear() const {return m_PreserveCollinear;};
   void PreserveCollinear(bool value) {m_PreserveCollinear = value;};
 protected:
-  bool AddPathInternal(const Path &pg, int highI, PolyType PolyTyp, bool Closed, TEdge* edges);
+  // Remove duplicate end point from a closed input path, remove duplicate points from the end of the input path.
+  // Returns index of the last point to be added or -1 if the path is degenerate.
+  template<typename PointIterator>
+  static int PathHighIndex(PointIterator begin, PointIterator end, bool Closed)
+  {
+    int highI = int(end - begin) - 1;
+    if (Closed) 
+      while (highI > 0 && (begin[highI] == begin[0])) 
+        --highI;
+    while (highI > 0 && (begin[highI] == begin[highI -1])) 
+      --highI;
+    return ((Closed && highI < 2) || (!Closed && highI < 1)) ? -1 : highI;
+  }
+  // Initialize the edges[0] to edges[highI] of a single path, their Curr points being already filled in.
+  bool AddPathInternal(int highI, PolyType PolyTyp, bool Closed, TEdge* edges);
   TEdge* AddBoundsToLML(TEdge *e, bool IsClosed);
   void Reset();
   TEdge* ProcessBound(TEdge* E, bool IsClockwise);
@@ -313,8 +507,8 @@ protected:
   // True if the input polygons have abs values higher than loRange, but lower than hiRange.
   // False if the input polygons have abs values lower or equal to loRange.
   bool              m_UseFullRange;
-  // A vector of edges per each input path.
-  std::vector<std::vector<TEdge>> m_edges;
+  // Edges of all the input paths.
+  EdgeArena         m_edges;
   // Don't remove intermediate vertices of a collinear sequence of points.
   bool             m_PreserveCollinear;
   // Is any of the paths inserted by AddPath() or AddPaths() open?
@@ -327,7 +521,7 @@ class Clipper : public ClipperBase
 public:
   Clipper(int initOptions = 0);
   ~Clipper() { Clear(); }
-  void Clear() { ClipperBase::Clear(); DisposeAllOutRecs(); }
+  void Clear();
   bool Execute(ClipType clipType,
       Paths &solution,
       PolyFillType fillType = pftEvenOdd) 
@@ -344,6 +538,31 @@ public:
       PolyTree &polytree,
       PolyFillType subjFillType,
       PolyFillType clipFillType);
+  // Same as Execute() into Paths, but each output polygon is passed to emit(const OutPtRange&) instead,
+  // so that the caller may store it directly into its own containers (for example Slic3r::Polygons).
+  template<typename EmitFn>
+  bool ExecuteAndEmit(ClipType clipType,
+      EmitFn &&emit,
+      PolyFillType subjFillType,
+      PolyFillType clipFillType)
+  {
+    bool succeeded = ExecutePaths(clipType, subjFillType, clipFillType);
+    if (succeeded)
+      for (const OutRec *outRec : m_PolyOuts) {
+        assert(! outRec->IsOpen);
+        if (! outRec->Pts) continue;
+        int cnt = 0;
+        const OutPt *p = outRec->Pts;
+        do {
+          ++ cnt;
+          p = p->Next;
+        } while (p != outRec->Pts);
+        if (cnt >= 2)
+          emit(OutPtRange(outRec->Pts->Prev, cnt));
+      }
+    DisposeAllOutRecs();
+    return succeeded;
+  }
   bool ReverseSolution() const { return m_ReverseOutput; };
   void ReverseSolution(bool value) {m_ReverseOutput = value;};
   bool StrictlySimple() const {return m_StrictSimple;};
@@ -355,23 +574,25 @@ public:
 protected:
   void Reset();
   virtual bool ExecuteInternal();
+  // Set up and run the clipping operation for output into Paths, leaving the result in m_PolyOuts.
+  bool ExecutePaths(ClipType clipType, PolyFillType subjFillType, PolyFillType clipFillType);
 private:
   
   // Output polygons.
   std::vector<OutRec*>  m_PolyOuts;
-  // Output points, allocated by a continuous sets of m_OutPtsChunkSize.
-  std::vector<OutPt*>   m_OutPts;
-  // List of free output points, to be used before taking a point from m_OutPts or allocating a new chunk.
+  // Output polygons are allocated from m_OutRecsPool.
+  ChunkedPool<OutRec, 32, 64> m_OutRecsPool;
+  // Output points, allocated by chunks.
+  ChunkedPool<OutPt, 256, 64> m_OutPtsPool;
+  // List of free output points, to be used before taking a point from m_OutPtsPool.
   OutPt                *m_OutPtsFree;
-  size_t                m_OutPtsChunkSize;
-  size_t                m_OutPtsChunkLast;
 
   std::vector<Join>     m_Joins;
   std::vector<Join>     m_GhostJoins;
   std::vector<IntersectNode> m_IntersectList;
   ClipType              m_ClipType;
   // A priority queue (a binary heap) of Y coordinates.
-  std::priority_queue<cInt> m_Scanbeam;
+  Scanbeam              m_Scanbeam;
   // Maxima are collected by ProcessEdgesAtTopOfScanbeam(), consumed by ProcessHorizontal().
   std::vector<cInt>     m_Maxima;
   TEdge                *m_ActiveEdges;
@@ -464,6 +685,11 @@ private:
   double m_miterLim, m_StepsPerRad;
   IntPoint m_lowest;
   PolyNode m_polyNodes;
+  // Storage of the children of m_polyNodes. The nodes are reused after Clear() together with the memory of their contours.
+  std::deque<PolyNode> m_polyNodesPool;
+  size_t   m_polyNodesUsed { 0 };
+  // Clipper for cleaning up the offsetted polygons, reused by the subsequent Execute() calls.
+  Clipper  m_clipper;
 
   void FixOrientations();
   void DoOffset(double delta);
@@ -7,10 +7,16 @@
 #define slic3r_AABBTreeIndirect_hpp_
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
 #include <limits>
 #include <type_traits>
 #include <vector>
 
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_invoke.h>
+#include <tbb/parallel_reduce.h>
+
 #include "Utils.hpp" // for next_highest_power_of_2()
 
 extern "C"
@@ -37,6 +43,9 @@ namespace AABBTreeIndirect {
 // to the source entity (a 3D triangle, a 2D segment etc, a 3D or 2D point etc).
 // The source bounding boxes may have an epsilon applied to fight numeric rounding errors when 
 // traversing the AABB tree.
+//
+// Large subtrees are built in parallel. As the position of each node in the implicit tree is given
+// by its position in the input sequence, the tree is the same as if built by a single thread.
 template<int ANumDimensions, typename ACoordType>
 class Tree
 {
@@ -115,6 +124,9 @@ public:
 	}
 
 private:
+	// Subtrees of at least this number of entities are built in parallel.
+	static constexpr size_t parallel_threshold = 16384;
+
 	// Build a balanced tree by splitting the input sequence by an axis aligned plane at a dimension.
 	template<typename SourceNode>
 	void build_recursive(std::vector<SourceNode> &input, size_t node, const size_t left, const size_t right)
@@ -129,9 +141,19 @@ private:
 		}
 
 		// Calculate bounding box of the input.
+		const bool  parallel = right - left >= parallel_threshold;
         BoundingBox bbox(input[left].bbox());
-        for (size_t i = left + 1; i <= right; ++ i)
-            bbox.extend(input[i].bbox());
+        if (parallel)
+            bbox = tbb::parallel_reduce(tbb::blocked_range<size_t>(left + 1, right + 1, parallel_threshold / 4), bbox,
+                [&input](const tbb::blocked_range<size_t> &range, BoundingBox bbox) {
+                    for (size_t i = range.begin(); i < range.end(); ++ i)
+                        bbox.extend(input[i].bbox());
+                    return bbox;
+                },
+                [](BoundingBox bbox, const BoundingBox &bbox2) { return bbox.extend(bbox2); });
+        else
+            for (size_t i = left + 1; i <= right; ++ i)
+                bbox.extend(input[i].bbox());
         int dimension = -1;
         bbox.diagonal().maxCoeff(&dimension);
 
@@ -141,8 +163,15 @@ private:
 		// Insert an inner node into the tree. Inner node does not reference any input entity (triangle, line segment etc).
 		m_nodes[node].idx  = inner;
 		m_nodes[node].bbox = bbox;
-        build_recursive(input, node * 2 + 1, left, center);
-		build_recursive(input, node * 2 + 2, center + 1, right);
+		if (parallel)
+			// The two subtrees are built over disjoint ranges of the input into disjoint nodes.
+			tbb::parallel_invoke(
+				[this, &input, node, left, center]() { build_recursive(input, node * 2 + 1, left, center); },
+				[this, &input, node, center, right]() { build_recursive(input, node * 2 + 2, center + 1, right); });
+		else {
+	        build_recursive(input, node * 2 + 1, left, center);
+			build_recursive(input, node * 2 + 2, center + 1, right);
+		}
 	}
 
 	// Partition the input m_nodes <left, right> at "k" and "dimension" using the QuickSelect method:
@@ -399,6 +428,127 @@ namespace detail {
 		}
 	}
 
+	// Packet of rays traversing the AABB tree together. The origins, the inverted directions
+	// and the parameters of the closest hits found so far are stored as structure of arrays,
+	// so that a single bounding box is tested against all the rays of the packet by a loop,
+	// which the compiler turns into SIMD instructions.
+	template<size_t APacketSize, typename AScalar>
+	struct RayPacket {
+		static constexpr size_t PacketSize = APacketSize;
+		using Scalar = AScalar;
+		using Lanes  = std::array<Scalar, PacketSize>;
+		// Bit mask of the rays of a packet.
+		using Mask   = uint32_t;
+		static_assert(PacketSize <= 32, "RayPacket: The packet does not fit the mask.");
+
+		Lanes origin[3];
+		Lanes invdir[3];
+		Lanes min_t;
+	};
+
+	// Vectorized variant of ray_box_intersect_invdir(), returning a bit mask of the rays of a packet
+	// intersecting the box before their closest hit found so far.
+	// The comparisons are the same as in ray_box_intersect_invdir(), only the early exits are replaced
+	// by selects, thus the result is the same for each of the rays, including the NaN corner cases.
+	template<typename RayPacketType, typename BoundingBox>
+	inline typename RayPacketType::Mask ray_packet_box_intersect_invdir(const RayPacketType &packet, const BoundingBox &box)
+	{
+		using Scalar = typename RayPacketType::Scalar;
+		const Scalar bmin[3] = { Scalar(box.min().x()), Scalar(box.min().y()), Scalar(box.min().z()) };
+		const Scalar bmax[3] = { Scalar(box.max().x()), Scalar(box.max().y()), Scalar(box.max().z()) };
+		const auto &ox = packet.origin[0], &oy = packet.origin[1], &oz = packet.origin[2];
+		const auto &ix = packet.invdir[0], &iy = packet.invdir[1], &iz = packet.invdir[2];
+		// The result is kept as Scalar and the early exits are expressed as selects of Scalar values,
+		// as this is the form, which gets vectorized even with plain SSE2.
+		std::array<Scalar, RayPacketType::PacketSize> hit;
+		for (size_t i = 0; i < RayPacketType::PacketSize; ++ i) {
+			Scalar x0 = (bmin[0] - ox[i]) * ix[i], x1 = (bmax[0] - ox[i]) * ix[i];
+			Scalar y0 = (bmin[1] - oy[i]) * iy[i], y1 = (bmax[1] - oy[i]) * iy[i];
+			Scalar z0 = (bmin[2] - oz[i]) * iz[i], z1 = (bmax[2] - oz[i]) * iz[i];
+			// Near and far slab parameters.
+			Scalar nx = ix[i] < 0 ? x1 : x0, fx = ix[i] < 0 ? x0 : x1;
+			Scalar ny = iy[i] < 0 ? y1 : y0, fy = iy[i] < 0 ? y0 : y1;
+			Scalar nz = iz[i] < 0 ? z1 : z0, fz = iz[i] < 0 ? z0 : z1;
+			Scalar ret  = nx > fy ? Scalar(0) : Scalar(1);
+			ret         = ny > fx ? Scalar(0) : ret;
+			Scalar tmin = ny > nx ? ny : nx;
+			Scalar tmax = fy < fx ? fy : fx;
+			ret         = nz > tmax ? Scalar(0) : ret;
+			ret         = tmin > fz ? Scalar(0) : ret;
+			tmin        = nz > tmin ? nz : tmin;
+			tmax        = fz < tmax ? fz : tmax;
+			ret         = tmin < packet.min_t[i] ? ret : Scalar(0);
+			hit[i]      = tmax > Scalar(0) ? ret : Scalar(0);
+		}
+		typename RayPacketType::Mask mask = 0;
+		for (size_t i = 0; i < RayPacketType::PacketSize; ++ i)
+			mask |= typename RayPacketType::Mask(hit[i] != Scalar(0)) << i;
+		return mask;
+	}
+
+	// Traverse the tree with a packet of up to PacketSize rays, depth first, visiting the left child first.
+	// Each ray is tested against the nodes intersected by all its parent nodes and the triangles
+	// are intersected in the same order as by intersect_ray_recursive_first_hit(), therefore
+	// the same hit is found for each ray, even if there are multiple hits at the same distance.
+	template<size_t PacketSize, typename VertexType, typename IndexedFaceType, typename TreeType, typename VectorType>
+	inline void intersect_ray_packet_first_hit(
+		const std::vector<VertexType> 		&vertices,
+		const std::vector<IndexedFaceType> 	&faces,
+		const TreeType 						&tree,
+		const VectorType					*origins,
+		const VectorType 					*dirs,
+		size_t 								 num_rays,
+		igl::Hit 							*hits)
+	{
+		using Scalar = typename VectorType::Scalar;
+		using Packet = RayPacket<PacketSize, Scalar>;
+		using Mask   = typename Packet::Mask;
+		assert(num_rays > 0 && num_rays <= PacketSize);
+
+		Packet packet;
+		for (size_t i = 0; i < PacketSize; ++ i) {
+			// The unused lanes repeat the last ray, they are masked out.
+			size_t     j      = std::min(i, num_rays - 1);
+			VectorType invdir = dirs[j].cwiseInverse();
+			for (int d = 0; d < 3; ++ d) {
+				packet.origin[d][i] = origins[j](d);
+				packet.invdir[d][i] = invdir(d);
+			}
+			packet.min_t[i] = std::numeric_limits<Scalar>::infinity();
+		}
+
+		// Nodes to be visited with the mask of rays intersecting their parent.
+		// The depth of the balanced tree is bounded by the bit width of size_t.
+		std::array<std::pair<size_t, Mask>, 2 * sizeof(size_t) * 8> stack;
+		size_t stack_size = 0;
+		stack[stack_size ++] = { size_t(0), Mask((uint64_t(1) << num_rays) - 1) };
+		while (stack_size > 0) {
+			const size_t node_idx = stack[-- stack_size].first;
+			const auto  &node     = tree.node(node_idx);
+			assert(node.is_valid());
+			Mask mask = stack[stack_size].second & ray_packet_box_intersect_invdir(packet, node.bbox);
+			if (mask == 0)
+				continue;
+			if (node.is_leaf()) {
+				auto face = faces[node.idx];
+				for (size_t i = 0; i < num_rays; ++ i)
+					if (mask & (Mask(1) << i)) {
+						double t, u, v;
+						// Compared with the rounded value, as intersect_ray_recursive_first_hit() compares igl::Hit::t.
+						if (intersect_triangle(origins[i], dirs[i], vertices[face(0)], vertices[face(1)], vertices[face(2)], t, u, v)
+							&& t > 0. && Scalar(float(t)) < packet.min_t[i]) {
+							hits[i] = igl::Hit { int(node.idx), -1, float(u), float(v), float(t) };
+							packet.min_t[i] = Scalar(float(t));
+						}
+					}
+			} else {
+				// Right child goes first to the stack to be visited last.
+				stack[stack_size ++] = { node_idx * 2 + 2, mask };
+				stack[stack_size ++] = { node_idx * 2 + 1, mask };
+			}
+		}
+	}
+
 	// Nothing to do with COVID-19 social distancing.
 	template<typename AVertexType, typename AIndexedFaceType, typename ATreeType, typename AVectorType>
 	struct IndexedTriangleSetDistancer {
@@ -581,24 +731,24 @@ inline Tree<3, typename VertexType::Scalar> build_aabb_tree_over_indexed_triangl
         VectorType 	m_centroid;
 	};
 
-	std::vector<InputType> input;
-	input.reserve(faces.size());
+	std::vector<InputType> input(faces.size());
     const VectorType veps(eps, eps, eps);
-	for (size_t i = 0; i < faces.size(); ++ i) {
-        const IndexedFaceType &face = faces[i];
-		const VertexType &v1 = vertices[face(0)];
-		const VertexType &v2 = vertices[face(1)];
-		const VertexType &v3 = vertices[face(2)];
-		InputType n;
-        n.m_idx      = i;
-        n.m_centroid = (1./3.) * (v1 + v2 + v3);
-        n.m_bbox = BoundingBox(v1, v1);
-        n.m_bbox.extend(v2);
-        n.m_bbox.extend(v3);
-        n.m_bbox.min() -= veps;
-        n.m_bbox.max() += veps;
-        input.emplace_back(n);
-	}
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, faces.size()), [&vertices, &faces, &input, &veps](const tbb::blocked_range<size_t> &range) {
+		for (size_t i = range.begin(); i < range.end(); ++ i) {
+	        const IndexedFaceType &face = faces[i];
+			const VertexType &v1 = vertices[face(0)];
+			const VertexType &v2 = vertices[face(1)];
+			const VertexType &v3 = vertices[face(2)];
+			InputType &n = input[i];
+	        n.m_idx      = i;
+	        n.m_centroid = (1./3.) * (v1 + v2 + v3);
+	        n.m_bbox = BoundingBox(v1, v1);
+	        n.m_bbox.extend(v2);
+	        n.m_bbox.extend(v3);
+	        n.m_bbox.min() -= veps;
+	        n.m_bbox.max() += veps;
+		}
+	});
 
 	TreeType out;
 	out.build(std::move(input));
@@ -632,6 +782,38 @@ inline bool intersect_ray_first_hit(
         ray_intersector, size_t(0), std::numeric_limits<Scalar>::infinity(), hit);
 }
 
+// Find the first intersections of a bunch of rays with indexed triangle set.
+// The rays are traversed through the AABB tree in packets of PacketSize rays, testing a bounding box
+// against all the rays of a packet at once. This pays off for coherent rays, for example rays
+// starting close to each other, which mostly visit the same nodes of the tree.
+// The hits are the same as returned by intersect_ray_first_hit() for each ray separately,
+// rays not intersecting the indexed triangle set get a hit with id -1 and infinite t.
+// Returns the number of rays intersecting the indexed triangle set.
+template<size_t PacketSize = 8, typename VertexType, typename IndexedFaceType, typename TreeType, typename VectorType>
+inline size_t intersect_rays_first_hit(
+	// Indexed triangle set - 3D vertices.
+	const std::vector<VertexType> 		&vertices,
+	// Indexed triangle set - triangular faces, references to vertices.
+	const std::vector<IndexedFaceType> 	&faces,
+	// AABBTreeIndirect::Tree over vertices & faces, bounding boxes built with the accuracy of vertices.
+	const TreeType 						&tree,
+	// Origins of the rays.
+	const std::vector<VectorType>		&origins,
+	// Directions of the rays.
+	const std::vector<VectorType> 		&dirs,
+	// First intersections of the rays with the indexed triangle set.
+	std::vector<igl::Hit> 				&hits)
+{
+	assert(origins.size() == dirs.size());
+	hits.assign(origins.size(), igl::Hit { -1, -1, 0.f, 0.f, std::numeric_limits<float>::infinity() });
+	if (tree.empty())
+		return 0;
+	for (size_t i = 0; i < origins.size(); i += PacketSize)
+		detail::intersect_ray_packet_first_hit<PacketSize>(vertices, faces, tree,
+			origins.data() + i, dirs.data() + i, std::min(PacketSize, origins.size() - i), hits.data() + i);
+	return size_t(std::count_if(hits.begin(), hits.end(), [](const igl::Hit &hit) { return hit.id >= 0; }));
+}
+
 // Find all intersections of a ray with indexed triangle set.
 // Intersection test is calculated with the accuracy of VectorType::Scalar
 // even if the triangle mesh and the AABB Tree are built with floats.
@@ -0,0 +1,694 @@
+// Wide bounding volume hierarchy built upon an external indexed triangle set, referencing the triangles
+// by integer indices. This is a more compact alternative to the binary AABBTreeIndirect::Tree3f,
+// answering the same queries with the same interface.
+
+#ifndef slic3r_AABBTreeWide_hpp_
+#define slic3r_AABBTreeWide_hpp_
+
+#include <cmath>
+
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+
+#include "AABBTreeIndirect.hpp"
+
+namespace Slic3r {
+namespace AABBTreeIndirect {
+
+// Static bounding volume hierarchy with AWidth children per node over a 3D indexed triangle set.
+//
+// The binary Tree stores a full bounding box of floats per node, thus a traversal touches a cache line
+// for each box tested. Here the bounding boxes of all the children of a node are stored with the node,
+// quantized to 8 bits relative to the bounding box of the node, so that a node of a 4-wide tree fits
+// a single cache line. The children boxes of a node are tested against the query all at once
+// by loops over the children, which the compiler vectorizes.
+// The quantized boxes are conservative: they always contain the exact boxes of the children.
+//
+// The tree is built top down by the surface area heuristic evaluated over binned centroids.
+// A node is filled by repeatedly splitting its child with the largest surface area.
+// Leaves reference up to MaxLeafSize consecutive items of a permuted index of the source entities.
+// Large subtrees are built in parallel into their own buffers, which are then concatenated in the order
+// of a serial depth first build, thus the tree does not depend on the number of threads.
+template<int AWidth>
+class WideTree
+{
+public:
+    static constexpr int    Width         = AWidth;
+    static constexpr int    NumDimensions = 3;
+    static constexpr size_t MaxLeafSize   = 4;
+    using                   CoordType     = float;
+    using                   VectorType    = Eigen::Matrix<CoordType, NumDimensions, 1, Eigen::DontAlign>;
+    using                   BoundingBox   = Eigen::AlignedBox<CoordType, NumDimensions>;
+    static_assert(Width >= 2 && Width <= 8, "WideTree: Unsupported node width.");
+
+    // Reference to a child of a node: Either an index of an inner node,
+    // or a range of the permuted source entities, which are referenced by a leaf.
+    enum : uint32_t {
+        // Child slot is not used.
+        empty_child = uint32_t(-1),
+        // Bit 31 marks a leaf, bits 28 to 30 store the number of entities - 1, bits 0 to 27 the first entity.
+        leaf_flag   = 0x80000000u,
+        leaf_first  = 0x0fffffffu,
+    };
+
+    struct Node {
+        // Bounding box of the node: Origin and the size of a quantization step.
+        CoordType   origin[NumDimensions];
+        CoordType   scale[NumDimensions];
+        // Quantized bounding boxes of the children, stored as structure of arrays for the vectorized tests.
+        uint8_t     qmin[NumDimensions][Width];
+        uint8_t     qmax[NumDimensions][Width];
+        uint32_t    children[Width];
+
+        // Bounds of the children boxes. Evaluated in doubles, where the product of a quantized value
+        // with a float step is exact, so the result does not depend on fused multiply-add contraction
+        // and it is the same value, which was verified to contain the exact box during the build.
+        double      child_min(int dim, int child) const { return double(origin[dim]) + double(qmin[dim][child]) * double(scale[dim]); }
+        double      child_max(int dim, int child) const { return double(origin[dim]) + double(qmax[dim][child]) * double(scale[dim]); }
+    };
+
+    static bool     is_leaf(uint32_t child)    { return (child & leaf_flag) != 0; }
+    static size_t   leaf_begin(uint32_t child) { return child & leaf_first; }
+    static size_t   leaf_end(uint32_t child)   { return leaf_begin(child) + ((child >> 28) & 7) + 1; }
+
+    void clear() { m_nodes.clear(); m_entities.clear(); }
+
+    // SourceNode shall implement the same interface as for Tree::build(), see the description there.
+    template<typename SourceNode>
+    void build(std::vector<SourceNode> &&input)
+    {
+        this->clear();
+        if (! input.empty()) {
+            assert(input.size() <= leaf_first);
+            m_nodes.reserve(2 * input.size() / (MaxLeafSize * (Width - 1)) + 1);
+            m_entities.reserve(input.size());
+            build_recursive(input, 0, input.size(), 0, m_nodes, m_entities);
+        }
+        input.clear();
+    }
+
+    template<typename SourceNode>
+    void build(const std::vector<SourceNode> &input)
+    {
+        std::vector<SourceNode> copy(input);
+        this->build(std::move(copy));
+    }
+
+    const std::vector<Node>&    nodes() const { return m_nodes; }
+    const Node&                 node(size_t idx) const { return m_nodes[idx]; }
+    // Indices of the source entities in the order referenced by the leaves.
+    const std::vector<size_t>&  entities() const { return m_entities; }
+    bool                        empty() const { return m_nodes.empty(); }
+
+private:
+    // Number of bins of the centroids to evaluate the surface area heuristic at.
+    static constexpr int NumBins        = 16;
+    // Below this depth the nodes are split by the median to limit the depth of the traversal stacks.
+    static constexpr int MaxSAHDepth    = 40;
+    // Subtrees of at least this number of entities are built in parallel.
+    static constexpr size_t ParallelThreshold = 16384;
+
+    static float half_area(const BoundingBox &bbox)
+    {
+        if (bbox.isEmpty())
+            return 0.f;
+        VectorType d = bbox.sizes();
+        return d.x() * d.y() + d.y() * d.z() + d.z() * d.x();
+    }
+
+    template<typename SourceNode>
+    static BoundingBox bbox_of(const std::vector<SourceNode> &input, size_t begin, size_t end)
+    {
+        auto extend = [&input](const tbb::blocked_range<size_t> &range, BoundingBox bbox) {
+            for (size_t i = range.begin(); i < range.end(); ++ i)
+                bbox.extend(input[i].bbox());
+            return bbox;
+        };
+        return end - begin >= ParallelThreshold ?
+            tbb::parallel_reduce(tbb::blocked_range<size_t>(begin, end, ParallelThreshold / 4), BoundingBox(), extend,
+                [](BoundingBox bbox, const BoundingBox &bbox2) { return bbox.extend(bbox2); }) :
+            extend(tbb::blocked_range<size_t>(begin, end), BoundingBox());
+    }
+
+    // Split the <begin, end) range of the input by the surface area heuristic, returns the split position.
+    template<typename SourceNode>
+    static size_t split(std::vector<SourceNode> &input, size_t begin, size_t end, int depth)
+    {
+        BoundingBox cbox;
+        for (size_t i = begin; i < end; ++ i)
+            cbox.extend(input[i].centroid());
+        int dimension = -1;
+        const float extent = cbox.sizes().maxCoeff(&dimension);
+        size_t center = (begin + end) / 2;
+        if (extent <= 0.f)
+            // All the centroids are the same.
+            return center;
+        if (depth >= MaxSAHDepth) {
+            std::nth_element(input.begin() + begin, input.begin() + center, input.begin() + end,
+                [dimension](const SourceNode &l, const SourceNode &r) { return l.centroid()(dimension) < r.centroid()(dimension); });
+            return center;
+        }
+
+        const float cmin = cbox.min()(dimension);
+        const float k    = float(NumBins) / extent;
+        auto bin_of = [cmin, k, dimension](const SourceNode &n) {
+            return std::min(NumBins - 1, int((n.centroid()(dimension) - cmin) * k));
+        };
+        BoundingBox bins[NumBins];
+        size_t      counts[NumBins] = { 0 };
+        for (size_t i = begin; i < end; ++ i) {
+            int b = bin_of(input[i]);
+            bins[b].extend(input[i].bbox());
+            ++ counts[b];
+        }
+        // Sweep from the right, then from the left, evaluating the cost of the splits after each bin.
+        float       right_cost[NumBins];
+        BoundingBox acc;
+        size_t      cnt = 0;
+        for (int b = NumBins - 1; b > 0; -- b) {
+            acc.extend(bins[b]);
+            cnt += counts[b];
+            right_cost[b - 1] = half_area(acc) * float(cnt);
+        }
+        acc.setEmpty();
+        cnt = 0;
+        int   best_split = -1;
+        float best_cost  = std::numeric_limits<float>::max();
+        for (int b = 0; b + 1 < NumBins; ++ b) {
+            acc.extend(bins[b]);
+            cnt += counts[b];
+            if (cnt == 0 || cnt == end - begin)
+                continue;
+            float cost = half_area(acc) * float(cnt) + right_cost[b];
+            if (cost < best_cost) {
+                best_cost  = cost;
+                best_split = b;
+            }
+        }
+        // The minimum and the maximum centroids fall into the first and the last bin, thus there is a valid split.
+        assert(best_split >= 0);
+        auto it = std::partition(input.begin() + begin, input.begin() + end,
+            [best_split, &bin_of](const SourceNode &n) { return bin_of(n) <= best_split; });
+        return size_t(it - input.begin());
+    }
+
+    // Build a subtree over <begin, end) of the input, appending its nodes and entities.
+    // Returns the index of the root of the subtree.
+    template<typename SourceNode>
+    static uint32_t build_recursive(std::vector<SourceNode> &input, size_t begin, size_t end, int depth,
+                                    std::vector<Node> &nodes, std::vector<size_t> &entities)
+    {
+        const size_t node_idx = nodes.size();
+        nodes.emplace_back();
+
+        // Split the largest child until the node is full or all its children are small enough to become leaves.
+        std::pair<size_t, size_t> ranges[Width];
+        BoundingBox               boxes[Width];
+        int                       num_children = 1;
+        ranges[0] = { begin, end };
+        boxes[0]  = bbox_of(input, begin, end);
+        const BoundingBox bbox = boxes[0];
+        while (num_children < Width) {
+            int   to_split = -1;
+            float max_area = -1.f;
+            for (int i = 0; i < num_children; ++ i)
+                if (ranges[i].second - ranges[i].first > MaxLeafSize) {
+                    float area = half_area(boxes[i]);
+                    if (area > max_area) {
+                        max_area = area;
+                        to_split = i;
+                    }
+                }
+            if (to_split == -1)
+                break;
+            std::pair<size_t, size_t> &range = ranges[to_split];
+            size_t mid = split(input, range.first, range.second, depth);
+            ranges[num_children] = { mid, range.second };
+            boxes [num_children] = bbox_of(input, mid, range.second);
+            range.second    = mid;
+            boxes[to_split] = bbox_of(input, range.first, mid);
+            ++ num_children;
+        }
+
+        quantize(nodes[node_idx], bbox, boxes, num_children);
+
+        // The children work on disjoint ranges of the input. If the node is large, the children subtrees
+        // are built in parallel into their own buffers, to be appended in the order of the children below.
+        struct Subtree {
+            std::vector<Node>   nodes;
+            std::vector<size_t> entities;
+        };
+        std::vector<Subtree> subtrees;
+        if (end - begin >= ParallelThreshold) {
+            subtrees.resize(num_children);
+            tbb::parallel_for(0, num_children, [&input, &ranges, &subtrees, depth](int i) {
+                if (ranges[i].second - ranges[i].first > MaxLeafSize)
+                    build_recursive(input, ranges[i].first, ranges[i].second, depth + 1, subtrees[i].nodes, subtrees[i].entities);
+            });
+        }
+
+        for (int i = 0; i < num_children; ++ i) {
+            uint32_t child;
+            if (ranges[i].second - ranges[i].first <= MaxLeafSize) {
+                child = leaf_flag | (uint32_t(ranges[i].second - ranges[i].first - 1) << 28) | uint32_t(entities.size());
+                for (size_t j = ranges[i].first; j < ranges[i].second; ++ j)
+                    entities.emplace_back(input[j].idx());
+            } else if (subtrees.empty())
+                child = build_recursive(input, ranges[i].first, ranges[i].second, depth + 1, nodes, entities);
+            else {
+                child = uint32_t(nodes.size());
+                append_subtree(subtrees[i], nodes, entities);
+                subtrees[i] = Subtree();
+            }
+            // nodes may have been reallocated by the recursive call.
+            nodes[node_idx].children[i] = child;
+        }
+        return uint32_t(node_idx);
+    }
+
+    // Append nodes and entities of a subtree, offsetting the references to them.
+    template<typename Subtree>
+    static void append_subtree(const Subtree &subtree, std::vector<Node> &nodes, std::vector<size_t> &entities)
+    {
+        const uint32_t node_offset   = uint32_t(nodes.size());
+        const uint32_t entity_offset = uint32_t(entities.size());
+        for (Node node : subtree.nodes) {
+            for (uint32_t &child : node.children)
+                if (child == empty_child)
+                    continue;
+                else if (is_leaf(child)) {
+                    assert(leaf_begin(child) + entity_offset <= leaf_first);
+                    child += entity_offset;
+                } else
+                    child += node_offset;
+            nodes.emplace_back(node);
+        }
+        entities.insert(entities.end(), subtree.entities.begin(), subtree.entities.end());
+    }
+
+    static void quantize(Node &node, const BoundingBox &bbox, const BoundingBox *boxes, int num_children)
+    {
+        for (int d = 0; d < NumDimensions; ++ d) {
+            node.origin[d] = bbox.min()(d);
+            float scale = (bbox.max()(d) - bbox.min()(d)) / 255.f;
+            // The last quantization step has to reach the maximum.
+            while (double(node.origin[d]) + 255. * double(scale) < double(bbox.max()(d)))
+                scale = std::nextafter(scale, std::numeric_limits<float>::max());
+            node.scale[d] = scale;
+        }
+        for (int i = 0; i < Width; ++ i) {
+            if (i >= num_children) {
+                node.children[i] = empty_child;
+                for (int d = 0; d < NumDimensions; ++ d) {
+                    node.qmin[d][i] = 255;
+                    node.qmax[d][i] = 0;
+                }
+                continue;
+            }
+            for (int d = 0; d < NumDimensions; ++ d) {
+                if (node.scale[d] == 0.f) {
+                    // Flat node, all the children start at the origin.
+                    node.qmin[d][i] = node.qmax[d][i] = 0;
+                    continue;
+                }
+                const float lo = boxes[i].min()(d);
+                const float hi = boxes[i].max()(d);
+                int qmin = std::clamp(int(std::floor((lo - node.origin[d]) / node.scale[d])), 0, 255);
+                int qmax = std::clamp(int(std::ceil ((hi - node.origin[d]) / node.scale[d])), 0, 255);
+                node.qmin[d][i] = uint8_t(qmin);
+                node.qmax[d][i] = uint8_t(qmax);
+                // Fix the rounding errors, so that the quantized box contains the exact one.
+                while (node.qmin[d][i] > 0 && node.child_min(d, i) > double(lo))
+                    -- node.qmin[d][i];
+                while (node.qmax[d][i] < 255 && node.child_max(d, i) < double(hi))
+                    ++ node.qmax[d][i];
+                assert(node.child_min(d, i) <= double(lo) && node.child_max(d, i) >= double(hi));
+            }
+        }
+    }
+
+    std::vector<Node>   m_nodes;
+    std::vector<size_t> m_entities;
+};
+
+using WideTree4f = WideTree<4>;
+using WideTree8f = WideTree<8>;
+
+namespace detail {
+    // Stack of children references to be visited by a traversal of a WideTree, together with a distance
+    // of their bounding box to the query, to skip the children which became too far since they were pushed.
+    // The depth of the tree is limited by the median splits, see WideTree::build_recursive().
+    // The items are trivially constructible and left uninitialized, a std::pair would zero the whole stack of each query.
+    template<typename TreeType, typename Scalar>
+    struct WideTreeStack {
+        struct Item {
+            uint32_t child;
+            Scalar   dist;
+        };
+        std::array<Item, 128 * (TreeType::Width - 1) + 1> items;
+        size_t                                            size = 0;
+
+        bool    empty() const { return size == 0; }
+        void    push(uint32_t child, Scalar dist) { assert(size < items.size()); items[size ++] = { child, dist }; }
+        Item    pop() { return items[-- size]; }
+        // Push the children with finite distances, the closest last to be popped first.
+        template<size_t N>
+        void    push_sorted(const uint32_t *children, const std::array<Scalar, N> &dist)
+        {
+            size_t first = size;
+            for (int i = 0; i < int(N); ++ i)
+                if (dist[i] != std::numeric_limits<Scalar>::infinity()) {
+                    // Insertion sort by the distance, descending.
+                    size_t j = size ++;
+                    assert(size <= items.size());
+                    for (; j > first && items[j - 1].dist < dist[i]; -- j)
+                        items[j] = items[j - 1];
+                    items[j] = { children[i], dist[i] };
+                }
+        }
+    };
+
+    // Parameters of the entries of a ray into the children boxes of a node before t_max,
+    // infinity for the children not intersected. Similar to ray_box_intersect_invdir(), but the near
+    // and far slabs are selected once per ray and NaNs produced by a ray parallel to a slab and starting
+    // at its boundary are ignored, thus such a box is conservatively reported as intersected.
+    template<typename TreeType, typename Vector, typename Scalar>
+    inline std::array<Scalar, size_t(TreeType::Width)> ray_children_intersect(
+        const typename TreeType::Node &node, const Vector &origin, const Vector &invdir, const Scalar t_max)
+    {
+        constexpr int Width = TreeType::Width;
+        Scalar lo[3][Width], hi[3][Width];
+        for (int d = 0; d < 3; ++ d)
+            for (int i = 0; i < Width; ++ i) {
+                lo[d][i] = Scalar(node.child_min(d, i));
+                hi[d][i] = Scalar(node.child_max(d, i));
+            }
+        const Scalar *near_x = invdir.x() < 0 ? hi[0] : lo[0], *far_x = invdir.x() < 0 ? lo[0] : hi[0];
+        const Scalar *near_y = invdir.y() < 0 ? hi[1] : lo[1], *far_y = invdir.y() < 0 ? lo[1] : hi[1];
+        const Scalar *near_z = invdir.z() < 0 ? hi[2] : lo[2], *far_z = invdir.z() < 0 ? lo[2] : hi[2];
+        std::array<Scalar, size_t(Width)> out;
+        for (int i = 0; i < Width; ++ i) {
+            Scalar nx = (near_x[i] - origin.x()) * invdir.x(), fx = (far_x[i] - origin.x()) * invdir.x();
+            Scalar ny = (near_y[i] - origin.y()) * invdir.y(), fy = (far_y[i] - origin.y()) * invdir.y();
+            Scalar nz = (near_z[i] - origin.z()) * invdir.z(), fz = (far_z[i] - origin.z()) * invdir.z();
+            // Comparisons with NaN are false, thus NaNs keep the previous value.
+            Scalar tmin = Scalar(0);
+            Scalar tmax = t_max;
+            tmin = nx > tmin ? nx : tmin;
+            tmin = ny > tmin ? ny : tmin;
+            tmin = nz > tmin ? nz : tmin;
+            tmax = fx < tmax ? fx : tmax;
+            tmax = fy < tmax ? fy : tmax;
+            tmax = fz < tmax ? fz : tmax;
+            out[i] = tmin <= tmax ? tmin : std::numeric_limits<Scalar>::infinity();
+        }
+        for (int i = 0; i < Width; ++ i)
+            if (node.children[i] == TreeType::empty_child)
+                out[i] = std::numeric_limits<Scalar>::infinity();
+        return out;
+    }
+
+    // Squared distances of a point to the children boxes of a node, infinity for the unused children
+    // and for the children farther than up_sqr_d.
+    template<typename TreeType, typename Vector, typename Scalar>
+    inline std::array<Scalar, size_t(TreeType::Width)> point_children_squared_distance(
+        const typename TreeType::Node &node, const Vector &point, const Scalar up_sqr_d)
+    {
+        constexpr int Width = TreeType::Width;
+        Scalar lo[3][Width], hi[3][Width];
+        for (int d = 0; d < 3; ++ d)
+            for (int i = 0; i < Width; ++ i) {
+                lo[d][i] = Scalar(node.child_min(d, i));
+                hi[d][i] = Scalar(node.child_max(d, i));
+            }
+        std::array<Scalar, size_t(Width)> out;
+        for (int i = 0; i < Width; ++ i) {
+            Scalar sqr_d = Scalar(0);
+            for (int d = 0; d < 3; ++ d) {
+                Scalar below = lo[d][i] - point(d);
+                Scalar above = point(d) - hi[d][i];
+                Scalar dist  = below > Scalar(0) ? below : (above > Scalar(0) ? above : Scalar(0));
+                sqr_d += dist * dist;
+            }
+            out[i] = sqr_d < up_sqr_d ? sqr_d : std::numeric_limits<Scalar>::infinity();
+        }
+        for (int i = 0; i < Width; ++ i)
+            if (node.children[i] == TreeType::empty_child)
+                out[i] = std::numeric_limits<Scalar>::infinity();
+        return out;
+    }
+
+    template<typename TreeType, typename RayIntersectorType, typename Scalar>
+    inline bool intersect_ray_wide_first_hit(const RayIntersectorType &ray_intersector, Scalar min_t, igl::Hit &hit)
+    {
+        const TreeType &tree  = ray_intersector.tree;
+        bool            found = false;
+        WideTreeStack<TreeType, Scalar> stack;
+        stack.push(0, Scalar(0));
+        while (! stack.empty()) {
+            const auto item = stack.pop();
+            if (item.dist > min_t)
+                // Hit closer than this box was already found.
+                continue;
+            const uint32_t child = item.child;
+            if (TreeType::is_leaf(child)) {
+                for (size_t i = TreeType::leaf_begin(child); i < TreeType::leaf_end(child); ++ i) {
+                    const size_t face_idx = tree.entities()[i];
+                    auto         face     = ray_intersector.faces[face_idx];
+                    double t, u, v;
+                    if (intersect_triangle(
+                            ray_intersector.origin, ray_intersector.dir,
+                            ray_intersector.vertices[face(0)], ray_intersector.vertices[face(1)], ray_intersector.vertices[face(2)],
+                            t, u, v)
+                        && t > 0. && Scalar(float(t)) < min_t) {
+                        hit   = igl::Hit { int(face_idx), -1, float(u), float(v), float(t) };
+                        min_t = Scalar(float(t));
+                        found = true;
+                    }
+                }
+            } else {
+                const auto &node = tree.node(child);
+                stack.push_sorted(node.children, ray_children_intersect<TreeType>(node, ray_intersector.origin, ray_intersector.invdir, min_t));
+            }
+        }
+        return found;
+    }
+} // namespace detail
+
+// Build a wide BVH over an indexed triangles set, see build_aabb_tree_over_indexed_triangle_set().
+template<int Width = 4, typename VertexType, typename IndexedFaceType>
+inline WideTree<Width> build_wide_aabb_tree_over_indexed_triangle_set(
+    // Indexed triangle set - 3D vertices.
+    const std::vector<VertexType>       &vertices,
+    // Indexed triangle set - triangular faces, references to vertices.
+    const std::vector<IndexedFaceType>  &faces,
+    const float                          eps = 0)
+{
+    using TreeType    = WideTree<Width>;
+    using VectorType  = typename TreeType::VectorType;
+    using BoundingBox = typename TreeType::BoundingBox;
+
+    struct InputType {
+        size_t              idx()       const { return m_idx; }
+        const BoundingBox&  bbox()      const { return m_bbox; }
+        const VectorType&   centroid()  const { return m_centroid; }
+
+        size_t      m_idx;
+        BoundingBox m_bbox;
+        VectorType  m_centroid;
+    };
+
+    std::vector<InputType> input(faces.size());
+    const VectorType veps(eps, eps, eps);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, faces.size()), [&vertices, &faces, &input, &veps](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i < range.end(); ++ i) {
+            const IndexedFaceType &face = faces[i];
+            const VectorType v1 = vertices[face(0)].template cast<float>();
+            const VectorType v2 = vertices[face(1)].template cast<float>();
+            const VectorType v3 = vertices[face(2)].template cast<float>();
+            InputType &n = input[i];
+            n.m_idx      = i;
+            n.m_centroid = (1.f/3.f) * (v1 + v2 + v3);
+            n.m_bbox = BoundingBox(v1, v1);
+            n.m_bbox.extend(v2);
+            n.m_bbox.extend(v3);
+            n.m_bbox.min() -= veps;
+            n.m_bbox.max() += veps;
+        }
+    });
+
+    TreeType out;
+    out.build(std::move(input));
+    return out;
+}
+
+// Following are the queries of AABBTreeIndirect.hpp over a WideTree. The nodes are visited
+// closest first, therefore the first hit or the closest triangle is the same as with the binary tree,
+// however if there are multiple triangles at the same distance, another one of them may be returned.
+
+// Find a first intersection of a ray with indexed triangle set.
+template<typename VertexType, typename IndexedFaceType, int Width, typename VectorType>
+inline bool intersect_ray_first_hit(
+    const std::vector<VertexType>       &vertices,
+    const std::vector<IndexedFaceType>  &faces,
+    const WideTree<Width>               &tree,
+    const VectorType                    &origin,
+    const VectorType                    &dir,
+    igl::Hit                            &hit)
+{
+    using Scalar = typename VectorType::Scalar;
+    auto ray_intersector = detail::RayIntersector<VertexType, IndexedFaceType, WideTree<Width>, VectorType> {
+        vertices, faces, tree,
+        origin, dir, VectorType(dir.cwiseInverse())
+    };
+    return ! tree.empty() && detail::intersect_ray_wide_first_hit<WideTree<Width>>(
+        ray_intersector, std::numeric_limits<Scalar>::infinity(), hit);
+}
+
+// Find the first intersections of a bunch of rays with indexed triangle set.
+// The ray packets of AABBTreeIndirect::intersect_rays_first_hit() are not implemented for the wide tree,
+// the wide nodes already test multiple boxes at once, thus the rays are cast one by one.
+template<size_t PacketSize = 8, typename VertexType, typename IndexedFaceType, int Width, typename VectorType>
+inline size_t intersect_rays_first_hit(
+    const std::vector<VertexType>       &vertices,
+    const std::vector<IndexedFaceType>  &faces,
+    const WideTree<Width>               &tree,
+    const std::vector<VectorType>       &origins,
+    const std::vector<VectorType>       &dirs,
+    std::vector<igl::Hit>               &hits)
+{
+    assert(origins.size() == dirs.size());
+    hits.assign(origins.size(), igl::Hit { -1, -1, 0.f, 0.f, std::numeric_limits<float>::infinity() });
+    size_t num_hits = 0;
+    for (size_t i = 0; i < origins.size(); ++ i)
+        if (intersect_ray_first_hit(vertices, faces, tree, origins[i], dirs[i], hits[i]))
+            ++ num_hits;
+    return num_hits;
+}
+
+// Find all intersections of a ray with indexed triangle set, sorted by the ray parameter.
+template<typename VertexType, typename IndexedFaceType, int Width, typename VectorType>
+inline bool intersect_ray_all_hits(
+    const std::vector<VertexType>       &vertices,
+    const std::vector<IndexedFaceType>  &faces,
+    const WideTree<Width>               &tree,
+    const VectorType                    &origin,
+    const VectorType                    &dir,
+    std::vector<igl::Hit>               &hits)
+{
+    using TreeType = WideTree<Width>;
+    using Scalar   = typename VectorType::Scalar;
+    hits.clear();
+    if (tree.empty())
+        return false;
+    const VectorType invdir = dir.cwiseInverse();
+    detail::WideTreeStack<TreeType, Scalar> stack;
+    stack.push(0, Scalar(0));
+    while (! stack.empty()) {
+        const uint32_t child = stack.pop().child;
+        if (TreeType::is_leaf(child)) {
+            for (size_t i = TreeType::leaf_begin(child); i < TreeType::leaf_end(child); ++ i) {
+                const size_t face_idx = tree.entities()[i];
+                auto         face     = faces[face_idx];
+                double t, u, v;
+                if (detail::intersect_triangle(origin, dir, vertices[face(0)], vertices[face(1)], vertices[face(2)], t, u, v) && t > 0.)
+                    hits.emplace_back(igl::Hit{ int(face_idx), -1, float(u), float(v), float(t) });
+            }
+        } else {
+            const auto &node = tree.node(child);
+            stack.push_sorted(node.children, detail::ray_children_intersect<TreeType>(node, origin, invdir, std::numeric_limits<Scalar>::infinity()));
+        }
+    }
+    std::sort(hits.begin(), hits.end(), [](const auto &l, const auto &r) { return l.t < r.t; });
+    return ! hits.empty();
+}
+
+namespace detail {
+    // Closest point search, visiting the children closest first. Returns the squared distance
+    // to the closest point closer than up_sqr_d, or up_sqr_d if there is no such point.
+    // If stop_at_first, the search ends with the first point found closer than up_sqr_d.
+    template<typename VertexType, typename IndexedFaceType, int Width, typename VectorType>
+    inline typename VectorType::Scalar squared_distance_to_indexed_triangle_set_wide(
+        const std::vector<VertexType>       &vertices,
+        const std::vector<IndexedFaceType>  &faces,
+        const WideTree<Width>               &tree,
+        const VectorType                    &point,
+        typename VectorType::Scalar          up_sqr_d,
+        bool                                 stop_at_first,
+        size_t                              &hit_idx_out,
+        Eigen::PlainObjectBase<VectorType>  &hit_point_out)
+    {
+        using TreeType = WideTree<Width>;
+        using Scalar   = typename VectorType::Scalar;
+        WideTreeStack<TreeType, Scalar> stack;
+        stack.push(0, Scalar(0));
+        while (! stack.empty()) {
+            const auto item = stack.pop();
+            if (item.dist >= up_sqr_d)
+                continue;
+            const uint32_t child = item.child;
+            if (TreeType::is_leaf(child)) {
+                for (size_t i = TreeType::leaf_begin(child); i < TreeType::leaf_end(child); ++ i) {
+                    const size_t face_idx = tree.entities()[i];
+                    const auto  &face     = faces[face_idx];
+                    VectorType c = closest_point_to_triangle<VectorType>(point,
+                        vertices[face(0)].template cast<Scalar>(),
+                        vertices[face(1)].template cast<Scalar>(),
+                        vertices[face(2)].template cast<Scalar>());
+                    Scalar sqr_d = (c - point).squaredNorm();
+                    if (sqr_d < up_sqr_d) {
+                        hit_idx_out   = face_idx;
+                        hit_point_out = c;
+                        up_sqr_d      = sqr_d;
+                        if (stop_at_first)
+                            return up_sqr_d;
+                    }
+                }
+            } else {
+                const auto &node = tree.node(child);
+                stack.push_sorted(node.children, point_children_squared_distance<TreeType>(node, point, up_sqr_d));
+            }
+        }
+        return up_sqr_d;
+    }
+} // namespace detail
+
+// Finding a closest triangle, its closest point and squared distance to the closest point.
+// Returns squared distance to the closest point or -1 if the input is empty.
+template<typename VertexType, typename IndexedFaceType, int Width, typename VectorType>
+inline typename VectorType::Scalar squared_distance_to_indexed_triangle_set(
+    const std::vector<VertexType>       &vertices,
+    const std::vector<IndexedFaceType>  &faces,
+    const WideTree<Width>               &tree,
+    const VectorType                    &point,
+    size_t                              &hit_idx_out,
+    Eigen::PlainObjectBase<VectorType>  &hit_point_out)
+{
+    using Scalar = typename VectorType::Scalar;
+    return tree.empty() ? Scalar(-1) :
+        detail::squared_distance_to_indexed_triangle_set_wide(vertices, faces, tree, point,
+            std::numeric_limits<Scalar>::infinity(), false, hit_idx_out, hit_point_out);
+}
+
+// Decides if exists some triangle with squared distance to the point lower than max_distance,
+// the same as is_any_triangle_in_radius() over the binary tree.
+template<typename VertexType, typename IndexedFaceType, int Width, typename VectorType>
+inline bool is_any_triangle_in_radius(
+    const std::vector<VertexType>       &vertices,
+    const std::vector<IndexedFaceType>  &faces,
+    const WideTree<Width>               &tree,
+    const VectorType                    &point,
+    typename VectorType::Scalar         &max_distance)
+{
+    size_t     hit_idx;
+    VectorType hit_point = VectorType::Ones() * (std::nan(""));
+    if (tree.empty())
+        return false;
+    detail::squared_distance_to_indexed_triangle_set_wide(vertices, faces, tree, point, max_distance, true, hit_idx, hit_point);
+    return hit_point.allFinite();
+}
+
+} // namespace AABBTreeIndirect
+} // namespace Slic3r
+
+#endif /* slic3r_AABBTreeWide_hpp_ */
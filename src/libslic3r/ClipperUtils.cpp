@@ -2,6 +2,8 @@
 #include "Geometry.hpp"
 #include "ShortestPath.hpp"
 
+#include <memory>
+
 // #define CLIPPER_UTILS_DEBUG
 
 #ifdef CLIPPER_UTILS_DEBUG
@@ -23,6 +25,60 @@
 
 namespace Slic3r {
 
+namespace ClipperUtils {
+    // The Clipper engines keep their memory (edges, output points, scanbeam) when cleared.
+    // The engines are cached per thread and lent to the functions below, so that the many small Clipper operations
+    // on the slicing hot paths (PerimeterGenerator, ...) recycle the memory instead of going through the heap allocator.
+    // The cache is a stack, as the functions may nest.
+    template<typename Engine>
+    class EngineLease
+    {
+    public:
+        EngineLease() {
+            std::vector<std::unique_ptr<Engine>> &engines = EngineLease::cache();
+            if (engines.empty())
+                m_engine = std::make_unique<Engine>();
+            else {
+                m_engine = std::move(engines.back());
+                engines.pop_back();
+            }
+        }
+        ~EngineLease() {
+            reset(*m_engine);
+            EngineLease::cache().emplace_back(std::move(m_engine));
+        }
+        EngineLease(const EngineLease &) = delete;
+        EngineLease& operator=(const EngineLease &) = delete;
+
+        Engine& operator*()  { return *m_engine; }
+        Engine* operator->() { return m_engine.get(); }
+
+    private:
+        static std::vector<std::unique_ptr<Engine>>& cache() {
+            static thread_local std::vector<std::unique_ptr<Engine>> engines;
+            return engines;
+        }
+        // Clear the engine and restore the default parameters.
+        static void reset(ClipperLib::Clipper &clipper) {
+            clipper.Clear();
+            clipper.ReverseSolution(false);
+            clipper.StrictlySimple(false);
+            clipper.PreserveCollinear(false);
+        }
+        static void reset(ClipperLib::ClipperOffset &co) {
+            co.Clear();
+            co.MiterLimit         = 2.;
+            co.ArcTolerance       = 0.25;
+            co.ShortestEdgeLength = 0.;
+        }
+
+        std::unique_ptr<Engine> m_engine;
+    };
+
+    using ClipperLease       = EngineLease<ClipperLib::Clipper>;
+    using ClipperOffsetLease = EngineLease<ClipperLib::ClipperOffset>;
+}
+
 #ifdef CLIPPER_UTILS_DEBUG
 bool clipper_export_enabled = false;
 // For debugging the Clipper library, for providing bug reports to the Clipper author.
@@ -128,6 +184,7 @@ ExPolygons PolyTreeToExPolygons(ClipperLib::PolyTree& polytree)
 Slic3r::Polygon ClipperPath_to_Slic3rPolygon(const ClipperLib::Path &input)
 {
     Polygon retval;
+    retval.points.reserve(input.size());
     for (ClipperLib::Path::const_iterator pit = input.begin(); pit != input.end(); ++pit)
         retval.points.emplace_back(pit->X, pit->Y);
     return retval;
@@ -136,6 +193,7 @@ Slic3r::Polygon ClipperPath_to_Slic3rPolygon(const ClipperLib::Path &input)
 Slic3r::Polyline ClipperPath_to_Slic3rPolyline(const ClipperLib::Path &input)
 {
     Polyline retval;
+    retval.points.reserve(input.size());
     for (ClipperLib::Path::const_iterator pit = input.begin(); pit != input.end(); ++pit)
         retval.points.emplace_back(pit->X, pit->Y);
     return retval;
@@ -162,13 +220,12 @@ Slic3r::Polylines ClipperPaths_to_Slic3rPolylines(const ClipperLib::Paths &input
 ExPolygons ClipperPaths_to_Slic3rExPolygons(const ClipperLib::Paths &input)
 {
     // init Clipper
-    ClipperLib::Clipper clipper;
-    clipper.Clear();
+    ClipperUtils::ClipperLease clipper;
     
     // perform union
-    clipper.AddPaths(input, ClipperLib::ptSubject, true);
+    clipper->AddPaths(input, ClipperLib::ptSubject, true);
     ClipperLib::PolyTree polytree;
-    clipper.Execute(ClipperLib::ctUnion, polytree, ClipperLib::pftEvenOdd, ClipperLib::pftEvenOdd);  // offset results work with both EvenOdd and NonZero
+    clipper->Execute(ClipperLib::ctUnion, polytree, ClipperLib::pftEvenOdd, ClipperLib::pftEvenOdd);  // offset results work with both EvenOdd and NonZero
     
     // write to ExPolygons object
     return PolyTreeToExPolygons(polytree);
@@ -226,16 +283,16 @@ ClipperLib::Paths _offset(ClipperLib::Paths &&input, ClipperLib::EndType endType
     scaleClipperPolygons(input);
     
     // perform offset
-    ClipperLib::ClipperOffset co;
+    ClipperUtils::ClipperOffsetLease co;
     if (joinType == jtRound)
-        co.ArcTolerance = miterLimit;
+        co->ArcTolerance = miterLimit;
     else
-        co.MiterLimit = miterLimit;
+        co->MiterLimit = miterLimit;
     float delta_scaled = delta * float(CLIPPER_OFFSET_SCALE);
-    co.ShortestEdgeLength = double(std::abs(delta_scaled * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR));
-    co.AddPaths(input, joinType, endType);
+    co->ShortestEdgeLength = double(std::abs(delta_scaled * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR));
+    co->AddPaths(input, joinType, endType);
     ClipperLib::Paths retval;
-    co.Execute(retval, delta_scaled);
+    co->Execute(retval, delta_scaled);
     
     // unscale output
     unscaleClipperPolygons(retval);
@@ -262,14 +319,14 @@ ClipperLib::Paths _offset(const Slic3r::ExPolygon &expolygon, const float delta,
     {
         ClipperLib::Path input = Slic3rMultiPoint_to_ClipperPath(expolygon.contour);
         scaleClipperPolygon(input);
-        ClipperLib::ClipperOffset co;
+        ClipperUtils::ClipperOffsetLease co;
         if (joinType == jtRound)
-            co.ArcTolerance = miterLimit * double(CLIPPER_OFFSET_SCALE);
+            co->ArcTolerance = miterLimit * double(CLIPPER_OFFSET_SCALE);
         else
-            co.MiterLimit = miterLimit;
-        co.ShortestEdgeLength = double(std::abs(delta_scaled * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR));
-        co.AddPath(input, joinType, ClipperLib::etClosedPolygon);
-        co.Execute(contours, delta_scaled);
+            co->MiterLimit = miterLimit;
+        co->ShortestEdgeLength = double(std::abs(delta_scaled * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR));
+        co->AddPath(input, joinType, ClipperLib::etClosedPolygon);
+        co->Execute(contours, delta_scaled);
     }
 
     // 2) Offset the holes one by one, collect the results.
@@ -279,15 +336,15 @@ ClipperLib::Paths _offset(const Slic3r::ExPolygon &expolygon, const float delta,
         for (Polygons::const_iterator it_hole = expolygon.holes.begin(); it_hole != expolygon.holes.end(); ++ it_hole) {
             ClipperLib::Path input = Slic3rMultiPoint_to_ClipperPath_reversed(*it_hole);
             scaleClipperPolygon(input);
-            ClipperLib::ClipperOffset co;
+            ClipperUtils::ClipperOffsetLease co;
             if (joinType == jtRound)
-                co.ArcTolerance = miterLimit * double(CLIPPER_OFFSET_SCALE);
+                co->ArcTolerance = miterLimit * double(CLIPPER_OFFSET_SCALE);
             else
-                co.MiterLimit = miterLimit;
-            co.ShortestEdgeLength = double(std::abs(delta_scaled * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR));
-            co.AddPath(input, joinType, ClipperLib::etClosedPolygon);
+                co->MiterLimit = miterLimit;
+            co->ShortestEdgeLength = double(std::abs(delta_scaled * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR));
+            co->AddPath(input, joinType, ClipperLib::etClosedPolygon);
             ClipperLib::Paths out;
-            co.Execute(out, - delta_scaled);
+            co->Execute(out, - delta_scaled);
             holes.insert(holes.end(), out.begin(), out.end());
         }
     }
@@ -297,11 +354,10 @@ ClipperLib::Paths _offset(const Slic3r::ExPolygon &expolygon, const float delta,
     if (holes.empty()) {
         output = std::move(contours);
     } else {
-        ClipperLib::Clipper clipper;
-        clipper.Clear();
-        clipper.AddPaths(contours, ClipperLib::ptSubject, true);
-        clipper.AddPaths(holes, ClipperLib::ptClip, true);
-        clipper.Execute(ClipperLib::ctDifference, output, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+        ClipperUtils::ClipperLease clipper;
+        clipper->AddPaths(contours, ClipperLib::ptSubject, true);
+        clipper->AddPaths(holes, ClipperLib::ptClip, true);
+        clipper->Execute(ClipperLib::ctDifference, output, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
     }
     
     // 4) Unscale the output.
@@ -328,14 +384,14 @@ ClipperLib::Paths _offset(const Slic3r::ExPolygons &expolygons, const float delt
         {
             ClipperLib::Path input = Slic3rMultiPoint_to_ClipperPath(it_expoly->contour);
             scaleClipperPolygon(input);
-            ClipperLib::ClipperOffset co;
+            ClipperUtils::ClipperOffsetLease co;
             if (joinType == jtRound)
-                co.ArcTolerance = miterLimit * double(CLIPPER_OFFSET_SCALE);
+                co->ArcTolerance = miterLimit * double(CLIPPER_OFFSET_SCALE);
             else
-                co.MiterLimit = miterLimit;
-            co.ShortestEdgeLength = double(std::abs(delta_scaled * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR));
-            co.AddPath(input, joinType, ClipperLib::etClosedPolygon);
-            co.Execute(contours, delta_scaled);
+                co->MiterLimit = miterLimit;
+            co->ShortestEdgeLength = double(std::abs(delta_scaled * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR));
+            co->AddPath(input, joinType, ClipperLib::etClosedPolygon);
+            co->Execute(contours, delta_scaled);
         }
         if (contours.empty())
             // No need to try to offset the holes.
@@ -352,15 +408,15 @@ ClipperLib::Paths _offset(const Slic3r::ExPolygons &expolygons, const float delt
                 for (Polygons::const_iterator it_hole = it_expoly->holes.begin(); it_hole != it_expoly->holes.end(); ++ it_hole) {
                     ClipperLib::Path input = Slic3rMultiPoint_to_ClipperPath_reversed(*it_hole);
                     scaleClipperPolygon(input);
-                    ClipperLib::ClipperOffset co;
+                    ClipperUtils::ClipperOffsetLease co;
                     if (joinType == jtRound)
-                        co.ArcTolerance = miterLimit * double(CLIPPER_OFFSET_SCALE);
+                        co->ArcTolerance = miterLimit * double(CLIPPER_OFFSET_SCALE);
                     else
-                        co.MiterLimit = miterLimit;
-                    co.ShortestEdgeLength = double(std::abs(delta_scaled * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR));
-                    co.AddPath(input, joinType, ClipperLib::etClosedPolygon);
+                        co->MiterLimit = miterLimit;
+                    co->ShortestEdgeLength = double(std::abs(delta_scaled * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR));
+                    co->AddPath(input, joinType, ClipperLib::etClosedPolygon);
                     ClipperLib::Paths out;
-                    co.Execute(out, - delta_scaled);
+                    co->Execute(out, - delta_scaled);
                     holes.insert(holes.end(), out.begin(), out.end());
                 }
             }
@@ -373,12 +429,11 @@ ClipperLib::Paths _offset(const Slic3r::ExPolygons &expolygons, const float delt
             } else if (delta < 0) {
                 // Negative offset. There is a chance, that the offsetted hole intersects the outer contour. 
                 // Subtract the offsetted holes from the offsetted contours.
-                ClipperLib::Clipper clipper;
-                clipper.Clear();
-                clipper.AddPaths(contours, ClipperLib::ptSubject, true);
-                clipper.AddPaths(holes, ClipperLib::ptClip, true);
+                ClipperUtils::ClipperLease clipper;
+                clipper->AddPaths(contours, ClipperLib::ptSubject, true);
+                clipper->AddPaths(holes, ClipperLib::ptClip, true);
                 ClipperLib::Paths output;
-                clipper.Execute(ClipperLib::ctDifference, output, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+                clipper->Execute(ClipperLib::ctDifference, output, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
                 if (! output.empty()) {
                     contours_cummulative.insert(contours_cummulative.end(), output.begin(), output.end());
                     ++ expolygons_collected;
@@ -404,10 +459,9 @@ ClipperLib::Paths _offset(const Slic3r::ExPolygons &expolygons, const float delt
     ClipperLib::Paths output;
     if (expolygons_collected > 1 && delta > 0) {
         // There is a chance that the outwards offsetted expolygons may intersect. Perform a union.
-        ClipperLib::Clipper clipper;
-        clipper.Clear(); 
-        clipper.AddPaths(contours_cummulative, ClipperLib::ptSubject, true);
-        clipper.Execute(ClipperLib::ctUnion, output, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+        ClipperUtils::ClipperLease clipper;
+        clipper->AddPaths(contours_cummulative, ClipperLib::ptSubject, true);
+        clipper->Execute(ClipperLib::ctUnion, output, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
     } else {
         // Negative offset. The shrunk expolygons shall not mutually intersect. Just copy the output.
         output = std::move(contours_cummulative);
@@ -429,26 +483,26 @@ _offset2(const Polygons &polygons, const float delta1, const float delta2,
     scaleClipperPolygons(input);
     
     // prepare ClipperOffset object
-    ClipperLib::ClipperOffset co;
+    ClipperUtils::ClipperOffsetLease co;
     if (joinType == jtRound) {
-        co.ArcTolerance = miterLimit;
+        co->ArcTolerance = miterLimit;
     } else {
-        co.MiterLimit = miterLimit;
+        co->MiterLimit = miterLimit;
     }
     float delta_scaled1 = delta1 * float(CLIPPER_OFFSET_SCALE);
     float delta_scaled2 = delta2 * float(CLIPPER_OFFSET_SCALE);
-    co.ShortestEdgeLength = double(std::max(std::abs(delta_scaled1), std::abs(delta_scaled2)) * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR);
+    co->ShortestEdgeLength = double(std::max(std::abs(delta_scaled1), std::abs(delta_scaled2)) * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR);
     
     // perform first offset
     ClipperLib::Paths output1;
-    co.AddPaths(input, joinType, ClipperLib::etClosedPolygon);
-    co.Execute(output1, delta_scaled1);
+    co->AddPaths(input, joinType, ClipperLib::etClosedPolygon);
+    co->Execute(output1, delta_scaled1);
     
     // perform second offset
-    co.Clear();
-    co.AddPaths(output1, joinType, ClipperLib::etClosedPolygon);
+    co->Clear();
+    co->AddPaths(output1, joinType, ClipperLib::etClosedPolygon);
     ClipperLib::Paths retval;
-    co.Execute(retval, delta_scaled2);
+    co->Execute(retval, delta_scaled2);
     
     // unscale output
     unscaleClipperPolygons(retval);
@@ -490,37 +544,55 @@ ExPolygons offset2_ex(const ExPolygons &expolygons, const float delta1,
     return union_ex(polys);
 }
 
+// Add the subject and the clip to the Clipper engine.
+// Without the safety offset, the edges are initialized from the Slic3r points directly.
+// With the safety offset, the polygons to be offsetted are converted to ClipperLib::Paths first.
+template<class TSubj, class TClip>
+static void _clipper_add_paths(ClipperLib::Clipper &clipper, const ClipperLib::ClipType clipType,
+    const TSubj &subject, const TClip &clip, const bool subject_closed, const bool safety_offset_)
+{
+    if (safety_offset_ && clipType == ClipperLib::ctUnion) {
+        ClipperLib::Paths input_subject = Slic3rMultiPoints_to_ClipperPaths(subject);
+        safety_offset(&input_subject);
+        clipper.AddPaths(input_subject, ClipperLib::ptSubject, subject_closed);
+    } else
+        clipper.AddPaths(ClipperUtils::paths_provider(subject), ClipperLib::ptSubject, subject_closed);
+    if (safety_offset_ && clipType != ClipperLib::ctUnion) {
+        ClipperLib::Paths input_clip = Slic3rMultiPoints_to_ClipperPaths(clip);
+        safety_offset(&input_clip);
+        clipper.AddPaths(input_clip, ClipperLib::ptClip, true);
+    } else
+        clipper.AddPaths(ClipperUtils::paths_provider(clip), ClipperLib::ptClip, true);
+}
+
+static inline void _clipper_execute(ClipperLib::Clipper &clipper, const ClipperLib::ClipType clipType, ClipperLib::PolyTree &retval, const ClipperLib::PolyFillType fillType)
+{
+    clipper.Execute(clipType, retval, fillType, fillType);
+}
+
+// Store the Clipper output directly into Polygons, bypassing ClipperLib::Paths.
+static inline void _clipper_execute(ClipperLib::Clipper &clipper, const ClipperLib::ClipType clipType, Polygons &retval, const ClipperLib::PolyFillType fillType)
+{
+    clipper.ExecuteAndEmit(clipType, [&retval](const ClipperLib::OutPtRange &path) {
+        retval.emplace_back();
+        Points &pts = retval.back().points;
+        pts.reserve(path.size());
+        for (const ClipperLib::IntPoint &pt : path)
+            pts.emplace_back(pt.X, pt.Y);
+    }, fillType, fillType);
+}
+
 template<class T, class TSubj, class TClip>
 T _clipper_do(const ClipperLib::ClipType     clipType,
-              TSubj &&                        subject,
-              TClip &&                        clip,
+              const TSubj &                  subject,
+              const TClip &                  clip,
               const ClipperLib::PolyFillType fillType,
               const bool                     safety_offset_)
 {
-    // read input
-    ClipperLib::Paths input_subject = Slic3rMultiPoints_to_ClipperPaths(std::forward<TSubj>(subject));
-    ClipperLib::Paths input_clip    = Slic3rMultiPoints_to_ClipperPaths(std::forward<TClip>(clip));
-    
-    // perform safety offset
-    if (safety_offset_) {
-        if (clipType == ClipperLib::ctUnion) {
-            safety_offset(&input_subject);
-        } else {
-            safety_offset(&input_clip);
-        }
-    }
-    
-    // init Clipper
-    ClipperLib::Clipper clipper;
-    clipper.Clear();
-    
-    // add polygons
-    clipper.AddPaths(input_subject, ClipperLib::ptSubject, true);
-    clipper.AddPaths(input_clip,    ClipperLib::ptClip,    true);
-    
-    // perform operation
+    ClipperUtils::ClipperLease clipper;
+    _clipper_add_paths(*clipper, clipType, subject, clip, true, safety_offset_);
     T retval;
-    clipper.Execute(clipType, retval, fillType, fillType);
+    _clipper_execute(*clipper, clipType, retval, fillType);
     return retval;
 }
 
@@ -534,26 +606,18 @@ T _clipper_do(const ClipperLib::ClipType     clipType,
 inline ClipperLib::PolyTree _clipper_do_polytree2(const ClipperLib::ClipType clipType, const Polygons &subject, 
     const Polygons &clip, const ClipperLib::PolyFillType fillType, const bool safety_offset_)
 {
-    // read input
-    ClipperLib::Paths input_subject = Slic3rMultiPoints_to_ClipperPaths(subject);
-    ClipperLib::Paths input_clip    = Slic3rMultiPoints_to_ClipperPaths(clip);
-    
-    // perform safety offset
-    if (safety_offset_)
-        safety_offset((clipType == ClipperLib::ctUnion) ? &input_subject : &input_clip);
-    
-    ClipperLib::Clipper clipper;
-    clipper.AddPaths(input_subject, ClipperLib::ptSubject, true);
-    clipper.AddPaths(input_clip,    ClipperLib::ptClip,    true);
-    // Perform the operation with the output to input_subject.
+    ClipperUtils::ClipperLease clipper;
+    _clipper_add_paths(*clipper, clipType, subject, clip, true, safety_offset_);
+    // Perform the operation with the output to Paths.
     // This pass does not generate a PolyTree, which is a very expensive operation with the current Clipper library
     // if there are overapping edges.
-    clipper.Execute(clipType, input_subject, fillType, fillType);
+    ClipperLib::Paths output;
+    clipper->Execute(clipType, output, fillType, fillType);
     // Perform an additional Union operation to generate the PolyTree ordering.
-    clipper.Clear();
-    clipper.AddPaths(input_subject, ClipperLib::ptSubject, true);
+    clipper->Clear();
+    clipper->AddPaths(output, ClipperLib::ptSubject, true);
     ClipperLib::PolyTree retval;
-    clipper.Execute(ClipperLib::ctUnion, retval, fillType, fillType);
+    clipper->Execute(ClipperLib::ctUnion, retval, fillType, fillType);
     return retval;
 }
 
@@ -561,30 +625,19 @@ ClipperLib::PolyTree _clipper_do_pl(const ClipperLib::ClipType clipType, const P
     const Polygons &clip, const ClipperLib::PolyFillType fillType,
     const bool safety_offset_)
 {
-    // read input
-    ClipperLib::Paths input_subject = Slic3rMultiPoints_to_ClipperPaths(subject);
-    ClipperLib::Paths input_clip    = Slic3rMultiPoints_to_ClipperPaths(clip);
-    
-    // perform safety offset
-    if (safety_offset_) safety_offset(&input_clip);
-    
-    // init Clipper
-    ClipperLib::Clipper clipper;
-    clipper.Clear();
-    
-    // add polygons
-    clipper.AddPaths(input_subject, ClipperLib::ptSubject, false);
-    clipper.AddPaths(input_clip,    ClipperLib::ptClip,    true);
+    // add polygons, perform the safety offset of the clip polygons
+    ClipperUtils::ClipperLease clipper;
+    _clipper_add_paths(*clipper, clipType, subject, clip, false, safety_offset_);
     
     // perform operation
     ClipperLib::PolyTree retval;
-    clipper.Execute(clipType, retval, fillType, fillType);
+    clipper->Execute(clipType, retval, fillType, fillType);
     return retval;
 }
 
 Polygons _clipper(ClipperLib::ClipType clipType, const Polygons &subject, const Polygons &clip, bool safety_offset_)
 {
-    return ClipperPaths_to_Slic3rPolygons(_clipper_do<ClipperLib::Paths>(clipType, subject, clip, ClipperLib::pftNonZero, safety_offset_));
+    return _clipper_do<Polygons>(clipType, subject, clip, ClipperLib::pftNonZero, safety_offset_);
 }
 
 ExPolygons _clipper_ex(ClipperLib::ClipType clipType, const Polygons &subject, const Polygons &clip, bool safety_offset_)
@@ -595,9 +648,14 @@ ExPolygons _clipper_ex(ClipperLib::ClipType clipType, const Polygons &subject, c
 
 Polylines _clipper_pl(ClipperLib::ClipType clipType, const Polylines &subject, const Polygons &clip, bool safety_offset_)
 {
-    ClipperLib::Paths output;
-    ClipperLib::PolyTreeToPaths(_clipper_do_pl(clipType, subject, clip, ClipperLib::pftNonZero, safety_offset_), output);
-    return ClipperPaths_to_Slic3rPolylines(output);
+    ClipperLib::PolyTree polytree = _clipper_do_pl(clipType, subject, clip, ClipperLib::pftNonZero, safety_offset_);
+    // Depth first traversal, the same order as ClipperLib::PolyTreeToPaths() produces.
+    Polylines retval;
+    retval.reserve(polytree.Total());
+    for (const ClipperLib::PolyNode *node = polytree.GetFirst(); node != nullptr; node = node->GetNext())
+        if (! node->Contour.empty())
+            retval.emplace_back(ClipperPath_to_Slic3rPolyline(node->Contour));
+    return retval;
 }
 
 Polylines _clipper_pl(ClipperLib::ClipType clipType, const Polygons &subject, const Polygons &clip, bool safety_offset_)
@@ -680,12 +738,12 @@ ClipperLib::PolyTree union_pt(const ExPolygons &subject, bool safety_offset_)
 
 ClipperLib::PolyTree union_pt(Polygons &&subject, bool safety_offset_)
 {
-    return _clipper_do<ClipperLib::PolyTree>(ClipperLib::ctUnion, std::move(subject), Polygons(), ClipperLib::pftEvenOdd, safety_offset_);
+    return _clipper_do<ClipperLib::PolyTree>(ClipperLib::ctUnion, subject, Polygons(), ClipperLib::pftEvenOdd, safety_offset_);
 }
 
 ClipperLib::PolyTree union_pt(ExPolygons &&subject, bool safety_offset_)
 {
-    return _clipper_do<ClipperLib::PolyTree>(ClipperLib::ctUnion, std::move(subject), Polygons(), ClipperLib::pftEvenOdd, safety_offset_);
+    return _clipper_do<ClipperLib::PolyTree>(ClipperLib::ctUnion, subject, Polygons(), ClipperLib::pftEvenOdd, safety_offset_);
 }
 
 // Simple spatial ordering of Polynodes
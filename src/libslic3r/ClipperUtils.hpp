@@ -26,6 +26,79 @@ using ClipperLib::jtSquare;
 
 namespace Slic3r {
 
+namespace ClipperUtils {
+    // Adaptors presenting the Slic3r polygons / polylines / expolygons to ClipperLib::ClipperBase::AddPaths()
+    // as a range of Points, so that the Clipper edges are initialized directly from the Slic3r point storage
+    // without converting the input to ClipperLib::Paths first.
+    template<typename MultiPointsType>
+    class MultiPointsProvider
+    {
+    public:
+        MultiPointsProvider(const MultiPointsType &multipoints) : m_multipoints(multipoints) {}
+
+        class iterator
+        {
+        public:
+            explicit iterator(typename MultiPointsType::const_iterator it) : m_it(it) {}
+            const Points& operator*() const { return m_it->points; }
+            const Points* operator->() const { return &m_it->points; }
+            bool operator==(const iterator &rhs) const { return m_it == rhs.m_it; }
+            bool operator!=(const iterator &rhs) const { return m_it != rhs.m_it; }
+            iterator& operator++() { ++ m_it; return *this; }
+        private:
+            typename MultiPointsType::const_iterator m_it;
+        };
+
+        iterator begin() const { return iterator(m_multipoints.cbegin()); }
+        iterator end()   const { return iterator(m_multipoints.cend()); }
+        size_t   size()  const { return m_multipoints.size(); }
+
+    private:
+        const MultiPointsType &m_multipoints;
+    };
+
+    using PolygonsProvider  = MultiPointsProvider<Polygons>;
+    using PolylinesProvider = MultiPointsProvider<Polylines>;
+
+    // Provides the contour followed by the holes of each ExPolygon.
+    class ExPolygonsProvider
+    {
+    public:
+        ExPolygonsProvider(const ExPolygons &expolygons) : m_expolygons(expolygons) {}
+
+        class iterator
+        {
+        public:
+            explicit iterator(ExPolygons::const_iterator it) : m_it(it), m_idx_contour(0) {}
+            const Points& operator*() const { return m_idx_contour == 0 ? m_it->contour.points : m_it->holes[m_idx_contour - 1].points; }
+            const Points* operator->() const { return &this->operator*(); }
+            bool operator==(const iterator &rhs) const { return m_it == rhs.m_it && m_idx_contour == rhs.m_idx_contour; }
+            bool operator!=(const iterator &rhs) const { return ! (*this == rhs); }
+            iterator& operator++() {
+                if (++ m_idx_contour > m_it->holes.size()) {
+                    ++ m_it;
+                    m_idx_contour = 0;
+                }
+                return *this;
+            }
+        private:
+            ExPolygons::const_iterator m_it;
+            // 0 for the contour, i + 1 for the i-th hole.
+            size_t                     m_idx_contour;
+        };
+
+        iterator begin() const { return iterator(m_expolygons.cbegin()); }
+        iterator end()   const { return iterator(m_expolygons.cend()); }
+
+    private:
+        const ExPolygons &m_expolygons;
+    };
+
+    inline PolygonsProvider   paths_provider(const Polygons &polygons)     { return PolygonsProvider(polygons); }
+    inline PolylinesProvider  paths_provider(const Polylines &polylines)   { return PolylinesProvider(polylines); }
+    inline ExPolygonsProvider paths_provider(const ExPolygons &expolygons) { return ExPolygonsProvider(expolygons); }
+}
+
 //-----------------------------------------------------------
 // legacy code from Clipper documentation
 void AddOuterPolyNodeToExPolygons(ClipperLib::PolyNode& polynode, Slic3r::ExPolygons *expolygons);
@@ -2,7 +2,7 @@
 #include "../ExPolygon.hpp"
 #include "../Surface.hpp"
 #include "../Geometry.hpp"
-#include "../AABBTreeIndirect.hpp"
+#include "../AABBTreeWide.hpp"
 #include "../Layer.hpp"
 #include "../Print.hpp"
 #include "../ShortestPath.hpp"
@@ -304,7 +304,7 @@ std::unique_ptr<FillAdaptive_Internal::Octree> FillAdaptive::build_octree(
     Vec3d rotation = Vec3d((5.0 * M_PI) / 4.0, Geometry::deg2rad(215.264), M_PI / 6.0);
     Transform3d rotation_matrix = Geometry::assemble_transform(Vec3d::Zero(), rotation, Vec3d::Ones(), Vec3d::Ones());
 
-    AABBTreeIndirect::Tree3f aabbTree = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(
+    AABBTreeIndirect::WideTree4f aabbTree = AABBTreeIndirect::build_wide_aabb_tree_over_indexed_triangle_set(
             triangle_mesh.its.vertices, triangle_mesh.its.indices);
     auto octree = std::make_unique<Octree>(std::make_unique<Cube>(cube_center), cube_center, cubes_properties);
 
@@ -317,7 +317,7 @@ void FillAdaptive::expand_cube(
     FillAdaptive_Internal::Cube *cube,
     const std::vector<FillAdaptive_Internal::CubeProperties> &cubes_properties,
     const Transform3d &rotation_matrix,
-    const AABBTreeIndirect::Tree3f &distance_tree,
+    const AABBTreeIndirect::WideTree4f &distance_tree,
     const TriangleMesh &triangle_mesh, int depth)
 {
     using namespace FillAdaptive_Internal;
@@ -1,7 +1,7 @@
 #ifndef slic3r_FillAdaptive_hpp_
 #define slic3r_FillAdaptive_hpp_
 
-#include "../AABBTreeIndirect.hpp"
+#include "../AABBTreeWide.hpp"
 
 #include "FillBase.hpp"
 
@@ -78,10 +78,10 @@ public:
     static void expand_cube(
         FillAdaptive_Internal::Cube *cube,
         const std::vector<FillAdaptive_Internal::CubeProperties> &cubes_properties,
-        const Transform3d &             rotation_matrix,
-        const AABBTreeIndirect::Tree3f &distance_tree,
-        const TriangleMesh &            triangle_mesh,
-        int                             depth);
+        const Transform3d &                 rotation_matrix,
+        const AABBTreeIndirect::WideTree4f &distance_tree,
+        const TriangleMesh &                triangle_mesh,
+        int                                 depth);
 };
 
 // Calculate line spacing for
@@ -10,6 +10,7 @@
 
 #include "3mf.hpp"
 
+#include <algorithm>
 #include <limits>
 #include <stdexcept>
 
@@ -30,6 +31,9 @@ namespace pt = boost::property_tree;
 #include <Eigen/Dense>
 #include "miniz_extension.hpp"
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 // VERSION NUMBERS
 // 0 : .3mf, files saved by older slic3r or other applications. No version definition in them.
 // 1 : Introduction of 3mf versioning. No other change in data saved into 3mf files.
@@ -153,7 +157,7 @@ std::string get_attribute_value_string(const char** attributes, unsigned int att
 float get_attribute_value_float(const char** attributes, unsigned int attributes_size, const char* attribute_key)
 {
     const char* text = get_attribute_value_charptr(attributes, attributes_size, attribute_key);
-    return (text != nullptr) ? (float)::atof(text) : 0.0f;
+    return (text != nullptr) ? (float)Slic3r::string_to_double_decimal_point(text) : 0.0f;
 }
 
 int get_attribute_value_int(const char** attributes, unsigned int attributes_size, const char* attribute_key)
@@ -193,7 +197,7 @@ Slic3r::Transform3d get_transform_from_3mf_specs_string(const std::string& mat_s
     {
         for (unsigned int r = 0; r < 3; ++r)
         {
-            ret(r, c) = ::atof(mat_elements_str[i++].c_str());
+            ret(r, c) = Slic3r::string_to_double_decimal_point(mat_elements_str[i++].c_str());
         }
     }
     return ret;
@@ -233,6 +237,82 @@ bool is_valid_object_type(const std::string& type)
     return false;
 }
 
+static void append_uint(std::string& out, unsigned int n)
+{
+    char buf[16];
+    char* end = buf + sizeof(buf);
+    char* ptr = end;
+    do {
+        *(--ptr) = char('0' + n % 10);
+        n /= 10;
+    } while (n > 0);
+    out.append(ptr, end);
+}
+
+// Appends the number formatted the same way as printf("%.9g"), which is the way a std::ostream with the precision
+// of std::numeric_limits<float>::max_digits10 formats it. Nine significant digits are enough for a float to survive
+// the conversion to text and back.
+// The fast path covers the numbers printed in the fixed notation: the number is scaled to a nine digit integer,
+// which is rounded correctly unless the fraction is close to a tie. Ties, the numbers printed in the exponential
+// notation, infinities and NaNs are left to the C library.
+static void append_float(std::string& out, double v)
+{
+    static constexpr const double   pow10d[] = { 1., 10., 100., 1000., 10000., 100000., 1000000., 10000000., 100000000., 1000000000., 10000000000., 100000000000., 1000000000000. };
+    static constexpr const uint64_t pow10i[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000, 10000000000, 100000000000, 1000000000000 };
+
+    double a = std::abs(v);
+    if (a == 0.) {
+        out += std::signbit(v) ? "-0" : "0";
+        return;
+    }
+    if (a >= 1e-4 && a < 1e9) {
+        // Number of the decimal digits, such that a * 10^digits has nine integer digits.
+        // log10() may be off by one close to the powers of ten.
+        int    digits = std::clamp(8 - int(std::floor(std::log10(a))), 0, 12);
+        double scaled = a * pow10d[digits];
+        if (scaled < 1e8 && digits < 12)
+            scaled = a * pow10d[++ digits];
+        else if (scaled >= 1e9 && digits > 0)
+            scaled = a * pow10d[-- digits];
+        double ipart = std::floor(scaled);
+        double frac  = scaled - ipart;
+        if (scaled >= 1e8 && scaled < 1e9 && std::abs(frac - 0.5) > scaled * 4.5e-16) {
+            uint64_t n = uint64_t(ipart) + (frac > 0.5);
+            if (n == 1000000000) {
+                // Rounded up to the next power of ten.
+                n /= 10;
+                -- digits;
+            }
+            if (digits >= 0) {
+                uint64_t ip = n / pow10i[digits];
+                uint64_t fp = n % pow10i[digits];
+                // %g strips the trailing zeros.
+                for (; digits > 0 && fp % 10 == 0; -- digits)
+                    fp /= 10;
+                char  buf[32];
+                char* end = buf + sizeof(buf);
+                char* ptr = end;
+                for (int i = 0; i < digits; ++i, fp /= 10)
+                    *(--ptr) = char('0' + fp % 10);
+                if (digits > 0)
+                    *(--ptr) = '.';
+                do {
+                    *(--ptr) = char('0' + ip % 10);
+                    ip /= 10;
+                } while (ip > 0);
+                if (v < 0.)
+                    *(--ptr) = '-';
+                out.append(ptr, end);
+                return;
+            }
+        }
+    }
+
+    char buf[64];
+    int  len = ::snprintf(buf, sizeof(buf), "%.9g", v);
+    out.append(buf, size_t(len));
+}
+
 namespace Slic3r {
 
 //! macro used to mark string used at localization,
@@ -285,8 +365,9 @@ namespace Slic3r {
         {
             std::vector<float> vertices;
             std::vector<unsigned int> triangles;
-            std::vector<std::string> custom_supports;
-            std::vector<std::string> custom_seam;
+            // Only the triangles with custom supports or seams are stored, indexed by the triangle index, in ascending order.
+            std::vector<std::pair<unsigned int, std::string>> custom_supports;
+            std::vector<std::pair<unsigned int, std::string>> custom_seam;
 
             bool empty()
             {
@@ -499,7 +580,19 @@ namespace Slic3r {
         bool _handle_start_config_metadata(const char** attributes, unsigned int num_attributes);
         bool _handle_end_config_metadata();
 
-        bool _generate_volumes(ModelObject& object, const Geometry& geometry, const ObjectMetadata::VolumeMetadataList& volumes);
+        // The volumes of an object and their meshes, which are built from the object's geometry in parallel with the other objects.
+        struct ObjectVolumes
+        {
+            ModelObject* object;
+            const Geometry* geometry;
+            ObjectMetadata::VolumeMetadataList volumes;
+            std::vector<TriangleMesh> meshes;
+            std::vector<TriangleMesh> convex_hulls;
+        };
+
+        bool _check_volumes(const ModelObject& object, const Geometry& geometry, const ObjectMetadata::VolumeMetadataList& volumes);
+        static TriangleMesh _build_volume_mesh(const Geometry& geometry, const ObjectMetadata::VolumeMetadata& volume_data);
+        bool _generate_volumes(ObjectVolumes& object_volumes);
 
         // callbacks to parse the .model file
         static void XMLCALL _handle_start_model_xml_element(void* userData, const char* name, const char** attributes);
@@ -666,6 +759,8 @@ namespace Slic3r {
 
         close_zip_reader(&archive);
 
+        std::vector<ObjectVolumes> objects_volumes;
+        objects_volumes.reserve(m_objects.size());
         for (const IdToModelObjectMap::value_type& object : m_objects)
         {
             ModelObject *model_object = m_model->objects[object.second];
@@ -729,7 +824,39 @@ namespace Slic3r {
                 volumes_ptr = &volumes;
             }
 
-            if (!_generate_volumes(*model_object, obj_geometry->second, *volumes_ptr))
+            if (!_check_volumes(*model_object, obj_geometry->second, *volumes_ptr))
+                return false;
+
+            objects_volumes.push_back({ model_object, &obj_geometry->second, *volumes_ptr });
+        }
+
+        // Build the meshes of all the volumes of all the objects in parallel, as repairing them
+        // and calculating their convex hulls is the most expensive part of the import.
+        std::vector<std::pair<size_t, size_t>> volumes_ids;
+        for (size_t i = 0; i < objects_volumes.size(); ++i)
+        {
+            ObjectVolumes& object_volumes = objects_volumes[i];
+            object_volumes.meshes.resize(object_volumes.volumes.size());
+            object_volumes.convex_hulls.resize(object_volumes.volumes.size());
+            for (size_t j = 0; j < object_volumes.volumes.size(); ++j)
+                volumes_ids.emplace_back(i, j);
+        }
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, volumes_ids.size(), 1),
+            [&objects_volumes, &volumes_ids](const tbb::blocked_range<size_t>& range) {
+                for (size_t k = range.begin(); k < range.end(); ++k)
+                {
+                    ObjectVolumes& object_volumes = objects_volumes[volumes_ids[k].first];
+                    size_t j = volumes_ids[k].second;
+                    TriangleMesh& mesh = object_volumes.meshes[j];
+                    mesh = _build_volume_mesh(*object_volumes.geometry, object_volumes.volumes[j]);
+                    mesh.repair();
+                    object_volumes.convex_hulls[j] = mesh.convex_hull_3d();
+                }
+            });
+
+        for (ObjectVolumes& object_volumes : objects_volumes)
+        {
+            if (!_generate_volumes(object_volumes))
                 return false;
         }
 
@@ -1555,8 +1682,13 @@ namespace Slic3r {
         m_curr_object.geometry.triangles.push_back((unsigned int)get_attribute_value_int(attributes, num_attributes, V2_ATTR));
         m_curr_object.geometry.triangles.push_back((unsigned int)get_attribute_value_int(attributes, num_attributes, V3_ATTR));
 
-        m_curr_object.geometry.custom_supports.push_back(get_attribute_value_string(attributes, num_attributes, CUSTOM_SUPPORTS_ATTR));
-        m_curr_object.geometry.custom_seam.push_back(get_attribute_value_string(attributes, num_attributes, CUSTOM_SEAM_ATTR));
+        unsigned int triangle_id = (unsigned int)m_curr_object.geometry.triangles.size() / 3 - 1;
+        const char* custom_supports = get_attribute_value_charptr(attributes, num_attributes, CUSTOM_SUPPORTS_ATTR);
+        if (custom_supports != nullptr && *custom_supports != 0)
+            m_curr_object.geometry.custom_supports.emplace_back(triangle_id, custom_supports);
+        const char* custom_seam = get_attribute_value_charptr(attributes, num_attributes, CUSTOM_SEAM_ATTR);
+        if (custom_seam != nullptr && *custom_seam != 0)
+            m_curr_object.geometry.custom_seam.emplace_back(triangle_id, custom_seam);
         return true;
     }
 
@@ -1828,7 +1960,7 @@ namespace Slic3r {
         return true;
     }
 
-    bool _3MF_Importer::_generate_volumes(ModelObject& object, const Geometry& geometry, const ObjectMetadata::VolumeMetadataList& volumes)
+    bool _3MF_Importer::_check_volumes(const ModelObject& object, const Geometry& geometry, const ObjectMetadata::VolumeMetadataList& volumes)
     {
         if (!object.volumes.empty())
         {
@@ -1845,6 +1977,47 @@ namespace Slic3r {
                 add_error("Found invalid triangle id");
                 return false;
             }
+        }
+
+        return true;
+    }
+
+    TriangleMesh _3MF_Importer::_build_volume_mesh(const Geometry& geometry, const ObjectMetadata::VolumeMetadata& volume_data)
+    {
+        // splits volume out of imported geometry
+        TriangleMesh triangle_mesh;
+        stl_file    &stl             = triangle_mesh.stl;
+        unsigned int triangles_count = volume_data.last_triangle_id - volume_data.first_triangle_id + 1;
+        stl.stats.type = inmemory;
+        stl.stats.number_of_facets = (uint32_t)triangles_count;
+        stl.stats.original_num_facets = (int)stl.stats.number_of_facets;
+        stl_allocate(&stl);
+
+        unsigned int src_start_id = volume_data.first_triangle_id * 3;
+
+        for (unsigned int i = 0; i < triangles_count; ++i)
+        {
+            unsigned int ii = i * 3;
+            stl_facet& facet = stl.facet_start[i];
+            for (unsigned int v = 0; v < 3; ++v)
+            {
+                unsigned int tri_id = geometry.triangles[src_start_id + ii + v] * 3;
+                facet.vertex[v] = Vec3f(geometry.vertices[tri_id + 0], geometry.vertices[tri_id + 1], geometry.vertices[tri_id + 2]);
+            }
+        }
+
+        stl_get_size(&stl);
+        return triangle_mesh;
+    }
+
+    bool _3MF_Importer::_generate_volumes(ObjectVolumes& object_volumes)
+    {
+        ModelObject& object = *object_volumes.object;
+        const Geometry& geometry = *object_volumes.geometry;
+
+        for (size_t j = 0; j < object_volumes.volumes.size(); ++j)
+        {
+            const ObjectMetadata::VolumeMetadata& volume_data = object_volumes.volumes[j];
 
             Transform3d volume_matrix_to_object = Transform3d::Identity();
             bool        has_transform 		    = false;
@@ -1859,48 +2032,21 @@ namespace Slic3r {
                 }
             }
 
-            // splits volume out of imported geometry
-			TriangleMesh triangle_mesh;
-            stl_file    &stl             = triangle_mesh.stl;
-			unsigned int triangles_count = volume_data.last_triangle_id - volume_data.first_triangle_id + 1;
-			stl.stats.type = inmemory;
-            stl.stats.number_of_facets = (uint32_t)triangles_count;
-            stl.stats.original_num_facets = (int)stl.stats.number_of_facets;
-            stl_allocate(&stl);
-
-            unsigned int src_start_id = volume_data.first_triangle_id * 3;
-
-            for (unsigned int i = 0; i < triangles_count; ++i)
-            {
-                unsigned int ii = i * 3;
-                stl_facet& facet = stl.facet_start[i];
-                for (unsigned int v = 0; v < 3; ++v)
-                {
-                    unsigned int tri_id = geometry.triangles[src_start_id + ii + v] * 3;
-                    facet.vertex[v] = Vec3f(geometry.vertices[tri_id + 0], geometry.vertices[tri_id + 1], geometry.vertices[tri_id + 2]);
-                }
-            }
-
-			stl_get_size(&stl);
-			triangle_mesh.repair();
-
-			ModelVolume* volume = object.add_volume(std::move(triangle_mesh));
+            // the mesh has been built, repaired and its convex hull calculated by _load_model_from_file()
+            ModelVolume* volume = object.add_volume(std::move(object_volumes.meshes[j]), std::move(object_volumes.convex_hulls[j]));
             // stores the volume matrix taken from the metadata, if present
             if (has_transform)
                 volume->source.transform = Slic3r::Geometry::Transformation(volume_matrix_to_object);
-            volume->calculate_convex_hull();
 
             // recreate custom supports and seam from previously loaded attribute
-            for (unsigned i=0; i<triangles_count; ++i) {
-                size_t index = src_start_id/3 + i;
-                assert(index < geometry.custom_supports.size());
-                assert(index < geometry.custom_seam.size());
-                if (! geometry.custom_supports[index].empty())
-                    volume->m_supported_facets.set_triangle_from_string(i, geometry.custom_supports[index]);
-                if (! geometry.custom_seam[index].empty())
-                    volume->m_seam_facets.set_triangle_from_string(i, geometry.custom_seam[index]);
-            }
-
+            auto first_triangle = [&volume_data](const std::vector<std::pair<unsigned int, std::string>>& data) {
+                return std::lower_bound(data.begin(), data.end(), volume_data.first_triangle_id,
+                    [](const std::pair<unsigned int, std::string>& item, unsigned int id) { return item.first < id; });
+            };
+            for (auto it = first_triangle(geometry.custom_supports); it != geometry.custom_supports.end() && it->first <= volume_data.last_triangle_id; ++it)
+                volume->m_supported_facets.set_triangle_from_string(int(it->first - volume_data.first_triangle_id), it->second);
+            for (auto it = first_triangle(geometry.custom_seam); it != geometry.custom_seam.end() && it->first <= volume_data.last_triangle_id; ++it)
+                volume->m_seam_facets.set_triangle_from_string(int(it->first - volume_data.first_triangle_id), it->second);
 
             // apply the remaining volume's metadata
             for (const Metadata& metadata : volume_data.metadata)
@@ -2012,6 +2158,34 @@ namespace Slic3r {
         typedef std::vector<BuildItem> BuildItemsList;
         typedef std::map<int, ObjectData> IdToObjectDataMap;
 
+        // A piece of the model file: a text followed by the vertices or the triangles <begin, end) of a ModelVolume.
+        // The chunks are converted to XML and compressed in parallel, a few of them at a time.
+        struct ModelFileChunk
+        {
+            std::string text;
+            const ModelVolume* volume{ nullptr };
+            bool triangles{ false };
+            // Index of the 1st vertex of the volume in the indexed triangle set of the 3MF object.
+            unsigned int first_vertex_id{ 0 };
+            size_t begin{ 0 };
+            size_t end{ 0 };
+            // Transformation of the vertices, copied serially: ModelVolume::get_matrix() updates a cache, thus it must not be called
+            // by the parallel conversion of the chunks.
+            Transform3d matrix{ Transform3d::Identity() };
+        };
+
+        struct ModelFileChunks
+        {
+            std::vector<ModelFileChunk> chunks;
+            // Text to be written before the next range of vertices or triangles.
+            std::string text;
+
+            void add_range(const ModelVolume* volume, bool triangles, unsigned int first_vertex_id, size_t count);
+            // Closes the list by a chunk with the remaining text.
+            void finish();
+            void append_chunk_xml(size_t idx, std::string& out) const;
+        };
+
         bool m_fullpath_sources{ true };
 
     public:
@@ -2023,9 +2197,9 @@ namespace Slic3r {
         bool _add_thumbnail_file_to_archive(mz_zip_archive& archive, const ThumbnailData& thumbnail_data);
         bool _add_relationships_file_to_archive(mz_zip_archive& archive);
         bool _add_model_file_to_archive(const std::string& filename, mz_zip_archive& archive, const Model& model, IdToObjectDataMap& objects_data);
-        bool _add_object_to_model_stream(std::stringstream& stream, unsigned int& object_id, ModelObject& object, BuildItemsList& build_items, VolumeToOffsetsMap& volumes_offsets);
-        bool _add_mesh_to_object_stream(std::stringstream& stream, ModelObject& object, VolumeToOffsetsMap& volumes_offsets);
-        bool _add_build_to_model_stream(std::stringstream& stream, const BuildItemsList& build_items);
+        bool _add_object_to_model_chunks(ModelFileChunks& chunks, unsigned int& object_id, ModelObject& object, BuildItemsList& build_items, VolumeToOffsetsMap& volumes_offsets);
+        bool _add_mesh_to_object_chunks(ModelFileChunks& chunks, ModelObject& object, VolumeToOffsetsMap& volumes_offsets);
+        bool _add_build_to_model_chunks(ModelFileChunks& chunks, const BuildItemsList& build_items);
         bool _add_layer_height_profile_file_to_archive(mz_zip_archive& archive, Model& model);
         bool _add_layer_config_ranges_file_to_archive(mz_zip_archive& archive, Model& model);
         bool _add_sla_support_points_file_to_archive(mz_zip_archive& archive, Model& model);
@@ -2234,31 +2408,117 @@ namespace Slic3r {
         return true;
     }
 
+    // Number of the vertices or triangles written into a single chunk of the model file, about 2 MB of XML.
+    static constexpr size_t MODEL_FILE_CHUNK_SIZE = 32768;
+
+    void _3MF_Exporter::ModelFileChunks::add_range(const ModelVolume* volume, bool triangles, unsigned int first_vertex_id, size_t count)
+    {
+        const Transform3d matrix = triangles ? Transform3d::Identity() : volume->get_matrix();
+        for (size_t begin = 0; begin < count; begin += MODEL_FILE_CHUNK_SIZE)
+        {
+            ModelFileChunk chunk;
+            chunk.text = std::move(text);
+            chunk.volume = volume;
+            chunk.triangles = triangles;
+            chunk.first_vertex_id = first_vertex_id;
+            chunk.begin = begin;
+            chunk.end = std::min(count, begin + MODEL_FILE_CHUNK_SIZE);
+            chunk.matrix = matrix;
+            chunks.emplace_back(std::move(chunk));
+            text.clear();
+        }
+    }
+
+    void _3MF_Exporter::ModelFileChunks::finish()
+    {
+        ModelFileChunk chunk;
+        chunk.text = std::move(text);
+        chunks.emplace_back(std::move(chunk));
+        text.clear();
+    }
+
+    void _3MF_Exporter::ModelFileChunks::append_chunk_xml(size_t idx, std::string& out) const
+    {
+        const ModelFileChunk& chunk = chunks[idx];
+        out += chunk.text;
+        if (chunk.volume == nullptr)
+            return;
+
+        const indexed_triangle_set& its = chunk.volume->mesh().its;
+        if (!chunk.triangles)
+        {
+            for (size_t i = chunk.begin; i < chunk.end; ++i)
+            {
+                Vec3f v = (chunk.matrix * its.vertices[i].cast<double>()).cast<float>();
+                out += "     <";
+                out += VERTEX_TAG;
+                out += " x=\"";
+                append_float(out, v(0));
+                out += "\" y=\"";
+                append_float(out, v(1));
+                out += "\" z=\"";
+                append_float(out, v(2));
+                out += "\" />\n";
+            }
+        }
+        else
+        {
+            for (size_t i = chunk.begin; i < chunk.end; ++i)
+            {
+                out += "     <";
+                out += TRIANGLE_TAG;
+                for (int j = 0; j < 3; ++j)
+                {
+                    out += " v";
+                    out += char('1' + j);
+                    out += "=\"";
+                    append_uint(out, its.indices[i][j] + chunk.first_vertex_id);
+                    out += "\"";
+                }
+                out += " ";
+
+                std::string custom_supports_data_string = chunk.volume->m_supported_facets.get_triangle_as_string(i);
+                if (!custom_supports_data_string.empty())
+                {
+                    out += CUSTOM_SUPPORTS_ATTR;
+                    out += "=\"" + custom_supports_data_string + "\" ";
+                }
+
+                std::string custom_seam_data_string = chunk.volume->m_seam_facets.get_triangle_as_string(i);
+                if (!custom_seam_data_string.empty())
+                {
+                    out += CUSTOM_SEAM_ATTR;
+                    out += "=\"" + custom_seam_data_string + "\" ";
+                }
+
+                out += "/>\n";
+            }
+        }
+    }
+
     bool _3MF_Exporter::_add_model_file_to_archive(const std::string& filename, mz_zip_archive& archive, const Model& model, IdToObjectDataMap& objects_data)
     {
-        std::stringstream stream;
-        // https://en.cppreference.com/w/cpp/types/numeric_limits/max_digits10
-        // Conversion of a floating-point value to text and back is exact as long as at least max_digits10 were used (9 for float, 17 for double).
-        // It is guaranteed to produce the same floating-point value, even though the intermediate text representation is not exact.
-        // The default value of std::stream precision is 6 digits only!
-		stream << std::setprecision(std::numeric_limits<float>::max_digits10);
-        stream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
-        stream << "<" << MODEL_TAG << " unit=\"millimeter\" xml:lang=\"en-US\" xmlns=\"http://schemas.microsoft.com/3dmanufacturing/core/2015/02\" xmlns:slic3rpe=\"http://schemas.slic3r.org/3mf/2017/06\">\n";
-        stream << " <" << METADATA_TAG << " name=\"" << SLIC3RPE_3MF_VERSION << "\">" << VERSION_3MF << "</" << METADATA_TAG << ">\n";
+        // The texts of the tags are collected here, the meshes are referenced by the chunks
+        // and converted to XML only when the chunks are written into the archive.
+        ModelFileChunks chunks;
+        std::string& text = chunks.text;
+        text += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+        text += std::string("<") + MODEL_TAG + " unit=\"millimeter\" xml:lang=\"en-US\" xmlns=\"http://schemas.microsoft.com/3dmanufacturing/core/2015/02\" xmlns:slic3rpe=\"http://schemas.slic3r.org/3mf/2017/06\">\n";
+        text += std::string(" <") + METADATA_TAG + " name=\"" + SLIC3RPE_3MF_VERSION + "\">" + std::to_string(VERSION_3MF) + "</" + METADATA_TAG + ">\n";
         std::string name = boost::filesystem::path(filename).stem().string();
-        stream << " <" << METADATA_TAG << " name=\"Title\">" << name << "</" << METADATA_TAG << ">\n";
-        stream << " <" << METADATA_TAG << " name=\"Designer\">" << "</" << METADATA_TAG << ">\n";
-        stream << " <" << METADATA_TAG << " name=\"Description\">" << name << "</" << METADATA_TAG << ">\n";
-        stream << " <" << METADATA_TAG << " name=\"Copyright\">" << "</" << METADATA_TAG << ">\n";
-        stream << " <" << METADATA_TAG << " name=\"LicenseTerms\">" << "</" << METADATA_TAG << ">\n";
-        stream << " <" << METADATA_TAG << " name=\"Rating\">" << "</" << METADATA_TAG << ">\n";
+        text += std::string(" <") + METADATA_TAG + " name=\"Title\">" + name + "</" + METADATA_TAG + ">\n";
+        text += std::string(" <") + METADATA_TAG + " name=\"Designer\">" + "</" + METADATA_TAG + ">\n";
+        text += std::string(" <") + METADATA_TAG + " name=\"Description\">" + name + "</" + METADATA_TAG + ">\n";
+        text += std::string(" <") + METADATA_TAG + " name=\"Copyright\">" + "</" + METADATA_TAG + ">\n";
+        text += std::string(" <") + METADATA_TAG + " name=\"LicenseTerms\">" + "</" + METADATA_TAG + ">\n";
+        text += std::string(" <") + METADATA_TAG + " name=\"Rating\">" + "</" + METADATA_TAG + ">\n";
         std::string date = Slic3r::Utils::utc_timestamp(Slic3r::Utils::get_current_time_utc());
         // keep only the date part of the string
         date = date.substr(0, 10);
-        stream << " <" << METADATA_TAG << " name=\"CreationDate\">" << date << "</" << METADATA_TAG << ">\n";
-        stream << " <" << METADATA_TAG << " name=\"ModificationDate\">" << date << "</" << METADATA_TAG << ">\n";
-        stream << " <" << METADATA_TAG << " name=\"Application\">" << SLIC3R_APP_KEY << "-" << SLIC3R_VERSION << "</" << METADATA_TAG << ">\n";
-        stream << " <" << RESOURCES_TAG << ">\n";
+        text += std::string(" <") + METADATA_TAG + " name=\"CreationDate\">" + date + "</" + METADATA_TAG + ">\n";
+        text += std::string(" <") + METADATA_TAG + " name=\"ModificationDate\">" + date + "</" + METADATA_TAG + ">\n";
+        text += std::string(" <") + METADATA_TAG + " name=\"Application\">" + SLIC3R_APP_KEY + "-" + SLIC3R_VERSION + "</" + METADATA_TAG + ">\n";
+        text += std::string(" <") + RESOURCES_TAG + ">\n";
 
         // Instance transformations, indexed by the 3MF object ID (which is a linear serialization of all instances of all ModelObjects).
         BuildItemsList build_items;
@@ -2278,27 +2538,27 @@ namespace Slic3r {
             // Store geometry of all ModelVolumes contained in a single ModelObject into a single 3MF indexed triangle set object.
             // object_it->second.volumes_offsets will contain the offsets of the ModelVolumes in that single indexed triangle set.
             // object_id will be increased to point to the 1st instance of the next ModelObject.
-            if (!_add_object_to_model_stream(stream, object_id, *obj, build_items, object_it->second.volumes_offsets))
+            if (!_add_object_to_model_chunks(chunks, object_id, *obj, build_items, object_it->second.volumes_offsets))
             {
                 add_error("Unable to add object to archive");
                 return false;
             }
         }
 
-        stream << " </" << RESOURCES_TAG << ">\n";
+        text += std::string(" </") + RESOURCES_TAG + ">\n";
 
         // Store the transformations of all the ModelInstances of all ModelObjects, indexed in a linear fashion.
-        if (!_add_build_to_model_stream(stream, build_items))
+        if (!_add_build_to_model_chunks(chunks, build_items))
         {
             add_error("Unable to add build to archive");
             return false;
         }
 
-        stream << "</" << MODEL_TAG << ">\n";
+        text += std::string("</") + MODEL_TAG + ">\n";
+        chunks.finish();
 
-        std::string out = stream.str();
-
-        if (!mz_zip_writer_add_mem(&archive, MODEL_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION))
+        if (!add_zip_entry_chunked(&archive, MODEL_FILE, chunks.chunks.size(),
+            [&chunks](size_t idx, std::string& out) { chunks.append_chunk_xml(idx, out); }, MZ_DEFAULT_COMPRESSION))
         {
             add_error("Unable to add model file to archive");
             return false;
@@ -2307,8 +2567,9 @@ namespace Slic3r {
         return true;
     }
 
-    bool _3MF_Exporter::_add_object_to_model_stream(std::stringstream& stream, unsigned int& object_id, ModelObject& object, BuildItemsList& build_items, VolumeToOffsetsMap& volumes_offsets)
+    bool _3MF_Exporter::_add_object_to_model_chunks(ModelFileChunks& chunks, unsigned int& object_id, ModelObject& object, BuildItemsList& build_items, VolumeToOffsetsMap& volumes_offsets)
     {
+        std::string& text = chunks.text;
         unsigned int id = 0;
         for (const ModelInstance* instance : object.instances)
         {
@@ -2317,11 +2578,11 @@ namespace Slic3r {
                 continue;
 
             unsigned int instance_id = object_id + id;
-            stream << "  <" << OBJECT_TAG << " id=\"" << instance_id << "\" type=\"model\">\n";
+            text += std::string("  <") + OBJECT_TAG + " id=\"" + std::to_string(instance_id) + "\" type=\"model\">\n";
 
             if (id == 0)
             {
-                if (!_add_mesh_to_object_stream(stream, object, volumes_offsets))
+                if (!_add_mesh_to_object_chunks(chunks, object, volumes_offsets))
                 {
                     add_error("Unable to add mesh to archive");
                     return false;
@@ -2329,9 +2590,9 @@ namespace Slic3r {
             }
             else
             {
-                stream << "   <" << COMPONENTS_TAG << ">\n";
-                stream << "    <" << COMPONENT_TAG << " objectid=\"" << object_id << "\" />\n";
-                stream << "   </" << COMPONENTS_TAG << ">\n";
+                text += std::string("   <") + COMPONENTS_TAG + ">\n";
+                text += std::string("    <") + COMPONENT_TAG + " objectid=\"" + std::to_string(object_id) + "\" />\n";
+                text += std::string("   </") + COMPONENTS_TAG + ">\n";
             }
 
             Transform3d t = instance->get_matrix();
@@ -2339,7 +2600,7 @@ namespace Slic3r {
             assert(instance_id == build_items.size() + 1);
             build_items.emplace_back(instance_id, t, instance->printable);
 
-            stream << "  </" << OBJECT_TAG << ">\n";
+            text += std::string("  </") + OBJECT_TAG + ">\n";
 
             ++id;
         }
@@ -2348,10 +2609,10 @@ namespace Slic3r {
         return true;
     }
 
-    bool _3MF_Exporter::_add_mesh_to_object_stream(std::stringstream& stream, ModelObject& object, VolumeToOffsetsMap& volumes_offsets)
+    bool _3MF_Exporter::_add_mesh_to_object_chunks(ModelFileChunks& chunks, ModelObject& object, VolumeToOffsetsMap& volumes_offsets)
     {
-        stream << "   <" << MESH_TAG << ">\n";
-        stream << "    <" << VERTICES_TAG << ">\n";
+        chunks.text += std::string("   <") + MESH_TAG + ">\n";
+        chunks.text += std::string("    <") + VERTICES_TAG + ">\n";
 
         unsigned int vertices_count = 0;
         for (ModelVolume* volume : object.volumes)
@@ -2375,20 +2636,12 @@ namespace Slic3r {
 
             vertices_count += (int)its.vertices.size();
 
-            const Transform3d& matrix = volume->get_matrix();
-
-            for (size_t i = 0; i < its.vertices.size(); ++i)
-            {
-                stream << "     <" << VERTEX_TAG << " ";
-                Vec3f v = (matrix * its.vertices[i].cast<double>()).cast<float>();
-                stream << "x=\"" << v(0) << "\" ";
-                stream << "y=\"" << v(1) << "\" ";
-                stream << "z=\"" << v(2) << "\" />\n";
-            }
+            // The vertices are transformed when the chunks are converted to XML.
+            chunks.add_range(volume, false, 0, its.vertices.size());
         }
 
-        stream << "    </" << VERTICES_TAG << ">\n";
-        stream << "    <" << TRIANGLES_TAG << ">\n";
+        chunks.text += std::string("    </") + VERTICES_TAG + ">\n";
+        chunks.text += std::string("    <") + TRIANGLES_TAG + ">\n";
 
         unsigned int triangles_count = 0;
         for (ModelVolume* volume : object.volumes)
@@ -2406,33 +2659,16 @@ namespace Slic3r {
             triangles_count += (int)its.indices.size();
             volume_it->second.last_triangle_id = triangles_count - 1;
 
-            for (size_t i = 0; i < its.indices.size(); ++ i)
-            {
-                stream << "     <" << TRIANGLE_TAG << " ";
-                for (int j = 0; j < 3; ++j)
-                {
-                    stream << "v" << j + 1 << "=\"" << its.indices[i][j] + volume_it->second.first_vertex_id << "\" ";
-                }
-
-                std::string custom_supports_data_string = volume->m_supported_facets.get_triangle_as_string(i);
-                if (! custom_supports_data_string.empty())
-                    stream << CUSTOM_SUPPORTS_ATTR << "=\"" << custom_supports_data_string << "\" ";
-
-                std::string custom_seam_data_string = volume->m_seam_facets.get_triangle_as_string(i);
-                if (! custom_seam_data_string.empty())
-                    stream << CUSTOM_SEAM_ATTR << "=\"" << custom_seam_data_string << "\" ";
-
-                stream << "/>\n";
-            }
+            chunks.add_range(volume, true, volume_it->second.first_vertex_id, its.indices.size());
         }
 
-        stream << "    </" << TRIANGLES_TAG << ">\n";
-        stream << "   </" << MESH_TAG << ">\n";
+        chunks.text += std::string("    </") + TRIANGLES_TAG + ">\n";
+        chunks.text += std::string("   </") + MESH_TAG + ">\n";
 
         return true;
     }
 
-    bool _3MF_Exporter::_add_build_to_model_stream(std::stringstream& stream, const BuildItemsList& build_items)
+    bool _3MF_Exporter::_add_build_to_model_chunks(ModelFileChunks& chunks, const BuildItemsList& build_items)
     {
         if (build_items.size() == 0)
         {
@@ -2440,24 +2676,25 @@ namespace Slic3r {
             return false;
         }
 
-        stream << " <" << BUILD_TAG << ">\n";
+        std::string& text = chunks.text;
+        text += std::string(" <") + BUILD_TAG + ">\n";
 
         for (const BuildItem& item : build_items)
         {
-            stream << "  <" << ITEM_TAG << " " << OBJECTID_ATTR << "=\"" << item.id << "\" " << TRANSFORM_ATTR << "=\"";
+            text += std::string("  <") + ITEM_TAG + " " + OBJECTID_ATTR + "=\"" + std::to_string(item.id) + "\" " + TRANSFORM_ATTR + "=\"";
             for (unsigned c = 0; c < 4; ++c)
             {
                 for (unsigned r = 0; r < 3; ++r)
                 {
-                    stream << item.transform(r, c);
+                    append_float(text, item.transform(r, c));
                     if ((r != 2) || (c != 3))
-                        stream << " ";
+                        text += " ";
                 }
             }
-            stream << "\" " << PRINTABLE_ATTR << "=\"" << item.printable << "\" />\n";
+            text += std::string("\" ") + PRINTABLE_ATTR + "=\"" + (item.printable ? "1" : "0") + "\" />\n";
         }
 
-        stream << " </" << BUILD_TAG << ">\n";
+        text += std::string(" </") + BUILD_TAG + ">\n";
 
         return true;
     }
@@ -26,6 +26,9 @@ namespace pt = boost::property_tree;
 #include <boost/nowide/fstream.hpp>
 #include "miniz_extension.hpp"
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #if 0
 // Enable debugging and assert in this file.
 #define DEBUG
@@ -235,6 +238,14 @@ struct AMFParserContext
     std::vector<int>         m_volume_facets;
     // Transformation matrix of a volume mesh from its coordinate system to Object's coordinate system.
     Transform3d 			 m_volume_transform;
+    // Volumes closed while parsing, waiting for their meshes to be repaired in parallel by endDocument().
+    struct PendingVolume {
+        ModelVolume *volume;
+        TriangleMesh mesh;
+        TriangleMesh convex_hull;
+        bool         update_source_offset;
+    };
+    std::vector<PendingVolume> m_pending_volumes;
     // Current material allocated for an amf/metadata subtree.
     ModelMaterial           *m_material;
     // Current instance allocated for an amf/constellation/instance subtree.
@@ -579,9 +590,9 @@ void AMFParserContext::endElement(const char * /* name */)
     case NODE_TYPE_VERTEX:
         assert(m_object);
         // Parse the vertex data
-        m_object_vertices.emplace_back((float)atof(m_value[0].c_str()));
-        m_object_vertices.emplace_back((float)atof(m_value[1].c_str()));
-        m_object_vertices.emplace_back((float)atof(m_value[2].c_str()));
+        m_object_vertices.emplace_back((float)string_to_double_decimal_point(m_value[0].c_str()));
+        m_object_vertices.emplace_back((float)string_to_double_decimal_point(m_value[1].c_str()));
+        m_object_vertices.emplace_back((float)string_to_double_decimal_point(m_value[2].c_str()));
         m_value[0].clear();
         m_value[1].clear();
         m_value[2].clear();
@@ -619,22 +630,21 @@ void AMFParserContext::endElement(const char * /* name */)
             }
         }        
         stl_get_size(&stl);
-        mesh.repair();
-		m_volume->set_mesh(std::move(mesh));
         // stores the volume matrix taken from the metadata, if present
         if (has_transform)
             m_volume->source.transform = Slic3r::Geometry::Transformation(m_volume_transform);
+        bool update_source_offset = true;
         if (m_volume->source.input_file.empty() && (m_volume->type() == ModelVolumeType::MODEL_PART))
         {
             m_volume->source.object_idx = (int)m_model.objects.size() - 1;
             m_volume->source.volume_idx = (int)m_model.objects.back()->volumes.size() - 1;
-            m_volume->center_geometry_after_creation();
         }
         else
             // pass false if the mesh offset has been already taken from the data 
-            m_volume->center_geometry_after_creation(m_volume->source.input_file.empty());
+            update_source_offset = m_volume->source.input_file.empty();
 
-        m_volume->calculate_convex_hull();
+        // the mesh is repaired and centered by endDocument(), together with the meshes of the other volumes
+        m_pending_volumes.push_back({ m_volume, std::move(mesh), TriangleMesh(), update_source_offset });
         m_volume_facets.clear();
         m_volume = nullptr;
         break;
@@ -803,6 +813,21 @@ void AMFParserContext::endElement(const char * /* name */)
 
 void AMFParserContext::endDocument()
 {
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, m_pending_volumes.size(), 1),
+        [this](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i) {
+                PendingVolume &pending = m_pending_volumes[i];
+                pending.mesh.repair();
+                pending.convex_hull = pending.mesh.convex_hull_3d();
+            }
+        });
+    for (PendingVolume &pending : m_pending_volumes) {
+        pending.volume->set_mesh(std::move(pending.mesh));
+        pending.volume->set_convex_hull(std::move(pending.convex_hull));
+        pending.volume->center_geometry_after_creation(pending.update_source_offset);
+    }
+    m_pending_volumes.clear();
+
     for (const auto &object : m_object_instances_map) {
         if (object.second.idx == -1) {
             printf("Undefined object %s referenced in constellation\n", object.first.c_str());
@@ -436,18 +436,21 @@ uqptr<sla::RasterBase> SL1Archive::create_raster() const
 
 sla::RasterEncoder SL1Archive::get_encoder() const
 {
-    return sla::PNGRasterEncoder{};
+    return sla::GrayscalePNGRasterEncoder{};
 }
 
-void SL1Archive::export_print(Zipper& zipper,
-                              const SLAPrint &print,
-                              const std::string &prjname)
+static std::string project_name(const std::string &filename, const std::string &prjname)
+{
+    return prjname.empty() ? boost::filesystem::path(filename).stem().string() : prjname;
+}
+
+static std::string layer_name(const std::string &project, size_t idx, const sla::EncodedRaster &rst)
+{
+    return project + string_printf("%.5d", int(idx)) + "." + rst.extension();
+}
+
+void SL1Archive::write_config(Zipper &zipper, const SLAPrint &print, const std::string &project)
 {
-    std::string project =
-        prjname.empty() ?
-            boost::filesystem::path(zipper.get_filename()).stem().string() :
-            prjname;
-    
     ConfMap iniconf, slicerconf;
     fill_iniconf(iniconf, print);
     
@@ -455,20 +458,30 @@ void SL1Archive::export_print(Zipper& zipper,
 
     fill_slicerconf(slicerconf, print);
 
+    zipper.add_entry("config.ini");
+    zipper << to_ini(iniconf);
+    zipper.add_entry("prusaslicer.ini");
+    zipper << to_ini(slicerconf);
+}
+
+void SL1Archive::write_layers(Zipper &zipper, const std::string &project)
+{
+    size_t i = 0;
+    for (const sla::EncodedRaster &rst : m_layers) {
+        std::string imgname = layer_name(project, i++, rst);
+        zipper.add_entry(imgname.c_str(), rst.data(), rst.size());
+    }
+}
+
+void SL1Archive::export_print(Zipper& zipper,
+                              const SLAPrint &print,
+                              const std::string &prjname)
+{
+    std::string project = project_name(zipper.get_filename(), prjname);
+
     try {
-        zipper.add_entry("config.ini");
-        zipper << to_ini(iniconf);
-        zipper.add_entry("prusaslicer.ini");
-        zipper << to_ini(slicerconf);
-        
-        size_t i = 0;
-        for (const sla::EncodedRaster &rst : m_layers) {
-
-            std::string imgname = project + string_printf("%.5d", i++) + "." +
-                                  rst.extension();
-            
-            zipper.add_entry(imgname.c_str(), rst.data(), rst.size());
-        }
+        write_config(zipper, print, project);
+        write_layers(zipper, project);
     } catch(std::exception& e) {
         BOOST_LOG_TRIVIAL(error) << e.what();
         // Rethrow the exception
@@ -476,4 +489,71 @@ void SL1Archive::export_print(Zipper& zipper,
     }
 }
 
+void SL1Archive::start_streaming_export(std::function<std::string()> output_path_fn,
+                                        const std::string &projectname)
+{
+    m_stream_path_fn = std::move(output_path_fn);
+    m_stream_project = projectname;
+    m_stream_zipper.reset();
+    
+    // Called from a single thread at a time in layer order.
+    set_layer_sink([this](size_t idx, sla::EncodedRaster &&rst) {
+        if (! m_stream_zipper)
+            open_streaming_zipper();
+        try {
+            m_stream_zipper->add_entry(layer_name(m_stream_project, idx, rst), rst.data(), rst.size());
+        } catch(std::exception& e) {
+            BOOST_LOG_TRIVIAL(error) << e.what();
+            throw;
+        }
+    });
+}
+
+void SL1Archive::open_streaming_zipper()
+{
+    m_stream_zipper = std::make_unique<Zipper>(m_stream_path_fn());
+    m_stream_project = project_name(m_stream_zipper->get_filename(), m_stream_project);
+}
+
+std::string SL1Archive::finish_streaming_export(const SLAPrint &print)
+{
+    // If no layer was streamed, the layers were either rasterized before
+    // the streaming was started or there are none.
+    bool streamed = bool(m_stream_zipper);
+    if (! streamed)
+        open_streaming_zipper();
+    
+    try {
+        write_config(*m_stream_zipper, print, m_stream_project);
+        if (! streamed)
+            write_layers(*m_stream_zipper, m_stream_project);
+        m_stream_zipper->finalize();
+    } catch(std::exception& e) {
+        BOOST_LOG_TRIVIAL(error) << e.what();
+        abort_streaming_export();
+        throw;
+    }
+    
+    std::string filename = m_stream_zipper->get_filename();
+    m_stream_zipper.reset();
+    set_layer_sink({});
+    m_stream_path_fn = {};
+    return filename;
+}
+
+void SL1Archive::abort_streaming_export()
+{
+    set_layer_sink({});
+    m_stream_path_fn = {};
+    if (! m_stream_zipper)
+        return;
+    
+    std::string filename = m_stream_zipper->get_filename();
+    // Closes the file.
+    m_stream_zipper.reset();
+    boost::system::error_code ec;
+    if (! boost::filesystem::remove(filename, ec) && ec)
+        BOOST_LOG_TRIVIAL(error) << "Failed to remove the incomplete archive " << filename << ": " << ec.message();
+}
+
 } // namespace Slic3r
@@ -2,6 +2,8 @@
 #define ARCHIVETRAITS_HPP
 
 #include <string>
+#include <memory>
+#include <functional>
 
 #include "libslic3r/Zipper.hpp"
 #include "libslic3r/SLAPrint.hpp"
@@ -11,15 +13,26 @@ namespace Slic3r {
 class SL1Archive: public SLAPrinter {
     SLAPrinterConfig m_cfg;
     
+    // Streaming export, see start_streaming_export().
+    std::function<std::string()> m_stream_path_fn;
+    std::string                  m_stream_project;
+    std::unique_ptr<Zipper>      m_stream_zipper;
+    
+    void open_streaming_zipper();
+    void write_config(Zipper &zipper, const SLAPrint &print, const std::string &project);
+    void write_layers(Zipper &zipper, const std::string &project);
+    
 protected:
     uqptr<sla::RasterBase> create_raster() const override;
     sla::RasterEncoder get_encoder() const override;
+    void abort_layer_sink() override { abort_streaming_export(); }
     
 public:
     
     SL1Archive() = default;
     explicit SL1Archive(const SLAPrinterConfig &cfg): m_cfg(cfg) {}
     explicit SL1Archive(SLAPrinterConfig &&cfg): m_cfg(std::move(cfg)) {}
+    ~SL1Archive() override { abort_streaming_export(); }
     
     void export_print(Zipper &zipper, const SLAPrint &print, const std::string &projectname = "");
     void export_print(const std::string &fname, const SLAPrint &print, const std::string &projectname = "")
@@ -28,6 +41,21 @@ public:
         export_print(zipper, print, projectname);
     }
     
+    // Streaming export: the layers rasterized by the following SLAPrint::process()
+    // are zipped in layer order while the next layers are being rasterized,
+    // instead of being kept in memory until export_print(). The archive is
+    // created when the first layer is finished, at that point the print
+    // statistics are known, so output_path_fn() may use them to name the file.
+    void start_streaming_export(std::function<std::string()> output_path_fn,
+                                const std::string &projectname = "");
+    // Write the configuration, finalize the archive started by
+    // start_streaming_export() and return its path.
+    std::string finish_streaming_export(const SLAPrint &print);
+    // Stop the streaming export started by start_streaming_export() without
+    // finishing it, the partially written archive is closed and deleted.
+    // Called automatically if the rasterization throws or is canceled.
+    void abort_streaming_export();
+    
     void apply(const SLAPrinterConfig &cfg) override
     {
         auto diff = m_cfg.diff(cfg);
@@ -20,6 +20,7 @@
 #include <boost/algorithm/string/find.hpp>
 #include <boost/foreach.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/beast/core/detail/base64.hpp>
 
@@ -30,6 +31,8 @@
 #include "SVG.hpp"
 
 #include <tbb/parallel_for.h>
+#include <tbb/pipeline.h>
+#include <tbb/task_arena.h>
 
 #include <Shiny/Shiny.h>
 
@@ -93,6 +96,37 @@ namespace Slic3r {
         m_external_mp = Slic3r::make_unique<MotionPlanner>(union_ex(this->collect_contours_all_layers(print.objects())));
     }
 
+    void AvoidCrossingPerimeters::init_layer_mp(ExPolygons &&islands)
+    {
+        size_t islands_hash = 0;
+        auto hash_polygon = [&islands_hash](const Polygon &polygon) {
+            boost::hash_combine(islands_hash, polygon.points.size());
+            for (const Point &pt : polygon.points) {
+                boost::hash_combine(islands_hash, pt.x());
+                boost::hash_combine(islands_hash, pt.y());
+            }
+        };
+        for (const ExPolygon &island : islands) {
+            hash_polygon(island.contour);
+            boost::hash_combine(islands_hash, island.holes.size());
+            for (const Polygon &hole : island.holes)
+                hash_polygon(hole);
+        }
+        auto it = std::find_if(m_layer_mp_cache.begin(), m_layer_mp_cache.end(),
+            [islands_hash, &islands](const LayerMP &layer_mp) { return layer_mp.islands_hash == islands_hash && layer_mp.islands == islands; });
+        if (it == m_layer_mp_cache.end()) {
+            // Replace the least recently used motion planner.
+            if (m_layer_mp_cache.size() == layer_mp_cache_size)
+                m_layer_mp_cache.pop_back();
+            m_layer_mp_cache.push_back({ islands_hash, std::move(islands), nullptr });
+            it = m_layer_mp_cache.end() - 1;
+            it->mp = Slic3r::make_unique<MotionPlanner>(it->islands);
+        }
+        // Move to the front, keeping the rest in the order of use.
+        std::rotate(m_layer_mp_cache.begin(), it, it + 1);
+        m_layer_mp = m_layer_mp_cache.front().mp.get();
+    }
+
     // Plan a travel move while minimizing the number of perimeter crossings.
     // point is in unscaled coordinates, in the coordinate system of the current active object
     // (set by gcodegen.set_origin()).
@@ -102,7 +136,7 @@ namespace Slic3r {
         // Otherwise perform the path planning in the coordinate system of the active object.
         bool  use_external = this->use_external_mp || this->use_external_mp_once;
         Point scaled_origin = use_external ? Point::new_scale(gcodegen.origin()(0), gcodegen.origin()(1)) : Point(0, 0);
-        Polyline result = (use_external ? m_external_mp.get() : m_layer_mp.get())->
+        Polyline result = (use_external ? m_external_mp.get() : m_layer_mp)->
             shortest_path(gcodegen.last_pos() + scaled_origin, point + scaled_origin);
         if (use_external)
             result.translate(-scaled_origin);
@@ -385,7 +419,7 @@ namespace Slic3r {
         config.set_key_value("end_filament_gcode", new ConfigOptionString(end_filament_gcode_str));
         config.set_key_value("toolchange_gcode", new ConfigOptionString(toolchange_gcode_str));
         config.set_key_value("start_filament_gcode", new ConfigOptionString(start_filament_gcode_str));
-        std::string tcr_gcode, tcr_escaped_gcode = gcodegen.placeholder_parser_process("tcr_rotated_gcode", tcr_rotated_gcode, new_extruder_id, &config);
+        std::string tcr_gcode, tcr_escaped_gcode = gcodegen.placeholder_parser_process("tcr_rotated_gcode", PlaceholderParser::compile(tcr_rotated_gcode), new_extruder_id, &config);
         unescape_string_cstyle(tcr_escaped_gcode, tcr_gcode);
         gcode += tcr_gcode;
         check_add_eol(toolchange_gcode_str);
@@ -787,7 +821,8 @@ void GCode::do_export(Print* print, const char* path, GCodePreviewData* preview_
     }
 
 #if ENABLE_GCODE_VIEWER
-    m_processor.process_file(path_tmp, [print]() { print->throw_if_canceled(); });
+    // The G-code has been processed by _write() while being exported, just finish the time estimates and add the M73 lines.
+    m_processor.finalize(path_tmp);
     DoExport::update_print_estimated_times_stats(m_processor, print->m_print_statistics);
     if (result != nullptr)
         *result = std::move(m_processor.extract_result());
@@ -1234,6 +1269,7 @@ void GCode::_do_export(Print& print, FILE* file, ThumbnailsGeneratorCallback thu
     m_cooling_buffer = make_unique<CoolingBuffer>(*this);
     if (print.config().spiral_vase.value)
         m_spiral_vase = make_unique<SpiralVase>(print.config());
+    m_enable_loop_clipping = true;
 #ifdef HAS_PRESSURE_EQUALIZER
     if (print.config().max_volumetric_extrusion_rate_slope_positive.value > 0 ||
         print.config().max_volumetric_extrusion_rate_slope_negative.value > 0)
@@ -1484,13 +1520,10 @@ void GCode::_do_export(Print& print, FILE* file, ThumbnailsGeneratorCallback thu
             m_cooling_buffer->reset();
             m_cooling_buffer->set_current_extruder(initial_extruder_id);
             // Pair the object layers with the support layers by z, extrude them.
-            std::vector<LayerToPrint> layers_to_print = collect_layers_to_print(object);
-            for (const LayerToPrint &ltp : layers_to_print) {
-                std::vector<LayerToPrint> lrs;
-                lrs.emplace_back(std::move(ltp));
-                this->process_layer(file, print, lrs, tool_ordering.tools_for_layer(ltp.print_z()), nullptr, *print_object_instance_sequential_active - object.instances().data());
-                print.throw_if_canceled();
-            }
+            std::vector<std::pair<coordf_t, std::vector<LayerToPrint>>> layers_to_print;
+            for (const LayerToPrint &ltp : collect_layers_to_print(object))
+                layers_to_print.emplace_back(ltp.print_z(), std::vector<LayerToPrint>{ ltp });
+            this->process_layers(print, tool_ordering, layers_to_print, nullptr, *print_object_instance_sequential_active - object.instances().data(), file);
 #ifdef HAS_PRESSURE_EQUALIZER
             if (m_pressure_equalizer)
                 _write(file, m_pressure_equalizer->process("", true));
@@ -1536,13 +1569,7 @@ void GCode::_do_export(Print& print, FILE* file, ThumbnailsGeneratorCallback thu
             print.throw_if_canceled();
         }
         // Extrude the layers.
-        for (auto &layer : layers_to_print) {
-            const LayerTools &layer_tools = tool_ordering.tools_for_layer(layer.first);
-            if (m_wipe_tower && layer_tools.has_wipe_tower)
-                m_wipe_tower->next_layer();
-            this->process_layer(file, print, layer.second, layer_tools, &print_object_instances_ordering, size_t(-1));
-            print.throw_if_canceled();
-        }
+        this->process_layers(print, tool_ordering, layers_to_print, &print_object_instances_ordering, size_t(-1), file);
 #ifdef HAS_PRESSURE_EQUALIZER
         if (m_pressure_equalizer)
             _write(file, m_pressure_equalizer->process("", true));
@@ -1643,6 +1670,14 @@ void GCode::_do_export(Print& print, FILE* file, ThumbnailsGeneratorCallback thu
 }
 
 std::string GCode::placeholder_parser_process(const std::string &name, const std::string &templ, unsigned int current_extruder_id, const DynamicConfig *config_override)
+{
+    auto it = m_placeholder_parser_templates.find(templ);
+    if (it == m_placeholder_parser_templates.end())
+        it = m_placeholder_parser_templates.emplace(templ, PlaceholderParser::compile(templ)).first;
+    return this->placeholder_parser_process(name, it->second, current_extruder_id, config_override);
+}
+
+std::string GCode::placeholder_parser_process(const std::string &name, const PlaceholderParser::Template &templ, unsigned int current_extruder_id, const DynamicConfig *config_override)
 {
     try {
         return m_placeholder_parser.process(templ, current_extruder_id, config_override);
@@ -1712,30 +1747,31 @@ static bool custom_gcode_sets_temperature(const std::string &gcode, const int mc
 }
 
 // Print the machine envelope G-code for the Marlin firmware based on the "machine_max_xxx" parameters.
-// Do not process this piece of G-code by the time estimator, it already knows the values through another sources.
+// The envelope is written through _write() as GCodeProcessor is fed while exporting, the time estimator
+// already knows the same values through another sources.
 void GCode::print_machine_envelope(FILE *file, Print &print)
 {
     if (print.config().gcode_flavor.value == gcfMarlin) {
-        fprintf(file, "M201 X%d Y%d Z%d E%d ; sets maximum accelerations, mm/sec^2\n",
+        _write_format(file, "M201 X%d Y%d Z%d E%d ; sets maximum accelerations, mm/sec^2\n",
             int(print.config().machine_max_acceleration_x.values.front() + 0.5),
             int(print.config().machine_max_acceleration_y.values.front() + 0.5),
             int(print.config().machine_max_acceleration_z.values.front() + 0.5),
             int(print.config().machine_max_acceleration_e.values.front() + 0.5));
-        fprintf(file, "M203 X%d Y%d Z%d E%d ; sets maximum feedrates, mm/sec\n",
+        _write_format(file, "M203 X%d Y%d Z%d E%d ; sets maximum feedrates, mm/sec\n",
             int(print.config().machine_max_feedrate_x.values.front() + 0.5),
             int(print.config().machine_max_feedrate_y.values.front() + 0.5),
             int(print.config().machine_max_feedrate_z.values.front() + 0.5),
             int(print.config().machine_max_feedrate_e.values.front() + 0.5));
-        fprintf(file, "M204 P%d R%d T%d ; sets acceleration (P, T) and retract acceleration (R), mm/sec^2\n",
+        _write_format(file, "M204 P%d R%d T%d ; sets acceleration (P, T) and retract acceleration (R), mm/sec^2\n",
             int(print.config().machine_max_acceleration_extruding.values.front() + 0.5),
             int(print.config().machine_max_acceleration_retracting.values.front() + 0.5),
             int(print.config().machine_max_acceleration_extruding.values.front() + 0.5));
-        fprintf(file, "M205 X%.2lf Y%.2lf Z%.2lf E%.2lf ; sets the jerk limits, mm/sec\n",
+        _write_format(file, "M205 X%.2lf Y%.2lf Z%.2lf E%.2lf ; sets the jerk limits, mm/sec\n",
             print.config().machine_max_jerk_x.values.front(),
             print.config().machine_max_jerk_y.values.front(),
             print.config().machine_max_jerk_z.values.front(),
             print.config().machine_max_jerk_e.values.front());
-        fprintf(file, "M205 S%d T%d ; sets the minimum extruding and travel feed rate, mm/sec\n",
+        _write_format(file, "M205 S%d T%d ; sets the minimum extruding and travel feed rate, mm/sec\n",
             int(print.config().machine_min_extruding_rate.values.front() + 0.5),
             int(print.config().machine_min_travel_rate.values.front() + 0.5));
     }
@@ -1795,12 +1831,15 @@ void GCode::_print_first_layer_extruder_temperatures(FILE *file, Print &print, c
     }
 }
 
+// by_extruder is indexed densely by the extruder ID, an empty entry marks an extruder not printing anything at this layer.
 inline GCode::ObjectByExtruder& object_by_extruder(
-    std::map<unsigned int, std::vector<GCode::ObjectByExtruder>> &by_extruder, 
-    unsigned int                                                  extruder_id, 
-    size_t                                                        object_idx, 
-    size_t                                                        num_objects)
+    std::vector<std::vector<GCode::ObjectByExtruder>> &by_extruder, 
+    unsigned int                                       extruder_id, 
+    size_t                                             object_idx, 
+    size_t                                             num_objects)
 {
+    if (extruder_id >= by_extruder.size())
+        by_extruder.resize(extruder_id + 1);
     std::vector<GCode::ObjectByExtruder> &objects_by_extruder = by_extruder[extruder_id];
     if (objects_by_extruder.empty())
         objects_by_extruder.assign(num_objects, GCode::ObjectByExtruder());
@@ -1808,11 +1847,11 @@ inline GCode::ObjectByExtruder& object_by_extruder(
 }
 
 inline std::vector<GCode::ObjectByExtruder::Island>& object_islands_by_extruder(
-    std::map<unsigned int, std::vector<GCode::ObjectByExtruder>>  &by_extruder, 
-    unsigned int                                                   extruder_id, 
-    size_t                                                         object_idx, 
-    size_t                                                         num_objects,
-    size_t                                                         num_islands)
+    std::vector<std::vector<GCode::ObjectByExtruder>> &by_extruder, 
+    unsigned int                                       extruder_id, 
+    size_t                                             object_idx, 
+    size_t                                             num_objects,
+    size_t                                             num_islands)
 {
     std::vector<GCode::ObjectByExtruder::Island> &islands = object_by_extruder(by_extruder, extruder_id, object_idx, num_objects).islands;
     if (islands.empty())
@@ -2036,9 +2075,127 @@ namespace Skirt {
 // In non-sequential mode, process_layer is called per each print_z height with all object and support layers accumulated.
 // For multi-material prints, this routine minimizes extruder switches by gathering extruder specific extrusion paths
 // and performing the extruder specific extrusions together.
-void GCode::process_layer(
-    // Write into the output file.
-    FILE                            		*file,
+// Calculate the distance field of the layer below, used by extrude_loop() to place the seams.
+static std::unique_ptr<EdgeGrid::Grid> make_lower_layer_edge_grid(const Layer &layer)
+{
+    const coord_t distance_field_resolution = coord_t(scale_(1.) + 0.5);
+    auto grid = make_unique<EdgeGrid::Grid>();
+    grid->create(layer.lower_layer->lslices, distance_field_resolution);
+    grid->calculate_sdf();
+    return grid;
+}
+
+void GCode::process_layers(
+    const Print                                                         &print,
+    const ToolOrdering                                                  &tool_ordering,
+    const std::vector<std::pair<coordf_t, std::vector<LayerToPrint>>>   &layers_to_print,
+    const std::vector<const PrintInstance*>                             *ordering,
+    const size_t                                                         single_object_idx,
+    FILE                                                                *file)
+{
+    // Layer in flight through the pipeline.
+    struct LayerInProgress {
+        size_t                                        idx;
+        std::vector<std::unique_ptr<EdgeGrid::Grid>>  lower_layer_edge_grids;
+        LayerResult                                   result;
+    };
+    typedef std::shared_ptr<LayerInProgress> LayerInProgressPtr;
+
+    size_t layer_to_print_idx = 0;
+    const auto generator = tbb::make_filter<void, LayerInProgressPtr>(tbb::filter::serial_in_order,
+        [&layer_to_print_idx, &layers_to_print](tbb::flow_control &fc) -> LayerInProgressPtr {
+            if (layer_to_print_idx == layers_to_print.size()) {
+                fc.stop();
+                return LayerInProgressPtr();
+            }
+            auto layer = std::make_shared<LayerInProgress>();
+            layer->idx = layer_to_print_idx ++;
+            return layer;
+        });
+    // The distance fields of the lower layers do not depend on the state of the G-code generator, calculate them in parallel.
+    const auto edge_grids = tbb::make_filter<LayerInProgressPtr, LayerInProgressPtr>(tbb::filter::parallel,
+        [&print, &layers_to_print](LayerInProgressPtr in) -> LayerInProgressPtr {
+            const std::vector<LayerToPrint> &layers = layers_to_print[in->idx].second;
+            in->lower_layer_edge_grids.resize(layers.size());
+            for (size_t i = 0; i < layers.size(); ++ i) {
+                const Layer *layer = layers[i].object_layer;
+                if (layer != nullptr && layer->lower_layer != nullptr &&
+                    std::any_of(layer->regions().begin(), layer->regions().end(), [](const LayerRegion *layerm) { return ! layerm->perimeters.entities.empty(); })) {
+                    print.throw_if_canceled();
+                    in->lower_layer_edge_grids[i] = make_lower_layer_edge_grid(*layer);
+                }
+            }
+            return in;
+        });
+    const auto process_layer = tbb::make_filter<LayerInProgressPtr, LayerInProgressPtr>(tbb::filter::serial_in_order,
+        [this, &print, &tool_ordering, &layers_to_print, ordering, single_object_idx](LayerInProgressPtr in) -> LayerInProgressPtr {
+            const std::pair<coordf_t, std::vector<LayerToPrint>> &layer = layers_to_print[in->idx];
+            const LayerTools &layer_tools = tool_ordering.tools_for_layer(layer.first);
+            if (m_wipe_tower && layer_tools.has_wipe_tower)
+                m_wipe_tower->next_layer();
+            print.throw_if_canceled();
+            in->result = this->process_layer(print, layer.second, layer_tools, ordering, single_object_idx, std::move(in->lower_layer_edge_grids));
+            return in;
+        });
+    // Apply spiral vase post-processing if this layer contains suitable geometry
+    // (we must feed all the G-code into the post-processor, including the first 
+    // bottom non-spiral layers otherwise it will mess with positions)
+    // we apply spiral vase at this stage because it requires a full layer.
+    // Just a reminder: A spiral vase mode is allowed for a single object per layer, single material print only.
+    const auto spiral_vase = tbb::make_filter<LayerInProgressPtr, LayerInProgressPtr>(tbb::filter::serial_in_order,
+        [this](LayerInProgressPtr in) -> LayerInProgressPtr {
+            if (m_spiral_vase && ! in->result.is_nop_layer_result()) {
+                m_spiral_vase->enable = in->result.spiral_vase_enable;
+                in->result.gcode = m_spiral_vase->process_layer(in->result.gcode);
+            }
+            return in;
+        });
+    const auto cooling = tbb::make_filter<LayerInProgressPtr, LayerInProgressPtr>(tbb::filter::serial_in_order,
+        [this](LayerInProgressPtr in) -> LayerInProgressPtr {
+            if (in->result.is_nop_layer_result())
+                return in;
+            std::string &gcode = in->result.gcode;
+            // Apply cooling logic; this may alter speeds.
+            if (m_cooling_buffer)
+                gcode = m_cooling_buffer->process_layer(gcode, in->result.layer_id);
+#if !ENABLE_GCODE_VIEWER
+            // add tag for analyzer
+            if (gcode.find(GCodeAnalyzer::Pause_Print_Tag) != gcode.npos)
+                gcode += "\n; " + GCodeAnalyzer::End_Pause_Print_Or_Custom_Code_Tag + "\n";
+            else if (gcode.find(GCodeAnalyzer::Custom_Code_Tag) != gcode.npos)
+                gcode += "\n; " + GCodeAnalyzer::End_Pause_Print_Or_Custom_Code_Tag + "\n";
+#endif // !ENABLE_GCODE_VIEWER
+#ifdef HAS_PRESSURE_EQUALIZER
+            // Apply pressure equalization if enabled;
+            // printf("G-code before filter:\n%s\n", gcode.c_str());
+            if (m_pressure_equalizer)
+                gcode = m_pressure_equalizer->process(gcode.c_str(), false);
+            // printf("G-code after filter:\n%s\n", out.c_str());
+#endif /* HAS_PRESSURE_EQUALIZER */
+            return in;
+        });
+    const auto output = tbb::make_filter<LayerInProgressPtr, void>(tbb::filter::serial_in_order,
+        [this, file, &layers_to_print](LayerInProgressPtr in) {
+            if (in->result.is_nop_layer_result())
+                return;
+            _write(file, in->result.gcode);
+#if !ENABLE_GCODE_VIEWER
+            BOOST_LOG_TRIVIAL(trace) << "Exported layer " << in->result.layer_id << " print_z " << layers_to_print[in->idx].first <<
+                ", time estimator memory: " <<
+                    format_memsize_MB(m_normal_time_estimator.memory_used() + (m_silent_time_estimator_enabled ? m_silent_time_estimator.memory_used() : 0)) <<
+                    ", analyzer memory: " <<
+                    format_memsize_MB(m_analyzer.memory_used()) <<
+                    log_memory_info();
+#endif // !ENABLE_GCODE_VIEWER
+        });
+
+    // Limit the number of layers in flight, so that the G-code of only a few layers is held in memory.
+    const size_t max_layers_in_flight = size_t(2 * tbb::this_task_arena::max_concurrency());
+    tbb::parallel_pipeline(max_layers_in_flight, generator & edge_grids & process_layer & spiral_vase & cooling & output);
+    print.throw_if_canceled();
+}
+
+GCode::LayerResult GCode::process_layer(
     const Print                    			&print,
     // Set of object & print layers of the same PrintObject and with the same print_z.
     const std::vector<LayerToPrint> 		&layers,
@@ -2047,7 +2204,9 @@ void GCode::process_layer(
 	const std::vector<const PrintInstance*> *ordering,
     // If set to size_t(-1), then print all copies of all objects.
     // Otherwise print a single copy of a single object.
-    const size_t                     		 single_object_instance_idx)
+    const size_t                     		 single_object_instance_idx,
+    // Distance fields of the layers below layers, indexed the same as layers. Calculated on demand if empty.
+    std::vector<std::unique_ptr<EdgeGrid::Grid>> &&lower_layer_edge_grids)
 {
     assert(! layers.empty());
     // Either printing all copies of all objects, or just a single copy of a single object.
@@ -2055,7 +2214,7 @@ void GCode::process_layer(
 
     if (layer_tools.extruders.empty())
         // Nothing to extrude.
-        return;
+        return LayerResult::make_nop_layer_result();
 
     // Extract 1st object_layer and support_layer of this set of layers with an equal print_z.
     const Layer         *object_layer  = nullptr;
@@ -2074,6 +2233,10 @@ void GCode::process_layer(
     // Initialize config with the 1st object to be printed at this layer.
     m_config.apply(layer.object()->config(), true);
 
+    // The spiral vase post-processing stays enabled or disabled as it was for the previous layer,
+    // unless it is decided for this layer below. Loop clipping is disabled just for the spiral vase layers.
+    LayerResult result { {}, layer.id(), m_spiral_vase && ! m_enable_loop_clipping };
+
     // Check whether it is possible to apply the spiral vase logic for this layer.
     // Just a reminder: A spiral vase mode is allowed for a single object, single material print only.
     if (m_spiral_vase && layers.size() == 1 && support_layer == nullptr) {
@@ -2087,12 +2250,12 @@ void GCode::process_layer(
                     break;
                 }
         }
-        m_spiral_vase->enable = enable;
+        result.spiral_vase_enable = enable;
     }
     // If we're going to apply spiralvase to this layer, disable loop clipping
-    m_enable_loop_clipping = ! m_spiral_vase || ! m_spiral_vase->enable;
+    m_enable_loop_clipping = ! result.spiral_vase_enable;
     
-    std::string gcode;
+    std::string &gcode = result.gcode;
 
 #if ENABLE_GCODE_VIEWER
     // add tag for processor
@@ -2160,7 +2323,7 @@ void GCode::process_layer(
         Skirt::make_skirt_loops_per_extruder_other_layers(print, layers, layer_tools, support_layer, m_skirt_done);
 
     // Group extrusions by an extruder, then by an object, an island and a region.
-    std::map<unsigned int, std::vector<ObjectByExtruder>> by_extruder;
+    std::vector<std::vector<ObjectByExtruder>> by_extruder(print.config().nozzle_diameter.size());
     bool is_anything_overridden = const_cast<LayerTools&>(layer_tools).wiping_extrusions().is_anything_overridden();
     for (const LayerToPrint &layer_to_print : layers) {
         if (layer_to_print.support_layer != nullptr) {
@@ -2316,7 +2479,7 @@ void GCode::process_layer(
     } // for objects
 
     // Extrude the skirt, brim, support, perimeters, infill ordered by the extruders.
-    std::vector<std::unique_ptr<EdgeGrid::Grid>> lower_layer_edge_grids(layers.size());
+    lower_layer_edge_grids.resize(layers.size());
     for (unsigned int extruder_id : layer_tools.extruders)
     {
         gcode += (layer_tools.has_wipe_tower && m_wipe_tower) ?
@@ -2370,11 +2533,10 @@ void GCode::process_layer(
         }
 
 
-        auto objects_by_extruder_it = by_extruder.find(extruder_id);
-        if (objects_by_extruder_it == by_extruder.end())
+        if (extruder_id >= by_extruder.size() || by_extruder[extruder_id].empty())
             continue;
 
-		std::vector<InstanceToPrint> instances_to_print = sort_print_object_instances(objects_by_extruder_it->second, layers, ordering, single_object_instance_idx);
+		std::vector<InstanceToPrint> instances_to_print = sort_print_object_instances(by_extruder[extruder_id], layers, ordering, single_object_instance_idx);
 
         // We are almost ready to print. However, we must go through all the objects twice to print the the overridden extrusions first (infill/perimeter wiping feature):
 		std::vector<ObjectByExtruder::Island::Region> by_region_per_copy_cache;
@@ -2423,43 +2585,7 @@ void GCode::process_layer(
         }
     }
 
-    // Apply spiral vase post-processing if this layer contains suitable geometry
-    // (we must feed all the G-code into the post-processor, including the first 
-    // bottom non-spiral layers otherwise it will mess with positions)
-    // we apply spiral vase at this stage because it requires a full layer.
-    // Just a reminder: A spiral vase mode is allowed for a single object per layer, single material print only.
-    if (m_spiral_vase)
-        gcode = m_spiral_vase->process_layer(gcode);
-
-    // Apply cooling logic; this may alter speeds.
-    if (m_cooling_buffer)
-        gcode = m_cooling_buffer->process_layer(gcode, layer.id());
-
-#if !ENABLE_GCODE_VIEWER
-    // add tag for analyzer
-    if (gcode.find(GCodeAnalyzer::Pause_Print_Tag) != gcode.npos)
-        gcode += "\n; " + GCodeAnalyzer::End_Pause_Print_Or_Custom_Code_Tag + "\n";
-    else if (gcode.find(GCodeAnalyzer::Custom_Code_Tag) != gcode.npos)
-        gcode += "\n; " + GCodeAnalyzer::End_Pause_Print_Or_Custom_Code_Tag + "\n";
-#endif // !ENABLE_GCODE_VIEWER
-
-#ifdef HAS_PRESSURE_EQUALIZER
-    // Apply pressure equalization if enabled;
-    // printf("G-code before filter:\n%s\n", gcode.c_str());
-    if (m_pressure_equalizer)
-        gcode = m_pressure_equalizer->process(gcode.c_str(), false);
-    // printf("G-code after filter:\n%s\n", out.c_str());
-#endif /* HAS_PRESSURE_EQUALIZER */
-    
-    _write(file, gcode);
-#if !ENABLE_GCODE_VIEWER
-    BOOST_LOG_TRIVIAL(trace) << "Exported layer " << layer.id() << " print_z " << print_z <<
-        ", time estimator memory: " <<
-            format_memsize_MB(m_normal_time_estimator.memory_used() + (m_silent_time_estimator_enabled ? m_silent_time_estimator.memory_used() : 0)) <<
-            ", analyzer memory: " <<
-            format_memsize_MB(m_analyzer.memory_used()) <<
-            log_memory_info();
-#endif // !ENABLE_GCODE_VIEWER
+    return result;
 }
 
 void GCode::apply_print_config(const PrintConfig &print_config)
@@ -2722,11 +2848,8 @@ std::string GCode::extrude_loop(ExtrusionLoop loop, std::string description, dou
 
     if (m_layer->lower_layer != nullptr && lower_layer_edge_grid != nullptr) {
         if (! *lower_layer_edge_grid) {
-            // Create the distance field for a layer below.
-            const coord_t distance_field_resolution = coord_t(scale_(1.) + 0.5);
-            *lower_layer_edge_grid = make_unique<EdgeGrid::Grid>();
-            (*lower_layer_edge_grid)->create(m_layer->lower_layer->lslices, distance_field_resolution);
-            (*lower_layer_edge_grid)->calculate_sdf();
+            // Create the distance field for a layer below, if it was not calculated in advance by process_layers().
+            *lower_layer_edge_grid = make_lower_layer_edge_grid(*m_layer);
             #if 0
             {
                 static int iRun = 0;
@@ -3099,8 +3222,12 @@ void GCode::_write(FILE* file, const char *what)
 #endif // !ENABLE_GCODE_VIEWER
 
         // writes string to file
-        fwrite(gcode, 1, ::strlen(gcode), file);
-#if !ENABLE_GCODE_VIEWER
+        size_t len = ::strlen(gcode);
+        fwrite(gcode, 1, len, file);
+#if ENABLE_GCODE_VIEWER
+        // feeds the processor with the same G-code, so that the file does not need to be parsed again once exported
+        m_processor.process_buffer(gcode, gcode + len);
+#else
         // updates time estimator and gcode lines vector
         m_normal_time_estimator.add_gcode_block(gcode);
         if (m_silent_time_estimator_enabled)
@@ -3328,7 +3455,8 @@ std::string GCode::_extrude(const ExtrusionPath &path, std::string description,
         for (const Line &line : path.polyline.lines()) {
             const double line_length = line.length() * SCALING_FACTOR;
             path_length += line_length;
-            gcode += m_writer.extrude_to_xy(
+            m_writer.extrude_to_xy(
+                gcode,
                 this->point_to_gcode(line.b),
                 e_per_mm * line_length,
                 comment);
@@ -3382,7 +3510,7 @@ std::string GCode::travel_to(const Point &point, ExtrusionRole role, std::string
     Lines lines = travel.lines();
     if (! lines.empty()) {
         for (const Line &line : lines)
-    	    gcode += m_writer.travel_to_xy(this->point_to_gcode(line.b), comment);    
+    	    m_writer.travel_to_xy(gcode, this->point_to_gcode(line.b), comment);
         this->set_last_pos(lines.back().b);
     }
     return gcode;
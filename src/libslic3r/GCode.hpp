@@ -24,6 +24,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 #ifdef HAS_PRESSURE_EQUALIZER
 #include "GCode/PressureEqualizer.hpp"
@@ -55,9 +56,10 @@ public:
     AvoidCrossingPerimeters() : use_external_mp(false), use_external_mp_once(false), disable_once(true) {}
     ~AvoidCrossingPerimeters() {}
 
-    void reset() { m_external_mp.reset(); m_layer_mp.reset(); }
+    void reset() { m_external_mp.reset(); m_layer_mp = nullptr; m_layer_mp_cache.clear(); }
 	void init_external_mp(const Print &print);
-    void init_layer_mp(const ExPolygons &islands) { m_layer_mp = Slic3r::make_unique<MotionPlanner>(islands); }
+    // Reuses the motion planner of a recent layer with the same islands, including its lazily built graphs.
+    void init_layer_mp(ExPolygons &&islands);
 
     Polyline travel_to(const GCode &gcodegen, const Point &point);
 
@@ -66,7 +68,17 @@ private:
 	static Polygons collect_contours_all_layers(const PrintObjectPtrs& objects);
 
     std::unique_ptr<MotionPlanner> m_external_mp;
-    std::unique_ptr<MotionPlanner> m_layer_mp;
+    MotionPlanner                 *m_layer_mp = nullptr;
+
+    // Motion planners of the recently printed layers, the most recently used first.
+    // The same layer is printed for each instance of an object, and many layers of an object are often of the same shape.
+    struct LayerMP {
+        size_t                         islands_hash;
+        ExPolygons                     islands;
+        std::unique_ptr<MotionPlanner> mp;
+    };
+    static constexpr size_t        layer_mp_cache_size = 8;
+    std::vector<LayerMP>           m_layer_mp_cache;
 };
 
 class OozePrevention {
@@ -214,7 +226,9 @@ public:
     const PlaceholderParser& placeholder_parser() const { return m_placeholder_parser; }
     // Process a template through the placeholder parser, collect error messages to be reported
     // inside the generated string and after the G-code export finishes.
+    // The template is compiled once and cached in m_placeholder_parser_templates.
     std::string     placeholder_parser_process(const std::string &name, const std::string &templ, unsigned int current_extruder_id, const DynamicConfig *config_override = nullptr);
+    std::string     placeholder_parser_process(const std::string &name, const PlaceholderParser::Template &templ, unsigned int current_extruder_id, const DynamicConfig *config_override = nullptr);
     bool            enable_cooling_markers() const { return m_enable_cooling_markers; }
 
     // For Perl bindings, to be used exclusively by unit tests.
@@ -242,9 +256,16 @@ private:
 
     static std::vector<LayerToPrint>        		                   collect_layers_to_print(const PrintObject &object);
     static std::vector<std::pair<coordf_t, std::vector<LayerToPrint>>> collect_layers_to_print(const Print &print);
-    void            process_layer(
-        // Write into the output file.
-        FILE                            *file,
+    // G-code of a single print_z generated by process_layer(), to be post-processed and written out by process_layers().
+    struct LayerResult {
+        std::string gcode;
+        size_t      layer_id;
+        // Is spiral vase post-processing enabled for this layer?
+        bool        spiral_vase_enable { false };
+        static LayerResult make_nop_layer_result() { return { "", size_t(-1), false }; }
+        bool        is_nop_layer_result() const { return layer_id == size_t(-1); }
+    };
+    LayerResult     process_layer(
         const Print                     &print,
         // Set of object & print layers of the same PrintObject and with the same print_z.
         const std::vector<LayerToPrint> &layers,
@@ -253,7 +274,23 @@ private:
 		const std::vector<const PrintInstance*> *ordering,
         // If set to size_t(-1), then print all copies of all objects.
         // Otherwise print a single copy of a single object.
-        const size_t                     single_object_idx = size_t(-1));
+        const size_t                     single_object_idx,
+        // Distance fields of the layers below layers, indexed the same as layers. Calculated on demand if empty.
+        std::vector<std::unique_ptr<EdgeGrid::Grid>> &&lower_layer_edge_grids);
+    // Generate and export the layers in a pipeline. The distance fields of the lower layers are calculated in parallel,
+    // while the G-code generation, the spiral vase, the cooling buffer and the output each process the layers in order,
+    // working on different layers at the same time. The output is the same as if the layers were processed one by one.
+    void            process_layers(
+        const Print                                                         &print,
+        const ToolOrdering                                                  &tool_ordering,
+        const std::vector<std::pair<coordf_t, std::vector<LayerToPrint>>>   &layers_to_print,
+		// Pairs of PrintObject index and its instance index.
+		const std::vector<const PrintInstance*>                             *ordering,
+        // If set to size_t(-1), then print all copies of all objects.
+        // Otherwise print a single copy of a single object.
+        const size_t                                                         single_object_idx,
+        // Write into the output file.
+        FILE                                                                *file);
 
     void            set_last_pos(const Point &pos) { m_last_pos = pos; m_last_pos_defined = true; }
     bool            last_pos_defined() const { return m_last_pos_defined; }
@@ -345,6 +382,8 @@ private:
     FullPrintConfig                     m_config;
     GCodeWriter                         m_writer;
     PlaceholderParser                   m_placeholder_parser;
+    // Custom G-code templates compiled by the placeholder parser, indexed by the template text.
+    std::unordered_map<std::string, PlaceholderParser::Template> m_placeholder_parser_templates;
     // Collection of templates, on which the placeholder substitution failed.
     std::set<std::string>               m_placeholder_parser_failed_templates;
     OozePrevention                      m_ooze_prevention;
@@ -449,16 +488,16 @@ private:
     bool                                on_first_layer() const { return m_layer != nullptr && m_layer->id() == 0; }
 
     friend ObjectByExtruder& object_by_extruder(
-        std::map<unsigned int, std::vector<ObjectByExtruder>> &by_extruder, 
-        unsigned int                                           extruder_id, 
-        size_t                                                 object_idx, 
-        size_t                                                 num_objects);
+        std::vector<std::vector<ObjectByExtruder>> &by_extruder, 
+        unsigned int                                extruder_id, 
+        size_t                                      object_idx, 
+        size_t                                      num_objects);
     friend std::vector<ObjectByExtruder::Island>& object_islands_by_extruder(
-        std::map<unsigned int, std::vector<ObjectByExtruder>>  &by_extruder, 
-        unsigned int                                            extruder_id, 
-        size_t                                                  object_idx, 
-        size_t                                                  num_objects,
-        size_t                                                  num_islands);
+        std::vector<std::vector<ObjectByExtruder>> &by_extruder, 
+        unsigned int                                extruder_id, 
+        size_t                                      object_idx, 
+        size_t                                      num_objects,
+        size_t                                      num_islands);
 
     friend class Wipe;
     friend class WipeTowerIntegration;
@@ -1,10 +1,12 @@
 #include "../GCode.hpp"
+#include "../Utils.hpp"
 #include "CoolingBuffer.hpp"
-#include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/log/trivial.hpp>
+#include <algorithm>
 #include <iostream>
 #include <float.h>
+#include <string.h>
 
 #if 0
     #define DEBUG
@@ -50,7 +52,7 @@ struct CoolingLine
     };
 
     CoolingLine(unsigned int type, size_t  line_start, size_t  line_end) :
-        type(type), line_start(line_start), line_end(line_end),
+        type(type), line_start(line_start), line_end(line_end), comment_start(line_end), f_start(0), f_end(0), f_value(0),
         length(0.f), feedrate(0.f), time(0.f), time_max(0.f), slowdown(false) {}
 
     bool adjustable(bool slowdown_external_perimeters) const {
@@ -68,6 +70,13 @@ struct CoolingLine
     size_t  line_start;
     // End of this line at the G-code snippet.
     size_t  line_end;
+    // Start of the comment of a G0 / G1 line at the G-code snippet, line_end if there is no comment.
+    size_t  comment_start;
+    // Span of the value of the F word of a G0 / G1 line, which sets or modifies the feedrate.
+    size_t  f_start;
+    size_t  f_end;
+    // Feedrate in mm/min as written by the F word, or the new extruder of a TYPE_SET_TOOL line.
+    int     f_value;
     // XY Euclidian length of this segment.
     float   length;
     // Current feedrate, possibly adjusted.
@@ -86,52 +95,52 @@ struct PerExtruderAdjustments
     // Calculate the total elapsed time per this extruder, adjusted for the slowdown.
     float elapsed_time_total() const {
         float time_total = 0.f;
-        for (const CoolingLine &line : lines)
-            time_total += line.time;
+        for (const CoolingLine *line : lines)
+            time_total += line->time;
         return time_total;
     }
     // Calculate the total elapsed time when slowing down 
     // to the minimum extrusion feed rate defined for the current material.
     float maximum_time_after_slowdown(bool slowdown_external_perimeters) const {
         float time_total = 0.f;
-        for (const CoolingLine &line : lines)
-            if (line.adjustable(slowdown_external_perimeters)) {
-                if (line.time_max == FLT_MAX)
+        for (const CoolingLine *line : lines)
+            if (line->adjustable(slowdown_external_perimeters)) {
+                if (line->time_max == FLT_MAX)
                     return FLT_MAX;
                 else
-                    time_total += line.time_max;
+                    time_total += line->time_max;
             } else
-                time_total += line.time;
+                time_total += line->time;
         return time_total;
     }
     // Calculate the adjustable part of the total time.
     float adjustable_time(bool slowdown_external_perimeters) const {
         float time_total = 0.f;
-        for (const CoolingLine &line : lines)
-            if (line.adjustable(slowdown_external_perimeters))
-                time_total += line.time;
+        for (const CoolingLine *line : lines)
+            if (line->adjustable(slowdown_external_perimeters))
+                time_total += line->time;
         return time_total;
     }
     // Calculate the non-adjustable part of the total time.
     float non_adjustable_time(bool slowdown_external_perimeters) const {
         float time_total = 0.f;
-        for (const CoolingLine &line : lines)
-            if (! line.adjustable(slowdown_external_perimeters))
-                time_total += line.time;
+        for (const CoolingLine *line : lines)
+            if (! line->adjustable(slowdown_external_perimeters))
+                time_total += line->time;
         return time_total;
     }
     // Slow down the adjustable extrusions to the minimum feedrate allowed for the current extruder material.
     // Used by both proportional and non-proportional slow down.
     float slowdown_to_minimum_feedrate(bool slowdown_external_perimeters) {
         float time_total = 0.f;
-        for (CoolingLine &line : lines) {
-            if (line.adjustable(slowdown_external_perimeters)) {
-                assert(line.time_max >= 0.f && line.time_max < FLT_MAX);
-                line.slowdown = true;
-                line.time     = line.time_max;
-                line.feedrate = line.length / line.time;
+        for (CoolingLine *line : lines) {
+            if (line->adjustable(slowdown_external_perimeters)) {
+                assert(line->time_max >= 0.f && line->time_max < FLT_MAX);
+                line->slowdown = true;
+                line->time     = line->time_max;
+                line->feedrate = line->length / line->time;
             }
-            time_total += line.time;
+            time_total += line->time;
         }
         return time_total;
     }
@@ -140,13 +149,13 @@ struct PerExtruderAdjustments
     float slow_down_proportional(float factor, bool slowdown_external_perimeters) {
         assert(factor >= 1.f);
         float time_total = 0.f;
-        for (CoolingLine &line : lines) {
-            if (line.adjustable(slowdown_external_perimeters)) {
-                line.slowdown = true;
-                line.time     = std::min(line.time_max, line.time * factor);
-                line.feedrate = line.length / line.time;
+        for (CoolingLine *line : lines) {
+            if (line->adjustable(slowdown_external_perimeters)) {
+                line->slowdown = true;
+                line->time     = std::min(line->time_max, line->time * factor);
+                line->feedrate = line->length / line->time;
             }
-            time_total += line.time;
+            time_total += line->time;
         }
         return time_total;
     }
@@ -154,17 +163,17 @@ struct PerExtruderAdjustments
     // Sort the lines, adjustable first, higher feedrate first.
     // Used by non-proportional slow down.
     void sort_lines_by_decreasing_feedrate() {
-        std::sort(lines.begin(), lines.end(), [](const CoolingLine &l1, const CoolingLine &l2) {
-            bool adj1 = l1.adjustable();
-            bool adj2 = l2.adjustable();
-            return (adj1 == adj2) ? l1.feedrate > l2.feedrate : adj1;
+        std::sort(lines.begin(), lines.end(), [](const CoolingLine *l1, const CoolingLine *l2) {
+            bool adj1 = l1->adjustable();
+            bool adj2 = l2->adjustable();
+            return (adj1 == adj2) ? l1->feedrate > l2->feedrate : adj1;
         });
         for (n_lines_adjustable = 0; 
-            n_lines_adjustable < lines.size() && this->lines[n_lines_adjustable].adjustable();
+            n_lines_adjustable < lines.size() && this->lines[n_lines_adjustable]->adjustable();
             ++ n_lines_adjustable);
         time_non_adjustable = 0.f;
         for (size_t i = n_lines_adjustable; i < lines.size(); ++ i)
-            time_non_adjustable += lines[i].time;
+            time_non_adjustable += lines[i]->time;
     }
 
     // Calculate the maximum time stretch when slowing down to min_feedrate.
@@ -174,7 +183,7 @@ struct PerExtruderAdjustments
         float time_stretch = 0.f;
         assert(this->min_print_speed < min_feedrate + EPSILON);
         for (size_t i = 0; i < n_lines_adjustable; ++ i) {
-            const CoolingLine &line = lines[i];
+            const CoolingLine &line = *lines[i];
             if (line.feedrate > min_feedrate)
                 time_stretch += line.time * (line.feedrate / min_feedrate - 1.f);
         }
@@ -187,7 +196,7 @@ struct PerExtruderAdjustments
     void slow_down_to_feedrate(float min_feedrate) {
         assert(this->min_print_speed < min_feedrate + EPSILON);
         for (size_t i = 0; i < n_lines_adjustable; ++ i) {
-            CoolingLine &line = lines[i];
+            CoolingLine &line = *lines[i];
             if (line.feedrate > min_feedrate) {
                 line.time *= std::max(1.f, line.feedrate / min_feedrate);
                 line.feedrate = min_feedrate;
@@ -205,8 +214,8 @@ struct PerExtruderAdjustments
     // Minimum print speed allowed for this extruder.
     float                       min_print_speed     = 0.f;
 
-    // Parsed lines.
-    std::vector<CoolingLine>    lines;
+    // Parsed lines of this extruder, pointing to the lines of the layer.
+    std::vector<CoolingLine*>   lines;
     // The following two values are set by sort_lines_by_decreasing_feedrate():
     // Number of adjustable lines, at the start of lines.
     size_t                      n_lines_adjustable  = 0;
@@ -235,7 +244,7 @@ float new_feedrate_to_reach_time_stretch(
         for (auto it = it_begin; it != it_end; ++ it) {
 			assert((*it)->min_print_speed < min_feedrate + EPSILON);
 			for (size_t i = 0; i < (*it)->n_lines_adjustable; ++i) {
-				const CoolingLine &line = (*it)->lines[i];
+				const CoolingLine &line = *(*it)->lines[i];
                 if (line.feedrate > min_feedrate) {
                     nomin += line.time * line.feedrate;
                     denom += line.time;
@@ -251,7 +260,7 @@ float new_feedrate_to_reach_time_stretch(
             goto finished;
         for (auto it = it_begin; it != it_end; ++ it)
 			for (size_t i = 0; i < (*it)->n_lines_adjustable; ++i) {
-				const CoolingLine &line = (*it)->lines[i];
+				const CoolingLine &line = *(*it)->lines[i];
                 if (line.feedrate > min_feedrate && line.feedrate < new_feedrate)
                     // Some of the line segments taken into account in the calculation of nomin / denom are now slower than new_feedrate, 
                     // which makes the new_feedrate lower than it should be.
@@ -281,14 +290,23 @@ finished:
 
 std::string CoolingBuffer::process_layer(const std::string &gcode, size_t layer_id)
 {
-    std::vector<PerExtruderAdjustments> per_extruder_adjustments = this->parse_layer_gcode(gcode, m_current_pos);
+    std::vector<CoolingLine>            lines;
+    std::vector<PerExtruderAdjustments> per_extruder_adjustments = this->parse_layer_gcode(gcode, m_current_pos, lines);
     float layer_time_stretched = this->calculate_layer_slowdown(per_extruder_adjustments);
-    return this->apply_layer_cooldown(gcode, layer_id, layer_time_stretched, per_extruder_adjustments);
+    return this->apply_layer_cooldown(gcode, layer_id, layer_time_stretched, lines);
+}
+
+// Does the G-code text [begin, end) contain the marker?
+static inline bool contains_marker(const char *begin, const char *end, const char *marker, size_t marker_len)
+{
+    return std::search(begin, end, marker, marker + marker_len) != end;
 }
 
 // Parse the layer G-code for the moves, which could be adjusted.
-// Return the list of parsed lines, bucketed by an extruder.
-std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::string &gcode, std::vector<float> &current_pos) const
+// The parsed lines are stored into lines in the order of the G-code, each line knowing the spans of its F word
+// and of its comment, so that apply_layer_cooldown() does not need to parse the G-code again.
+// Return the parsed lines bucketed by an extruder, pointing into lines.
+std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::string &gcode, std::vector<float> &current_pos, std::vector<CoolingLine> &lines) const
 {
     const FullPrintConfig       &config        = m_gcodegen.config();
     const std::vector<Extruder> &extruders     = m_gcodegen.writer().extruders();
@@ -308,47 +326,59 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
         map_extruder_to_per_extruder_adjustment[extruder_id] = i;
     }
 
+    // The lines are referenced by per_extruder_adjustments, they must not be reallocated. At most one line is stored per G-code line.
+    lines.clear();
+    lines.reserve(std::count(gcode.begin(), gcode.end(), '\n') + 1);
+
     const std::string toolchange_prefix = m_gcodegen.writer().toolchange_prefix();
     unsigned int      current_extruder  = m_current_extruder;
     PerExtruderAdjustments *adjustment  = &per_extruder_adjustments[map_extruder_to_per_extruder_adjustment[current_extruder]];
-    const char       *line_start = gcode.c_str();
-    const char       *line_end   = line_start;
+    const char       *gcode_begin = gcode.c_str();
+    const char       *gcode_end   = gcode_begin + gcode.size();
+    const char       *line_start  = gcode_begin;
+    const char       *line_end    = line_start;
     const char        extrusion_axis = config.get_extrusion_axis()[0];
     // Index of an existing CoolingLine of the current adjustment, which holds the feedrate setting command
     // for a sequence of extrusion moves.
     size_t            active_speed_modifier = size_t(-1);
 
-    for (; *line_start != 0; line_start = line_end) 
+    for (; line_start != gcode_end; line_start = line_end)
     {
-        while (*line_end != '\n' && *line_end != 0)
-            ++ line_end;
-        // sline will not contain the trailing '\n'.
-        std::string sline(line_start, line_end);
+        // sline_end points to the trailing '\n' or to the end of the G-code.
+        const char *sline_end = (const char*)memchr(line_start, '\n', gcode_end - line_start);
+        if (sline_end == nullptr)
+            sline_end = gcode_end;
+        line_end = (sline_end == gcode_end) ? sline_end : sline_end + 1;
+        auto starts_with = [line_start, sline_end](const char *prefix, size_t len) {
+            return size_t(sline_end - line_start) >= len && memcmp(line_start, prefix, len) == 0;
+        };
         // CoolingLine will contain the trailing '\n'.
-        if (*line_end == '\n')
-            ++ line_end;
-        CoolingLine line(0, line_start - gcode.c_str(), line_end - gcode.c_str());
-        if (boost::starts_with(sline, "G0 "))
+        CoolingLine line(0, line_start - gcode_begin, line_end - gcode_begin);
+        if (starts_with("G0 ", 3))
             line.type = CoolingLine::TYPE_G0;
-        else if (boost::starts_with(sline, "G1 "))
+        else if (starts_with("G1 ", 3))
             line.type = CoolingLine::TYPE_G1;
-        else if (boost::starts_with(sline, "G92 "))
+        else if (starts_with("G92 ", 4))
             line.type = CoolingLine::TYPE_G92;
         if (line.type) {
             // G0, G1 or G92
             // Parse the G-code line.
-            std::vector<float> new_pos(current_pos);
-            const char *c = sline.data() + 3;
+            float new_pos[5];
+            std::copy(current_pos.begin(), current_pos.end(), new_pos);
+            const char *c = line_start + 3;
             for (;;) {
                 // Skip whitespaces.
-                for (; *c == ' ' || *c == '\t'; ++ c);
-                if (*c == 0 || *c == ';')
+                for (; c != sline_end && (*c == ' ' || *c == '\t'); ++ c);
+                if (c == sline_end || *c == ';')
                     break;
                 // Parse the axis.
                 size_t axis = (*c >= 'X' && *c <= 'Z') ? (*c - 'X') :
                               (*c == extrusion_axis) ? 3 : (*c == 'F') ? 4 : size_t(-1);
                 if (axis != size_t(-1)) {
-                    new_pos[axis] = float(atof(++c));
+                    char  *number_end = nullptr;
+                    double value      = string_to_double_decimal_point(++ c, &number_end);
+                    // Don't let the number continue on the next line.
+                    new_pos[axis] = number_end <= sline_end ? float(value) : 0.f;
                     if (axis == 4) {
                         // Convert mm/min to mm/sec.
                         new_pos[4] /= 60.f;
@@ -358,15 +388,21 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
                     }
                 }
                 // Skip this word.
-                for (; *c != ' ' && *c != '\t' && *c != 0; ++ c);
+                for (; c != sline_end && *c != ' ' && *c != '\t'; ++ c);
             }
-            bool external_perimeter = boost::contains(sline, ";_EXTERNAL_PERIMETER");
-            bool wipe               = boost::contains(sline, ";_WIPE");
+            // All the cooling markers start with a semicolon, look for them in the comment only.
+            const char *comment = (const char*)memchr(line_start, ';', sline_end - line_start);
+            if (comment == nullptr)
+                comment = sline_end;
+            else
+                line.comment_start = comment - gcode_begin;
+            bool external_perimeter = contains_marker(comment, sline_end, ";_EXTERNAL_PERIMETER", 20);
+            bool wipe               = contains_marker(comment, sline_end, ";_WIPE", 6);
             if (external_perimeter)
                 line.type |= CoolingLine::TYPE_EXTERNAL_PERIMETER;
             if (wipe)
                 line.type |= CoolingLine::TYPE_WIPE;
-            if (boost::contains(sline, ";_EXTRUDE_SET_SPEED") && ! wipe) {
+            if (! wipe && contains_marker(comment, sline_end, ";_EXTRUDE_SET_SPEED", 19)) {
                 line.type |= CoolingLine::TYPE_ADJUSTABLE;
                 active_speed_modifier = adjustment->lines.size();
             }
@@ -397,7 +433,7 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
                 if (active_speed_modifier < adjustment->lines.size() && (line.type & CoolingLine::TYPE_G1)) {
                     // Inside the ";_EXTRUDE_SET_SPEED" blocks, there must not be a G1 Fxx entry.
                     assert((line.type & CoolingLine::TYPE_HAS_F) == 0);
-                    CoolingLine &sm = adjustment->lines[active_speed_modifier];
+                    CoolingLine &sm = *adjustment->lines[active_speed_modifier];
                     assert(sm.feedrate > 0.f);
                     sm.length   += line.length;
                     sm.time     += line.time;
@@ -411,17 +447,27 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
                     line.type = 0;
                 }
             }
-            current_pos = std::move(new_pos);
-        } else if (boost::starts_with(sline, ";_EXTRUDE_END")) {
+            std::copy(new_pos, new_pos + 5, current_pos.begin());
+            if (line.type & (CoolingLine::TYPE_ADJUSTABLE | CoolingLine::TYPE_EXTERNAL_PERIMETER | CoolingLine::TYPE_WIPE | CoolingLine::TYPE_HAS_F)) {
+                // Remember the F word for apply_layer_cooldown(), which may replace or remove it.
+                const char *fpos = strstr(line_start + 2, " F") + 2;
+                const char *fend = fpos;
+                for (const char *end = gcode_begin + line.comment_start; fend != end && *fend != ' ' && *fend != ';' && *fend != '\n'; ++ fend);
+                line.f_start = fpos - gcode_begin;
+                line.f_end   = fend - gcode_begin;
+                line.f_value = atoi(fpos);
+            }
+        } else if (starts_with(";_EXTRUDE_END", 13)) {
             line.type = CoolingLine::TYPE_EXTRUDE_END;
             active_speed_modifier = size_t(-1);
-        } else if (boost::starts_with(sline, toolchange_prefix)) {
-            unsigned int new_extruder = (unsigned int)atoi(sline.c_str() + toolchange_prefix.size());
+        } else if (starts_with(toolchange_prefix.data(), toolchange_prefix.size())) {
+            unsigned int new_extruder = (unsigned int)atoi(line_start + toolchange_prefix.size());
             // Only change extruder in case the number is meaningful. User could provide an out-of-range index through custom gcodes - those shall be ignored.
             if (new_extruder < map_extruder_to_per_extruder_adjustment.size()) {
                 if (new_extruder != current_extruder) {
                     // Switch the tool.
-                    line.type = CoolingLine::TYPE_SET_TOOL;
+                    line.type    = CoolingLine::TYPE_SET_TOOL;
+                    line.f_value = int(new_extruder);
                     current_extruder = new_extruder;
                     adjustment         = &per_extruder_adjustments[map_extruder_to_per_extruder_adjustment[current_extruder]];
                 }
@@ -429,24 +475,25 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
             else {
                 // Only log the error in case of MM printer. Single extruder printers likely ignore any T anyway.
                 if (map_extruder_to_per_extruder_adjustment.size() > 1)
-                    BOOST_LOG_TRIVIAL(error) << "CoolingBuffer encountered an invalid toolchange, maybe from a custom gcode: " << sline;
+                    BOOST_LOG_TRIVIAL(error) << "CoolingBuffer encountered an invalid toolchange, maybe from a custom gcode: " << std::string(line_start, sline_end);
             }
 
-        } else if (boost::starts_with(sline, ";_BRIDGE_FAN_START")) {
+        } else if (starts_with(";_BRIDGE_FAN_START", 18)) {
             line.type = CoolingLine::TYPE_BRIDGE_FAN_START;
-        } else if (boost::starts_with(sline, ";_BRIDGE_FAN_END")) {
+        } else if (starts_with(";_BRIDGE_FAN_END", 16)) {
             line.type = CoolingLine::TYPE_BRIDGE_FAN_END;
-        } else if (boost::starts_with(sline, "G4 ")) {
+        } else if (starts_with("G4 ", 3)) {
             // Parse the wait time.
             line.type = CoolingLine::TYPE_G4;
-            size_t pos_S = sline.find('S', 3);
-            size_t pos_P = sline.find('P', 3);
-            line.time = line.time_max = float(
-                (pos_S > 0) ? atof(sline.c_str() + pos_S + 1) :
-                (pos_P > 0) ? atof(sline.c_str() + pos_P + 1) * 0.001 : 0.);
+            const char *pos_S = std::find(line_start + 3, sline_end, 'S');
+            char       *number_end = nullptr;
+            double      time = (pos_S != sline_end) ? string_to_double_decimal_point(pos_S + 1, &number_end) : 0.;
+            line.time = line.time_max = (number_end <= sline_end) ? float(time) : 0.f;
+        }
+        if (line.type != 0) {
+            lines.emplace_back(std::move(line));
+            adjustment->lines.emplace_back(&lines.back());
         }
-        if (line.type != 0)
-            adjustment->lines.emplace_back(std::move(line));
     }
 
     return per_extruder_adjustments;
@@ -523,8 +570,8 @@ static inline void extruder_range_slow_down_non_proportional(
         adj->idx_line_begin = 0;
         adj->idx_line_end   = 0;
         assert(adj->idx_line_begin < adj->n_lines_adjustable);
-        if (adj->lines[adj->idx_line_begin].feedrate > feedrate)
-            feedrate = adj->lines[adj->idx_line_begin].feedrate;
+        if (adj->lines[adj->idx_line_begin]->feedrate > feedrate)
+            feedrate = adj->lines[adj->idx_line_begin]->feedrate;
     }
     assert(feedrate > 0.f);
     // Sort by min_print_speed, maximum speed first.
@@ -535,14 +582,14 @@ static inline void extruder_range_slow_down_non_proportional(
         // For each extruder, find the span of lines with a feedrate close to feedrate.
         for (PerExtruderAdjustments *adj : by_min_print_speed) {
             for (adj->idx_line_end = adj->idx_line_begin;
-                adj->idx_line_end < adj->n_lines_adjustable && adj->lines[adj->idx_line_end].feedrate > feedrate - EPSILON;
+                adj->idx_line_end < adj->n_lines_adjustable && adj->lines[adj->idx_line_end]->feedrate > feedrate - EPSILON;
                  ++ adj->idx_line_end) ;
         }
         // Find the next highest adjustable feedrate among the extruders.
         float feedrate_next = 0.f;
         for (PerExtruderAdjustments *adj : by_min_print_speed)
-            if (adj->idx_line_end < adj->n_lines_adjustable && adj->lines[adj->idx_line_end].feedrate > feedrate_next)
-                feedrate_next = adj->lines[adj->idx_line_end].feedrate;
+            if (adj->idx_line_end < adj->n_lines_adjustable && adj->lines[adj->idx_line_end]->feedrate > feedrate_next)
+                feedrate_next = adj->lines[adj->idx_line_end]->feedrate;
         // Slow down, limited by max(feedrate_next, min_print_speed).
         for (auto adj = by_min_print_speed.begin(); adj != by_min_print_speed.end();) {
             // Slow down at most by time_stretch.
@@ -647,7 +694,7 @@ float CoolingBuffer::calculate_layer_slowdown(std::vector<PerExtruderAdjustments
     return elapsed_time_total0;
 }
 
-// Apply slow down over G-code lines stored in per_extruder_adjustments, enable fan if needed.
+// Apply slow down over the parsed G-code lines, enable fan if needed.
 // Returns the adjusted G-code.
 std::string CoolingBuffer::apply_layer_cooldown(
     // Source G-code for the current layer.
@@ -656,22 +703,9 @@ std::string CoolingBuffer::apply_layer_cooldown(
     size_t                                  layer_id, 
     // Total time of this layer after slow down, used to control the fan.
     float                                   layer_time,
-    // Per extruder list of G-code lines and their cool down attributes.
-    std::vector<PerExtruderAdjustments>    &per_extruder_adjustments)
+    // G-code lines and their cool down attributes, in the order of the source G-code.
+    const std::vector<CoolingLine>         &lines)
 {
-    // First sort the adjustment lines by of multiple extruders by their position in the source G-code.
-    std::vector<const CoolingLine*> lines;
-    {
-        size_t n_lines = 0;
-        for (const PerExtruderAdjustments &adj : per_extruder_adjustments)
-            n_lines += adj.lines.size();
-        lines.reserve(n_lines);
-        for (const PerExtruderAdjustments &adj : per_extruder_adjustments)
-            for (const CoolingLine &line : adj.lines)
-                lines.emplace_back(&line);
-        std::sort(lines.begin(), lines.end(), [](const CoolingLine *ln1, const CoolingLine *ln2) { return ln1->line_start < ln2->line_start; } );
-    }
-    // Second generate the adjusted G-code.
     std::string new_gcode;
     new_gcode.reserve(gcode.size() * 2);
     int  fan_speed          = -1;
@@ -713,47 +747,44 @@ std::string CoolingBuffer::apply_layer_cooldown(
 
     const char         *pos               = gcode.c_str();
     int                 current_feedrate  = 0;
-    const std::string   toolchange_prefix = m_gcodegen.writer().toolchange_prefix();
     change_extruder_set_fan();
-    for (const CoolingLine *line : lines) {
-        const char *line_start  = gcode.c_str() + line->line_start;
-        const char *line_end    = gcode.c_str() + line->line_end;
+    for (const CoolingLine &line : lines) {
+        const char *line_start  = gcode.c_str() + line.line_start;
+        const char *line_end    = gcode.c_str() + line.line_end;
         if (line_start > pos)
             new_gcode.append(pos, line_start - pos);
-        if (line->type & CoolingLine::TYPE_SET_TOOL) {
-            unsigned int new_extruder = (unsigned int)atoi(line_start + toolchange_prefix.size());
+        if (line.type & CoolingLine::TYPE_SET_TOOL) {
+            unsigned int new_extruder = (unsigned int)line.f_value;
             if (new_extruder != m_current_extruder) {
                 m_current_extruder = new_extruder;
                 change_extruder_set_fan();
             }
             new_gcode.append(line_start, line_end - line_start);
-        } else if (line->type & CoolingLine::TYPE_BRIDGE_FAN_START) {
+        } else if (line.type & CoolingLine::TYPE_BRIDGE_FAN_START) {
             if (bridge_fan_control)
                 new_gcode += m_gcodegen.writer().set_fan(bridge_fan_speed, true);
-        } else if (line->type & CoolingLine::TYPE_BRIDGE_FAN_END) {
+        } else if (line.type & CoolingLine::TYPE_BRIDGE_FAN_END) {
             if (bridge_fan_control)
                 new_gcode += m_gcodegen.writer().set_fan(fan_speed, true);
-        } else if (line->type & CoolingLine::TYPE_EXTRUDE_END) {
+        } else if (line.type & CoolingLine::TYPE_EXTRUDE_END) {
             // Just remove this comment.
-        } else if (line->type & (CoolingLine::TYPE_ADJUSTABLE | CoolingLine::TYPE_EXTERNAL_PERIMETER | CoolingLine::TYPE_WIPE | CoolingLine::TYPE_HAS_F)) {
-            // Find the start of a comment, or roll to the end of line.
-            const char *end = line_start;
-            for (; end < line_end && *end != ';'; ++ end);
-            // Find the 'F' word.
-            const char *fpos            = strstr(line_start + 2, " F") + 2;
+        } else if (line.type & (CoolingLine::TYPE_ADJUSTABLE | CoolingLine::TYPE_EXTERNAL_PERIMETER | CoolingLine::TYPE_WIPE | CoolingLine::TYPE_HAS_F)) {
+            // The start of a comment, or the end of line.
+            const char *end = gcode.c_str() + line.comment_start;
+            // The value of the 'F' word.
+            const char *fpos            = gcode.c_str() + line.f_start;
             int         new_feedrate    = current_feedrate;
             bool        modify          = false;
-            assert(fpos != nullptr);
-            if (line->slowdown) {
+            if (line.slowdown) {
                 modify       = true;
-                new_feedrate = int(floor(60. * line->feedrate + 0.5));
+                new_feedrate = int(floor(60. * line.feedrate + 0.5));
             } else {
-                new_feedrate = atoi(fpos);
+                new_feedrate = line.f_value;
                 if (new_feedrate != current_feedrate) {
                     // Append the line without the comment.
                     new_gcode.append(line_start, end - line_start);
                     current_feedrate = new_feedrate;
-                } else if ((line->type & (CoolingLine::TYPE_ADJUSTABLE | CoolingLine::TYPE_EXTERNAL_PERIMETER | CoolingLine::TYPE_WIPE)) || line->length == 0.) {
+                } else if ((line.type & (CoolingLine::TYPE_ADJUSTABLE | CoolingLine::TYPE_EXTERNAL_PERIMETER | CoolingLine::TYPE_WIPE)) || line.length == 0.) {
                     // Feedrate does not change and this line does not move the print head. Skip the complete G-code line including the G-code comment.
                     end = line_end;
                 } else {
@@ -778,7 +809,7 @@ std::string CoolingBuffer::apply_layer_cooldown(
                     new_gcode.append(line_start, f - line_start + 1);
                 }
                 // Skip the non-whitespaces of the F parameter up the comment or end of line.
-                for (; fpos != end && *fpos != ' ' && *fpos != ';' && *fpos != '\n'; ++fpos);
+                fpos = gcode.c_str() + line.f_end;
                 // Append the rest of the line without the comment.
                 if (fpos < end)
                     new_gcode.append(fpos, end - fpos);
@@ -787,13 +818,13 @@ std::string CoolingBuffer::apply_layer_cooldown(
             }
             // Process the rest of the line.
             if (end < line_end) {
-                if (line->type & (CoolingLine::TYPE_ADJUSTABLE | CoolingLine::TYPE_EXTERNAL_PERIMETER | CoolingLine::TYPE_WIPE)) {
+                if (line.type & (CoolingLine::TYPE_ADJUSTABLE | CoolingLine::TYPE_EXTERNAL_PERIMETER | CoolingLine::TYPE_WIPE)) {
                     // Process comments, remove ";_EXTRUDE_SET_SPEED", ";_EXTERNAL_PERIMETER", ";_WIPE"
                     std::string comment(end, line_end);
                     boost::replace_all(comment, ";_EXTRUDE_SET_SPEED", "");
-                    if (line->type & CoolingLine::TYPE_EXTERNAL_PERIMETER)
+                    if (line.type & CoolingLine::TYPE_EXTERNAL_PERIMETER)
                         boost::replace_all(comment, ";_EXTERNAL_PERIMETER", "");
-                    if (line->type & CoolingLine::TYPE_WIPE)
+                    if (line.type & CoolingLine::TYPE_WIPE)
                         boost::replace_all(comment, ";_WIPE", "");
                     new_gcode += comment;
                 } else {
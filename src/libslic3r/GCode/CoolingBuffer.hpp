@@ -9,6 +9,7 @@ namespace Slic3r {
 
 class GCode;
 class Layer;
+struct CoolingLine;
 struct PerExtruderAdjustments;
 
 // A standalone G-code filter, to control cooling of the print.
@@ -30,11 +31,12 @@ public:
 
 private:
 	CoolingBuffer& operator=(const CoolingBuffer&) = delete;
-    std::vector<PerExtruderAdjustments> parse_layer_gcode(const std::string &gcode, std::vector<float> &current_pos) const;
+    // Parse the G-code of a layer once into lines, which are adjusted in place and then applied to the G-code by apply_layer_cooldown().
+    std::vector<PerExtruderAdjustments> parse_layer_gcode(const std::string &gcode, std::vector<float> &current_pos, std::vector<CoolingLine> &lines) const;
     float       calculate_layer_slowdown(std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
-    // Apply slow down over G-code lines stored in per_extruder_adjustments, enable fan if needed.
+    // Apply slow down over the parsed G-code lines, enable fan if needed.
     // Returns the adjusted G-code.
-    std::string apply_layer_cooldown(const std::string &gcode, size_t layer_id, float layer_time, std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
+    std::string apply_layer_cooldown(const std::string &gcode, size_t layer_id, float layer_time, const std::vector<CoolingLine> &lines);
 
     GCode&              m_gcodegen;
     std::string         m_gcode;
@@ -7,6 +7,7 @@
 #include <boost/nowide/fstream.hpp>
 #include <boost/nowide/cstdio.hpp>
 
+#include <algorithm>
 #include <float.h>
 #include <assert.h>
 
@@ -339,7 +340,6 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename)
         return std::string(line_M73);
     };
 
-    GCodeReader parser;
     std::string gcode_line;
     size_t g1_lines_counter = 0;
     // keeps track of last exported pair <percent, remaining time>
@@ -353,6 +353,10 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename)
 
     // replace placeholder lines with the proper final value
     auto process_placeholders = [&](const std::string& gcode_line) {
+        // all the placeholders are comments, skip the G-code lines quickly
+        if (gcode_line.front() != ';')
+            return std::make_pair(false, gcode_line);
+
         // remove trailing '\n'
         std::string line = gcode_line.substr(0, gcode_line.length() - 1);
 
@@ -385,13 +389,17 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename)
     };
 
     // check for temporary lines
-    auto is_temporary_decoration = [](const std::string& gcode_line) {
-        // remove trailing '\n'
-        std::string line = gcode_line.substr(0, gcode_line.length() - 1);
-        if (line == "; " + Layer_Change_Tag)
-            return true;
-        else
-            return false;
+    const std::string layer_change_line = "; " + Layer_Change_Tag + "\n";
+    auto is_temporary_decoration = [&layer_change_line](const std::string& gcode_line) {
+        return gcode_line == layer_change_line;
+    };
+
+    // Only the G1 lines are of interest, test for them without parsing the whole line by GCodeReader.
+    auto is_G1_line = [](const std::string& gcode_line) {
+        const char* c = gcode_line.c_str();
+        while (*c == ' ' || *c == '\t')
+            ++c;
+        return c[0] == 'G' && c[1] == '1' && (c[2] == ' ' || c[2] == '\t' || c[2] == ';' || c[2] == '\r' || c[2] == '\n' || c[2] == 0);
     };
 
     // add lines M73 to exported gcode
@@ -439,13 +447,10 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename)
                 continue;
 
             // add lines M73 where needed
-            parser.parse_line(gcode_line,
-                [&](GCodeReader& reader, const GCodeReader::GCodeLine& line) {
-                    if (line.cmd_is("G1")) {
-                        process_line_G1();
-                        ++g1_lines_counter;
-                    }
-                });
+            if (is_G1_line(gcode_line)) {
+                process_line_G1();
+                ++g1_lines_counter;
+            }
         }
 
         export_line += gcode_line;
@@ -464,6 +469,63 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename)
             "Is " + out_path + " locked?" + '\n');
 }
 
+GCodeProcessor::MoveVertex GCodeProcessor::MoveVertices::operator[](size_t idx) const
+{
+    assert(idx < this->size());
+    auto it_run = std::upper_bound(m_runs.begin(), m_runs.end(), idx, [](size_t idx, const Run& run) { return idx < run.first; });
+    assert(it_run != m_runs.begin());
+    return this->make_vertex(idx, it_run - m_runs.begin() - 1);
+}
+
+void GCodeProcessor::MoveVertices::emplace_back(const MoveVertex& move)
+{
+    assert(move.time == static_cast<float>(this->size()));
+    if (m_runs.empty() || ! m_runs.back().same_attributes(move)) {
+        Run run;
+        run.first          = static_cast<uint32_t>(this->size());
+        run.extrusion_role = move.extrusion_role;
+        run.extruder_id    = move.extruder_id;
+        run.cp_color_id    = move.cp_color_id;
+        run.z              = move.position.z();
+        run.feedrate       = move.feedrate;
+        run.width          = move.width;
+        run.height         = move.height;
+        run.mm3_per_mm     = move.mm3_per_mm;
+        run.fan_speed      = move.fan_speed;
+        m_runs.emplace_back(run);
+    }
+    m_runs.back().types_mask |= 1 << static_cast<int>(move.type);
+    m_types.emplace_back(move.type);
+    m_xy.emplace_back(move.position.x(), move.position.y());
+    m_delta_extruder.emplace_back(move.delta_extruder);
+}
+
+size_t GCodeProcessor::MoveVertices::memsize() const
+{
+    return SLIC3R_STDVEC_MEMSIZE(m_types, EMoveType) + SLIC3R_STDVEC_MEMSIZE(m_xy, Vec2f) + 
+           SLIC3R_STDVEC_MEMSIZE(m_delta_extruder, float) + SLIC3R_STDVEC_MEMSIZE(m_runs, Run);
+}
+
+GCodeProcessor::MoveVertex GCodeProcessor::MoveVertices::make_vertex(size_t idx, size_t run_idx) const
+{
+    const Run& run = m_runs[run_idx];
+    assert(run.first <= idx && (run_idx + 1 == m_runs.size() || idx < m_runs[run_idx + 1].first));
+    MoveVertex move;
+    move.type           = m_types[idx];
+    move.extrusion_role = run.extrusion_role;
+    move.extruder_id    = run.extruder_id;
+    move.cp_color_id    = run.cp_color_id;
+    move.position       = Vec3f(m_xy[idx].x(), m_xy[idx].y(), run.z);
+    move.delta_extruder = m_delta_extruder[idx];
+    move.feedrate       = run.feedrate;
+    move.width          = run.width;
+    move.height         = run.height;
+    move.mm3_per_mm     = run.mm3_per_mm;
+    move.fan_speed      = run.fan_speed;
+    move.time           = static_cast<float>(idx);
+    return move;
+}
+
 const std::vector<std::pair<GCodeProcessor::EProducer, std::string>> GCodeProcessor::Producers = {
     { EProducer::PrusaSlicer, "PrusaSlicer" },
     { EProducer::Cura,        "Cura_SteamEngine" },
@@ -716,6 +778,7 @@ void GCodeProcessor::reset()
     m_producers_enabled = false;
 
     m_time_processor.reset();
+    m_incomplete_line.clear();
 
     m_result.reset();
     m_result.id = ++s_result_id;
@@ -773,6 +836,50 @@ void GCodeProcessor::process_file(const std::string& filename, std::function<voi
         process_gcode_line(line);
         });
 
+    finalize(filename);
+
+#if ENABLE_GCODE_VIEWER_STATISTICS
+    m_result.time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start_time).count();
+#endif // ENABLE_GCODE_VIEWER_STATISTICS
+}
+
+void GCodeProcessor::process_buffer(const char* begin, const char* end)
+{
+    // 1st move must be a dummy move
+    if (m_result.moves.empty())
+        m_result.moves.emplace_back(MoveVertex());
+
+    auto process_line = [this](GCodeReader& reader, const GCodeReader::GCodeLine& line) { process_gcode_line(line); };
+
+    const char* first_line_end = std::find(begin, end, '\n');
+    if (!m_incomplete_line.empty()) {
+        // Complete the last line of the previous chunk.
+        if (first_line_end == end) {
+            m_incomplete_line.append(begin, end);
+            return;
+        }
+        m_incomplete_line.append(begin, first_line_end + 1);
+        m_parser.parse_buffer(m_incomplete_line, process_line);
+        m_incomplete_line.clear();
+        begin = first_line_end + 1;
+    }
+
+    // Process the complete lines, keep the unterminated tail for the next chunk.
+    const char* last_line_end = end;
+    while (last_line_end != begin && *(last_line_end - 1) != '\n')
+        --last_line_end;
+    m_parser.parse_buffer(begin, last_line_end, process_line);
+    m_incomplete_line.assign(last_line_end, end);
+}
+
+void GCodeProcessor::finalize(const std::string& filename)
+{
+    if (!m_incomplete_line.empty()) {
+        // The G-code does not end with a new line.
+        m_parser.parse_buffer(m_incomplete_line, [this](GCodeReader& reader, const GCodeReader::GCodeLine& line) { process_gcode_line(line); });
+        m_incomplete_line.clear();
+    }
+
     // process the time blocks
     for (size_t i = 0; i < static_cast<size_t>(PrintEstimatedTimeStatistics::ETimeMode::Count); ++i) {
         TimeMachine& machine = m_time_processor.machines[i];
@@ -794,10 +901,6 @@ void GCodeProcessor::process_file(const std::string& filename, std::function<voi
     m_height_compare.output();
     m_width_compare.output();
 #endif // ENABLE_GCODE_VIEWER_DATA_CHECKING
-
-#if ENABLE_GCODE_VIEWER_STATISTICS
-    m_result.time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start_time).count();
-#endif // ENABLE_GCODE_VIEWER_STATISTICS
 }
 
 float GCodeProcessor::get_time(PrintEstimatedTimeStatistics::ETimeMode mode) const
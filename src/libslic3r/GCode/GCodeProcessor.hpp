@@ -9,6 +9,7 @@
 #include "libslic3r/CustomGCode.hpp"
 
 #include <array>
+#include <iterator>
 #include <vector>
 #include <string>
 
@@ -256,10 +257,100 @@ namespace Slic3r {
             float volumetric_rate() const { return feedrate * mm3_per_mm; }
         };
 
+        // Compact storage of the moves in a structure of arrays.
+        // Only the type, the XY position and the extrusion are stored per move, the other attributes
+        // (role, extruder, color, Z, feedrate, width, height, mm3_per_mm, fan speed) change rarely
+        // and they are stored once per run of consecutive moves sharing them.
+        // MoveVertex::time is not stored, it is the index of the move.
+        class MoveVertices
+        {
+        public:
+            // Run of consecutive moves sharing the same attributes.
+            struct Run
+            {
+                // Index of the first move of this run.
+                uint32_t first{ 0 };
+                // Mask of the types (1 << EMoveType) of the moves of this run.
+                uint32_t types_mask{ 0 };
+                ExtrusionRole extrusion_role{ erNone };
+                unsigned char extruder_id{ 0 };
+                unsigned char cp_color_id{ 0 };
+                float z{ 0.0f }; // mm
+                float feedrate{ 0.0f }; // mm/s
+                float width{ 0.0f }; // mm
+                float height{ 0.0f }; // mm
+                float mm3_per_mm{ 0.0f };
+                float fan_speed{ 0.0f }; // percentage
+
+                bool  has_type(EMoveType type) const { return (types_mask & (1 << static_cast<int>(type))) != 0; }
+                float volumetric_rate() const { return feedrate * mm3_per_mm; }
+                bool  same_attributes(const MoveVertex& move) const {
+                    return extrusion_role == move.extrusion_role && extruder_id == move.extruder_id && cp_color_id == move.cp_color_id &&
+                           z == move.position.z() && feedrate == move.feedrate && width == move.width && height == move.height &&
+                           mm3_per_mm == move.mm3_per_mm && fan_speed == move.fan_speed;
+                }
+            };
+
+            // Sequential access to the moves, cheaper than the random access.
+            class const_iterator
+            {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type        = MoveVertex;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = void;
+                using reference         = MoveVertex;
+
+                const_iterator(const MoveVertices& moves, size_t idx, size_t run) : m_moves(&moves), m_idx(idx), m_run(run) {}
+                MoveVertex      operator*() const { return m_moves->make_vertex(m_idx, m_run); }
+                const_iterator& operator++() {
+                    if (++ m_idx < m_moves->size() && m_run + 1 < m_moves->m_runs.size() && m_moves->m_runs[m_run + 1].first == m_idx)
+                        ++ m_run;
+                    return *this;
+                }
+                bool            operator==(const const_iterator& rhs) const { return m_idx == rhs.m_idx; }
+                bool            operator!=(const const_iterator& rhs) const { return m_idx != rhs.m_idx; }
+                // Index of the move, which the iterator points to.
+                size_t          index() const { return m_idx; }
+
+            private:
+                const MoveVertices* m_moves;
+                size_t              m_idx;
+                size_t              m_run;
+            };
+
+            size_t         size() const { return m_types.size(); }
+            bool           empty() const { return m_types.empty(); }
+            // Random access, searches for the run of the move.
+            MoveVertex     operator[](size_t idx) const;
+            const_iterator begin() const { return const_iterator(*this, 0, 0); }
+            const_iterator end() const { return const_iterator(*this, this->size(), m_runs.empty() ? 0 : m_runs.size() - 1); }
+
+            // The time of the vertex is expected to be equal to the index of the move.
+            void           emplace_back(const MoveVertex& move);
+            void           clear() { m_types.clear(); m_xy.clear(); m_delta_extruder.clear(); m_runs.clear(); }
+            void           shrink_to_fit() { m_types.shrink_to_fit(); m_xy.shrink_to_fit(); m_delta_extruder.shrink_to_fit(); m_runs.shrink_to_fit(); }
+
+            // Per attribute access.
+            const std::vector<EMoveType>& types() const { return m_types; }
+            const std::vector<Run>&       runs() const { return m_runs; }
+
+            // Memory allocated by the moves.
+            size_t         memsize() const;
+
+        private:
+            MoveVertex     make_vertex(size_t idx, size_t run) const;
+
+            std::vector<EMoveType> m_types;
+            std::vector<Vec2f>     m_xy; // mm
+            std::vector<float>     m_delta_extruder; // mm
+            std::vector<Run>       m_runs;
+        };
+
         struct Result
         {
             unsigned int id;
-            std::vector<MoveVertex> moves;
+            MoveVertices moves;
             Pointfs bed_shape;
             std::string printer_settings_id;
             std::vector<std::string> extruder_colors;
@@ -270,14 +361,14 @@ namespace Slic3r {
             void reset()
             {
                 time = 0;
-                moves = std::vector<MoveVertex>();
+                moves = MoveVertices();
                 bed_shape = Pointfs();
                 extruder_colors = std::vector<std::string>();
             }
 #else
             void reset()
             {
-                moves = std::vector<MoveVertex>();
+                moves = MoveVertices();
                 bed_shape = Pointfs();
                 extruder_colors = std::vector<std::string>();
             }
@@ -393,6 +484,9 @@ namespace Slic3r {
 
         TimeProcessor m_time_processor;
 
+        // Unterminated last line of the chunk passed to process_buffer(), to be completed by the next chunk.
+        std::string m_incomplete_line;
+
         Result m_result;
         static unsigned int s_result_id;
 
@@ -420,8 +514,16 @@ namespace Slic3r {
 
         // Process the gcode contained in the file with the given filename
         // throws CanceledException through print->throw_if_canceled() (sent by the caller as callback).
+        // The lines are parsed by GCodeReader in parallel, the state of the processor is updated serially.
         void process_file(const std::string& filename, std::function<void()> cancel_callback = nullptr);
 
+        // Process the G-code in chunks while it is being exported, so that the exported file does not need to be parsed again.
+        // To be called after reset() and apply_config() with consecutive chunks of the G-code. The chunks do not need to be split at line ends.
+        void process_buffer(const char* begin, const char* end);
+        // Process the time blocks and update the statistics once all the G-code has been processed,
+        // post-process the file with the given filename to add the remaining time lines M73.
+        void finalize(const std::string& filename);
+
         float get_time(PrintEstimatedTimeStatistics::ETimeMode mode) const;
         std::string get_time_dhm(PrintEstimatedTimeStatistics::ETimeMode mode) const;
         std::vector<std::pair<CustomGCode::Type, std::pair<float, float>>> get_custom_gcode_times(PrintEstimatedTimeStatistics::ETimeMode mode, bool include_remaining) const;
@@ -5,6 +5,7 @@
 
 #include "../libslic3r.h"
 
+#include <unordered_map>
 #include <utility>
 
 #include <boost/container/small_vector.hpp>
@@ -63,7 +64,9 @@ private:
         return it == entity_map.end() ? false : it->second[copy_id] != -1;
     }
 
-    std::map<const ExtrusionEntity*, ExtruderPerCopy> entity_map;  // to keep track of who prints what
+    // To keep track of who prints what. Looked up for each extrusion entity when exporting G-code, therefore hashed.
+    // Pointers into the values are returned by get_extruder_overrides(), std::unordered_map keeps them valid on insertion.
+    std::unordered_map<const ExtrusionEntity*, ExtruderPerCopy> entity_map;
     bool something_overridable = false;
     bool something_overridden = false;
     const LayerTools* m_layer_tools = nullptr;    // so we know which LayerTools object this belongs to
@@ -1,12 +1,22 @@
 #include "GCodeReader.hpp"
+#include "Utils.hpp"
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
 #if ENABLE_GCODE_VIEWER
 #include <boost/nowide/fstream.hpp>
 #endif // ENABLE_GCODE_VIEWER
+#include <boost/nowide/cstdio.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <memory>
+#include <mutex>
+
+#include <tbb/pipeline.h>
+#include <tbb/task_arena.h>
 
 #include <Shiny/Shiny.h>
 
@@ -24,14 +34,12 @@ void GCodeReader::apply_config(const DynamicPrintConfig &config)
     m_extrusion_axis = m_config.get_extrusion_axis()[0];
 }
 
-const char* GCodeReader::parse_line_internal(const char *ptr, GCodeLine &gline, std::pair<const char*, const char*> &command)
+// Thread safe, called in parallel by parse_file(), therefore not profiled.
+const char* GCodeReader::parse_line_internal(const char *ptr, GCodeLine &gline, std::pair<const char*, const char*> &command) const
 {
-    PROFILE_FUNC();
-    
     // command and args
     const char *c = ptr;
     {
-        PROFILE_BLOCK(command_and_args);
         // Skip the whitespaces.
         command.first = skip_whitespaces(c);
         // Skip the command.
@@ -60,7 +68,7 @@ const char* GCodeReader::parse_line_internal(const char *ptr, GCodeLine &gline,
             if (axis != NUM_AXES_WITH_UNKNOWN) {
                 // Try to parse the numeric value.
                 char   *pend = nullptr;
-                double  v = strtod(++ c, &pend);
+                double  v = parse_number(++ c, &pend);
                 if (pend != nullptr && is_end_of_word(*pend)) {
                     // The axis value has been parsed correctly.
                     if (axis != UNKNOWN_AXIS)
@@ -76,17 +84,13 @@ const char* GCodeReader::parse_line_internal(const char *ptr, GCodeLine &gline,
         }
     }
     
-    if (gline.has(E) && m_config.use_relative_e_distances)
-        m_position[E] = 0;
-
     // Skip the rest of the line.
-    for (; ! is_end_of_line(*c); ++ c);
+    if (! is_end_of_line(*c))
+        c += strcspn(c, "\r\n");
 
     // Copy the raw string including the comment, without the trailing newlines.
-    if (c > ptr) {
-        PROFILE_BLOCK(copy_raw_string);
+    if (c > ptr)
         gline.m_raw.assign(ptr, c);
-    }
 
     // Skip the trailing newlines.
 	if (*c == '\r')
@@ -94,10 +98,16 @@ const char* GCodeReader::parse_line_internal(const char *ptr, GCodeLine &gline,
 	if (*c == '\n')
 		++ c;
 
+    return c;
+}
+
+void GCodeReader::begin_line(const GCodeLine &gline)
+{
+    if (gline.has(E) && m_config.use_relative_e_distances)
+        m_position[E] = 0;
+
     if (m_verbose)
         std::cout << gline.m_raw << std::endl;
-
-    return c;
 }
 
 void GCodeReader::update_coordinates(GCodeLine &gline, std::pair<const char*, const char*> &command)
@@ -114,21 +124,124 @@ void GCodeReader::update_coordinates(GCodeLine &gline, std::pair<const char*, co
     }
 }
 
+double GCodeReader::parse_number(const char *c, char **pend)
+{
+    return string_to_double_decimal_point(c, pend);
+}
+
 void GCodeReader::parse_file(const std::string &file, callback_t callback)
 {
-#if ENABLE_GCODE_VIEWER
-    boost::nowide::ifstream f(file);
-#else
-    std::ifstream f(file);
-#endif // ENABLE_GCODE_VIEWER
-    std::string line;
+    FILE *f = boost::nowide::fopen(file.c_str(), "rb");
+    if (f == nullptr)
+        return;
+
+    // The file is read in blocks of complete lines. The lines of the blocks are parsed in parallel,
+    // while the callback and the update of the current position are called serially in the order of the file.
+    // The blocks grow from the first one, so that not much of the file is read ahead if the parsing is quit early,
+    // for example after the producer of the G-code is detected.
+    static constexpr const size_t block_size       = 1024 * 1024;
+    static constexpr const size_t first_block_size = 32 * 1024;
+    size_t                              next_block_size = first_block_size;
+    struct Block
+    {
+        // Complete lines, each one terminated by a new line.
+        std::vector<char>                                   data;
+        size_t                                              num_lines { 0 };
+        std::vector<GCodeLine>                              lines;
+        // Commands of the lines, pointing into data.
+        std::vector<std::pair<const char*, const char*>>    commands;
+    };
+    // The processed blocks are recycled, so that their buffers and the strings of their lines are not allocated again.
+    std::mutex                          pool_mutex;
+    std::vector<std::shared_ptr<Block>> pool;
+    // Incomplete last line of the last block read.
+    std::vector<char>                   tail;
+    bool                                eof = false;
+    // m_parsing_file is reset by quit_parsing_file() from the callback, which runs in the serial output stage.
+    // The output stage passes it to the input stage through this flag, as the two stages may run concurrently.
+    std::atomic<bool>                   quit { false };
 #if ENABLE_GCODE_VIEWER
     m_parsing_file = true;
-    while (m_parsing_file && std::getline(f, line))
+    auto parsing = [this]() { return m_parsing_file; };
 #else
-    while (std::getline(f, line))
+    auto parsing = []() { return true; };
 #endif // ENABLE_GCODE_VIEWER
-        this->parse_line(line, callback);
+
+    try {
+        tbb::parallel_pipeline(2 * tbb::this_task_arena::max_concurrency(),
+            tbb::make_filter<void, std::shared_ptr<Block>>(tbb::filter::serial_in_order,
+                [f, &pool_mutex, &pool, &tail, &eof, &quit, &next_block_size](tbb::flow_control &fc) -> std::shared_ptr<Block> {
+                    if (eof || quit) {
+                        fc.stop();
+                        return nullptr;
+                    }
+                    std::shared_ptr<Block> block;
+                    {
+                        std::lock_guard<std::mutex> lock(pool_mutex);
+                        if (! pool.empty()) {
+                            block = std::move(pool.back());
+                            pool.pop_back();
+                        }
+                    }
+                    if (! block)
+                        block = std::make_shared<Block>();
+                    const size_t size = next_block_size;
+                    next_block_size = std::min(2 * next_block_size, block_size);
+                    std::vector<char> &data = block->data;
+                    data.assign(tail.begin(), tail.end());
+                    data.resize(tail.size() + size);
+                    size_t num_read = fread(data.data() + tail.size(), 1, size, f);
+                    data.resize(tail.size() + num_read);
+                    if (num_read < size) {
+                        eof = true;
+                        // Terminate the last line of the file, if it is not terminated yet.
+                        if (! data.empty() && data.back() != '\n')
+                            data.emplace_back('\n');
+                    }
+                    // Pass the incomplete last line to the next block. A line longer than a block is accumulated over several reads.
+                    size_t num_complete = data.rend() - std::find(data.rbegin(), data.rend(), '\n');
+                    tail.assign(data.begin() + num_complete, data.end());
+                    data.resize(num_complete);
+                    return block;
+                }) &
+            tbb::make_filter<std::shared_ptr<Block>, std::shared_ptr<Block>>(tbb::filter::parallel,
+                [this](std::shared_ptr<Block> block) {
+                    // As with std::getline(), a line ends with '\n' and the line parser stops at a '\r' or a zero character,
+                    // the rest of such line is ignored.
+                    const char *ptr = block->data.data();
+                    const char *end = ptr + block->data.size();
+                    size_t      num_lines = 0;
+                    for (const char *eol; (eol = (const char*)memchr(ptr, '\n', end - ptr)) != nullptr; ptr = eol + 1, ++ num_lines) {
+                        if (num_lines == block->lines.size()) {
+                            block->lines.emplace_back();
+                            block->commands.emplace_back();
+                        }
+                        GCodeLine &gline = block->lines[num_lines];
+                        gline.reset();
+                        this->parse_line_internal(ptr, gline, block->commands[num_lines]);
+                    }
+                    block->num_lines = num_lines;
+                    return block;
+                }) &
+            tbb::make_filter<std::shared_ptr<Block>, void>(tbb::filter::serial_in_order,
+                [this, &callback, &pool_mutex, &pool, &parsing, &quit](std::shared_ptr<Block> block) {
+                    for (size_t i = 0; i < block->num_lines && parsing(); ++ i) {
+                        GCodeLine &gline = block->lines[i];
+                        this->begin_line(gline);
+                        callback(*this, gline);
+                        this->update_coordinates(gline, block->commands[i]);
+                    }
+                    if (! parsing())
+                        quit = true;
+                    std::lock_guard<std::mutex> lock(pool_mutex);
+                    pool.emplace_back(std::move(block));
+                }));
+    } catch (...) {
+        // The callback may throw, for example if the processing was canceled.
+        fclose(f);
+        throw;
+    }
+    fclose(f);
 }
 
 bool GCodeReader::GCodeLine::has(char axis) const
@@ -170,7 +283,7 @@ bool GCodeReader::GCodeLine::has_value(char axis, float &value) const
         if (*c == axis) {
             // Try to parse the numeric value.
             char   *pend = nullptr;
-            double  v = strtod(++ c, &pend);
+            double  v = parse_number(++ c, &pend);
             if (pend != nullptr && is_end_of_word(*pend)) {
                 // The axis value has been parsed correctly.
                 value = float(v);
@@ -92,11 +92,25 @@ public:
     void parse_buffer(const std::string &buffer)
         { this->parse_buffer(buffer, [](GCodeReader&, const GCodeReader::GCodeLine&){}); }
 
+    // Parse the lines of the buffer [begin, end). The buffer does not need to be zero terminated, 
+    // but its last line must be terminated by a new line.
+    template<typename Callback>
+    void parse_buffer(const char *begin, const char *end, Callback callback)
+    {
+        const char *ptr = begin;
+        GCodeLine gline;
+        while (ptr < end) {
+            gline.reset();
+            ptr = this->parse_line(ptr, gline, callback);
+        }
+    }
+
     template<typename Callback>
     const char* parse_line(const char *ptr, GCodeLine &gline, Callback &callback)
     {
         std::pair<const char*, const char*> cmd;
         const char *end = parse_line_internal(ptr, gline, cmd);
+        begin_line(gline);
         callback(*this, gline);
         update_coordinates(gline, cmd);
         return end;
@@ -106,6 +120,8 @@ public:
     void parse_line(const std::string &line, Callback callback)
         { GCodeLine gline; this->parse_line(line.c_str(), gline, callback); }
 
+    // Parse a G-code file. The file is read in large blocks, the lines of the blocks are parsed in parallel
+    // without allocating memory per line, the callback is called serially in the order of the lines.
     void parse_file(const std::string &file, callback_t callback);
 #if ENABLE_GCODE_VIEWER
     void quit_parsing_file() { m_parsing_file = false; }
@@ -126,9 +142,15 @@ public:
     void   set_extrusion_axis(char axis) { m_extrusion_axis = axis; }
 
 private:
-    const char* parse_line_internal(const char *ptr, GCodeLine &gline, std::pair<const char*, const char*> &command);
+    // Parse a single line, does not modify the state of the reader.
+    const char* parse_line_internal(const char *ptr, GCodeLine &gline, std::pair<const char*, const char*> &command) const;
+    // Update the state of the reader before the parsed line is passed to the callback.
+    void        begin_line(const GCodeLine &gline);
     void        update_coordinates(GCodeLine &gline, std::pair<const char*, const char*> &command);
 
+    // Parse a decimal number in a locale independent way, mimicking strtod(), see string_to_double_decimal_point().
+    static double       parse_number(const char *c, char **pend);
+
     static bool         is_whitespace(char c)           { return c == ' ' || c == '\t'; }
     static bool         is_end_of_line(char c)          { return c == '\r' || c == '\n' || c == 0; }
     static bool         is_end_of_gcode_line(char c)    { return c == ';' || is_end_of_line(c); }
@@ -149,6 +171,7 @@ private:
     float       m_position[NUM_AXES];
     bool        m_verbose;
 #if ENABLE_GCODE_VIEWER
+    // Only accessed from the callback and from the serial output stage of parse_file().
     bool        m_parsing_file{ false };
 #endif // ENABLE_GCODE_VIEWER
 };
@@ -1,20 +1,63 @@
 #include "GCodeWriter.hpp"
 #include "CustomGCode.hpp"
 #include <algorithm>
-#include <iomanip>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
 #include <map>
 #include <assert.h>
 
 #define FLAVOR_IS(val) this->config.gcode_flavor == val
 #define FLAVOR_IS_NOT(val) this->config.gcode_flavor != val
-#define COMMENT(comment) if (this->config.gcode_comments && !comment.empty()) gcode << " ; " << comment;
-#define PRECISION(val, precision) std::fixed << std::setprecision(precision) << val
-#define XYZF_NUM(val) PRECISION(val, 3)
-#define E_NUM(val) PRECISION(val, 5)
+#define XYZF_NUM GCodeFormatter::XYZF_EXPORT_DIGITS
+#define E_NUM GCodeFormatter::E_EXPORT_DIGITS
 
 namespace Slic3r {
 
+void GCodeFormatter::append_fixed(std::string &out, double v, int digits)
+{
+    static constexpr const double   pow10d[] = { 1., 10., 100., 1000., 10000., 100000., 1000000., 10000000., 100000000., 1000000000. };
+    static constexpr const uint64_t pow10i[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+    assert(digits >= 0 && digits <= 9);
+
+    // Scale to an integer and round. The product is rounded to double with an error of at most half ulp,
+    // therefore the rounding to an integer is correct unless the fractional part is close to a tie.
+    // Infinities and NaNs fail the range test.
+    double scaled = std::abs(v) * pow10d[digits];
+    if (scaled < 9007199254740992.) {
+        double ipart = std::floor(scaled);
+        double frac  = scaled - ipart;
+        if (std::abs(frac - 0.5) > scaled * 4.5e-16) {
+            uint64_t n = uint64_t(ipart) + (frac > 0.5);
+            // Enough for the sign, 16 integer digits, the decimal point and 9 decimal digits.
+            char  buf[32];
+            char *end = buf + sizeof(buf);
+            char *ptr = end;
+            if (digits > 0) {
+                uint64_t f = n % pow10i[digits];
+                n /= pow10i[digits];
+                for (int i = 0; i < digits; ++ i, f /= 10)
+                    *(-- ptr) = char('0' + f % 10);
+                *(-- ptr) = '.';
+            }
+            do {
+                *(-- ptr) = char('0' + n % 10);
+                n /= 10;
+            } while (n > 0);
+            if (std::signbit(v))
+                *(-- ptr) = '-';
+            out.append(ptr, end);
+            return;
+        }
+    }
+
+    // Ties, huge numbers, infinities and NaNs are left to the C library.
+    // The longest output is that of the largest double: 309 integer digits, sign, decimal point and 9 decimal digits.
+    char buf[512];
+    int  len = ::snprintf(buf, sizeof(buf), "%.*f", digits, v);
+    out.append(buf, size_t(len));
+}
+
 void GCodeWriter::apply_print_config(const PrintConfig &print_config)
 {
     this->config.apply(print_config, true);
@@ -270,26 +313,27 @@ std::string GCodeWriter::set_speed(double F, const std::string &comment, const s
 {
     assert(F > 0.);
     assert(F < 100000.);
-    std::ostringstream gcode;
-    gcode << "G1 F" << XYZF_NUM(F);
-    COMMENT(comment);
-    gcode << cooling_marker;
-    gcode << "\n";
-    return gcode.str();
+    std::string gcode;
+    GCodeFormatter(gcode).emit("G1").emit_axis(" F", F, XYZF_NUM).emit_comment(this->config.gcode_comments, comment).emit(cooling_marker).end_line();
+    return gcode;
 }
 
 std::string GCodeWriter::travel_to_xy(const Vec2d &point, const std::string &comment)
+{
+    std::string gcode;
+    this->travel_to_xy(gcode, point, comment);
+    return gcode;
+}
+
+void GCodeWriter::travel_to_xy(std::string &out, const Vec2d &point, const std::string &comment)
 {
     m_pos(0) = point(0);
     m_pos(1) = point(1);
     
-    std::ostringstream gcode;
-    gcode << "G1 X" << XYZF_NUM(point(0))
-          <<   " Y" << XYZF_NUM(point(1))
-          <<   " F" << XYZF_NUM(this->config.travel_speed.value * 60.0);
-    COMMENT(comment);
-    gcode << "\n";
-    return gcode.str();
+    GCodeFormatter(out).emit("G1").emit_xy(point)
+        .emit_axis(" F", this->config.travel_speed.value * 60.0, XYZF_NUM)
+        .emit_comment(this->config.gcode_comments, comment)
+        .end_line();
 }
 
 std::string GCodeWriter::travel_to_xyz(const Vec3d &point, const std::string &comment)
@@ -313,14 +357,12 @@ std::string GCodeWriter::travel_to_xyz(const Vec3d &point, const std::string &co
     m_lifted = 0;
     m_pos = point;
     
-    std::ostringstream gcode;
-    gcode << "G1 X" << XYZF_NUM(point(0))
-          <<   " Y" << XYZF_NUM(point(1))
-          <<   " Z" << XYZF_NUM(point(2))
-          <<   " F" << XYZF_NUM(this->config.travel_speed.value * 60.0);
-    COMMENT(comment);
-    gcode << "\n";
-    return gcode.str();
+    std::string gcode;
+    GCodeFormatter(gcode).emit("G1").emit_xyz(point)
+        .emit_axis(" F", this->config.travel_speed.value * 60.0, XYZF_NUM)
+        .emit_comment(this->config.gcode_comments, comment)
+        .end_line();
+    return gcode;
 }
 
 std::string GCodeWriter::travel_to_z(double z, const std::string &comment)
@@ -346,12 +388,12 @@ std::string GCodeWriter::_travel_to_z(double z, const std::string &comment)
 {
     m_pos(2) = z;
     
-    std::ostringstream gcode;
-    gcode << "G1 Z" << XYZF_NUM(z)
-          <<   " F" << XYZF_NUM(this->config.travel_speed.value * 60.0);
-    COMMENT(comment);
-    gcode << "\n";
-    return gcode.str();
+    std::string gcode;
+    GCodeFormatter(gcode).emit("G1").emit_axis(" Z", z, XYZF_NUM)
+        .emit_axis(" F", this->config.travel_speed.value * 60.0, XYZF_NUM)
+        .emit_comment(this->config.gcode_comments, comment)
+        .end_line();
+    return gcode;
 }
 
 bool GCodeWriter::will_move_z(double z) const
@@ -367,18 +409,22 @@ bool GCodeWriter::will_move_z(double z) const
 }
 
 std::string GCodeWriter::extrude_to_xy(const Vec2d &point, double dE, const std::string &comment)
+{
+    std::string gcode;
+    this->extrude_to_xy(gcode, point, dE, comment);
+    return gcode;
+}
+
+void GCodeWriter::extrude_to_xy(std::string &out, const Vec2d &point, double dE, const std::string &comment)
 {
     m_pos(0) = point(0);
     m_pos(1) = point(1);
     m_extruder->extrude(dE);
     
-    std::ostringstream gcode;
-    gcode << "G1 X" << XYZF_NUM(point(0))
-          <<   " Y" << XYZF_NUM(point(1))
-          <<    " " << m_extrusion_axis << E_NUM(m_extruder->E());
-    COMMENT(comment);
-    gcode << "\n";
-    return gcode.str();
+    GCodeFormatter(out).emit("G1").emit_xy(point)
+        .emit(" ").emit_axis(m_extrusion_axis.c_str(), m_extruder->E(), E_NUM)
+        .emit_comment(this->config.gcode_comments, comment)
+        .end_line();
 }
 
 std::string GCodeWriter::extrude_to_xyz(const Vec3d &point, double dE, const std::string &comment)
@@ -387,14 +433,12 @@ std::string GCodeWriter::extrude_to_xyz(const Vec3d &point, double dE, const std
     m_lifted = 0;
     m_extruder->extrude(dE);
     
-    std::ostringstream gcode;
-    gcode << "G1 X" << XYZF_NUM(point(0))
-          <<   " Y" << XYZF_NUM(point(1))
-          <<   " Z" << XYZF_NUM(point(2))
-          <<    " " << m_extrusion_axis << E_NUM(m_extruder->E());
-    COMMENT(comment);
-    gcode << "\n";
-    return gcode.str();
+    std::string gcode;
+    GCodeFormatter(gcode).emit("G1").emit_xyz(point)
+        .emit(" ").emit_axis(m_extrusion_axis.c_str(), m_extruder->E(), E_NUM)
+        .emit_comment(this->config.gcode_comments, comment)
+        .end_line();
+    return gcode;
 }
 
 std::string GCodeWriter::retract(bool before_wipe)
@@ -421,7 +465,7 @@ std::string GCodeWriter::retract_for_toolchange(bool before_wipe)
 
 std::string GCodeWriter::_retract(double length, double restart_extra, const std::string &comment)
 {
-    std::ostringstream gcode;
+    std::string gcode;
     
     /*  If firmware retraction is enabled, we use a fake value of 1
         since we ignore the actual configured retract_length which 
@@ -440,48 +484,49 @@ std::string GCodeWriter::_retract(double length, double restart_extra, const std
     if (dE != 0) {
         if (this->config.use_firmware_retraction) {
             if (FLAVOR_IS(gcfMachinekit))
-                gcode << "G22 ; retract\n";
+                gcode += "G22 ; retract\n";
             else
-                gcode << "G10 ; retract\n";
+                gcode += "G10 ; retract\n";
         } else {
-            gcode << "G1 " << m_extrusion_axis << E_NUM(m_extruder->E())
-                           << " F" << float(m_extruder->retract_speed() * 60.);
-            COMMENT(comment);
-            gcode << "\n";
+            // The feed rate used to be exported as a float with the precision of the extruder axis.
+            GCodeFormatter(gcode).emit("G1 ").emit_axis(m_extrusion_axis.c_str(), m_extruder->E(), E_NUM)
+                .emit_axis(" F", float(m_extruder->retract_speed() * 60.), E_NUM)
+                .emit_comment(this->config.gcode_comments, comment)
+                .end_line();
         }
     }
     
     if (FLAVOR_IS(gcfMakerWare))
-        gcode << "M103 ; extruder off\n";
+        gcode += "M103 ; extruder off\n";
     
-    return gcode.str();
+    return gcode;
 }
 
 std::string GCodeWriter::unretract()
 {
-    std::ostringstream gcode;
+    std::string gcode;
     
     if (FLAVOR_IS(gcfMakerWare))
-        gcode << "M101 ; extruder on\n";
+        gcode += "M101 ; extruder on\n";
     
     double dE = m_extruder->unretract();
     if (dE != 0) {
         if (this->config.use_firmware_retraction) {
             if (FLAVOR_IS(gcfMachinekit))
-                 gcode << "G23 ; unretract\n";
+                 gcode += "G23 ; unretract\n";
             else
-                 gcode << "G11 ; unretract\n";
-            gcode << this->reset_e();
+                 gcode += "G11 ; unretract\n";
+            gcode += this->reset_e();
         } else {
             // use G1 instead of G0 because G0 will blend the restart with the previous travel move
-            gcode << "G1 " << m_extrusion_axis << E_NUM(m_extruder->E())
-                           << " F" << float(m_extruder->deretract_speed() * 60.);
-            if (this->config.gcode_comments) gcode << " ; unretract";
-            gcode << "\n";
+            GCodeFormatter(gcode).emit("G1 ").emit_axis(m_extrusion_axis.c_str(), m_extruder->E(), E_NUM)
+                .emit_axis(" F", float(m_extruder->deretract_speed() * 60.), E_NUM)
+                .emit(this->config.gcode_comments ? " ; unretract" : "")
+                .end_line();
         }
     }
     
-    return gcode.str();
+    return gcode;
 }
 
 /*  If this method is called more than once before calling unlift(),
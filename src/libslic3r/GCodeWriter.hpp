@@ -10,6 +10,38 @@
 
 namespace Slic3r {
 
+// Emitter of G-code lines, appending to an output string without going through iostreams.
+// The output string may be reused for many lines (a whole layer) to avoid reallocations.
+class GCodeFormatter {
+public:
+    // Number of decimal digits of the XYZ coordinates and of the feed rate.
+    static constexpr const int XYZF_EXPORT_DIGITS = 3;
+    // Number of decimal digits of the extruder axis.
+    static constexpr const int E_EXPORT_DIGITS    = 5;
+
+    explicit GCodeFormatter(std::string &out) : m_out(out) {}
+
+    GCodeFormatter& emit(const char *str)        { m_out += str; return *this; }
+    GCodeFormatter& emit(const std::string &str) { m_out += str; return *this; }
+    // Emit a number with a fixed count of decimal digits, for example emit_axis(" X", 1.2, 3) emits " X1.200".
+    GCodeFormatter& emit_axis(const char *axis, double v, int digits) { m_out += axis; append_fixed(m_out, v, digits); return *this; }
+    GCodeFormatter& emit_xy(const Vec2d &point)
+        { return this->emit_axis(" X", point.x(), XYZF_EXPORT_DIGITS).emit_axis(" Y", point.y(), XYZF_EXPORT_DIGITS); }
+    GCodeFormatter& emit_xyz(const Vec3d &point)
+        { return this->emit_xy(Vec2d(point.x(), point.y())).emit_axis(" Z", point.z(), XYZF_EXPORT_DIGITS); }
+    GCodeFormatter& emit_comment(bool allow_comments, const std::string &comment)
+        { if (allow_comments && ! comment.empty()) { m_out += " ; "; m_out += comment; } return *this; }
+    void            end_line() { m_out += '\n'; }
+
+    // Append v with the given number of decimal digits (at most 9).
+    // The output is the same as of printf("%.*f", digits, v) or of std::fixed << std::setprecision(digits) << v,
+    // a locale independent fast path is taken for the numbers, which could be correctly rounded from their scaled integer value.
+    static void append_fixed(std::string &out, double v, int digits);
+
+private:
+    std::string &m_out;
+};
+
 class GCodeWriter {
 public:
     GCodeConfig config;
@@ -56,10 +88,14 @@ public:
     std::string toolchange(unsigned int extruder_id);
     std::string set_speed(double F, const std::string &comment = std::string(), const std::string &cooling_marker = std::string()) const;
     std::string travel_to_xy(const Vec2d &point, const std::string &comment = std::string());
+    // Append the travel move to the output string, so that the string is not allocated for each move.
+    void        travel_to_xy(std::string &out, const Vec2d &point, const std::string &comment = std::string());
     std::string travel_to_xyz(const Vec3d &point, const std::string &comment = std::string());
     std::string travel_to_z(double z, const std::string &comment = std::string());
     bool        will_move_z(double z) const;
     std::string extrude_to_xy(const Vec2d &point, double dE, const std::string &comment = std::string());
+    // Append the extrusion move to the output string, so that the string is not allocated for each move.
+    void        extrude_to_xy(std::string &out, const Vec2d &point, double dE, const std::string &comment = std::string());
     std::string extrude_to_xyz(const Vec3d &point, double dE, const std::string &comment = std::string());
     std::string retract(bool before_wipe = false);
     std::string retract_for_toolchange(bool before_wipe = false);
@@ -634,6 +634,15 @@ ModelVolume* ModelObject::add_volume(TriangleMesh &&mesh)
     return v;
 }
 
+ModelVolume* ModelObject::add_volume(TriangleMesh &&mesh, TriangleMesh &&convex_hull)
+{
+    ModelVolume* v = new ModelVolume(this, std::move(mesh), std::move(convex_hull));
+    this->volumes.push_back(v);
+    v->center_geometry_after_creation();
+    this->invalidate_bounding_box();
+    return v;
+}
+
 ModelVolume* ModelObject::add_volume(const ModelVolume &other)
 {
     ModelVolume* v = new ModelVolume(this, other);
@@ -4,6 +4,7 @@
 #include "Utils.hpp"
 
 #include <limits> // for numeric_limits
+#include <unordered_map>
 #include <assert.h>
 
 #define BOOST_VORONOI_USE_GMP 1
@@ -22,6 +23,62 @@ MotionPlanner::MotionPlanner(const ExPolygons &islands) : m_initialized(false)
             m_islands.emplace_back(MotionPlannerEnv(island));
         expp.clear();
     }
+
+    this->islands_grid_build();
+}
+
+void MotionPlanner::islands_grid_build()
+{
+    m_islands_grid_cols = 0;
+    m_islands_grid_rows = 0;
+    m_islands_grid_cell_start.clear();
+    m_islands_grid_data.clear();
+    if (m_islands.empty())
+        return;
+
+    m_islands_grid_bbox = m_islands.front().m_island_bbox;
+    for (const MotionPlannerEnv &island : m_islands)
+        m_islands_grid_bbox.merge(island.m_island_bbox);
+    // About a single island per cell.
+    m_islands_grid_cols = m_islands_grid_rows = size_t(std::ceil(std::sqrt(double(m_islands.size()))));
+    Point size = m_islands_grid_bbox.size();
+    m_islands_grid_cell_size = Point(size.x() / coord_t(m_islands_grid_cols) + 1, size.y() / coord_t(m_islands_grid_rows) + 1);
+
+    // Range of cells overlapped by a bounding box, inclusive.
+    auto cell_range = [this](const BoundingBox &bbox) {
+        return std::make_pair(
+            Point((bbox.min.x() - m_islands_grid_bbox.min.x()) / m_islands_grid_cell_size.x(), (bbox.min.y() - m_islands_grid_bbox.min.y()) / m_islands_grid_cell_size.y()),
+            Point((bbox.max.x() - m_islands_grid_bbox.min.x()) / m_islands_grid_cell_size.x(), (bbox.max.y() - m_islands_grid_bbox.min.y()) / m_islands_grid_cell_size.y()));
+    };
+    // Count the islands per cell, then fill in the islands in the order of their indices.
+    m_islands_grid_cell_start.assign(m_islands_grid_cols * m_islands_grid_rows + 1, 0);
+    for (const MotionPlannerEnv &island : m_islands) {
+        auto range = cell_range(island.m_island_bbox);
+        for (coord_t row = range.first.y(); row <= range.second.y(); ++ row)
+            for (coord_t col = range.first.x(); col <= range.second.x(); ++ col)
+                ++ m_islands_grid_cell_start[size_t(row) * m_islands_grid_cols + size_t(col) + 1];
+    }
+    for (size_t i = 1; i < m_islands_grid_cell_start.size(); ++ i)
+        m_islands_grid_cell_start[i] += m_islands_grid_cell_start[i - 1];
+    m_islands_grid_data.assign(m_islands_grid_cell_start.back(), 0);
+    std::vector<size_t> cell_end(m_islands_grid_cell_start.begin(), m_islands_grid_cell_start.end() - 1);
+    for (const MotionPlannerEnv &island : m_islands) {
+        auto range = cell_range(island.m_island_bbox);
+        for (coord_t row = range.first.y(); row <= range.second.y(); ++ row)
+            for (coord_t col = range.first.x(); col <= range.second.x(); ++ col)
+                m_islands_grid_data[cell_end[size_t(row) * m_islands_grid_cols + size_t(col)] ++] = size_t(&island - m_islands.data());
+    }
+}
+
+void MotionPlanner::islands_grid_candidates(const Point &pt, std::vector<size_t> &out) const
+{
+    // The grid covers the bounding boxes of all the islands.
+    if (m_islands_grid_cell_start.empty() || ! m_islands_grid_bbox.contains(pt))
+        return;
+    size_t col  = size_t((pt.x() - m_islands_grid_bbox.min.x()) / m_islands_grid_cell_size.x());
+    size_t row  = size_t((pt.y() - m_islands_grid_bbox.min.y()) / m_islands_grid_cell_size.y());
+    size_t cell = row * m_islands_grid_cols + col;
+    out.insert(out.end(), m_islands_grid_data.begin() + m_islands_grid_cell_start[cell], m_islands_grid_data.begin() + m_islands_grid_cell_start[cell + 1]);
 }
 
 void MotionPlanner::initialize()
@@ -62,11 +119,17 @@ Polyline MotionPlanner::shortest_path(const Point &from, const Point &to)
         return Polyline(from, to);
     
     // Are both points in the same island?
+    // Only the islands, which bounding boxes may contain from or to, are tested in the order of their indices.
+    std::vector<size_t> candidates;
+    this->islands_grid_candidates(from, candidates);
+    this->islands_grid_candidates(to, candidates);
+    sort_remove_duplicates(candidates);
     int island_idx_from = -1;
     int island_idx_to   = -1;
     int island_idx      = -1;
-    for (MotionPlannerEnv &island : m_islands) {
-        int idx = &island - m_islands.data();
+    for (size_t candidate : candidates) {
+        MotionPlannerEnv &island = m_islands[candidate];
+        int idx = int(candidate);
         if (island.island_contains(from))
             island_idx_from = idx;
         if (island.island_contains(to))
@@ -124,7 +187,7 @@ Polyline MotionPlanner::shortest_path(const Point &from, const Point &to)
     {
         // grow our environment slightly in order for simplify_by_visibility()
         // to work best by considering moves on boundaries valid as well
-        ExPolygonCollection grown_env(offset_ex(env.m_env.expolygons, float(+SCALED_EPSILON)));
+        const ExPolygonCollection &grown_env = env.m_env_grown;
         
         if (island_idx == -1) {
             /*  If 'from' or 'to' are not inside our env, they were connected using the 
@@ -137,11 +200,11 @@ Polyline MotionPlanner::shortest_path(const Point &from, const Point &to)
             if (! grown_env.contains(from)) {
                 // delete second point while the line connecting first to third crosses the
                 // boundaries as many times as the current first to second
-                while (polyline.points.size() > 2 && intersection_ln(Line(from, polyline.points[2]), (Polygons)grown_env).size() == 1)
+                while (polyline.points.size() > 2 && intersection_ln(Line(from, polyline.points[2]), env.m_env_grown_polygons).size() == 1)
                     polyline.points.erase(polyline.points.begin() + 1);
             }
             if (! grown_env.contains(to))
-                while (polyline.points.size() > 2 && intersection_ln(Line(*(polyline.points.end() - 3), to), (Polygons)grown_env).size() == 1)
+                while (polyline.points.size() > 2 && intersection_ln(Line(*(polyline.points.end() - 3), to), env.m_env_grown_polygons).size() == 1)
                     polyline.points.erase(polyline.points.end() - 2);
         }
 
@@ -194,40 +257,48 @@ const MotionPlannerGraph& MotionPlanner::init_graph(int island_idx)
         typedef voronoi_diagram<double> VD;
         VD vd;
         // Mapping between Voronoi vertices and graph nodes.
-        std::map<const VD::vertex_type*, size_t> vd_vertices;
+        // Each vertex is shared by several edges, thus the island containment is tested only once per vertex.
+        static constexpr size_t vertex_outside   = size_t(-1);
+        static constexpr size_t vertex_no_node   = size_t(-2);
+        std::unordered_map<const VD::vertex_type*, size_t> vd_vertices;
         // get boundaries as lines
-        const MotionPlannerEnv &env = this->get_env(island_idx);
+        MotionPlannerEnv &env = (island_idx == -1) ? m_outer : m_islands[island_idx];
         Lines lines = env.m_env.lines();
         boost::polygon::construct_voronoi(lines.begin(), lines.end(), &vd);
+        vd_vertices.reserve(vd.num_vertices());
+        auto vertex_inside = [&vd_vertices, &env](const VD::vertex_type *v) {
+            auto it = vd_vertices.find(v);
+            if (it == vd_vertices.end())
+                //FIXME This test has a terrible O(n^2) time complexity.
+                it = vd_vertices.emplace(v, env.island_contains_b(Point(v->x(), v->y())) ? vertex_no_node : vertex_outside).first;
+            return it->second != vertex_outside;
+        };
+        // Find a vertex in the graph, allocate a new node if the vertex does not exist in the graph yet.
+        auto vertex_node = [&vd_vertices, graph](const VD::vertex_type *v, const Point &p) {
+            size_t &idx = vd_vertices[v];
+            if (idx == vertex_no_node)
+                idx = graph->add_node(p);
+            return idx;
+        };
         // traverse the Voronoi diagram and generate graph nodes and edges
         for (const VD::edge_type &edge : vd.edges()) {
             if (edge.is_infinite())
                 continue;
             const VD::vertex_type* v0 = edge.vertex0();
             const VD::vertex_type* v1 = edge.vertex1();
-            Point p0(v0->x(), v0->y());
-            Point p1(v1->x(), v1->y());
             // Insert only Voronoi edges fully contained in the island.
-            //FIXME This test has a terrible O(n^2) time complexity.
-            if (env.island_contains_b(p0) && env.island_contains_b(p1)) {
-                // Find v0 in the graph, allocate a new node if v0 does not exist in the graph yet.
-                auto i_v0 = vd_vertices.find(v0);
-                size_t v0_idx;
-                if (i_v0 == vd_vertices.end())
-                    vd_vertices[v0] = v0_idx = graph->add_node(p0);
-                else
-                    v0_idx = i_v0->second;
-                // Find v1 in the graph, allocate a new node if v0 does not exist in the graph yet.
-                auto i_v1 = vd_vertices.find(v1);
-                size_t v1_idx;
-                if (i_v1 == vd_vertices.end())
-                    vd_vertices[v1] = v1_idx = graph->add_node(p1);
-                else
-                    v1_idx = i_v1->second;
+            if (vertex_inside(v0) && vertex_inside(v1)) {
+                Point p0(v0->x(), v0->y());
+                Point p1(v1->x(), v1->y());
+                size_t v0_idx = vertex_node(v0, p0);
+                size_t v1_idx = vertex_node(v1, p1);
                 // Euclidean distance is used as weight for the graph edge
                 graph->add_edge(v0_idx, v1_idx, (p1 - p0).cast<double>().norm());
             }
         }
+        graph->build_node_index();
+        env.m_env_grown          = ExPolygonCollection(offset_ex(env.m_env.expolygons, float(+SCALED_EPSILON)));
+        env.m_env_grown_polygons = Polygons(env.m_env_grown);
     }
 
     return *graph;
@@ -305,7 +376,36 @@ void MotionPlannerGraph::add_edge(size_t from, size_t to, double weight)
     m_adjacency_list[from].emplace_back(Neighbor(node_t(to), weight));
 }
 
-// Dijkstra's shortest path in a weighted graph from node_start to node_end.
+// Closest node to point, resolving ties the same way as Point::nearest_point_index():
+// the first node coinciding with point, otherwise the last of the closest nodes.
+size_t MotionPlannerGraph::find_closest_node(const Point &point) const
+{
+    if (m_nodes_index.empty())
+        return point.nearest_point_index(m_nodes);
+
+    using KDTree = KDTreeIndirect<2, double, NodeCoordinateFn>;
+    struct Visitor {
+        Visitor(const KDTree &kdtree, const Points &nodes, const Point &point) : kdtree(kdtree), nodes(nodes), point(point) {}
+        unsigned int operator()(size_t idx, size_t dimension) {
+            const Point &node = nodes[idx];
+            double dist = sqr<double>(point.x() - node.x()) + sqr<double>(point.y() - node.y());
+            if (dist < min_dist || (dist == min_dist && (dist == 0. ? idx < min_idx : idx > min_idx))) {
+                min_dist = dist;
+                min_idx  = idx;
+            }
+            return kdtree.descent_mask(double(point(dimension)), min_dist, idx, dimension);
+        }
+        const KDTree &kdtree;
+        const Points &nodes;
+        const Point  &point;
+        size_t        min_idx  = size_t(-1);
+        double        min_dist = std::numeric_limits<double>::max();
+    } visitor(m_nodes_index, m_nodes, point);
+    m_nodes_index.visit(visitor);
+    return visitor.min_idx;
+}
+
+// A* shortest path in a weighted graph from node_start to node_end.
 // The returned path contains the end points.
 // If no path exists from node_start to node_end, a straight segment is returned.
 Polyline MotionPlannerGraph::shortest_path(size_t node_start, size_t node_end) const
@@ -314,45 +414,55 @@ Polyline MotionPlannerGraph::shortest_path(size_t node_start, size_t node_end) c
     if (this->empty())
         return Polyline();
 
-    // Dijkstra algorithm, previous node of the current node 'u' in the shortest path towards node_start.
-    std::vector<node_t>   previous(m_adjacency_list.size(), -1);
-    std::vector<weight_t> distance(m_adjacency_list.size(), std::numeric_limits<weight_t>::infinity());
-    std::vector<size_t>   map_node_to_queue_id(m_adjacency_list.size(), size_t(-1));
+    // A* algorithm, previous node of the current node 'u' in the shortest path towards node_start.
+    std::vector<node_t>   previous(m_nodes.size(), -1);
+    std::vector<weight_t> distance(m_nodes.size(), std::numeric_limits<weight_t>::infinity());
+    // Length of the path from node_start through a node to node_end estimated by the Euclidean distance from the node to node_end.
+    // The estimate never exceeds the length of the path, as the edge weights are the Euclidean lengths of the edges.
+    std::vector<weight_t> estimate(m_nodes.size(), std::numeric_limits<weight_t>::infinity());
+    std::vector<size_t>   map_node_to_queue_id(m_nodes.size(), size_t(-1));
+    const Vec2d           end_point = m_nodes[node_end].cast<double>();
+    auto                  heuristic = [this, &end_point](node_t node) { return (end_point - m_nodes[node].cast<double>()).norm(); };
     distance[node_start] = 0.;
+    estimate[node_start] = heuristic(node_t(node_start));
 
+    // Only the nodes reached so far are queued.
     auto queue = make_mutable_priority_queue<node_t, false>(
         [&map_node_to_queue_id](const node_t node, size_t idx) { map_node_to_queue_id[node] = idx; },
-        [&distance](const node_t node1, const node_t node2) { return distance[node1] < distance[node2]; });
-    queue.reserve(m_adjacency_list.size());
-    for (size_t i = 0; i < m_adjacency_list.size(); ++ i)
-        queue.push(node_t(i));
+        [&estimate](const node_t node1, const node_t node2) { return estimate[node1] < estimate[node2]; });
+    queue.push(node_t(node_start));
 
     while (! queue.empty()) {
-        // Get the next node with the lowest distance to node_start.
+        // Get the next node with the lowest estimate of the path length.
         node_t u = node_t(queue.top());
         queue.pop();
         map_node_to_queue_id[u] = size_t(-1);
         // Stop searching if we reached our destination.
         if (size_t(u) == node_end)
             break;
+        if (size_t(u) >= m_adjacency_list.size())
+            continue;
         // Visit each edge starting at node u.
-        for (const Neighbor& neighbor : m_adjacency_list[u])
-            if (map_node_to_queue_id[neighbor.target] != size_t(-1)) {
-                weight_t alt = distance[u] + neighbor.weight;
-                // If total distance through u is shorter than the previous
-                // distance (if any) between node_start and neighbor.target, replace it.
-                if (alt < distance[neighbor.target]) {
-                    distance[neighbor.target] = alt;
-                    previous[neighbor.target] = u;
+        for (const Neighbor& neighbor : m_adjacency_list[u]) {
+            weight_t alt = distance[u] + neighbor.weight;
+            // If total distance through u is shorter than the previous
+            // distance (if any) between node_start and neighbor.target, replace it.
+            if (alt < distance[neighbor.target]) {
+                distance[neighbor.target] = alt;
+                estimate[neighbor.target] = alt + heuristic(neighbor.target);
+                previous[neighbor.target] = u;
+                if (map_node_to_queue_id[neighbor.target] == size_t(-1))
+                    queue.push(neighbor.target);
+                else
                     queue.update(map_node_to_queue_id[neighbor.target]);
-                }
             }
+        }
     }
 
     // In case the end point was not reached, previous[node_end] contains -1
     // and a straight line from node_start to node_end is returned.
     Polyline polyline;
-    polyline.points.reserve(m_adjacency_list.size());
+    polyline.points.reserve(m_nodes.size());
     for (node_t vertex = node_t(node_end); vertex != -1; vertex = previous[vertex])
         polyline.points.emplace_back(m_nodes[vertex]);
     polyline.points.emplace_back(m_nodes[node_start]);
@@ -5,6 +5,7 @@
 #include "BoundingBox.hpp"
 #include "ClipperUtils.hpp"
 #include "ExPolygonCollection.hpp"
+#include "KDTreeIndirect.hpp"
 #include "Polyline.hpp"
 #include <map>
 #include <utility>
@@ -36,16 +37,27 @@ private:
     BoundingBox         m_island_bbox;
     // Region, where the travel is allowed.
     ExPolygonCollection m_env;
+    // m_env grown by SCALED_EPSILON and its polygons, calculated by MotionPlanner::init_graph() together with the graph.
+    ExPolygonCollection m_env_grown;
+    Polygons            m_env_grown_polygons;
 };
 
-// A 2D directed graph for searching a shortest path using the famous Dijkstra algorithm.
+// A 2D directed graph for searching a shortest path using the A* algorithm.
 class MotionPlannerGraph
 {    
 public:
+    MotionPlannerGraph() : m_nodes_index(NodeCoordinateFn(&m_nodes)) {}
+    // m_nodes_index references m_nodes.
+    MotionPlannerGraph(const MotionPlannerGraph &rhs) = delete;
+    MotionPlannerGraph& operator=(const MotionPlannerGraph &rhs) = delete;
+
     // Add a directed edge into the graph.
     size_t   add_node(const Point &p) { m_nodes.emplace_back(p); return m_nodes.size() - 1; }
     void     add_edge(size_t from, size_t to, double weight);
-    size_t   find_closest_node(const Point &point) const { return point.nearest_point_index(m_nodes); }
+    // Build a KD tree over the nodes for find_closest_node(). To be called once all the nodes were added.
+    void     build_node_index() { m_nodes_index.build(m_nodes.size()); }
+    // Returns the same node as point.nearest_point_index(m_nodes).
+    size_t   find_closest_node(const Point &point) const;
 
     bool     empty() const { return m_adjacency_list.empty(); }
     Polyline shortest_path(size_t from, size_t to) const;
@@ -60,8 +72,14 @@ private:
         node_t   target;
         weight_t weight;
     };
+    struct NodeCoordinateFn {
+        NodeCoordinateFn(const Points *nodes) : nodes(nodes) {}
+        double operator()(size_t idx, size_t dimension) const { return double((*nodes)[idx](dimension)); }
+        const Points *nodes;
+    };
     Points                              m_nodes;
     std::vector<std::vector<Neighbor>>  m_adjacency_list;
+    KDTreeIndirect<2, double, NodeCoordinateFn> m_nodes_index;
 };
 
 class MotionPlanner
@@ -76,11 +94,22 @@ public:
 private:
     bool                                m_initialized;
     std::vector<MotionPlannerEnv>       m_islands;
+    // Uniform grid over the bounding boxes of m_islands for finding the islands, which may contain a point.
+    // Indices of the islands overlapping each cell are stored in ascending order, the cells are stored in a row major order.
+    BoundingBox                         m_islands_grid_bbox;
+    Point                               m_islands_grid_cell_size;
+    size_t                              m_islands_grid_cols;
+    size_t                              m_islands_grid_rows;
+    std::vector<size_t>                 m_islands_grid_cell_start;
+    std::vector<size_t>                 m_islands_grid_data;
     MotionPlannerEnv                    m_outer;
     // 0th graph is the graph for m_outer. Other graphs are 1 indexed.
     std::vector<std::unique_ptr<MotionPlannerGraph>> m_graphs;
     
     void                      initialize();
+    void                      islands_grid_build();
+    // Append indices of the islands, which bounding boxes may contain pt.
+    void                      islands_grid_candidates(const Point &pt, std::vector<size_t> &out) const;
     const MotionPlannerGraph& init_graph(int island_idx);
     const MotionPlannerEnv&   get_env(int island_idx) const
         { return (island_idx == -1) ? m_outer : m_islands[island_idx]; }
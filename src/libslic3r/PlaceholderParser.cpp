@@ -1,5 +1,6 @@
 #include "PlaceholderParser.hpp"
 #include "Flow.hpp"
+#include <atomic>
 #include <cstring>
 #include <ctime>
 #include <iomanip>
@@ -70,6 +71,27 @@ PlaceholderParser::PlaceholderParser(const DynamicConfig *external_config) : m_e
     this->update_timestamp();
 }
 
+PlaceholderParser::PlaceholderParser(const PlaceholderParser &rhs) : m_config(rhs.m_config), m_external_config(rhs.m_external_config)
+{
+    this->config_changed();
+}
+
+PlaceholderParser& PlaceholderParser::operator=(const PlaceholderParser &rhs)
+{
+    m_config          = rhs.m_config;
+    m_external_config = rhs.m_external_config;
+    this->config_changed();
+    return *this;
+}
+
+void PlaceholderParser::config_changed()
+{
+    // Generations are unique over all the PlaceholderParser instances, so that a compiled template
+    // does not take the options resolved by one PlaceholderParser for the options of another one.
+    static std::atomic<size_t> last_generation { 0 };
+    m_config_generation = ++ last_generation;
+}
+
 void PlaceholderParser::update_timestamp(DynamicConfig &config)
 {
     time_t rawtime;
@@ -139,6 +161,7 @@ void PlaceholderParser::apply_only(const DynamicPrintConfig &rhs, const std::vec
 void PlaceholderParser::apply_config(DynamicPrintConfig &&rhs)
 {
 	m_config += std::move(rhs);
+    this->config_changed();
 }
 
 void PlaceholderParser::apply_env_variables()
@@ -1330,4 +1353,214 @@ bool PlaceholderParser::evaluate_boolean_expression(const std::string &templ, co
     return process_macro(templ, context) == "true";
 }
 
+// Keywords of the macro language, which are not identifiers.
+static bool is_keyword(const std::string &identifier)
+{
+    static const char *keywords[] = { "and", "if", "int", "else", "elsif", "endif", "false", "min", "max", "not", "or", "true" };
+    return std::find_if(std::begin(keywords), std::end(keywords), [&identifier](const char *kw) { return identifier == kw; }) != std::end(keywords);
+}
+
+PlaceholderParser::Template PlaceholderParser::compile(const std::string &templ)
+{
+    using Segment = Template::Segment;
+    Template    out;
+    out.m_text = templ;
+
+    const char *begin = templ.c_str();
+    const char *end   = begin + templ.size();
+    // Non-ASCII text is validated as UTF-8 by the macro processor, white spaces are the only other characters to be skipped.
+    if (std::any_of(begin, end, [](char c) { return (unsigned char)c >= 0x80; }))
+        return out;
+    auto skip_space = [end](const char *it) {
+        for (; it != end && (*it == ' ' || *it == '\t' || *it == '\n' || *it == '\v' || *it == '\f' || *it == '\r'); ++ it);
+        return it;
+    };
+    auto parse_identifier = [end](const char *&it, std::string &identifier) {
+        const char *start = it;
+        if (it == end || ! (std::isalpha(*it) || *it == '_'))
+            return false;
+        for (++ it; it != end && (std::isalnum(*it) || *it == '_'); ++ it);
+        identifier.assign(start, it);
+        return ! is_keyword(identifier);
+    };
+    auto parse_index = [end](const char *&it, int &index) {
+        const char *start = it;
+        for (index = 0; it != end && *it >= '0' && *it <= '9' && it - start < 9; ++ it)
+            index = index * 10 + (*it - '0');
+        return it != start && (it == end || *it < '0' || *it > '9');
+    };
+
+    // The macro processor skips the white spaces at the start of the template.
+    for (const char *it = skip_space(begin); it != end;) {
+        Segment segment;
+        if (*it == '[') {
+            // [variable] or [vector_variable_index]
+            segment.type = Segment::LEGACY_VARIABLE;
+            it = skip_space(it + 1);
+            if (! parse_identifier(it, segment.text))
+                return out;
+            it = skip_space(it);
+            if (it == end || *it ++ != ']')
+                return out;
+            size_t idx = segment.text.rfind('_');
+            if (idx != std::string::npos) {
+                // Possibly a legacy vector indexing.
+                segment.text2 = segment.text.substr(0, idx);
+                const char *index = segment.text.c_str() + idx + 1;
+                if (*index == 0)
+                    segment.index = 0;
+                else if (! parse_index(index, segment.index) || *index != 0)
+                    segment.index = -1;
+            }
+        } else if (*it == '{') {
+            // {variable}, {vector_variable[index]} or {vector_variable[index_variable]}
+            segment.type = Segment::SCALAR_VARIABLE;
+            it = skip_space(it + 1);
+            if (! parse_identifier(it, segment.text))
+                return out;
+            it = skip_space(it);
+            if (it != end && *it == '[') {
+                segment.type = Segment::VECTOR_VARIABLE;
+                it = skip_space(it + 1);
+                if (! (parse_index(it, segment.index) || parse_identifier(it, segment.text2)))
+                    return out;
+                it = skip_space(it);
+                if (it == end || *it ++ != ']')
+                    return out;
+                it = skip_space(it);
+            }
+            if (it == end || *it ++ != '}')
+                return out;
+        } else {
+            // Text up to the next macro.
+            const char *start = it;
+            for (; it != end && *it != '[' && *it != '{'; ++ it);
+            segment.type = Segment::TEXT;
+            segment.text.assign(start, it);
+        }
+        out.m_segments.emplace_back(std::move(segment));
+    }
+    out.m_compiled = true;
+    return out;
+}
+
+// Formatting of a double the same way as by the macro processor.
+static inline void append_double(std::string &out, double value)
+{
+    std::ostringstream ss;
+    ss << value;
+    out += ss.str();
+}
+
+std::string PlaceholderParser::process(const Template &templ, unsigned int current_extruder_id, const DynamicConfig *config_override) const
+{
+    using Segment = Template::Segment;
+    if (! templ.m_compiled)
+        return this->process(templ.m_text, current_extruder_id, config_override);
+
+    if (templ.m_config_generation != m_config_generation) {
+        // Resolve the variables in m_config and m_external_config, the config_override is specific to each call.
+        auto resolve = [this](const std::string &opt_key) -> const ConfigOption* {
+            if (opt_key.empty())
+                return nullptr;
+            const ConfigOption *opt = m_config.option(opt_key);
+            if (opt == nullptr && m_external_config != nullptr)
+                opt = m_external_config->option(opt_key);
+            return opt;
+        };
+        for (const Segment &segment : templ.m_segments)
+            if (segment.type != Segment::TEXT) {
+                segment.opt  = resolve(segment.text);
+                segment.opt2 = resolve(segment.text2);
+            }
+        templ.m_config_generation = m_config_generation;
+    }
+
+    // config_override has the highest priority when looking up a symbol.
+    auto option = [config_override](const std::string &opt_key, const ConfigOption *resolved) -> const ConfigOption* {
+        const ConfigOption *opt = (config_override == nullptr || opt_key.empty()) ? nullptr : config_override->option(opt_key);
+        return (opt == nullptr) ? resolved : opt;
+    };
+    // Fill in the template. Returns false on an error or on a value, which is not filled in by the compiled template,
+    // for the macro processor to report the error or to fill in the value.
+    auto fill_in = [&templ, current_extruder_id, &option](std::string &out) {
+        for (const Segment &segment : templ.m_segments) {
+            switch (segment.type) {
+            case Segment::TEXT:
+                out += segment.text;
+                break;
+            case Segment::LEGACY_VARIABLE:
+            {
+                const ConfigOption *opt = option(segment.text, segment.opt);
+                size_t              idx = current_extruder_id;
+                if (opt == nullptr) {
+                    // Legacy vector indexing.
+                    opt = option(segment.text2, segment.opt2);
+                    if (opt == nullptr || ! opt->is_vector() || segment.index < 0)
+                        return false;
+                    idx = size_t(segment.index);
+                }
+                if (opt->is_scalar())
+                    out += opt->serialize();
+                else {
+                    const ConfigOptionVectorBase *vec = static_cast<const ConfigOptionVectorBase*>(opt);
+                    if (vec->empty())
+                        return false;
+                    out += vec->vserialize()[(idx >= vec->size()) ? 0 : idx];
+                }
+                break;
+            }
+            case Segment::SCALAR_VARIABLE:
+            {
+                const ConfigOption *opt = option(segment.text, segment.opt);
+                if (opt == nullptr || opt->is_vector())
+                    return false;
+                switch (opt->type()) {
+                case coFloat:   append_double(out, opt->getFloat()); break;
+                case coInt:     out += std::to_string(opt->getInt()); break;
+                case coString:  out += static_cast<const ConfigOptionString*>(opt)->value; break;
+                case coPercent: append_double(out, opt->getFloat()); break;
+                case coPoint:   out += opt->serialize(); break;
+                case coBool:    out += opt->getBool() ? "true" : "false"; break;
+                // coFloatOrPercent is resolved over its dependencies by the macro processor.
+                default:        return false;
+                }
+                break;
+            }
+            case Segment::VECTOR_VARIABLE:
+            {
+                const ConfigOption *opt = option(segment.text, segment.opt);
+                if (opt == nullptr || opt->is_scalar())
+                    return false;
+                int index = segment.index;
+                if (! segment.text2.empty()) {
+                    const ConfigOption *opt_index = option(segment.text2, segment.opt2);
+                    if (opt_index == nullptr || opt_index->type() != coInt)
+                        return false;
+                    index = opt_index->getInt();
+                }
+                const ConfigOptionVectorBase *vec = static_cast<const ConfigOptionVectorBase*>(opt);
+                if (vec->empty())
+                    return false;
+                size_t idx = (index < 0) ? 0 : (index >= int(vec->size())) ? 0 : size_t(index);
+                switch (opt->type()) {
+                case coFloats:   append_double(out, static_cast<const ConfigOptionFloats*>(opt)->values[idx]); break;
+                case coInts:     out += std::to_string(static_cast<const ConfigOptionInts*>(opt)->values[idx]); break;
+                case coStrings:  out += static_cast<const ConfigOptionStrings*>(opt)->values[idx]; break;
+                case coPercents: append_double(out, static_cast<const ConfigOptionPercents*>(opt)->values[idx]); break;
+                case coPoints:   out += to_string(static_cast<const ConfigOptionPoints*>(opt)->values[idx]); break;
+                case coBools:    out += (static_cast<const ConfigOptionBools*>(opt)->values[idx] != 0) ? "true" : "false"; break;
+                default:         return false;
+                }
+                break;
+            }
+            }
+        }
+        return true;
+    };
+
+    std::string out;
+    return fill_in(out) ? out : this->process(templ.m_text, current_extruder_id, config_override);
+}
+
 }
@@ -13,6 +13,9 @@ class PlaceholderParser
 {
 public:    
     PlaceholderParser(const DynamicConfig *external_config = nullptr);
+    // The copy is a new state of the config, to which the compiled templates have to be bound again.
+    PlaceholderParser(const PlaceholderParser &rhs);
+    PlaceholderParser& operator=(const PlaceholderParser &rhs);
     
     // Return a list of keys, which should be changed in m_config from rhs.
     // This contains keys, which are found in rhs, but not in m_config.
@@ -32,8 +35,8 @@ public:
     void set(const std::string &key, bool value)                { this->set(key, new ConfigOptionBool(value)); }
     void set(const std::string &key, double value)              { this->set(key, new ConfigOptionFloat(value)); }
     void set(const std::string &key, const std::vector<std::string> &values) { this->set(key, new ConfigOptionStrings(values)); }
-    void set(const std::string &key, ConfigOption *opt)         { m_config.set_key_value(key, opt); }
-	DynamicConfig&			config_writable()					{ return m_config; }
+    void set(const std::string &key, ConfigOption *opt)         { m_config.set_key_value(key, opt); this->config_changed(); }
+	DynamicConfig&			config_writable()					{ this->config_changed(); return m_config; }
 	const DynamicConfig&    config() const                      { return m_config; }
     const ConfigOption*     option(const std::string &key) const { return m_config.option(key); }
     // External config is not owned by PlaceholderParser. It has a lowest priority when looking up an option.
@@ -42,6 +45,56 @@ public:
     // Fill in the template using a macro processing language.
     // Throws std::runtime_error on syntax or runtime error.
     std::string process(const std::string &templ, unsigned int current_extruder_id = 0, const DynamicConfig *config_override = nullptr) const;
+
+    // Template parsed once by compile() to be filled in repeatedly by process() without running the macro processor.
+    // Text with variable references in the form of [variable], [vector_variable_index], {variable}, {vector_variable[index]}
+    // and {vector_variable[index_variable]} is compiled. The variables are resolved once into ConfigOption pointers to the config
+    // of the PlaceholderParser or to its external config, and resolved again after the config of the PlaceholderParser changes.
+    // The external config is expected not to change while the compiled templates are being processed.
+    // The rest of the macro language, and any evaluation error, is left to the macro processor.
+    // Not thread safe, the resolved variables are cached inside the template.
+    class Template
+    {
+    public:
+        const std::string&  text() const { return m_text; }
+        // Is the template compiled, or is it left to the macro processor?
+        bool                compiled() const { return m_compiled; }
+
+    private:
+        friend class PlaceholderParser;
+        struct Segment {
+            enum Type {
+                TEXT,
+                // [variable] or [vector_variable_index]
+                LEGACY_VARIABLE,
+                // {variable}
+                SCALAR_VARIABLE,
+                // {vector_variable[index]} or {vector_variable[index_variable]}
+                VECTOR_VARIABLE,
+            };
+            Type                        type;
+            // Text or the name of the variable.
+            std::string                 text;
+            // Vector variable of [vector_variable_index] or the index variable of {vector_variable[index_variable]}.
+            std::string                 text2;
+            // Index of [vector_variable_index] or {vector_variable[index]}, -1 if invalid or not constant.
+            int                         index { -1 };
+            // Options named by text and text2, resolved by the PlaceholderParser, which processed this template the last time.
+            mutable const ConfigOption *opt  { nullptr };
+            mutable const ConfigOption *opt2 { nullptr };
+        };
+        std::string                     m_text;
+        bool                            m_compiled { false };
+        std::vector<Segment>            m_segments;
+        // Generation of the PlaceholderParser config, for which the options of m_segments were resolved.
+        mutable size_t                  m_config_generation { 0 };
+    };
+
+    // Parse the template, throws nothing. Templates not compiled are processed by the macro processor.
+    static Template compile(const std::string &templ);
+    // Fill in the compiled template, the same as process(templ.text(), ...) would.
+    // Throws std::runtime_error on syntax or runtime error.
+    std::string process(const Template &templ, unsigned int current_extruder_id = 0, const DynamicConfig *config_override = nullptr) const;
     
     // Evaluate a boolean expression using the full expressive power of the PlaceholderParser boolean expression syntax.
     // Throws std::runtime_error on syntax or runtime error.
@@ -50,12 +103,17 @@ public:
     // Update timestamp, year, month, day, hour, minute, second variables at the provided config.
     static void update_timestamp(DynamicConfig &config);
     // Update timestamp, year, month, day, hour, minute, second variables at m_config.
-    void update_timestamp() { update_timestamp(m_config); }
+    void update_timestamp() { update_timestamp(m_config); this->config_changed(); }
 
 private:
+    // Invalidate the ConfigOptions resolved by the compiled templates.
+    void                     config_changed();
+
 	// config has a higher priority than external_config when looking up a symbol.
     DynamicConfig 			 m_config;
     const DynamicConfig 	*m_external_config;
+    // Unique for each state of m_config, to which the compiled templates resolve their variables.
+    size_t                   m_config_generation;
 };
 
 }
@@ -36,33 +36,15 @@ template<class Color> struct Colors {
 template<class Color> const Color Colors<Color>::White = Color{255};
 template<class Color> const Color Colors<Color>::Black = Color{0};
 
-template<class PixelRenderer,
-         template<class /*agg::renderer_base<PixelRenderer>*/> class Renderer,
-         class Rasterizer = agg::rasterizer_scanline_aa<>,
-         class Scanline   = agg::scanline_p8>
-class AGGRaster: public RasterBase {
-public:
-    using TColor = typename PixelRenderer::color_type;
-    using TValue = typename TColor::value_type;
-    using TPixel = typename PixelRenderer::pixel_type;
-    using TRawBuffer = agg::rendering_buffer;
-    
+// Converts polygons in scaled coordinates into AGG paths in the pixel
+// coordinates of a raster, applying the orientation and mirroring of the
+// raster transformation. Shared by the raster backends, so that they feed the
+// AGG rasterizer with exactly the same paths.
+class AGGPathConverter {
 protected:
-    
-    Resolution m_resolution;
-    PixelDim m_pxdim_scaled;    // used for scaled coordinate polygons
-    
-    std::vector<TPixel> m_buf;
-    agg::rendering_buffer m_rbuf;
-    
-    PixelRenderer m_pixrenderer;
-    
-    agg::renderer_base<PixelRenderer> m_raw_renderer;
-    Renderer<agg::renderer_base<PixelRenderer>> m_renderer;
-    
-    Trafo m_trafo;
-    Scanline m_scanlines;
-    Rasterizer m_rasterizer;
+    RasterBase::Resolution m_resolution;
+    RasterBase::PixelDim m_pxdim_scaled;    // used for scaled coordinate polygons
+    RasterBase::Trafo m_trafo;
     
     void flipy(agg::path_storage &path) const
     {
@@ -74,13 +56,12 @@ protected:
         path.flip_x(0, double(m_resolution.width_px));
     }
     
-    double getPx(const Point &p) { return p(0) * m_pxdim_scaled.w_mm; }
-    double getPy(const Point &p) { return p(1) * m_pxdim_scaled.h_mm; }
-    agg::path_storage to_path(const Polygon &poly) { return to_path(poly.points); }
-    double getPx(const ClipperLib::IntPoint &p) { return p.X * m_pxdim_scaled.w_mm; }
-    double getPy(const ClipperLib::IntPoint& p) { return p.Y * m_pxdim_scaled.h_mm; }
+    double getPx(const Point &p) const { return p(0) * m_pxdim_scaled.w_mm; }
+    double getPy(const Point &p) const { return p(1) * m_pxdim_scaled.h_mm; }
+    double getPx(const ClipperLib::IntPoint &p) const { return p.X * m_pxdim_scaled.w_mm; }
+    double getPy(const ClipperLib::IntPoint& p) const { return p.Y * m_pxdim_scaled.h_mm; }
     
-    template<class PointVec> agg::path_storage _to_path(const PointVec& v)
+    template<class PointVec> agg::path_storage _to_path(const PointVec& v) const
     {
         agg::path_storage path;
         
@@ -92,7 +73,7 @@ protected:
         return path;
     }
     
-    template<class PointVec> agg::path_storage _to_path_flpxy(const PointVec& v)
+    template<class PointVec> agg::path_storage _to_path_flpxy(const PointVec& v) const
     {
         agg::path_storage path;
         
@@ -104,7 +85,18 @@ protected:
         return path;
     }
     
-    template<class PointVec> agg::path_storage to_path(const PointVec &v)
+public:
+    AGGPathConverter(const RasterBase::Resolution &res,
+                     const RasterBase::PixelDim &  pd,
+                     const RasterBase::Trafo &     trafo)
+        : m_resolution(res)
+        , m_pxdim_scaled(SCALING_FACTOR / pd.w_mm, SCALING_FACTOR / pd.h_mm)
+        , m_trafo(trafo)
+    {}
+    
+    agg::path_storage to_path(const Polygon &poly) const { return to_path(poly.points); }
+    
+    template<class PointVec> agg::path_storage to_path(const PointVec &v) const
     {
         auto path = m_trafo.flipXY ? _to_path_flpxy(v) : _to_path(v);
         
@@ -117,12 +109,43 @@ protected:
         return path;
     }
     
+    // Add the contour and the holes of a polygon to an AGG rasterizer.
+    template<class Rasterizer, class P> void add_paths(Rasterizer &rasterizer, const P &poly) const
+    {
+        rasterizer.add_path(to_path(contour(poly)));
+        for(auto& h : holes(poly)) rasterizer.add_path(to_path(h));
+    }
+};
+
+template<class PixelRenderer,
+         template<class /*agg::renderer_base<PixelRenderer>*/> class Renderer,
+         class Rasterizer = agg::rasterizer_scanline_aa<>,
+         class Scanline   = agg::scanline_p8>
+class AGGRaster: public RasterBase, protected AGGPathConverter {
+public:
+    using TColor = typename PixelRenderer::color_type;
+    using TValue = typename TColor::value_type;
+    using TPixel = typename PixelRenderer::pixel_type;
+    using TRawBuffer = agg::rendering_buffer;
+    
+protected:
+    
+    std::vector<TPixel> m_buf;
+    agg::rendering_buffer m_rbuf;
+    
+    PixelRenderer m_pixrenderer;
+    
+    agg::renderer_base<PixelRenderer> m_raw_renderer;
+    Renderer<agg::renderer_base<PixelRenderer>> m_renderer;
+    
+    Scanline m_scanlines;
+    Rasterizer m_rasterizer;
+    
     template<class P> void _draw(const P &poly)
     {
         m_rasterizer.reset();
         
-        m_rasterizer.add_path(to_path(contour(poly)));
-        for(auto& h : holes(poly)) m_rasterizer.add_path(to_path(h));
+        add_paths(m_rasterizer, poly);
         
         agg::render_scanlines(m_rasterizer, m_scanlines, m_renderer);
     }
@@ -135,8 +158,7 @@ public:
               const TColor &    foreground,
               const TColor &    background,
               GammaFn &&        gammafn)
-        : m_resolution(res)
-        , m_pxdim_scaled(SCALING_FACTOR / pd.w_mm, SCALING_FACTOR / pd.h_mm)
+        : AGGPathConverter(res, pd, trafo)
         , m_buf(res.pixels())
         , m_rbuf(reinterpret_cast<TValue *>(m_buf.data()),
                  unsigned(res.width_px),
@@ -145,7 +167,6 @@ public:
         , m_pixrenderer(m_rbuf)
         , m_raw_renderer(m_pixrenderer)
         , m_renderer(m_raw_renderer)
-        , m_trafo(trafo)
     {
         m_renderer.color(foreground);
         clear(background);
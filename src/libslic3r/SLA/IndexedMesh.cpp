@@ -1,7 +1,7 @@
 #include "IndexedMesh.hpp"
 #include "Concurrency.hpp"
 
-#include <libslic3r/AABBTreeIndirect.hpp>
+#include <libslic3r/AABBTreeWide.hpp>
 #include <libslic3r/TriangleMesh.hpp>
 
 #include <numeric>
@@ -14,12 +14,12 @@ namespace Slic3r { namespace sla {
 
 class IndexedMesh::AABBImpl {
 private:
-    AABBTreeIndirect::Tree3f m_tree;
+    AABBTreeIndirect::WideTree4f m_tree;
 
 public:
     void init(const TriangleMesh& tm)
     {
-        m_tree = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(
+        m_tree = AABBTreeIndirect::build_wide_aabb_tree_over_indexed_triangle_set(
             tm.its.vertices, tm.its.indices);
     }
 
@@ -32,6 +32,16 @@ public:
                                                   s, dir, hit);
     }
 
+    void intersect_rays(const TriangleMesh& tm,
+                        const std::vector<Vec3d>& s, const std::vector<Vec3d>& dir,
+                        std::vector<igl::Hit>& hits)
+    {
+        AABBTreeIndirect::intersect_rays_first_hit(tm.its.vertices,
+                                                   tm.its.indices,
+                                                   m_tree,
+                                                   s, dir, hits);
+    }
+
     void intersect_ray(const TriangleMesh& tm,
                        const Vec3d& s, const Vec3d& dir, std::vector<igl::Hit>& hits)
     {
@@ -149,6 +159,40 @@ IndexedMesh::query_ray_hit(const Vec3d &s, const Vec3d &dir) const
     return ret;
 }
 
+std::vector<IndexedMesh::hit_result>
+IndexedMesh::query_ray_hit(const std::vector<Vec3d> &sources,
+                           const std::vector<Vec3d> &dirs) const
+{
+    assert(sources.size() == dirs.size());
+    std::vector<hit_result> outs;
+    outs.reserve(sources.size());
+
+#ifdef SLIC3R_HOLE_RAYCASTER
+    if (! m_holes.empty()) {
+        for (size_t i = 0; i < sources.size(); ++ i)
+            outs.emplace_back(query_ray_hit(sources[i], dirs[i]));
+        return outs;
+    }
+#endif
+
+    std::vector<igl::Hit> hits;
+    m_aabb->intersect_rays(*m_tm, sources, dirs, hits);
+    for (size_t i = 0; i < hits.size(); ++ i) {
+        assert(is_approx(dirs[i].norm(), 1.));
+        const igl::Hit &hit = hits[i];
+        outs.emplace_back(hit_result(*this));
+        outs.back().m_t = double(hit.t);
+        outs.back().m_dir = dirs[i];
+        outs.back().m_source = sources[i];
+        if(!std::isinf(hit.t) && !std::isnan(hit.t)) {
+            outs.back().m_normal = this->normal_by_face_id(hit.id);
+            outs.back().m_face_id = hit.id;
+        }
+    }
+
+    return outs;
+}
+
 std::vector<IndexedMesh::hit_result>
 IndexedMesh::query_ray_hits(const Vec3d &s, const Vec3d &dir) const
 {
@@ -117,6 +117,12 @@ public:
     // Casting a ray on the mesh, returns the distance where the hit occures.
     hit_result query_ray_hit(const Vec3d &s, const Vec3d &dir) const;
     
+    // Casting a bunch of rays on the mesh at once. The hits are the same as
+    // of query_ray_hit() called for each ray, see the batched queries
+    // of AABBTreeIndirect.
+    std::vector<hit_result> query_ray_hit(const std::vector<Vec3d> &sources,
+                                          const std::vector<Vec3d> &dirs) const;
+
     // Casts a ray on the mesh and returns all hits
     std::vector<hit_result> query_ray_hits(const Vec3d &s, const Vec3d &dir) const;
 
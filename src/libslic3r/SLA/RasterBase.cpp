@@ -2,6 +2,9 @@
 #define SLARASTER_CPP
 
 #include <functional>
+#include <algorithm>
+#include <iterator>
+#include <cstring>
 
 #include <libslic3r/SLA/RasterBase.hpp>
 #include <libslic3r/SLA/AGGRaster.hpp>
@@ -38,6 +41,171 @@ EncodedRaster PNGRasterEncoder::operator()(const void *ptr, size_t w, size_t h,
     return EncodedRaster(std::move(buf), "png");
 }
 
+namespace {
+
+enum PNGFilter : uint8_t { pfNone = 0, pfUp = 2 };
+
+// Filter one scanline of a greyscale image into dst (w + 1 bytes including
+// the filter type). The sliced masks are long runs of black and white with a
+// single anti-aliased pixel at the edges. The differential filters (Sub,
+// Average, Paeth) turn the runs into zeros, but they spread the edge pixels
+// and the deflated image gets bigger. Only a row repeating the previous one
+// is filtered (by Up into zeros), which helps the fast levels with short
+// match searches to find it.
+void filter_scanline(const uint8_t *row, const uint8_t *prev, size_t w, uint8_t *dst)
+{
+    if (prev && std::memcmp(row, prev, w) == 0) {
+        dst[0] = pfUp;
+        std::memset(dst + 1, 0, w);
+    } else {
+        dst[0] = pfNone;
+        std::memcpy(dst + 1, row, w);
+    }
+}
+
+// Equivalent of zlib's adler32_combine(): checksum of the concatenation of
+// two buffers, the second one of length len2.
+uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t len2)
+{
+    const uint32_t BASE = 65521;
+    uint32_t rem  = uint32_t(len2 % BASE);
+    uint32_t sum1 = adler1 & 0xffff;
+    uint32_t sum2 = (rem * sum1) % BASE;
+    sum1 += (adler2 & 0xffff) + BASE - 1;
+    sum2 += (adler1 >> 16) + (adler2 >> 16) + BASE - rem;
+    if (sum1 >= BASE) sum1 -= BASE;
+    if (sum1 >= BASE) sum1 -= BASE;
+    if (sum2 >= (BASE << 1)) sum2 -= (BASE << 1);
+    if (sum2 >= BASE) sum2 -= BASE;
+    return sum1 | (sum2 << 16);
+}
+
+void put_u32(std::vector<uint8_t> &buf, uint32_t v)
+{
+    buf.emplace_back(uint8_t(v >> 24));
+    buf.emplace_back(uint8_t(v >> 16));
+    buf.emplace_back(uint8_t(v >> 8));
+    buf.emplace_back(uint8_t(v));
+}
+
+// Append a PNG chunk, the chunk type is expected at data[0..3].
+void put_chunk(std::vector<uint8_t> &buf, const uint8_t *data, size_t len)
+{
+    put_u32(buf, uint32_t(len - 4));
+    buf.insert(buf.end(), data, data + len);
+    put_u32(buf, uint32_t(mz_crc32(MZ_CRC32_INIT, data, len)));
+}
+
+mz_bool vector_putter(const void *buf, int len, void *user)
+{
+    auto out = static_cast<std::vector<uint8_t>*>(user);
+    auto ptr = static_cast<const uint8_t*>(buf);
+    out->insert(out->end(), ptr, ptr + len);
+    return MZ_TRUE;
+}
+
+// Filter and deflate the rows [row_begin, row_end) into raw deflate data.
+// The final block of the stream is only closed if last is set, otherwise the
+// output is byte aligned by a full flush, so that the blocks may be simply
+// concatenated.
+bool deflate_rows(const uint8_t *img, size_t w, size_t row_begin, size_t row_end,
+                  int level, bool last, std::vector<uint8_t> &out, uint32_t &adler)
+{
+    const size_t bpl = w + 1;
+    std::vector<uint8_t> filtered((row_end - row_begin) * bpl);
+    for (size_t r = row_begin; r < row_end; ++ r)
+        filter_scanline(img + r * w, r > 0 ? img + (r - 1) * w : nullptr, w,
+                        filtered.data() + (r - row_begin) * bpl);
+
+    adler = uint32_t(mz_adler32(MZ_ADLER32_INIT, filtered.data(), filtered.size()));
+
+    std::unique_ptr<tdefl_compressor, void(*)(tdefl_compressor*)> comp(
+        tdefl_compressor_alloc(), tdefl_compressor_free);
+    if (! comp)
+        return false;
+
+    mz_uint flags = tdefl_create_comp_flags_from_zip_params(level, -MZ_DEFAULT_WINDOW_BITS,
+                                                            MZ_DEFAULT_STRATEGY);
+    out.reserve(filtered.size() / 8);
+    if (tdefl_init(comp.get(), vector_putter, &out, int(flags)) != TDEFL_STATUS_OKAY)
+        return false;
+
+    tdefl_status st = tdefl_compress_buffer(comp.get(), filtered.data(), filtered.size(),
+                                            last ? TDEFL_FINISH : TDEFL_FULL_FLUSH);
+    return st == (last ? TDEFL_STATUS_DONE : TDEFL_STATUS_OKAY);
+}
+
+} // namespace
+
+EncodedRaster GrayscalePNGRasterEncoder::operator()(const void *ptr, size_t w,
+                                                    size_t h, size_t num_components)
+{
+    if (num_components != 1 || w == 0 || h == 0)
+        return PNGRasterEncoder{}(ptr, w, h, num_components);
+
+    auto img = static_cast<const uint8_t*>(ptr);
+    int  lvl = std::max(0, std::min(this->level, 10));
+
+    // Split the rows into blocks, which are compressed independently.
+    const size_t bpl = w + 1;
+    size_t rows_per_block = h;
+    if (this->block_size > 0 && h * bpl > 2 * this->block_size)
+        rows_per_block = std::max<size_t>(1, this->block_size / bpl);
+    const size_t num_blocks = (h + rows_per_block - 1) / rows_per_block;
+
+    std::vector<std::vector<uint8_t>> deflated(num_blocks);
+    std::vector<uint32_t> adlers(num_blocks, MZ_ADLER32_INIT);
+    std::vector<char>     valid(num_blocks, false);
+    auto deflate_block = [&](size_t i) {
+        size_t row_begin = i * rows_per_block;
+        size_t row_end   = std::min(h, row_begin + rows_per_block);
+        valid[i] = deflate_rows(img, w, row_begin, row_end, lvl, i + 1 == num_blocks,
+                                deflated[i], adlers[i]);
+    };
+    if (num_blocks > 1)
+        ccr::for_each(size_t(0), num_blocks, deflate_block);
+    else
+        deflate_block(0);
+
+    // On error, an empty buffer is returned the same way as PNGRasterEncoder does.
+    if (std::find(valid.begin(), valid.end(), false) != valid.end())
+        return EncodedRaster({}, "png");
+
+    // IDAT payload: zlib header, the concatenated deflate blocks, Adler-32.
+    std::vector<uint8_t> idat = { 'I', 'D', 'A', 'T', 0x78, uint8_t(lvl <= 1 ? 0x01 : 0x9c) };
+    size_t idat_size = idat.size() + 4;
+    for (const std::vector<uint8_t> &d : deflated)
+        idat_size += d.size();
+    idat.reserve(idat_size);
+
+    uint32_t adler = adlers.front();
+    for (size_t i = 0; i < num_blocks; ++ i) {
+        idat.insert(idat.end(), deflated[i].begin(), deflated[i].end());
+        if (i > 0) {
+            size_t len = (std::min(h, (i + 1) * rows_per_block) - i * rows_per_block) * bpl;
+            adler = adler32_combine(adler, adlers[i], len);
+        }
+    }
+    put_u32(idat, adler);
+
+    std::vector<uint8_t> buf;
+    buf.reserve(8 + 25 + idat.size() + 8 + 12);
+    const uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    buf.insert(buf.end(), std::begin(signature), std::end(signature));
+
+    // 8 bit greyscale, deflate, adaptive filtering, no interlace.
+    std::vector<uint8_t> ihdr = { 'I', 'H', 'D', 'R' };
+    put_u32(ihdr, uint32_t(w));
+    put_u32(ihdr, uint32_t(h));
+    ihdr.insert(ihdr.end(), { 8, 0, 0, 0, 0 });
+    put_chunk(buf, ihdr.data(), ihdr.size());
+    put_chunk(buf, idat.data(), idat.size());
+    const uint8_t iend[] = { 'I', 'E', 'N', 'D' };
+    put_chunk(buf, iend, sizeof(iend));
+
+    return EncodedRaster(std::move(buf), "png");
+}
+
 std::ostream &operator<<(std::ostream &stream, const EncodedRaster &bytes)
 {
     stream.write(reinterpret_cast<const char *>(bytes.data()),
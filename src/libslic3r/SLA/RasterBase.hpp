@@ -106,6 +106,24 @@ struct PNGRasterEncoder {
     EncodedRaster operator()(const void *ptr, size_t w, size_t h, size_t num_components);
 };
 
+// PNG encoder tuned for the greyscale masks of SLA layers. The scanline
+// filters are chosen cheaply for images which are mostly black, and large
+// images are deflated by several threads in independent blocks.
+// Multi channel images are handed over to PNGRasterEncoder.
+struct GrayscalePNGRasterEncoder {
+    // Speed / size trade-off of the deflate levels (0 - 10): 0 stores the
+    // data uncompressed, 1 is the fastest, higher levels search longer for
+    // matches. Level 4 is both faster and smaller on the masks than the
+    // level 6 of PNGRasterEncoder.
+    int    level      = 4;
+    // Number of filtered bytes deflated independently of each other.
+    // Images larger than two blocks are compressed in parallel, zero disables
+    // the splitting.
+    size_t block_size = 1024 * 1024;
+
+    EncodedRaster operator()(const void *ptr, size_t w, size_t h, size_t num_components);
+};
+
 struct PPMRasterEncoder {
     EncodedRaster operator()(const void *ptr, size_t w, size_t h, size_t num_components);
 };
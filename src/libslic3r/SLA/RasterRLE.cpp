@@ -0,0 +1,151 @@
+#include <libslic3r/SLA/RasterRLE.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace Slic3r { namespace sla {
+
+namespace {
+
+// The same blending of a white, opaque foreground as agg::pixfmt_gray8 does
+// in blend_hline() and blend_solid_hspan().
+inline uint8_t blend_white(uint8_t px, uint8_t cover)
+{
+    return cover == agg::cover_mask ?
+        uint8_t(agg::gray8::base_mask) :
+        agg::gray8::lerp(px, agg::gray8::base_mask, agg::gray8::mult_cover(agg::gray8::base_mask, cover));
+}
+
+// Append a run, joining it with the previous one if they touch and have the
+// same value. Black runs are not stored.
+inline void append_run(RasterGrayscaleRLE::Row &row, uint32_t x, uint32_t len, uint8_t value)
+{
+    if (value == 0 || len == 0)
+        return;
+    if (! row.empty() && row.back().end() == x && row.back().value == value)
+        row.back().len += len;
+    else
+        row.push_back({x, len, value});
+}
+
+// Blend the covers given by spans (value is the cover) into the runs of a row.
+void blend_row(const RasterGrayscaleRLE::Row &row, const RasterGrayscaleRLE::Row &spans,
+               RasterGrayscaleRLE::Row &out)
+{
+    constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    out.clear();
+    size_t   i = 0, j = 0;
+    uint32_t x = 0;
+    while (i < row.size() || j < spans.size()) {
+        uint32_t row_begin  = i < row.size()   ? row[i].x   : NONE;
+        uint32_t span_begin = j < spans.size() ? spans[j].x : NONE;
+        x = std::max(x, std::min(row_begin, span_begin));
+
+        bool in_row  = row_begin <= x;
+        bool in_span = span_begin <= x;
+        uint32_t end = std::min(in_row  ? row[i].end()   : row_begin,
+                                in_span ? spans[j].end() : span_begin);
+
+        uint8_t value = in_row ? row[i].value : 0;
+        if (in_span)
+            value = blend_white(value, spans[j].value);
+        append_run(out, x, end - x, value);
+
+        x = end;
+        if (in_row && row[i].end() == x)
+            ++ i;
+        if (in_span && spans[j].end() == x)
+            ++ j;
+    }
+}
+
+} // namespace
+
+void RasterGrayscaleRLE::blend_scanline(const agg::scanline_p8 &sl)
+{
+    int y = sl.y();
+    if (y < 0 || y >= int(m_resolution.height_px))
+        return;
+
+    // Collect the spans clipped to the raster, the same way
+    // agg::renderer_base clips them.
+    const int w = int(m_resolution.width_px);
+    m_spans.clear();
+    auto add_span = [this](int x, int len, uint8_t cover) {
+        if (! m_spans.empty() && m_spans.back().end() == uint32_t(x) && m_spans.back().value == cover)
+            m_spans.back().len += uint32_t(len);
+        else
+            m_spans.push_back({uint32_t(x), uint32_t(len), cover});
+    };
+    unsigned num_spans = sl.num_spans();
+    auto     span      = sl.begin();
+    for (;;) {
+        int x   = span->x;
+        int len = span->len;
+        const agg::cover_type *covers = span->covers;
+        bool solid = len < 0;
+        if (solid)
+            len = -len;
+
+        if (x < 0) {
+            len -= -x;
+            if (! solid)
+                covers += -x;
+            x = 0;
+        }
+        len = std::min(len, w - x);
+
+        if (len > 0 && solid)
+            add_span(x, len, covers[0]);
+        else
+            for (int k = 0; k < len; ++ k)
+                add_span(x + k, 1, covers[k]);
+
+        if (-- num_spans == 0) break;
+        ++ span;
+    }
+
+    if (m_spans.empty())
+        return;
+
+    Row &row = m_rows[size_t(y)];
+    blend_row(row, m_spans, m_merged);
+    row.swap(m_merged);
+}
+
+uint8_t RasterGrayscaleRLE::read_pixel(size_t col, size_t row) const
+{
+    const Row &r  = m_rows[row];
+    auto       it = std::upper_bound(r.begin(), r.end(), col,
+                                     [](size_t c, const Run &run) { return c < run.x; });
+    if (it == r.begin())
+        return 0;
+    -- it;
+    return col < it->end() ? it->value : 0;
+}
+
+EncodedRaster RasterGrayscaleRLE::encode(RasterEncoder encoder) const
+{
+    const size_t w = m_resolution.width_px;
+    std::vector<uint8_t> buf(m_resolution.pixels(), 0);
+    for (size_t r = 0; r < m_rows.size(); ++ r)
+        for (const Run &run : m_rows[r])
+            std::fill_n(buf.begin() + r * w + run.x, run.len, run.value);
+
+    return encoder(buf.data(), w, m_resolution.height_px, 1);
+}
+
+uqptr<RasterBase> create_raster_grayscale_rle(
+    const RasterBase::Resolution &res,
+    const RasterBase::PixelDim &  pxdim,
+    double                        gamma,
+    const RasterBase::Trafo &     tr)
+{
+    if (gamma > 0)
+        return std::make_unique<RasterGrayscaleRLE>(res, pxdim, tr, agg::gamma_power(gamma));
+    else
+        return std::make_unique<RasterGrayscaleRLE>(res, pxdim, tr, agg::gamma_threshold(.5));
+}
+
+}} // namespace Slic3r::sla
@@ -0,0 +1,93 @@
+#ifndef SLA_RASTERRLE_HPP
+#define SLA_RASTERRLE_HPP
+
+#include <libslic3r/SLA/AGGRaster.hpp>
+
+namespace Slic3r { namespace sla {
+
+/*
+ * Monochrome canvas storing each row as a sorted list of runs of equal,
+ * non-black pixels. The polygons are rasterized by the AGG cell rasterizer
+ * (analytic area coverage) and the scanline spans are merged into the runs
+ * directly, so no dense pixel buffer exists until the raster is encoded.
+ * Empty rows cost nothing to draw into or to clear.
+ *
+ * The output is identical to RasterGrayscaleAA with the same gamma function,
+ * including overlapping polygons, which are blended the same way.
+ */
+class RasterGrayscaleRLE: public RasterBase, protected AGGPathConverter {
+public:
+    struct Run {
+        uint32_t x;
+        uint32_t len;
+        uint8_t  value;
+
+        uint32_t end() const { return x + len; }
+        bool operator==(const Run &r) const { return x == r.x && len == r.len && value == r.value; }
+    };
+    using Row = std::vector<Run>;
+
+private:
+    std::vector<Row> m_rows;
+
+    agg::rasterizer_scanline_aa<> m_rasterizer;
+    agg::scanline_p8 m_scanline;
+
+    // Spans of the current scanline and the merged row, reused between draws.
+    Row m_spans, m_merged;
+
+    void blend_scanline(const agg::scanline_p8 &sl);
+
+    template<class P> void _draw(const P &poly)
+    {
+        m_rasterizer.reset();
+        add_paths(m_rasterizer, poly);
+
+        if (m_rasterizer.rewind_scanlines()) {
+            m_scanline.reset(m_rasterizer.min_x(), m_rasterizer.max_x());
+            while (m_rasterizer.sweep_scanline(m_scanline))
+                blend_scanline(m_scanline);
+        }
+    }
+
+public:
+    template<class GammaFn>
+    RasterGrayscaleRLE(const RasterBase::Resolution &res,
+                       const RasterBase::PixelDim &  pd,
+                       const RasterBase::Trafo &     trafo,
+                       GammaFn &&                    gammafn)
+        : AGGPathConverter(res, pd, trafo), m_rows(res.height_px)
+    {
+        m_rasterizer.gamma(gammafn);
+    }
+
+    Trafo trafo() const override { return m_trafo; }
+    Resolution resolution() const override { return m_resolution; }
+    PixelDim   pixel_dimensions() const override
+    {
+        return {SCALING_FACTOR / m_pxdim_scaled.w_mm,
+                SCALING_FACTOR / m_pxdim_scaled.h_mm};
+    }
+
+    void draw(const ExPolygon &poly) override { _draw(poly); }
+    void draw(const ClipperLib::Polygon &poly) override { _draw(poly); }
+
+    // Expands the runs into a dense buffer for the encoder.
+    EncodedRaster encode(RasterEncoder encoder) const override;
+
+    const Row& row(size_t r) const { return m_rows[r]; }
+    uint8_t read_pixel(size_t col, size_t row) const;
+
+    void clear() { for (Row &r : m_rows) r.clear(); }
+};
+
+// If gamma is zero, thresholding will be performed which disables AA.
+uqptr<RasterBase> create_raster_grayscale_rle(
+    const RasterBase::Resolution &res,
+    const RasterBase::PixelDim &  pxdim,
+    double                        gamma = 1.0,
+    const RasterBase::Trafo &     tr    = {});
+
+}} // namespace Slic3r::sla
+
+#endif // SLA_RASTERRLE_HPP
@@ -1,14 +1,80 @@
 #include <limits>
 #include <exception>
+#include <numeric>
+#include <algorithm>
 
 #include <libnest2d/optimizers/nlopt/genetic.hpp>
 #include <libslic3r/SLA/Rotfinder.hpp>
 #include <libslic3r/SLA/SupportTree.hpp>
+#include <libslic3r/SLA/Concurrency.hpp>
 #include "Model.hpp"
 
 namespace Slic3r {
 namespace sla {
 
+NormalHistogram::NormalHistogram(const TriangleMesh &mesh)
+{
+    std::vector<Vec3f> normals;
+    normals.reserve(mesh.stl.facet_start.size());
+    for (const stl_facet &facet : mesh.stl.facet_start)
+        normals.emplace_back(facet.normal);
+
+    std::sort(normals.begin(), normals.end(), [](const Vec3f &a, const Vec3f &b) {
+        return std::lexicographical_compare(a.data(), a.data() + 3, b.data(), b.data() + 3);
+    });
+
+    size_t num_unique = 0;
+    for (size_t i = 0; i < normals.size(); ++ i)
+        if (i == 0 || normals[i] != normals[i - 1])
+            ++ num_unique;
+
+    auto n = Eigen::Index(num_unique);
+    x.resize(n); y.resize(n); z.resize(n); w.resize(n);
+    Eigen::Index j = -1;
+    for (size_t i = 0; i < normals.size(); ++ i) {
+        if (i == 0 || normals[i] != normals[i - 1]) {
+            ++ j;
+            x(j) = normals[i].x();
+            y(j) = normals[i].y();
+            z(j) = normals[i].z();
+            w(j) = 0.f;
+        }
+        w(j) += 1.f;
+    }
+}
+
+// Sum of the absolute values of the components of all the rotated normals.
+// The normals are processed in fixed blocks, in parallel for large meshes, and
+// the block sums are added up in order, so the result does not depend on the
+// number of threads. The block loop is vectorized by Eigen.
+double rotated_normals_score(const NormalHistogram &normals, const Matrix3f &rot)
+{
+    static const size_t BlockSize = 16384;
+
+    const size_t N = normals.size();
+    const size_t num_blocks = (N + BlockSize - 1) / BlockSize;
+    std::vector<double> sums(num_blocks, 0.);
+
+    auto block_score = [&normals, &rot, &sums, N](size_t block) {
+        auto from = Eigen::Index(block * BlockSize);
+        auto n    = Eigen::Index(std::min(BlockSize, N - size_t(from)));
+        auto x = normals.x.segment(from, n);
+        auto y = normals.y.segment(from, n);
+        auto z = normals.z.segment(from, n);
+        auto w = normals.w.segment(from, n);
+        sums[block] = (w * ((rot(0, 0) * x + rot(0, 1) * y + rot(0, 2) * z).abs() +
+                            (rot(1, 0) * x + rot(1, 1) * y + rot(1, 2) * z).abs() +
+                            (rot(2, 0) * x + rot(2, 1) * y + rot(2, 2) * z).abs())).sum();
+    };
+
+    if (num_blocks > 1)
+        ccr::for_each(size_t(0), num_blocks, block_score);
+    else if (num_blocks == 1)
+        block_score(0);
+
+    return std::accumulate(sums.begin(), sums.end(), 0.);
+}
+
 std::array<double, 3> find_best_rotation(const ModelObject& modelobj,
                                          float accuracy,
                                          std::function<void(unsigned)> statuscb,
@@ -25,9 +91,9 @@ std::array<double, 3> find_best_rotation(const ModelObject& modelobj,
     // return value
     std::array<double, 3> rot;
 
-    // We will use only one instance of this converted mesh to examine different
+    // We will use only the normals of this mesh to examine different
     // rotations
-    const TriangleMesh& mesh = modelobj.raw_mesh();
+    const NormalHistogram normals(modelobj.raw_mesh());
 
     // For current iteration number
     unsigned status = 0;
@@ -43,11 +109,9 @@ std::array<double, 3> find_best_rotation(const ModelObject& modelobj,
     // call the status callback in each iteration but the actual value may be
     // the same for subsequent iterations (status goes from 0 to 100 but
     // iterations can be many more)
-    auto objfunc = [&mesh, &status, &statuscb, &stopcond, max_tries]
+    auto objfunc = [&normals, &status, &statuscb, &stopcond, max_tries]
             (double rx, double ry, double rz)
     {
-        const TriangleMesh& m = mesh;
-
         // prepare the rotation transformation
         Transform3d rt = Transform3d::Identity();
 
@@ -55,8 +119,6 @@ std::array<double, 3> find_best_rotation(const ModelObject& modelobj,
         rt.rotate(Eigen::AngleAxisd(ry, Vec3d::UnitY()));
         rt.rotate(Eigen::AngleAxisd(rx, Vec3d::UnitX()));
 
-        double score = 0;
-
         // For all triangles we calculate the normal and sum up the dot product
         // (a scalar indicating how much are two vectors aligned) with each axis
         // this will result in a value that is greater if a normal is aligned
@@ -67,17 +129,7 @@ std::array<double, 3> find_best_rotation(const ModelObject& modelobj,
         // area. The current function is only an example of how to optimize.
 
         // Later we can add more criteria like the number of overhangs, etc...
-        for(size_t i = 0; i < m.stl.facet_start.size(); i++) {
-            Vec3d n = m.stl.facet_start[i].normal.cast<double>();
-
-            // rotate the normal with the current rotation given by the solver
-            n = rt * n;
-
-            // We should score against the alignment with the reference planes
-            score += std::abs(n.dot(Vec3d::UnitX()));
-            score += std::abs(n.dot(Vec3d::UnitY()));
-            score += std::abs(n.dot(Vec3d::UnitZ()));
-        }
+        double score = rotated_normals_score(normals, rt.linear().cast<float>());
 
         // report status
         if(!stopcond()) statuscb( unsigned(++status * 100.0/max_tries) );
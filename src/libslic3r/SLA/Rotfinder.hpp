@@ -4,12 +4,33 @@
 #include <functional>
 #include <array>
 
+#include <libslic3r/Point.hpp>
+
 namespace Slic3r {
 
 class ModelObject;
+class TriangleMesh;
 
 namespace sla {
 
+// The facet normals of a mesh as a structure of arrays. Facets with the same
+// normal are merged into a single entry weighted by their count, which
+// shrinks meshes with large flat regions considerably. Only the exactly equal
+// normals are merged, therefore a mesh of curved surfaces is hardly reduced
+// and the speedup of the rotation search depends on the mesh. The objective
+// function only depends on the normals, so the mesh itself is not touched again.
+struct NormalHistogram {
+    Eigen::ArrayXf x, y, z, w;
+
+    explicit NormalHistogram(const TriangleMesh &mesh);
+
+    size_t size() const { return size_t(w.size()); }
+};
+
+// Sum of the absolute values of the components of all the rotated normals,
+// the score of a rotation maximized by find_best_rotation().
+double rotated_normals_score(const NormalHistogram &normals, const Matrix3f &rot);
+
 /**
   * The function should find the best rotation for SLA upside down printing.
   *
@@ -60,7 +60,7 @@ SupportPointGenerator::SupportPointGenerator(
     : SupportPointGenerator(emesh, config, throw_on_cancel, statusfn)
 {
     std::random_device rd;
-    m_rng.seed(rd());
+    m_seed = rd();
     execute(slices, heights);
 }
 
@@ -270,13 +270,12 @@ void SupportPointGenerator::process(const std::vector<ExPolygons>& slices, const
                     above_link.island->supports_force_inherited += below_support_force * above_link.overlap_area / above_overlap_area;
             }
         }
-        // Now iterate over all polygons and append new points if needed.
-        for (Structure &s : layer_top->islands) {
+        for (Structure &s : layer_top->islands)
             // Penalization resulting from large diff from the last layer:
             s.supports_force_inherited /= std::max(1.f, 0.17f * (s.overhangs_area) / s.area);
 
-            add_support_points(s, point_grid);
-        }
+        // Now iterate over all polygons and append new points if needed.
+        add_support_points(*layer_top, point_grid);
 
         m_throw_on_cancel();
 
@@ -293,7 +292,81 @@ void SupportPointGenerator::process(const std::vector<ExPolygons>& slices, const
     }
 }
 
-void SupportPointGenerator::add_support_points(SupportPointGenerator::Structure &s, SupportPointGenerator::PointGrid3D &grid3d)
+void SupportPointGenerator::add_support_points(SupportPointGenerator::MyLayer &layer, SupportPointGenerator::PointGrid3D &grid3d)
+{
+    // The islands are independent once their inherited support force is
+    // known, with one exception: the new points of an island must not collide
+    // with the points of the islands processed before it. Assign each island
+    // to the first wave following the waves of all the preceding islands
+    // within the collision distance. The islands of a single wave cannot see
+    // each other's points, so they are sampled in parallel with the same
+    // result as if they were sampled one by one in their order.
+    if (layer.islands.empty())
+        return;
+
+    const coord_t reach = scaled<coord_t>(this->poisson_radius()) + 1;
+    std::vector<BoundingBox> reach_boxes;
+    reach_boxes.reserve(layer.islands.size());
+    BoundingBox layer_bbox;
+    for (const Structure &s : layer.islands) {
+        BoundingBox bb = s.bbox;
+        bb.offset(reach);
+        reach_boxes.emplace_back(bb);
+        layer_bbox.merge(bb);
+    }
+
+    // The islands already assigned to a wave are bucketed by a grid of about
+    // one cell per island, an island is only tested against the islands
+    // sharing a cell with its reach box.
+    const size_t  grid_size = size_t(std::ceil(std::sqrt(double(layer.islands.size()))));
+    const int64_t cell_w    = int64_t(layer_bbox.size().x()) / int64_t(grid_size) + 1;
+    const int64_t cell_h    = int64_t(layer_bbox.size().y()) / int64_t(grid_size) + 1;
+    std::vector<std::vector<size_t>> grid(grid_size * grid_size);
+    auto cell_x = [&layer_bbox, cell_w, grid_size](coord_t x) {
+        return std::min(grid_size - 1, size_t(std::max<int64_t>(0, (int64_t(x) - layer_bbox.min.x()) / cell_w)));
+    };
+    auto cell_y = [&layer_bbox, cell_h, grid_size](coord_t y) {
+        return std::min(grid_size - 1, size_t(std::max<int64_t>(0, (int64_t(y) - layer_bbox.min.y()) / cell_h)));
+    };
+
+    std::vector<std::vector<size_t>> waves;
+    std::vector<size_t> island_wave(layer.islands.size(), 0);
+    for (size_t i = 0; i < layer.islands.size(); ++ i) {
+        size_t wave = 0;
+        const BoundingBox &reach_box = reach_boxes[i];
+        for (size_t y = cell_y(reach_box.min.y()); y <= cell_y(reach_box.max.y()); ++ y)
+            for (size_t x = cell_x(reach_box.min.x()); x <= cell_x(reach_box.max.x()); ++ x)
+                for (size_t j : grid[y * grid_size + x])
+                    if (island_wave[j] >= wave && reach_box.overlap(layer.islands[j].bbox))
+                        wave = island_wave[j] + 1;
+        island_wave[i] = wave;
+        const BoundingBox &bbox = layer.islands[i].bbox;
+        for (size_t y = cell_y(bbox.min.y()); y <= cell_y(bbox.max.y()); ++ y)
+            for (size_t x = cell_x(bbox.min.x()); x <= cell_x(bbox.max.x()); ++ x)
+                grid[y * grid_size + x].emplace_back(i);
+        if (wave == waves.size())
+            waves.emplace_back();
+        waves[wave].emplace_back(i);
+    }
+
+    std::vector<std::vector<SupportPoint>> island_points(layer.islands.size());
+    auto sample_island = [this, &layer, &grid3d, &island_points](size_t idx) {
+        std::seed_seq seq{ uint32_t(m_seed), uint32_t(layer.layer_id), uint32_t(idx) };
+        std::mt19937  rng(seq);
+        add_support_points(layer.islands[idx], grid3d, rng, island_points[idx]);
+    };
+    for (const std::vector<size_t> &wave : waves)
+        if (wave.size() > 1)
+            ccr::for_each(wave.begin(), wave.end(), sample_island);
+        else
+            sample_island(wave.front());
+
+    for (std::vector<SupportPoint> &pts : island_points)
+        m_output.insert(m_output.end(), pts.begin(), pts.end());
+}
+
+void SupportPointGenerator::add_support_points(SupportPointGenerator::Structure &s, SupportPointGenerator::PointGrid3D &grid3d,
+                                               std::mt19937 &rng, std::vector<SupportPoint> &out)
 {
     // Select each type of surface (overrhang, dangling, slope), derive the support
     // force deficit for it and call uniformly conver with the right params
@@ -306,7 +379,7 @@ void SupportPointGenerator::add_support_points(SupportPointGenerator::Structure
     if (s.islands_below.empty()) {
         // completely new island - needs support no doubt
         // deficit is full, there is nothing below that would hold this island
-        uniformly_cover({ *s.polygon }, s, s.area * tp, grid3d, IslandCoverageFlags(icfIsNew | icfBoundaryOnly) );
+        uniformly_cover({ *s.polygon }, s, s.area * tp, grid3d, rng, out, IslandCoverageFlags(icfIsNew | icfBoundaryOnly) );
         return;
     }
 
@@ -316,16 +389,16 @@ void SupportPointGenerator::add_support_points(SupportPointGenerator::Structure
         // What we now have in polygons needs support, regardless of what the forces are, so we can add them.
 
         double a = std::accumulate(s.dangling_areas.begin(), s.dangling_areas.end(), 0., areafn);
-        uniformly_cover(s.dangling_areas, s, a * tp - current * DANGL_DAMPING * std::sqrt(1. - a / s.area), grid3d);
+        uniformly_cover(s.dangling_areas, s, a * tp - current * DANGL_DAMPING * std::sqrt(1. - a / s.area), grid3d, rng, out);
     }
 
     if (! s.overhangs_slopes.empty()) {
         double a = std::accumulate(s.overhangs_slopes.begin(), s.overhangs_slopes.end(), 0., areafn);
-        uniformly_cover(s.overhangs_slopes, s, a * tp -  current * SLOPE_DAMPING * std::sqrt(1. - a / s.area), grid3d);
+        uniformly_cover(s.overhangs_slopes, s, a * tp -  current * SLOPE_DAMPING * std::sqrt(1. - a / s.area), grid3d, rng, out);
     }
 
     if (! s.overhangs.empty()) {
-        uniformly_cover(s.overhangs, s, s.overhangs_area * tp, grid3d);
+        uniformly_cover(s.overhangs, s, s.overhangs_area * tp, grid3d, rng, out);
     }
 }
 
@@ -527,7 +600,15 @@ static inline std::vector<Vec2f> poisson_disk_from_samples(const std::vector<Vec
 }
 
 
-void SupportPointGenerator::uniformly_cover(const ExPolygons& islands, Structure& structure, float deficit, PointGrid3D &grid3d, IslandCoverageFlags flags)
+float SupportPointGenerator::poisson_radius() const
+{
+    const float density_horizontal = m_config.tear_pressure() / m_config.support_force();
+    //FIXME why?
+    return std::max(m_config.minimal_distance, 1.f / (5.f * density_horizontal));
+}
+
+void SupportPointGenerator::uniformly_cover(const ExPolygons& islands, Structure& structure, float deficit, PointGrid3D &grid3d,
+                                            std::mt19937 &rng, std::vector<SupportPoint> &out, IslandCoverageFlags flags)
 {
     //int num_of_points = std::max(1, (int)((island.area()*pow(SCALING_FACTOR, 2) * m_config.tear_pressure)/m_config.support_force));
 
@@ -548,22 +629,18 @@ void SupportPointGenerator::uniformly_cover(const ExPolygons& islands, Structure
     // Number of newly added points.
     const size_t poisson_samples_target = size_t(ceil(support_force_deficit / m_config.support_force()));
 
-    const float density_horizontal = m_config.tear_pressure() / m_config.support_force();
-    //FIXME why?
-    float poisson_radius		= std::max(m_config.minimal_distance, 1.f / (5.f * density_horizontal));
+    float poisson_radius		= this->poisson_radius();
 //    const float poisson_radius     = 1.f / (15.f * density_horizontal);
     const float samples_per_mm2 = 30.f / (float(M_PI) * poisson_radius * poisson_radius);
     // Minimum distance between samples, in 3D space.
 //    float min_spacing			= poisson_radius / 3.f;
     float min_spacing			= poisson_radius;
 
-    //FIXME share the random generator. The random generator may be not so cheap to initialize, also we don't want the random generator to be restarted for each polygon.
-
     std::vector<Vec2f> raw_samples =
         flags & icfBoundaryOnly ?
             sample_expolygon_with_boundary(islands, samples_per_mm2,
-                                           5.f / poisson_radius, m_rng) :
-            sample_expolygon(islands, samples_per_mm2, m_rng);
+                                           5.f / poisson_radius, rng) :
+            sample_expolygon(islands, samples_per_mm2, rng);
 
     std::vector<Vec2f>  poisson_samples;
     for (size_t iter = 0; iter < 4; ++ iter) {
@@ -595,11 +672,11 @@ void SupportPointGenerator::uniformly_cover(const ExPolygons& islands, Structure
 
 //    assert(! poisson_samples.empty());
     if (poisson_samples_target < poisson_samples.size()) {
-        std::shuffle(poisson_samples.begin(), poisson_samples.end(), m_rng);
+        std::shuffle(poisson_samples.begin(), poisson_samples.end(), rng);
         poisson_samples.erase(poisson_samples.begin() + poisson_samples_target, poisson_samples.end());
     }
     for (const Vec2f &pt : poisson_samples) {
-        m_output.emplace_back(float(pt(0)), float(pt(1)), structure.zlevel, m_config.head_diameter/2.f, flags & icfIsNew);
+        out.emplace_back(float(pt(0)), float(pt(1)), structure.zlevel, m_config.head_diameter/2.f, flags & icfIsNew);
         structure.supports_force_this_layer += m_config.support_force();
         grid3d.insert(pt, &structure);
     }
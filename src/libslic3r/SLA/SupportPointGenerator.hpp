@@ -12,6 +12,8 @@
 
 #include <boost/container/small_vector.hpp>
 
+#include <tbb/concurrent_unordered_map.h>
+
 // #define SLA_SUPPORTPOINTGEN_DEBUG
 
 namespace Slic3r { namespace sla {
@@ -136,13 +138,14 @@ public:
         Structure   *island;
     };
     
+    // Points may be inserted and queried concurrently from several threads.
     struct PointGrid3D {
         struct GridHash {
             std::size_t operator()(const Vec3i &cell_id) const {
                 return std::hash<int>()(cell_id.x()) ^ std::hash<int>()(cell_id.y() * 593) ^ std::hash<int>()(cell_id.z() * 7919);
             }
         };
-        typedef std::unordered_multimap<Vec3i, RichSupportPoint, GridHash> Grid;
+        typedef tbb::concurrent_unordered_multimap<Vec3i, RichSupportPoint, GridHash> Grid;
         
         Vec3f   cell_size;
         Grid    grid;
@@ -157,7 +160,7 @@ public:
             RichSupportPoint pt;
             pt.position = Vec3f(pos.x(), pos.y(), float(island->layer->print_z));
             pt.island   = island;
-            grid.emplace(cell_id(pt.position), pt);
+            grid.insert(std::make_pair(cell_id(pt.position), pt));
         }
         
         bool collides_with(const Vec2f &pos, float print_z, float radius) {
@@ -192,7 +195,9 @@ public:
     void execute(const std::vector<ExPolygons> &slices,
                  const std::vector<float> &     heights);
     
-    void seed(std::mt19937::result_type s) { m_rng.seed(s); }
+    // Each island is sampled with its own random generator, seeded by this
+    // seed, the layer and the index of the island.
+    void seed(std::mt19937::result_type s) { m_seed = s; }
 private:
     std::vector<SupportPoint> m_output;
     
@@ -205,9 +210,16 @@ public:
 
 private:
 
-    void uniformly_cover(const ExPolygons& islands, Structure& structure, float deficit, PointGrid3D &grid3d, IslandCoverageFlags flags = icfNone);
+    // Initial radius of the Poisson disk sampling, which is also the largest
+    // distance in which the support points of an island collide with others.
+    float poisson_radius() const;
+
+    void uniformly_cover(const ExPolygons& islands, Structure& structure, float deficit, PointGrid3D &grid3d,
+                         std::mt19937 &rng, std::vector<SupportPoint> &out, IslandCoverageFlags flags = icfNone);
+
+    void add_support_points(Structure& structure, PointGrid3D &grid3d, std::mt19937 &rng, std::vector<SupportPoint> &out);
 
-    void add_support_points(Structure& structure, PointGrid3D &grid3d);
+    void add_support_points(MyLayer &layer, PointGrid3D &grid3d);
 
     void project_onto_mesh(std::vector<SupportPoint>& points) const;
 
@@ -220,7 +232,7 @@ private:
     std::function<void(void)> m_throw_on_cancel;
     std::function<void(int)>  m_statusfn;
     
-    std::mt19937 m_rng;
+    std::mt19937::result_type m_seed = std::mt19937::default_seed;
 };
 
 void remove_bottom_points(std::vector<SupportPoint> &pts, float lvl);
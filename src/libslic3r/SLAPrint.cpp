@@ -4,11 +4,14 @@
 #include "ClipperUtils.hpp"
 #include "Geometry.hpp"
 #include "MTUtils.hpp"
+#include "Utils.hpp"
 
 #include <unordered_set>
 #include <numeric>
 
 #include <tbb/parallel_for.h>
+#include <tbb/pipeline.h>
+#include <tbb/task_arena.h>
 #include <boost/filesystem/path.hpp>
 #include <boost/log/trivial.hpp>
 
@@ -661,6 +664,46 @@ std::string SLAPrint::validate() const
     return "";
 }
 
+void SLAPrinter::draw_layers_streaming(size_t layer_num, const std::function<void(sla::RasterBase&, size_t)> &drawfn)
+{
+    // The pipeline tokens bound the number of the layers drawn, encoded or waiting to be passed
+    // to the sink in layer order, thus the number of the encoded layers held in memory.
+    size_t max_in_flight = m_max_layers_in_flight > 0 ? m_max_layers_in_flight :
+                           2 * size_t(std::max(1, tbb::this_task_arena::max_concurrency()));
+    
+    struct EncodedLayer {
+        size_t             idx;
+        sla::EncodedRaster raster;
+    };
+    
+    // Let the sink clean up the layers passed so far if drawing is canceled or fails.
+    ScopeGuard abort_guard([this]() { abort_layer_sink(); });
+    size_t next_layer = 0;
+    tbb::parallel_pipeline(max_in_flight,
+        // Generate the layer indices.
+        tbb::make_filter<void, size_t>(tbb::filter::serial_in_order,
+            [&next_layer, layer_num](tbb::flow_control &fc) -> size_t {
+                if (next_layer == layer_num) {
+                    fc.stop();
+                    return 0;
+                }
+                return next_layer ++;
+            }) &
+        // Draw and encode the layers in parallel.
+        tbb::make_filter<size_t, std::shared_ptr<EncodedLayer>>(tbb::filter::parallel,
+            [this, &drawfn](size_t idx) {
+                auto rst = create_raster();
+                drawfn(*rst, idx);
+                return std::make_shared<EncodedLayer>(EncodedLayer{ idx, rst->encode(get_encoder()) });
+            }) &
+        // Pass the encoded layers to the sink in layer order.
+        tbb::make_filter<std::shared_ptr<EncodedLayer>, void>(tbb::filter::serial_in_order,
+            [this](std::shared_ptr<EncodedLayer> layer) {
+                m_layer_sink(layer->idx, std::move(layer->raster));
+            }));
+    abort_guard.reset();
+}
+
 void SLAPrint::set_printer(SLAPrinter *arch)
 {
     invalidate_step(slapsRasterize);
@@ -370,20 +370,48 @@ struct SLAPrintStatistics
 };
 
 class SLAPrinter {
+public:
+    // Receives the encoded layers in layer order: void(size_t lyrid, sla::EncodedRaster &&layer);
+    using LayerSink = std::function<void(size_t, sla::EncodedRaster &&)>;
+
 protected:
     std::vector<sla::EncodedRaster> m_layers;
     
     virtual uqptr<sla::RasterBase> create_raster() const = 0;
     virtual sla::RasterEncoder get_encoder() const = 0;
     
+    // Streaming of the layers, see set_layer_sink().
+    LayerSink m_layer_sink;
+    size_t    m_max_layers_in_flight = 0;
+    
+    // Called by draw_layers() before rethrowing, if drawing the layers for
+    // the layer sink threw or was canceled. Must not throw.
+    virtual void abort_layer_sink() {}
+    
 public:
     virtual ~SLAPrinter() = default;
     
     virtual void apply(const SLAPrinterConfig &cfg) = 0;
     
+    // If a layer sink is set, draw_layers() does not keep the encoded layers
+    // in m_layers, but passes them to the sink in layer order while the
+    // following layers are being drawn. At most max_layers_in_flight layers
+    // (twice the number of threads if zero) are kept in memory at once.
+    void set_layer_sink(LayerSink sink, size_t max_layers_in_flight = 0)
+    {
+        m_layer_sink           = std::move(sink);
+        m_max_layers_in_flight = max_layers_in_flight;
+    }
+    
     // Fn have to be thread safe: void(sla::RasterBase& raster, size_t lyrid);
     template<class Fn> void draw_layers(size_t layer_num, Fn &&drawfn)
     {
+        if (m_layer_sink) {
+            m_layers.clear();
+            draw_layers_streaming(layer_num, drawfn);
+            return;
+        }
+        
         m_layers.resize(layer_num);
         sla::ccr::for_each(size_t(0), m_layers.size(),
                            [this, &drawfn] (size_t idx) {
@@ -393,6 +421,9 @@ public:
                                enc = rst->encode(get_encoder());
                            });
     }
+    
+private:
+    void draw_layers_streaming(size_t layer_num, const std::function<void(sla::RasterBase&, size_t)> &drawfn);
 };
 
 /**
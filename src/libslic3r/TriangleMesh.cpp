@@ -764,6 +764,25 @@ void TriangleMeshSlicer::init(const TriangleMesh *_mesh, throw_on_cancel_callbac
         if ((i & 0x0ffff) == 0)
             throw_on_cancel();
     }
+
+    this->build_facet_z_index();
+}
+
+// Sort the facets by their minimum Z, so that the facets crossing a band of layers could be found by a sweep
+// over the layers without testing all the facets of the mesh.
+void TriangleMeshSlicer::build_facet_z_index()
+{
+    m_facets_z_sorted.clear();
+    m_facets_z_sorted.reserve(this->mesh->stl.stats.number_of_facets);
+    for (uint32_t facet_idx = 0; facet_idx < this->mesh->stl.stats.number_of_facets; ++ facet_idx) {
+        const stl_facet &facet = this->mesh->stl.facet_start[facet_idx];
+        FacetZSpan span;
+        span.min_z     = fminf(facet.vertex[0](2), fminf(facet.vertex[1](2), facet.vertex[2](2)));
+        span.max_z     = fmaxf(facet.vertex[0](2), fmaxf(facet.vertex[1](2), facet.vertex[2](2)));
+        span.facet_idx = int(facet_idx);
+        m_facets_z_sorted.emplace_back(span);
+    }
+    std::sort(m_facets_z_sorted.begin(), m_facets_z_sorted.end(), [](const FacetZSpan &l, const FacetZSpan &r) { return l.min_z < r.min_z; });
 }
 
 
@@ -772,6 +791,9 @@ void TriangleMeshSlicer::set_up_direction(const Vec3f& up)
 {
     m_quaternion.setFromTwoVectors(up, Vec3f::UnitZ());
     m_use_quaternion = true;
+    // The facet Z index was built for the original up direction. Rather than re-sorting the facets for each new direction
+    // (the GUI mesh clipper changes the direction interactively), slice_bands() tests all the facets with a tilted up direction.
+    m_facets_z_sorted.clear();
 }
 
 
@@ -809,28 +831,123 @@ void TriangleMeshSlicer::slice(const std::vector<float> &z, SlicingMode mode, st
     
     BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::_slice_do";
     std::vector<IntersectionLines> lines(z.size());
-    {
-        boost::mutex lines_mutex;
-        tbb::parallel_for(
-            tbb::blocked_range<int>(0,this->mesh->stl.stats.number_of_facets),
-            [&lines, &lines_mutex, &z, throw_on_cancel, this](const tbb::blocked_range<int>& range) {
-                for (int facet_idx = range.begin(); facet_idx < range.end(); ++ facet_idx) {
-                    if ((facet_idx & 0x0ffff) == 0)
-                        throw_on_cancel();
-                    this->_slice_do(facet_idx, &lines, &lines_mutex, z);
-                }
-            }
-        );
-    }
+    this->_slice_facets(nullptr, this->mesh->stl.stats.number_of_facets, z, lines, throw_on_cancel);
     throw_on_cancel();
 
     // v_scaled_shared could be freed here
     
     // build loops
     BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::_make_loops_do";
-    layers->resize(z.size());
+    this->_make_loops_do(lines, mode, layers, throw_on_cancel);
+    BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::slice finished";
+
+#ifdef SLIC3R_DEBUG
+    {
+        static int iRun = 0;
+        for (size_t i = 0; i < z.size(); ++ i) {
+            Polygons  &polygons   = (*layers)[i];
+            ExPolygons expolygons = union_ex(polygons, true);
+            SVG::export_expolygons(debug_out_path("slice_%d_%d.svg", iRun, i).c_str(), expolygons);
+            {
+                BoundingBox bbox;
+                for (const IntersectionLine &l : lines[i]) {
+                    bbox.merge(l.a);
+                    bbox.merge(l.b);
+                }
+                SVG svg(debug_out_path("slice_loops_%d_%d.svg", iRun, i).c_str(), bbox);
+                svg.draw(expolygons);
+                for (const IntersectionLine &l : lines[i])
+                    svg.draw(l, "red", 0);
+                svg.draw_outline(expolygons, "black", "blue", 0);
+                svg.Close();
+            }
+#if 0
+//FIXME slice_facet() may create zero length edges due to rounding of doubles into coord_t.
+            for (Polygon &poly : polygons) {
+                for (size_t i = 1; i < poly.points.size(); ++ i)
+                    assert(poly.points[i-1] != poly.points[i]);
+                assert(poly.points.front() != poly.points.back());
+            }
+#endif
+        }
+        ++ iRun;
+    }
+#endif
+}
+
+void TriangleMeshSlicer::slice_bands(const std::vector<float> &z, SlicingMode mode, size_t layers_per_band, layer_band_callback_type callback, throw_on_cancel_callback_type throw_on_cancel) const
+{
+    BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::slice_bands";
+    assert(layers_per_band > 0);
+    assert(std::is_sorted(z.begin(), z.end()));
+
+    // Sweep over the facets sorted by their minimum Z. Facets are activated once the band reaches their minimum Z
+    // and they are retired once the band passes over their maximum Z.
+    std::vector<int> active;
+    auto             it_next_facet = m_facets_z_sorted.begin();
+    std::vector<int> band_facets;
+    for (size_t first_layer = 0; first_layer < z.size(); first_layer += layers_per_band) {
+        throw_on_cancel();
+        size_t             last_layer = std::min(z.size(), first_layer + layers_per_band);
+        std::vector<float> band_z(z.begin() + first_layer, z.begin() + last_layer);
+        std::vector<IntersectionLines> lines(band_z.size());
+        if (m_use_quaternion || (first_layer == 0 && last_layer == z.size())) {
+            // No index for a tilted up direction, and no need to sweep if there is a single band.
+            this->_slice_facets(nullptr, this->mesh->stl.stats.number_of_facets, band_z, lines, throw_on_cancel);
+        } else {
+            for (; it_next_facet != m_facets_z_sorted.end() && it_next_facet->min_z <= band_z.back(); ++ it_next_facet)
+                active.emplace_back(int(it_next_facet - m_facets_z_sorted.begin()));
+            active.erase(std::remove_if(active.begin(), active.end(), 
+                [this, &band_z](int i) { return m_facets_z_sorted[i].max_z < band_z.front(); }), active.end());
+            // Slice the facets in the order of their indices to produce the same loops as TriangleMeshSlicer::slice().
+            band_facets.clear();
+            for (int i : active)
+                band_facets.emplace_back(m_facets_z_sorted[i].facet_idx);
+            std::sort(band_facets.begin(), band_facets.end());
+
+            this->_slice_facets(band_facets.data(), band_facets.size(), band_z, lines, throw_on_cancel);
+        }
+        std::vector<Polygons> layers;
+        this->_make_loops_do(lines, mode, &layers, throw_on_cancel);
+        // Release the intersection lines before handing over the band.
+        lines = std::vector<IntersectionLines>();
+        callback(first_layer, std::move(layers));
+    }
+    BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::slice_bands finished";
+}
+
+// Slice the facets [0, num_facets), or the facets listed in facet_ids if facet_ids is not null,
+// and distribute the intersection lines into the layers.
+void TriangleMeshSlicer::_slice_facets(const int *facet_ids, size_t num_facets, const std::vector<float> &z, std::vector<IntersectionLines> &lines, throw_on_cancel_callback_type throw_on_cancel) const
+{
+    // Each fixed range of facets collects its intersection lines into its own bucket, so that the slicing threads
+    // do not contend on a shared lock. The buckets are then merged into the layers in facet order,
+    // therefore the lines of each layer are ordered the same way as if the facets were sliced by a single thread.
+    static constexpr size_t facets_per_bucket = 0x01000;
+    std::vector<LayerIntersectionLines> buckets((num_facets + facets_per_bucket - 1) / facets_per_bucket);
     tbb::parallel_for(
-        tbb::blocked_range<size_t>(0, z.size()),
+        tbb::blocked_range<size_t>(0, buckets.size()),
+        [&buckets, &z, facet_ids, num_facets, throw_on_cancel, this](const tbb::blocked_range<size_t>& range) {
+            for (size_t bucket_idx = range.begin(); bucket_idx < range.end(); ++ bucket_idx) {
+                if ((bucket_idx & 0x0f) == 0)
+                    throw_on_cancel();
+                LayerIntersectionLines &bucket = buckets[bucket_idx];
+                size_t idx_end = std::min(num_facets, (bucket_idx + 1) * facets_per_bucket);
+                for (size_t idx = bucket_idx * facets_per_bucket; idx < idx_end; ++ idx)
+                    this->_slice_do(facet_ids ? size_t(facet_ids[idx]) : idx, bucket, z);
+            }
+        }
+    );
+    throw_on_cancel();
+    merge_intersection_lines(buckets, lines);
+}
+
+// Chain the intersection lines of each layer into closed loops, post-process the loops according to the slicing mode.
+void TriangleMeshSlicer::_make_loops_do(std::vector<IntersectionLines> &lines, SlicingMode mode, std::vector<Polygons> *layers, throw_on_cancel_callback_type throw_on_cancel) const
+{
+    layers->resize(lines.size());
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, lines.size()),
         [&lines, &layers, mode, throw_on_cancel, this](const tbb::blocked_range<size_t>& range) {
             for (size_t line_idx = range.begin(); line_idx < range.end(); ++ line_idx) {
                 if ((line_idx & 0x0ffff) == 0)
@@ -866,44 +983,9 @@ void TriangleMeshSlicer::slice(const std::vector<float> &z, SlicingMode mode, st
             }
         }
     );
-    BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::slice finished";
-
-#ifdef SLIC3R_DEBUG
-    {
-        static int iRun = 0;
-        for (size_t i = 0; i < z.size(); ++ i) {
-            Polygons  &polygons   = (*layers)[i];
-            ExPolygons expolygons = union_ex(polygons, true);
-            SVG::export_expolygons(debug_out_path("slice_%d_%d.svg", iRun, i).c_str(), expolygons);
-            {
-                BoundingBox bbox;
-                for (const IntersectionLine &l : lines[i]) {
-                    bbox.merge(l.a);
-                    bbox.merge(l.b);
-                }
-                SVG svg(debug_out_path("slice_loops_%d_%d.svg", iRun, i).c_str(), bbox);
-                svg.draw(expolygons);
-                for (const IntersectionLine &l : lines[i])
-                    svg.draw(l, "red", 0);
-                svg.draw_outline(expolygons, "black", "blue", 0);
-                svg.Close();
-            }
-#if 0
-//FIXME slice_facet() may create zero length edges due to rounding of doubles into coord_t.
-            for (Polygon &poly : polygons) {
-                for (size_t i = 1; i < poly.points.size(); ++ i)
-                    assert(poly.points[i-1] != poly.points[i]);
-                assert(poly.points.front() != poly.points.back());
-            }
-#endif
-        }
-        ++ iRun;
-    }
-#endif
 }
 
-void TriangleMeshSlicer::_slice_do(size_t facet_idx, std::vector<IntersectionLines>* lines, boost::mutex* lines_mutex, 
-    const std::vector<float> &z) const
+void TriangleMeshSlicer::_slice_do(size_t facet_idx, LayerIntersectionLines &lines, const std::vector<float> &z) const
 {
     const stl_facet &facet = m_use_quaternion ? (this->mesh->stl.facet_start.data() + facet_idx)->rotated(m_quaternion) : *(this->mesh->stl.facet_start.data() + facet_idx);
     
@@ -931,37 +1013,54 @@ void TriangleMeshSlicer::_slice_do(size_t facet_idx, std::vector<IntersectionLin
         std::vector<float>::size_type layer_idx = it - z.begin();
         IntersectionLine il;
         if (this->slice_facet(*it / SCALING_FACTOR, facet, facet_idx, min_z, max_z, &il) == TriangleMeshSlicer::Slicing) {
-            boost::lock_guard<boost::mutex> l(*lines_mutex);
             if (il.edge_type == feHorizontal) {
                 // Ignore horizontal triangles. Any valid horizontal triangle must have a vertical triangle connected, otherwise the part has zero volume.
             } else
-                (*lines)[layer_idx].emplace_back(il);
+                lines.emplace_back(layer_idx, il);
         }
     }
 }
 
+// Distribute the intersection lines collected per facet range into layers, keeping the order of the buckets.
+void TriangleMeshSlicer::merge_intersection_lines(const std::vector<LayerIntersectionLines> &buckets, std::vector<IntersectionLines> &lines)
+{
+    std::vector<size_t> num_lines(lines.size(), 0);
+    for (const LayerIntersectionLines &bucket : buckets)
+        for (const std::pair<size_t, IntersectionLine> &l : bucket)
+            ++ num_lines[l.first];
+    for (size_t layer_idx = 0; layer_idx < lines.size(); ++ layer_idx)
+        lines[layer_idx].reserve(lines[layer_idx].size() + num_lines[layer_idx]);
+    for (const LayerIntersectionLines &bucket : buckets)
+        for (const std::pair<size_t, IntersectionLine> &l : bucket)
+            lines[l.first].emplace_back(l.second);
+}
+
 void TriangleMeshSlicer::slice(const std::vector<float> &z, SlicingMode mode, const float closing_radius, std::vector<ExPolygons>* layers, throw_on_cancel_callback_type throw_on_cancel) const
 {
-    std::vector<Polygons> layers_p;
-    this->slice(z, (mode == SlicingMode::PositiveLargestContour) ? SlicingMode::Positive : mode, &layers_p, throw_on_cancel);
-    
-	BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::make_expolygons in parallel - start";
-	layers->resize(z.size());
-	tbb::parallel_for(
-		tbb::blocked_range<size_t>(0, z.size()),
-		[&layers_p, mode, closing_radius, layers, throw_on_cancel, this](const tbb::blocked_range<size_t>& range) {
-    		for (size_t layer_id = range.begin(); layer_id < range.end(); ++ layer_id) {
+    // Slice in bands of layers, so that only the intersection lines and polygons of a single band are held in memory
+    // next to the resulting ExPolygons.
+    static constexpr size_t layers_per_band = 256;
+    layers->resize(z.size());
+    this->slice_bands(z, (mode == SlicingMode::PositiveLargestContour) ? SlicingMode::Positive : mode, layers_per_band,
+        [mode, closing_radius, layers, throw_on_cancel, this](size_t first_layer, std::vector<Polygons> &&layers_p) {
+            BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::make_expolygons in parallel - start";
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(0, layers_p.size()),
+                [&layers_p, first_layer, mode, closing_radius, layers, throw_on_cancel, this](const tbb::blocked_range<size_t>& range) {
+                    for (size_t band_layer_id = range.begin(); band_layer_id < range.end(); ++ band_layer_id) {
+                        size_t layer_id = first_layer + band_layer_id;
 #ifdef SLIC3R_TRIANGLEMESH_DEBUG
-                printf("Layer %zu (slice_z = %.2f):\n", layer_id, z[layer_id]);
+                        printf("Layer %zu (slice_z = %.2f):\n", layer_id, z[layer_id]);
 #endif
-                throw_on_cancel();
-                ExPolygons &expolygons = (*layers)[layer_id];
-    			this->make_expolygons(layers_p[layer_id], closing_radius, &expolygons);
-    			if (mode == SlicingMode::PositiveLargestContour)
-					keep_largest_contour_only(expolygons);
-    		}
-    	});
-	BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::make_expolygons in parallel - end";
+                        throw_on_cancel();
+                        ExPolygons &expolygons = (*layers)[layer_id];
+                        this->make_expolygons(layers_p[band_layer_id], closing_radius, &expolygons);
+                        if (mode == SlicingMode::PositiveLargestContour)
+                            keep_largest_contour_only(expolygons);
+                    }
+                });
+            BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::make_expolygons in parallel - end";
+        }, throw_on_cancel);
 }
 
 // Return true, if the facet has been sliced and line_out has been filled.
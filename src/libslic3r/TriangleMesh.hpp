@@ -181,6 +181,13 @@ public:
     void init(const TriangleMesh *mesh, throw_on_cancel_callback_type throw_on_cancel);
     void slice(const std::vector<float> &z, SlicingMode mode, std::vector<Polygons>* layers, throw_on_cancel_callback_type throw_on_cancel) const;
     void slice(const std::vector<float> &z, SlicingMode mode, const float closing_radius, std::vector<ExPolygons>* layers, throw_on_cancel_callback_type throw_on_cancel) const;
+    // Called by slice_bands() with the index of the first layer of a band and with the slices of the band.
+    typedef std::function<void(size_t first_layer, std::vector<Polygons> &&layers)> layer_band_callback_type;
+    // Slice the mesh in bands of layers_per_band consecutive layers, the bands are handed to the callback in the order
+    // of increasing Z as they are finished. Only the facets spanning a band are sliced for that band and the intersection lines
+    // are released after each band, therefore the peak memory is bounded by the band size and not by the height of the object.
+    // The slices are the same as the ones produced by slice().
+    void slice_bands(const std::vector<float> &z, SlicingMode mode, size_t layers_per_band, layer_band_callback_type callback, throw_on_cancel_callback_type throw_on_cancel) const;
     enum FacetSliceType {
         NoSlice = 0,
         Slicing = 1,
@@ -201,8 +208,23 @@ private:
     Eigen::Quaternion<float, Eigen::DontAlign> m_quaternion;
     // Whether or not the above quaterion should be used
     bool                     m_use_quaternion = false;
+    // Z extent of a facet.
+    struct FacetZSpan {
+        float min_z;
+        float max_z;
+        int   facet_idx;
+    };
+    // Facets sorted by their minimum Z in the original up direction, for sweeping over the layers by slice_bands().
+    std::vector<FacetZSpan>  m_facets_z_sorted;
+
+    // Intersection lines tagged with the index of the layer they belong to.
+    typedef std::vector<std::pair<size_t, IntersectionLine>> LayerIntersectionLines;
 
-    void _slice_do(size_t facet_idx, std::vector<IntersectionLines>* lines, boost::mutex* lines_mutex, const std::vector<float> &z) const;
+    void _slice_do(size_t facet_idx, LayerIntersectionLines &lines, const std::vector<float> &z) const;
+    static void merge_intersection_lines(const std::vector<LayerIntersectionLines> &buckets, std::vector<IntersectionLines> &lines);
+    void build_facet_z_index();
+    void _slice_facets(const int *facet_ids, size_t num_facets, const std::vector<float> &z, std::vector<IntersectionLines> &lines, throw_on_cancel_callback_type throw_on_cancel) const;
+    void _make_loops_do(std::vector<IntersectionLines> &lines, SlicingMode mode, std::vector<Polygons> *layers, throw_on_cancel_callback_type throw_on_cancel) const;
     void make_loops(std::vector<IntersectionLine> &lines, Polygons* loops) const;
     void make_expolygons(const Polygons &loops, const float closing_radius, ExPolygons* slices) const;
     void make_expolygons_simple(std::vector<IntersectionLine> &lines, ExPolygons* slices) const;
@@ -245,18 +267,31 @@ TriangleMesh make_sphere(double rho, double fa=(2*PI/360));
 #include <cereal/access.hpp>
 namespace cereal {
 	template <class Archive> struct specialize<Archive, Slic3r::TriangleMesh, cereal::specialization::non_member_load_save> {};
+	// The statistics are stored in full, so that the repair results reported to the user survive Undo / Redo.
+	template<class Archive, class Stats> void serialize_stl_stats(Archive &archive, Stats &stats) {
+		archive(stats.header, stats.type, stats.number_of_facets,
+			stats.max.x(), stats.max.y(), stats.max.z(), stats.min.x(), stats.min.y(), stats.min.z(), stats.size.x(), stats.size.y(), stats.size.z(),
+			stats.bounding_diameter, stats.shortest_edge, stats.volume, stats.connected_edges,
+			stats.connected_facets_1_edge, stats.connected_facets_2_edge, stats.connected_facets_3_edge,
+			stats.facets_w_1_bad_edge, stats.facets_w_2_bad_edge, stats.facets_w_3_bad_edge, stats.original_num_facets,
+			stats.edges_fixed, stats.degenerate_facets, stats.facets_removed, stats.facets_added, stats.facets_reversed,
+			stats.backwards_edges, stats.normals_fixed, stats.number_of_parts);
+	}
+	// The mesh is not repaired when loaded, it is stored after being repaired. The neighbors and the indexed triangle set
+	// are not stored, they are to be recalculated by TriangleMesh::restore_optional().
 	template<class Archive> void load(Archive &archive, Slic3r::TriangleMesh &mesh) {
         stl_file &stl = mesh.stl;
-        stl.stats.type = inmemory;
-		archive(stl.stats.number_of_facets, stl.stats.original_num_facets);
-        stl_allocate(&stl);
+		archive(mesh.repaired);
+		serialize_stl_stats(archive, stl.stats);
+		stl.facet_start.assign(stl.stats.number_of_facets, stl_facet());
+		stl.neighbors_start.clear();
+		mesh.its.clear();
 		archive.loadBinary((char*)stl.facet_start.data(), stl.facet_start.size() * 50);
-        stl_get_size(&stl);
-        mesh.repair();
 	}
 	template<class Archive> void save(Archive &archive, const Slic3r::TriangleMesh &mesh) {
 		const stl_file& stl = mesh.stl;
-		archive(stl.stats.number_of_facets, stl.stats.original_num_facets);
+		archive(mesh.repaired);
+		serialize_stl_stats(archive, stl.stats);
 		archive.saveBinary((char*)stl.facet_start.data(), stl.facet_start.size() * 50);
 	}
 }
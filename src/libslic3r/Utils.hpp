@@ -103,6 +103,12 @@ namespace PerlUtils {
 
 std::string string_printf(const char *format, ...);
 
+// Conversion of a number to double with the syntax and the result of strtod() in the "C" locale,
+// whatever the current locale is. The usual decimal numbers (at most 19 significant digits and
+// a decimal exponent within +-22) are converted exactly without calling the C library.
+// If pend is not null, it receives the end of the number, the same as with strtod().
+double string_to_double_decimal_point(const char *str, char **pend = nullptr);
+
 // Standard "generated by Slic3r version xxx timestamp xxx" header string, 
 // to be placed at the top of Slic3r generated files.
 std::string header_slic3r_generated();
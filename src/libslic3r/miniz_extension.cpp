@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <exception>
+#include <memory>
 
 #include "miniz_extension.hpp"
 
@@ -8,6 +10,9 @@
 
 #include "I18N.hpp"
 
+#include <tbb/pipeline.h>
+#include <tbb/task_arena.h>
+
 //! macro used to mark string used at localization,
 //! return same string
 #define L(s) Slic3r::I18N::translate(s)
@@ -76,6 +81,90 @@ bool open_zip_writer(mz_zip_archive *zip, const std::string &fname)
 bool close_zip_reader(mz_zip_archive *zip) { return close_zip(zip, true); }
 bool close_zip_writer(mz_zip_archive *zip) { return close_zip(zip, false); }
 
+namespace {
+mz_bool string_putter(const void *buf, int len, void *user)
+{
+    static_cast<std::string*>(user)->append(static_cast<const char*>(buf), size_t(len));
+    return MZ_TRUE;
+}
+}
+
+bool add_zip_entry_chunked(mz_zip_archive *zip, const std::string &name, size_t num_chunks,
+                           const std::function<void(size_t, std::string&)> &produce_chunk,
+                           mz_uint level)
+{
+    if (int(level) < 0)
+        level = MZ_DEFAULT_LEVEL;
+    if (num_chunks == 0)
+        return mz_zip_writer_add_mem(zip, name.c_str(), nullptr, 0, level);
+    // The entry is stored, not deflated, if not compressed. Its method is derived
+    // from the level, the chunks must not be passed as deflated data then.
+    const bool store = (level & 0xF) == MZ_NO_COMPRESSION;
+
+    struct Chunk {
+        size_t      idx;
+        std::string data;
+        std::string deflated;
+        bool        ok;
+    };
+
+    // Each chunk is deflated by its own compressor. All the chunks but the last one
+    // end with a full flush, which aligns them to a byte boundary without closing
+    // the deflate stream, thus the deflated chunks concatenate to a valid stream.
+    mz_uint flags = tdefl_create_comp_flags_from_zip_params(int(level), -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY);
+    auto deflate_chunk = [flags, num_chunks](Chunk &chunk) {
+        std::unique_ptr<tdefl_compressor, void(*)(tdefl_compressor*)> comp(tdefl_compressor_alloc(), tdefl_compressor_free);
+        bool last = chunk.idx + 1 == num_chunks;
+        chunk.deflated.reserve(chunk.data.size() / 4);
+        chunk.ok = comp && tdefl_init(comp.get(), string_putter, &chunk.deflated, int(flags)) == TDEFL_STATUS_OKAY &&
+            tdefl_compress_buffer(comp.get(), chunk.data.data(), chunk.data.size(), last ? TDEFL_FINISH : TDEFL_FULL_FLUSH) ==
+                (last ? TDEFL_STATUS_DONE : TDEFL_STATUS_OKAY);
+    };
+
+    std::string entry;
+    mz_uint64   size = 0;
+    mz_uint32   crc  = MZ_CRC32_INIT;
+    bool        ok   = true;
+    size_t      next = 0;
+    tbb::parallel_pipeline(2 * size_t(std::max(1, tbb::this_task_arena::max_concurrency())),
+        tbb::make_filter<void, size_t>(tbb::filter::serial_in_order,
+            [&next, num_chunks](tbb::flow_control &fc) -> size_t {
+                if (next == num_chunks) {
+                    fc.stop();
+                    return 0;
+                }
+                return next ++;
+            }) &
+        // Produce and deflate the chunks in parallel.
+        tbb::make_filter<size_t, std::shared_ptr<Chunk>>(tbb::filter::parallel,
+            [&produce_chunk, &deflate_chunk, store](size_t idx) {
+                auto chunk = std::make_shared<Chunk>();
+                chunk->idx = idx;
+                chunk->ok  = true;
+                produce_chunk(idx, chunk->data);
+                if (! store)
+                    deflate_chunk(*chunk);
+                return chunk;
+            }) &
+        // Concatenate the deflated (or the stored) chunks in order.
+        tbb::make_filter<std::shared_ptr<Chunk>, void>(tbb::filter::serial_in_order,
+            [&entry, &size, &crc, &ok, store](std::shared_ptr<Chunk> chunk) {
+                ok   &= chunk->ok;
+                size += chunk->data.size();
+                crc   = mz_uint32(mz_crc32(crc, reinterpret_cast<const unsigned char*>(chunk->data.data()), chunk->data.size()));
+                entry += store ? chunk->data : chunk->deflated;
+            }));
+
+    if (! ok) {
+        zip->m_last_error = MZ_ZIP_COMPRESSION_FAILED;
+        return false;
+    }
+    if (size == 0 || store)
+        return mz_zip_writer_add_mem(zip, name.c_str(), entry.data(), entry.size(), level);
+    return mz_zip_writer_add_mem_ex(zip, name.c_str(), entry.data(), entry.size(), nullptr, 0,
+                                    level | MZ_ZIP_FLAG_COMPRESSED_DATA, size, crc);
+}
+
 MZ_Archive::MZ_Archive()
 {
     mz_zip_zero_struct(&arch);
@@ -1,6 +1,7 @@
 #ifndef MINIZ_EXTENSION_HPP
 #define MINIZ_EXTENSION_HPP
 
+#include <functional>
 #include <string>
 #include <miniz.h>
 
@@ -11,6 +12,16 @@ bool open_zip_writer(mz_zip_archive *zip, const std::string &fname_utf8);
 bool close_zip_reader(mz_zip_archive *zip);
 bool close_zip_writer(mz_zip_archive *zip);
 
+// Adds an entry of num_chunks pieces to the archive, the piece idx being
+// appended to the output string by produce_chunk(idx, out). The pieces are
+// produced and deflated in parallel, a bounded number of them at a time, so
+// neither the whole uncompressed entry nor a copy of it is held in memory,
+// only its compressed data until the entry is written. With level
+// MZ_NO_COMPRESSION the pieces are stored, thus the whole entry is held.
+bool add_zip_entry_chunked(mz_zip_archive *zip, const std::string &name, size_t num_chunks,
+                           const std::function<void(size_t, std::string&)> &produce_chunk,
+                           mz_uint level = MZ_DEFAULT_LEVEL);
+
 class MZ_Archive {
 public:
     mz_zip_archive arch;
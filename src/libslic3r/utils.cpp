@@ -1,6 +1,8 @@
 #include "Utils.hpp"
 #include "I18N.hpp"
 
+#include <clocale>
+#include <cstring>
 #include <locale>
 #include <ctime>
 #include <cstdarg>
@@ -602,6 +604,79 @@ std::string string_printf(const char *format, ...)
     return buffer;
 }
 
+double string_to_double_decimal_point(const char *str, char **pend)
+{
+    static constexpr const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+    const char *p = str;
+    while (*p == ' ' || (*p >= '\t' && *p <= '\r'))
+        ++ p;
+    bool negative = *p == '-';
+    if (*p == '-' || *p == '+')
+        ++ p;
+    // Accumulate the significant digits into an integer mantissa.
+    uint64_t mantissa   = 0;
+    int      num_digits = 0;
+    int      exponent   = 0;
+    bool     has_digits = false;
+    for (; *p >= '0' && *p <= '9'; ++ p, has_digits = true)
+        if (num_digits < 19) {
+            mantissa = mantissa * 10 + uint64_t(*p - '0');
+            num_digits += mantissa > 0;
+        } else
+            ++ exponent;
+    if (*p == '.')
+        for (++ p; *p >= '0' && *p <= '9'; ++ p, has_digits = true)
+            if (num_digits < 19) {
+                mantissa = mantissa * 10 + uint64_t(*p - '0');
+                num_digits += mantissa > 0;
+                -- exponent;
+            }
+    if (has_digits && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        bool exp_negative = *q == '-';
+        if (*q == '-' || *q == '+')
+            ++ q;
+        if (*q >= '0' && *q <= '9') {
+            int e = 0;
+            for (; *q >= '0' && *q <= '9'; ++ q)
+                if (e < 10000)
+                    e = e * 10 + (*q - '0');
+            exponent += exp_negative ? - e : e;
+            p = q;
+        }
+    }
+    // Clinger's fast path: both the mantissa and the power of ten are exact doubles,
+    // therefore the single multiplication or division is correctly rounded, the same as by strtod().
+    // A number followed by a letter or a dot may be a hexadecimal number, or strtod() may end it elsewhere.
+    auto may_continue = [](char c) { return c == '.' || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); };
+    if (has_digits && mantissa < (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22 && ! may_continue(*p)) {
+        double v = double(mantissa);
+        v = exponent < 0 ? v / pow10[- exponent] : v * pow10[exponent];
+        if (pend)
+            *pend = const_cast<char*>(p);
+        return negative ? - v : v;
+    }
+
+    // strtod() expects the decimal point of the current locale. Replace the dot by it in a copy of the number.
+    const char *decimal_point = localeconv()->decimal_point;
+    if (decimal_point[0] == '.' || decimal_point[0] == 0 || decimal_point[1] != 0)
+        return strtod(str, pend);
+    char buf[512];
+    size_t len = 0;
+    for (; len + 1 < sizeof(buf) && str[len] != 0 && (may_continue(str[len]) || strchr(" \t\n\v\f\r+-_()", str[len]) != nullptr); ++ len)
+        buf[len] = str[len] == '.' ? decimal_point[0] : str[len];
+    if (len + 1 == sizeof(buf))
+        return strtod(str, pend);
+    buf[len] = 0;
+    char  *end;
+    double v = strtod(buf, &end);
+    if (pend)
+        *pend = const_cast<char*>(str) + (end - buf);
+    return v;
+}
+
 std::string header_slic3r_generated()
 {
     return std::string("generated by " SLIC3R_APP_NAME " " SLIC3R_VERSION " on " ) + Utils::utc_timestamp();
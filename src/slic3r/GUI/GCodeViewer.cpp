@@ -406,32 +406,20 @@ void GCodeViewer::refresh(const GCodeProcessor::Result& gcode_result, const std:
 
     // update ranges for coloring / legend
     m_extrusions.reset_ranges();
-    for (size_t i = 0; i < m_vertices_count; ++i) {
-        // skip first vertex
-        if (i == 0)
-            continue;
-
-        const GCodeProcessor::MoveVertex& curr = gcode_result.moves[i];
-
-        switch (curr.type)
-        {
-        case EMoveType::Extrude:
-        {
-            m_extrusions.ranges.height.update_from(round_to_nearest(curr.height, 2));
-            m_extrusions.ranges.width.update_from(round_to_nearest(curr.width, 2));
-            m_extrusions.ranges.fan_speed.update_from(curr.fan_speed);
-            m_extrusions.ranges.volumetric_rate.update_from(round_to_nearest(curr.volumetric_rate(), 2));
-            [[fallthrough]];
-        }
-        case EMoveType::Travel:
-        {
-            if (m_buffers[buffer_id(curr.type)].visible)
-                m_extrusions.ranges.feedrate.update_from(curr.feedrate);
-
-            break;
-        }
-        default: { break; }
-        }
+    // The attributes are constant over a run of moves, therefore it is sufficient to scan the runs.
+    // The first vertex is a dummy move, which is neither an extrusion nor a travel.
+    bool extrude_visible = m_buffers[buffer_id(EMoveType::Extrude)].visible;
+    bool travel_visible  = m_buffers[buffer_id(EMoveType::Travel)].visible;
+    for (const GCodeProcessor::MoveVertices::Run& run : gcode_result.moves.runs()) {
+        bool extrude = run.has_type(EMoveType::Extrude);
+        if (extrude) {
+            m_extrusions.ranges.height.update_from(round_to_nearest(run.height, 2));
+            m_extrusions.ranges.width.update_from(round_to_nearest(run.width, 2));
+            m_extrusions.ranges.fan_speed.update_from(run.fan_speed);
+            m_extrusions.ranges.volumetric_rate.update_from(round_to_nearest(run.volumetric_rate(), 2));
+        }
+        if ((extrude && extrude_visible) || (run.has_type(EMoveType::Travel) && travel_visible))
+            m_extrusions.ranges.feedrate.update_from(run.feedrate);
     }
 
 #if ENABLE_GCODE_VIEWER_STATISTICS
@@ -864,7 +852,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
 {
 #if ENABLE_GCODE_VIEWER_STATISTICS
     auto start_time = std::chrono::high_resolution_clock::now();
-    m_statistics.results_size = SLIC3R_STDVEC_MEMSIZE(gcode_result.moves, GCodeProcessor::MoveVertex);
+    m_statistics.results_size = gcode_result.moves.memsize();
     m_statistics.results_time = gcode_result.time;
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
 
@@ -873,8 +861,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
     if (m_vertices_count == 0)
         return;
 
-    for (size_t i = 0; i < m_vertices_count; ++i) {
-        const GCodeProcessor::MoveVertex& move = gcode_result.moves[i];
+    for (const GCodeProcessor::MoveVertex& move : gcode_result.moves) {
         if (wxGetApp().is_gcode_viewer())
             // for the gcode viewer we need all moves to correctly size the printbed
             m_paths_bounding_box.merge(move.position.cast<double>());
@@ -1161,13 +1148,10 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
     // toolpaths data -> extract from result
     std::vector<std::vector<float>> vertices(m_buffers.size());
     std::vector<std::vector<unsigned int>> indices(m_buffers.size());
-    for (size_t i = 0; i < m_vertices_count; ++i) {
-        // skip first vertex
-        if (i == 0)
-            continue;
-
-        const GCodeProcessor::MoveVertex& prev = gcode_result.moves[i - 1];
-        const GCodeProcessor::MoveVertex& curr = gcode_result.moves[i];
+    GCodeProcessor::MoveVertices::const_iterator it_move = gcode_result.moves.begin();
+    GCodeProcessor::MoveVertex prev = *it_move;
+    for (size_t i = 1; i < m_vertices_count; ++i) {
+        const GCodeProcessor::MoveVertex curr = *(++ it_move);
 
         unsigned char id = buffer_id(curr.type);
         TBuffer& buffer = m_buffers[id];
@@ -1198,6 +1182,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
         }
         default: { break; }
         }
+        prev = curr;
     }
 
     // toolpaths data -> send data to gpu
@@ -1242,15 +1227,19 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
 
     // layers zs / roles / extruder ids / cp color ids -> extract from result
-    for (size_t i = 0; i < m_vertices_count; ++i) {
-        const GCodeProcessor::MoveVertex& move = gcode_result.moves[i];
-        if (move.type == EMoveType::Extrude)
-            m_layers_zs.emplace_back(static_cast<double>(move.position[2]));
-
-        m_extruder_ids.emplace_back(move.extruder_id);
-
-        if (i > 0)
-            m_roles.emplace_back(move.extrusion_role);
+    // the attributes are constant over a run of moves, therefore it is sufficient to scan the runs
+    const std::vector<GCodeProcessor::MoveVertices::Run>& runs = gcode_result.moves.runs();
+    for (size_t i = 0; i < runs.size(); ++i) {
+        const GCodeProcessor::MoveVertices::Run& run = runs[i];
+        if (run.has_type(EMoveType::Extrude))
+            m_layers_zs.emplace_back(static_cast<double>(run.z));
+
+        m_extruder_ids.emplace_back(run.extruder_id);
+
+        // skip the role of the first vertex, unless its run contains other vertices
+        size_t run_end = (i + 1 < runs.size()) ? runs[i + 1].first : m_vertices_count;
+        if (run.first > 0 || run_end > 1)
+            m_roles.emplace_back(run.extrusion_role);
     }
 
     // layers zs -> replace intervals of layers with similar top positions with their average value.
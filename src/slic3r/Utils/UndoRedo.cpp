@@ -1,10 +1,13 @@
 #include "UndoRedo.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <fstream>
 #include <memory>
+#include <string_view>
 #include <typeinfo> 
+#include <unordered_map>
 #include <cassert>
 #include <cstddef>
 
@@ -23,6 +26,9 @@
 
 #include <boost/foreach.hpp>
 
+#include <tbb/parallel_for.h>
+#include <tbb/task_group.h>
+
 #ifndef NDEBUG
 // #define SLIC3R_UNDOREDO_DEBUG
 #endif /* NDEBUG */
@@ -76,6 +82,70 @@ private:
 	size_t 	m_end;
 };
 
+// Chunk of a serialized immutable object. The serialized data is split into chunks of serialized_chunk_size,
+// which are compressed independently of each other and shared by content through the SerializedChunkPool.
+struct SerializedChunk
+{
+	// Hash and size of the uncompressed data.
+	size_t 		hash { 0 };
+	size_t 		size { 0 };
+	// Data, which does not compress, is stored as is.
+	bool 		compressed { false };
+	std::string data;
+
+	bool 		operator==(const SerializedChunk &rhs) const 
+		{ return this->hash == rhs.hash && this->size == rhs.size && this->compressed == rhs.compressed && this->data == rhs.data; }
+	size_t 		memsize() const { return sizeof(SerializedChunk) + this->data.size(); }
+};
+using SerializedChunkPtr = std::shared_ptr<const SerializedChunk>;
+
+static constexpr const size_t serialized_chunk_size = 1024 * 1024;
+
+// Compress a chunk of a serialized object, decompress a chunk appending it to out.
+static SerializedChunk 	compress_serialized_chunk(const char *data, size_t size);
+static void 			decompress_serialized_chunk(const SerializedChunk &chunk, std::string &out);
+
+// Chunks of the immutable objects serialized onto the Undo / Redo stack, indexed by the hash of their uncompressed data,
+// so that chunks of the same content are stored just once. The chunks are owned by the histories of the immutable objects.
+class SerializedChunkPool
+{
+public:
+	SerializedChunkPtr insert(SerializedChunk &&chunk) {
+		std::weak_ptr<const SerializedChunk> &slot = m_chunks[chunk.hash];
+		SerializedChunkPtr out = slot.lock();
+		if (! out || ! (*out == chunk)) {
+			// Either a new chunk, or a hash collision, in which case the new chunk replaces the old one in the pool.
+			out = std::make_shared<const SerializedChunk>(std::move(chunk));
+			slot = out;
+		}
+		return out;
+	}
+
+	// Remove the chunks no more referenced by any history.
+	void collect_garbage() {
+		for (auto it = m_chunks.begin(); it != m_chunks.end();)
+			if (it->second.expired())
+				it = m_chunks.erase(it);
+			else
+				++ it;
+	}
+
+	void clear() { m_chunks.clear(); }
+
+private:
+	std::unordered_map<size_t, std::weak_ptr<const SerializedChunk>> m_chunks;
+};
+
+// Serialization of an immutable object running in the background.
+struct SerializationJob
+{
+	// The object being serialized. It is kept alive by the job even if the history owning the job is released in the meantime.
+	std::shared_ptr<const void> 	object;
+	// Output of the job, empty if the serialization failed.
+	std::vector<SerializedChunk> 	chunks;
+	std::atomic<bool> 				done { false };
+};
+
 // History of a single object tracked by the Undo / Redo stack. The object may be mutable or immutable.
 class ObjectHistoryBase
 {
@@ -104,6 +174,15 @@ public:
 	// Restore optional data possibly released by release_optional.
 	virtual void   restore_optional() = 0;
 
+	// Start serializing and compressing the object in the background if it is an immutable object referenced by the Undo / Redo stack only.
+	// Return true if the serialization was started.
+	virtual bool   start_serialization(tbb::task_group & /* tasks */) { return false; }
+	// Is the object being serialized in the background?
+	virtual bool   serialization_running() const { return false; }
+	// If the background serialization finished, replace the object with its serialized data.
+	// Return the amount of memory released.
+	virtual size_t finish_serialization(SerializedChunkPool & /* pool */) { return 0; }
+
 	// Estimated size in memory, to be used to drop least recently used snapshots.
 	virtual size_t memsize() const = 0;
 
@@ -185,8 +264,8 @@ protected:
 // and as long as the ref counter of these objects is higher than 1 (1 reference is held
 // by the Undo / Redo stack), there is no cost associated to holding the object
 // at the Undo / Redo stack. Once the reference counter drops to 1 (only the Undo / Redo
-// stack holds the reference), the shared pointer may get serialized (and possibly compressed)
-// and the shared pointer may be released.
+// stack holds the reference) and the Undo / Redo stack grows over its memory limit,
+// the object is serialized and compressed in the background and the shared pointer is released.
 // The history of a single immutable object may not be continuous, as an immutable object may
 // be removed from the scene while being kept at the Copy / Paste stack.
 template<typename T>
@@ -206,8 +285,8 @@ public:
 	size_t memsize() const override {
 		size_t memsize = sizeof(*this);
 		if (this->is_serialized())
-			memsize += m_serialized.size();
-		else if (m_shared_object.use_count() == 1)
+			memsize += this->serialized_memsize();
+		else if (this->referenced_by_stack_only())
 			// Only count the shared object's memsize into the total Undo / Redo stack memsize if it is referenced from the Undo / Redo stack only.
 			memsize += m_shared_object->memsize();
 		memsize += m_history.size() * sizeof(Interval);
@@ -242,10 +321,10 @@ public:
 		if (m_optional) {
 			bool released = false;
 			if (this->is_serialized()) {
-				mem_released += m_serialized.size();
+				mem_released += this->serialized_memsize();
 				m_serialized.clear();
 				released = true;
-			} else if (m_shared_object.use_count() == 1) {
+			} else if (this->referenced_by_stack_only()) {
 				mem_released += m_shared_object->memsize();
 				m_shared_object.reset();
 				released = true;
@@ -254,7 +333,7 @@ public:
 				mem_released += m_history.size() * sizeof(Interval);
 				m_history.clear();
 			}
-		} else if (m_shared_object.use_count() == 1) {
+		} else if (this->referenced_by_stack_only() && ! m_serialization) {
 			// The object is in memory, but it is not shared with the scene. Let the object decide whether there is any optional data to release.
 			const_cast<T*>(m_shared_object.get())->release_optional();
 		}
@@ -263,19 +342,70 @@ public:
 
 	// Restore optional data possibly released by this->release_optional().
 	void restore_optional() override {
-		if (m_shared_object.use_count() == 1)
+		assert(! this->serialization_running());
+		if (this->referenced_by_stack_only())
 			const_cast<T*>(m_shared_object.get())->restore_optional();
 	}
 
+	bool start_serialization(tbb::task_group &tasks) override {
+		// Optional objects are rather released than serialized.
+		if (m_optional || m_serialization || ! this->referenced_by_stack_only())
+			return false;
+		m_serialization = std::make_shared<SerializationJob>();
+		m_serialization->object = m_shared_object;
+		tasks.run([job = m_serialization, object = m_shared_object.get()]() {
+			try {
+				// The immutable objects do not reference other objects on the Undo / Redo stack, thus the stack is not needed by the archive.
+				std::ostringstream oss;
+				{
+					cereal::BinaryOutputArchive archive(oss);
+					archive(*object);
+				}
+				const std::string data = oss.str();
+				job->chunks.assign((data.size() + serialized_chunk_size - 1) / serialized_chunk_size, SerializedChunk());
+				tbb::parallel_for(size_t(0), job->chunks.size(), [&data, &job](size_t chunk_idx) {
+					size_t begin = chunk_idx * serialized_chunk_size;
+					job->chunks[chunk_idx] = compress_serialized_chunk(data.data() + begin, std::min(serialized_chunk_size, data.size() - begin));
+				});
+			} catch (std::exception &) {
+				// Keep the object in memory.
+				job->chunks.clear();
+			}
+			job->done = true;
+		});
+		return true;
+	}
+
+	bool serialization_running() const override { return m_serialization && ! m_serialization->done; }
+
+	size_t finish_serialization(SerializedChunkPool &pool) override {
+		if (! m_serialization || ! m_serialization->done)
+			return 0;
+		// The object may have been shared with the scene again by undo / redo, while it was being serialized.
+		bool 							  release = this->referenced_by_stack_only();
+		std::shared_ptr<SerializationJob> job     = std::move(m_serialization);
+		if (! release || job->chunks.empty())
+			return 0;
+		size_t memsize_object = m_shared_object->memsize();
+		m_serialized.reserve(job->chunks.size());
+		for (SerializedChunk &chunk : job->chunks)
+			m_serialized.emplace_back(pool.insert(std::move(chunk)));
+		m_shared_object.reset();
+		size_t memsize_serialized = this->serialized_memsize();
+		return memsize_object > memsize_serialized ? memsize_object - memsize_serialized : 0;
+	}
+
+	// Drop the result of a finished background serialization, as the object is going to be shared with the scene.
+	void discard_serialization() { assert(! this->serialization_running()); m_serialization.reset(); }
+
 	bool 						is_serialized() const { return m_shared_object.get() == nullptr; }
-	const std::string&			serialized_data() const { return m_serialized; }
 	std::shared_ptr<const T>& 	shared_ptr(StackImpl &stack);
 
 #ifdef SLIC3R_UNDOREDO_DEBUG
 	std::string 				format() override {
 		std::string out = typeid(T).name();
 		out += this->is_serialized() ? 
-			std::string(" len:") + std::to_string(m_serialized.size()) : 
+			std::string(" chunks:") + std::to_string(m_serialized.size()) + " len:" + std::to_string(this->serialized_memsize()) : 
 			std::string(" shared_ptr:") + ptr_to_string(m_shared_object.get());
 		for (const Interval &interval : m_history)
 			out += std::string(", <") + std::to_string(interval.begin()) + "," + std::to_string(interval.end()) + ")";
@@ -288,12 +418,25 @@ public:
 #endif /* NDEBUG */
 
 private:
+	// Is the object referenced by the Undo / Redo stack only? The background serialization holds one more reference.
+	bool 						referenced_by_stack_only() const { return m_shared_object.use_count() == (m_serialization ? 2 : 1); }
+
+	// A chunk shared by multiple histories is accounted to each of them proportionally.
+	size_t 						serialized_memsize() const {
+		size_t memsize = m_serialized.capacity() * sizeof(SerializedChunkPtr);
+		for (const SerializedChunkPtr &chunk : m_serialized)
+			memsize += (chunk->memsize() + chunk.use_count() - 1) / chunk.use_count();
+		return memsize;
+	}
+
 	// Either the source object is held by a shared pointer and the m_serialized field is empty,
-	// or the shared pointer is null and the object is being serialized into m_serialized.
-	std::shared_ptr<const T>	m_shared_object;
+	// or the shared pointer is null and the object is serialized into m_serialized.
+	std::shared_ptr<const T>			m_shared_object;
 	// If this object is optional, then it may be deleted from the Undo / Redo stack and recalculated from other data (for example mesh convex hull).
-	bool 						m_optional;
-	std::string 				m_serialized;
+	bool 								m_optional;
+	std::vector<SerializedChunkPtr> 	m_serialized;
+	// Serialization of m_shared_object running in the background, or finished and not collected yet.
+	std::shared_ptr<SerializationJob> 	m_serialization;
 };
 
 struct MutableHistoryInterval
@@ -491,10 +634,13 @@ public:
 	// Stack needs to be initialized. An empty stack is not valid, there must be a "New Project" status stored at the beginning.
 	// Initially enable Undo / Redo stack to occupy maximum 10% of the total system physical memory.
 	StackImpl() : m_memory_limit(std::min(Slic3r::total_physical_memory() / 10, size_t(1 * 16384 * 65536 / UNDO_REDO_DEBUG_LOW_MEM_FACTOR))), m_active_snapshot_time(0), m_current_time(0) {}
+	~StackImpl() { m_serialization_tasks.wait(); }
 
 	void clear() {
+		m_serialization_tasks.wait();
 		m_objects.clear();
 		m_shared_ptr_to_object_id.clear();
+		m_serialized_chunks.clear();
 		m_snapshots.clear();
 		m_active_snapshot_time = 0;
 		m_current_time = 0;
@@ -594,6 +740,10 @@ private:
 		return it->second;
 	}
 	void 							collect_garbage();
+	// Serialization of the immutable objects in the background, see ImmutableObjectHistory.
+	bool 							start_serialization();
+	bool 							serialization_running() const;
+	size_t 							finish_serialization();
 
 	// Maximum memory allowed to be occupied by the Undo / Redo stack. If the limit is exceeded,
 	// least recently used snapshots will be released.
@@ -611,6 +761,10 @@ private:
 	size_t 													m_current_time;
 	// Last selection serialized or deserialized.
 	Selection 												m_selection;
+	// Chunks of the serialized immutable objects, shared by content.
+	SerializedChunkPool 									m_serialized_chunks;
+	// Immutable objects being serialized in the background.
+	tbb::task_group 										m_serialization_tasks;
 };
 
 using InputArchive  = cereal::UserDataAdapter<StackImpl, cereal::BinaryInputArchive>;
@@ -723,14 +877,51 @@ namespace cereal
 #include <slic3r/GUI/Selection.hpp>
 #include <slic3r/GUI/Gizmos/GLGizmosManager.hpp>
 
+// Included after the other headers, as miniz defines the zlib function names as macros.
+#include <miniz.h>
+
 namespace Slic3r {
 namespace UndoRedo {
 
+// The fastest deflate level is used: The compression runs in the background, but the decompression runs
+// on the UI thread when undoing.
+static SerializedChunk compress_serialized_chunk(const char *data, size_t size)
+{
+	SerializedChunk chunk;
+	chunk.hash = std::hash<std::string_view>()(std::string_view(data, size));
+	chunk.size = size;
+	mz_ulong 				   compressed_size = mz_compressBound(mz_ulong(size));
+	std::vector<unsigned char> compressed(compressed_size);
+	if (mz_compress2(compressed.data(), &compressed_size, (const unsigned char*)data, mz_ulong(size), MZ_BEST_SPEED) == MZ_OK && compressed_size < size) {
+		chunk.data.assign((const char*)compressed.data(), compressed_size);
+		chunk.compressed = true;
+	} else
+		chunk.data.assign(data, size);
+	return chunk;
+}
+
+// Append the uncompressed data of a chunk to out.
+static void decompress_serialized_chunk(const SerializedChunk &chunk, std::string &out)
+{
+	if (! chunk.compressed) {
+		out += chunk.data;
+		return;
+	}
+	size_t   offset = out.size();
+	mz_ulong size   = mz_ulong(chunk.size);
+	out.resize(offset + chunk.size);
+	if (mz_uncompress((unsigned char*)&out[offset], &size, (const unsigned char*)chunk.data.data(), mz_ulong(chunk.data.size())) != MZ_OK || size != chunk.size)
+		throw std::runtime_error("Undo / Redo stack: Failed to decompress a serialized object");
+}
+
 template<typename T> std::shared_ptr<const T>& 	ImmutableObjectHistory<T>::shared_ptr(StackImpl &stack)
 {
 	if (m_shared_object.get() == nullptr && ! this->m_serialized.empty()) {
-		// Deserialize the object.
-		std::istringstream iss(m_serialized);
+		// Decompress and deserialize the object.
+		std::string serialized;
+		for (const SerializedChunkPtr &chunk : m_serialized)
+			decompress_serialized_chunk(*chunk, serialized);
+		std::istringstream iss(std::move(serialized));
 		{
 			Slic3r::UndoRedo::InputArchive archive(stack, iss);
 			typedef typename std::remove_const<T>::type Type;
@@ -738,6 +929,7 @@ template<typename T> std::shared_ptr<const T>& 	ImmutableObjectHistory<T>::share
 			archive(*mesh.get());
 			m_shared_object = std::move(mesh);
 		}
+		m_serialized.clear();
 	}
 	return m_shared_object;
 }
@@ -790,8 +982,19 @@ template<typename T> std::shared_ptr<const T> StackImpl::load_immutable_object(c
 		return std::shared_ptr<const T>();
 	auto *object_history = static_cast<ImmutableObjectHistory<T>*>(it_object_history->second.get());
 	assert(object_history->has_snapshot(m_active_snapshot_time));
+	if (object_history->serialization_running())
+		// The object is being serialized, while restore_optional() may modify it.
+		m_serialization_tasks.wait();
+	// The object is going to be shared with the scene, its serialization is of no use.
+	object_history->discard_serialization();
+	bool deserialize = object_history->is_serialized();
+	std::shared_ptr<const T> &object = object_history->shared_ptr(*this);
+	if (deserialize)
+		// Map the deserialized object back to the ObjectID of its history, so that it will not be stored again with the next snapshot.
+		m_shared_ptr_to_object_id[(const void*)object.get()] = id;
+	// Restore the optional data released from memory or not serialized, for example the shared vertices of a triangle mesh.
 	object_history->restore_optional();
-	return object_history->shared_ptr(*this);
+	return object;
 }
 
 template<typename T> void StackImpl::load_mutable_object(const Slic3r::ObjectID id, T &target)
@@ -949,11 +1152,45 @@ void StackImpl::collect_garbage()
 		} else
 			++ it;
 	}
+	m_serialized_chunks.collect_garbage();
+}
+
+bool StackImpl::start_serialization()
+{
+	bool started = false;
+	for (auto &kvp : m_objects)
+		if (kvp.second->start_serialization(m_serialization_tasks))
+			started = true;
+	return started;
+}
+
+bool StackImpl::serialization_running() const
+{
+	for (const auto &kvp : m_objects)
+		if (kvp.second->serialization_running())
+			return true;
+	return false;
+}
+
+// Replace the immutable objects serialized in the background with their serialized data. Return the amount of memory released.
+size_t StackImpl::finish_serialization()
+{
+	size_t mem_released = 0;
+	for (auto &kvp : m_objects) {
+		const void *ptr = kvp.second->immutable_object_ptr();
+		mem_released += kvp.second->finish_serialization(m_serialized_chunks);
+		if (ptr != nullptr && kvp.second->immutable_object_ptr() == nullptr)
+			// The object was released. Release it from the ptr to ObjectID map, as its address may be reused by another object.
+			m_shared_ptr_to_object_id.erase(ptr);
+	}
+	return mem_released;
 }
 
 void StackImpl::release_least_recently_used()
 {
 	assert(this->valid());
+	// Collect the immutable objects serialized in the background since the last call.
+	this->finish_serialization();
 	size_t current_memsize = this->memsize();
 #ifdef SLIC3R_UNDOREDO_DEBUG
 	bool released = false;
@@ -977,6 +1214,21 @@ void StackImpl::release_least_recently_used()
 		else
 			current_memsize = 0;
 	}
+	if (current_memsize > m_memory_limit) {
+		// Rather compress the triangle meshes than release the snapshots.
+		if (this->serialization_running()) {
+			// The serialization started by the last call did not finish yet. Wait for it, so that the memory limit is respected.
+			m_serialization_tasks.wait();
+			size_t mem_released = this->finish_serialization();
+			current_memsize = (current_memsize > mem_released) ? current_memsize - mem_released : 0;
+		}
+		if (current_memsize > m_memory_limit && this->start_serialization()) {
+			// Serialize and compress the meshes in the background not to block the UI thread. The snapshots will be released
+			// by the next call if the memory limit is still exceeded.
+			assert(this->valid());
+			return;
+		}
+	}
 	while (current_memsize > m_memory_limit && m_snapshots.size() >= 3) {
 		// From which side to remove a snapshot?
 		assert(m_snapshots.front().timestamp < m_active_snapshot_time);
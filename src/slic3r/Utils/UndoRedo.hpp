@@ -99,6 +99,8 @@ public:
 	size_t memsize() const;
 
 	// Release least recently used snapshots up to the memory limit set above.
+	// The triangle meshes referenced by the Undo / Redo stack only are compressed in the background first,
+	// the snapshots are released only if the compressed meshes still do not fit.
 	void release_least_recently_used();
 
 	// Store the current application state onto the Undo / Redo stack, remove all snapshots after m_active_snapshot_time.
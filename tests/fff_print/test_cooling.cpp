@@ -0,0 +1,247 @@
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+
+#include "libslic3r/GCode.hpp"
+#include "libslic3r/GCode/CoolingBuffer.hpp"
+
+using namespace Slic3r;
+
+// Three extruders with different cooling settings, the last one not cooled.
+static std::unique_ptr<CoolingBuffer> make_cooling_buffer(GCode &gcodegen)
+{
+	DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+	config.set_deserialize({
+		{ "travel_speed", 				"130" },
+		{ "use_relative_e_distances", 	"0" },
+		{ "cooling", 					"1,1,0" },
+		{ "slowdown_below_layer_time", 	"5,20,10" },
+		{ "min_print_speed", 			"10,0,15" },
+		{ "min_fan_speed", 				"35,20,50" },
+		{ "fan_always_on", 				"1,0,1" },
+		{ "disable_fan_first_layers", 	"1,3,0" },
+		{ "max_fan_speed", 				"100,80,90" },
+		{ "fan_below_layer_time", 		"60,30,100" },
+		{ "bridge_fan_speed", 			"100,100,40" }
+	});
+	PrintConfig print_config;
+	print_config.apply(config, true);
+	gcodegen.apply_print_config(print_config);
+	gcodegen.writer().set_extruders({ 0, 1, 2 });
+	return std::make_unique<CoolingBuffer>(gcodegen);
+}
+
+// Pseudo random G-code of a layer exercising the lines recognized by CoolingBuffer.
+// The random numbers are drawn in sequenced statements to produce the same G-code with any compiler.
+static std::string random_layer_gcode(std::mt19937 &rng, size_t layer_id)
+{
+	auto r = [&rng](unsigned int n) { return int(rng() % n); };
+	auto f = [&rng](double a, double b) { return a + (b - a) * double(rng() % 100000) / 100000.; };
+	char buf[256];
+	std::string gcode;
+	int    num_lines = 1 + r(layer_id % 7 == 0 ? 400 : 40);
+	double scale     = f(0.01, 3.);
+	for (int i = 0; i < num_lines; ++ i) {
+		buf[0] = 0;
+		switch (r(16)) {
+		case 0: case 1: case 2: {
+			bool bridge = r(6) == 0;
+			if (bridge)
+				gcode += ";_BRIDGE_FAN_START\n";
+			if (r(5) == 0) {
+				sprintf(buf, "G1 F%d%s\n", 60 * r(100) + 60, bridge ? "" : ";_EXTRUDE_SET_SPEED");
+			} else {
+				double feedrate = f(100, 6000);
+				bool   external = r(3) == 0;
+				sprintf(buf, "G1 F%.3f%s%s\n", feedrate, bridge ? "" : ";_EXTRUDE_SET_SPEED", external ? ";_EXTERNAL_PERIMETER" : "");
+			}
+			gcode += buf;
+			for (int num_extrusions = 1 + r(20); num_extrusions > 0; -- num_extrusions) {
+				double x = f(0, 200 * scale);
+				double y = f(0, 200 * scale);
+				double e = f(0, 2);
+				bool   comment = r(4) == 0;
+				sprintf(buf, "G1 X%.3f Y%.3f E%.5f%s\n", x, y, e, comment ? " ; perimeter" : "");
+				gcode += buf;
+			}
+			strcpy(buf, bridge ? ";_BRIDGE_FAN_END\n" : ";_EXTRUDE_END\n");
+			break;
+		}
+		case 3:  { double x = f(0, 200); double y = f(0, 200); sprintf(buf, "G1 X%.3f Y%.3f F%d\n", x, y, 60 * r(200)); break; }
+		case 4:  { double e = f(0, 2); sprintf(buf, "G1 E-%.5f F%d ; retract\n", e, 60 * r(60)); break; }
+		case 5:  strcpy(buf, "G92 E0\n"); break;
+		case 6:  sprintf(buf, "T%d\n", r(3)); break;
+		// Dwell given either by S (seconds) or by P (milliseconds).
+		case 7:  { bool seconds = r(2) == 1; sprintf(buf, seconds ? "G4 S%d\n" : "G4 P%d\n", r(5)); break; }
+		case 8:  { int feedrate = 60 * r(100) + 1; double x = f(0, 200); double y = f(0, 200); sprintf(buf, "G1 F%d;_WIPE\nG1 X%.3f Y%.3f E-.1 ; wipe and retract\n", feedrate, x, y); break; }
+		case 9:  { double z = f(0, 10); sprintf(buf, "G1 Z%.3f F%d\n", z, 60 * r(100)); break; }
+		case 10: strcpy(buf, "M204 S1000\n;TYPE:Perimeter\n"); break;
+		case 11: { double x = f(0, 200); double y = f(0, 200); sprintf(buf, "G0 X%.2f\tY%.2f F%d\n", x, y, 60 * r(100) + 60); break; }
+		case 12: { int f1 = 60 * r(100) + 60; int f2 = 60 * r(100) + 60; sprintf(buf, "G1 F%d\nG1 F%d\n", f1, f2); break; }
+		// Feed rate on a line with a comment.
+		case 13: { double x = f(0, 200); double y = f(0, 200); sprintf(buf, "G1 X%.3f Y%.3f F%d ; travel\n", x, y, 60 * r(200) + 60); break; }
+		case 14: strcpy(buf, "\n"); break;
+		default: { double x = f(0, 200); double e = f(0, 1); sprintf(buf, "G1 X%.3f E%.4f\n", x, e); break; }
+		}
+		gcode += buf;
+	}
+	// The G-code of a layer may not end with a new line.
+	if (r(3) == 0)
+		gcode.pop_back();
+	return gcode;
+}
+
+// The expected G-code was produced by CoolingBuffer before its G-code parser was rewritten to parse each line once.
+SCENARIO("CoolingBuffer output is stable", "[CoolingBuffer]") {
+	GCode gcodegen;
+	std::unique_ptr<CoolingBuffer> buffer = make_cooling_buffer(gcodegen);
+	WHEN("A short layer with the feed rates set on lines with comments") {
+		std::string gcode =
+			"G1 Z0.4 F7800\n"
+			"G1 X10 Y10 F7800 ; travel\n"
+			"G1 F1800 ; set speed\n"
+			"G1 F1800;_EXTRUDE_SET_SPEED;_EXTERNAL_PERIMETER\n"
+			"G1 X20 Y10 E0.5 ; perimeter\n"
+			"G1 X20 Y20 E0.5\n"
+			";_EXTRUDE_END\n"
+			"G1 F3000;_EXTRUDE_SET_SPEED\n"
+			"G1 X10 Y20 E1.0 ; infill\n"
+			"G1 X10 Y10 E0.5\n"
+			";_EXTRUDE_END\n"
+			"G1 E-0.8 F2100 ; retract\n";
+		THEN("The extrusions are slowed down, the redundant feed rates are removed") {
+			REQUIRE(buffer->process_layer(gcode, 2) ==
+				"M106 S255\n"
+				"G1 Z0.4 F7800\n"
+				"G1 X10 Y10 ; travel\n"
+				"G1 F1800 ; set speed\n"
+				"G1 F600\n"
+				"G1 X20 Y10 E0.5 ; perimeter\n"
+				"G1 X20 Y20 E0.5\n"
+				"G1\n"
+				"G1 X10 Y20 E1.0 ; infill\n"
+				"G1 X10 Y10 E0.5\n"
+				"G1 E-0.8 F2100 ; retract\n");
+		}
+	}
+	WHEN("Dwells given by S or P only") {
+		std::string gcode =
+			"G1 F2400;_EXTRUDE_SET_SPEED\n"
+			"G1 X30 Y0 E1.2\n"
+			";_EXTRUDE_END\n"
+			"G4 S2\n"
+			"G1 F2400;_EXTRUDE_SET_SPEED\n"
+			"G1 X30 Y30 E1.2\n"
+			";_EXTRUDE_END\n"
+			"G4 P1500\n"
+			"G4 S0\n";
+		THEN("The dwells are kept and counted into the layer time") {
+			REQUIRE(buffer->process_layer(gcode, 3) ==
+				"M106 S252.45\n"
+				"G1 F1198\n"
+				"G1 X30 Y0 E1.2\n"
+				"G4 S2\n"
+				"G1\n"
+				"G1 X30 Y30 E1.2\n"
+				"G4 P1500\n"
+				"G4 S0\n");
+		}
+	}
+	WHEN("Tool changes and a bridge") {
+		std::string gcode =
+			"G1 F3600;_EXTRUDE_SET_SPEED\n"
+			"G1 X15 Y5 E0.4\n"
+			";_EXTRUDE_END\n"
+			"T1\n"
+			"G1 X5 Y5 F9000\n"
+			";_BRIDGE_FAN_START\n"
+			"G1 F1200\n"
+			"G1 X25 Y5 E0.9 ; bridge\n"
+			";_BRIDGE_FAN_END\n"
+			"G1 F3600;_EXTRUDE_SET_SPEED\n"
+			"G1 X25 Y25 E0.9\n"
+			";_EXTRUDE_END\n"
+			"T2\n"
+			"G1 F3600;_EXTRUDE_SET_SPEED\n"
+			"G1 X5 Y25 E0.9\n"
+			";_EXTRUDE_END\n"
+			"T7\n";
+		THEN("The fan is set per extruder and for the bridge, the third extruder is not cooled") {
+			REQUIRE(buffer->process_layer(gcode, 4) ==
+				"M106 S204\n"
+				"G1 F600\n"
+				"G1 X15 Y5 E0.4\n"
+				"M106 S175.95\n"
+				"T1\n"
+				"G1 X5 Y5 F9000\n"
+				"M106 S255\n"
+				"G1 F1200\n"
+				"G1 X25 Y5 E0.9 ; bridge\n"
+				"M106 S175.95\n"
+				"G1 F64\n"
+				"G1 X25 Y25 E0.9\n"
+				"M106 S127.5\n"
+				"T2\n"
+				"G1 F3600\n"
+				"G1 X5 Y25 E0.9\n"
+				"T7\n");
+		}
+	}
+	WHEN("The first layer not ending with a new line") {
+		std::string gcode =
+			"G1 F1200;_EXTRUDE_SET_SPEED\n"
+			"G1 X50 Y0 E2.5\n"
+			"G1 X50 Y50 E2.5\n"
+			";_EXTRUDE_END";
+		THEN("The fan stays disabled") {
+			REQUIRE(buffer->process_layer(gcode, 0) ==
+				"G1 F1199\n"
+				"G1 X50 Y0 E2.5\n"
+				"G1 X50 Y50 E2.5\n");
+		}
+	}
+	WHEN("A wipe after the extrusion") {
+		std::string gcode =
+			"G92 E0\n"
+			"G1 F2000;_EXTRUDE_SET_SPEED\n"
+			"G1 X40 Y10 E1.5\n"
+			";_EXTRUDE_END\n"
+			"G1 F8000;_WIPE\n"
+			"G1 X35 Y10 E-.1 ; wipe and retract\n"
+			"G1 E-0.7 F2100 ; retract\n"
+			"G1 Z1.4 F7800\n";
+		THEN("The wipe feed rate is not adjusted") {
+			REQUIRE(buffer->process_layer(gcode, 6) ==
+				"M106 S255\n"
+				"G92 E0\n"
+				"G1 F600\n"
+				"G1 X40 Y10 E1.5\n"
+				"G1 F8000\n"
+				"G1 X35 Y10 E-.1 ; wipe and retract\n"
+				"G1 E-0.7 F2100 ; retract\n"
+				"G1 Z1.4 F7800\n");
+		}
+	}
+	WHEN("Layers of pseudo random G-code are processed") {
+		std::mt19937 rng(5489u);
+		size_t   length = 0;
+		// FNV-1a hash of the processed G-code.
+		uint64_t hash   = 14695981039346656037ull;
+		for (size_t layer_id = 0; layer_id < 500; ++ layer_id) {
+			std::string gcode = buffer->process_layer(random_layer_gcode(rng, layer_id), layer_id);
+			length += gcode.size();
+			for (unsigned char c : gcode) {
+				hash ^= c;
+				hash *= 1099511628211ull;
+			}
+		}
+		THEN("The G-code is the same as produced by the original parser") {
+			REQUIRE(length == 1957324);
+			REQUIRE(hash == 0xe8af6c88c12cf52eull);
+		}
+	}
+}
@@ -2,10 +2,24 @@
 
 #include <memory>
 
+#include <boost/filesystem.hpp>
+#include <boost/nowide/cstdio.hpp>
+
 #include "libslic3r/GCode.hpp"
+#include "libslic3r/GCode/GCodeProcessor.hpp"
+
+#include "test_data.hpp"
 
 using namespace Slic3r;
 
+static bool same_move(const GCodeProcessor::MoveVertex &lhs, const GCodeProcessor::MoveVertex &rhs)
+{
+	return lhs.type == rhs.type && lhs.extrusion_role == rhs.extrusion_role && lhs.extruder_id == rhs.extruder_id &&
+		lhs.cp_color_id == rhs.cp_color_id && lhs.position == rhs.position && lhs.delta_extruder == rhs.delta_extruder &&
+		lhs.feedrate == rhs.feedrate && lhs.width == rhs.width && lhs.height == rhs.height &&
+		lhs.mm3_per_mm == rhs.mm3_per_mm && lhs.fan_speed == rhs.fan_speed && lhs.time == rhs.time;
+}
+
 SCENARIO("Origin manipulation", "[GCode]") {
 	Slic3r::GCode gcodegen;
 	WHEN("set_origin to (10,0)") {
@@ -20,3 +34,93 @@ SCENARIO("Origin manipulation", "[GCode]") {
     	}
     }
 }
+
+SCENARIO("GCodeProcessor::MoveVertices stores the moves without loss", "[GCode]") {
+	GIVEN("Moves with attributes changing every few moves") {
+		std::vector<GCodeProcessor::MoveVertex> moves(1000);
+		for (size_t i = 0; i < moves.size(); ++ i) {
+			GCodeProcessor::MoveVertex &move = moves[i];
+			move.type           = (i % 3 == 0) ? EMoveType::Travel : EMoveType::Extrude;
+			move.extrusion_role = ExtrusionRole(i / 100 % erCount);
+			move.extruder_id    = (unsigned char)(i / 250);
+			move.position       = Vec3f(0.1f * float(i), 0.2f * float(i % 17), 0.2f * float(i / 50));
+			move.delta_extruder = 0.01f * float(i % 7);
+			move.feedrate       = float(40 + i / 30);
+			move.width          = 0.45f;
+			move.height         = (i < 50) ? 0.2f : 0.15f;
+			move.mm3_per_mm     = 0.05f;
+			move.fan_speed      = (i < 200) ? 0.f : 100.f;
+			move.time           = float(i);
+		}
+		GCodeProcessor::MoveVertices vertices;
+		for (const GCodeProcessor::MoveVertex &move : moves)
+			vertices.emplace_back(move);
+		THEN("Random access returns the stored moves") {
+			REQUIRE(vertices.size() == moves.size());
+			for (size_t i = 0; i < moves.size(); ++ i)
+				REQUIRE(same_move(vertices[i], moves[i]));
+		}
+		THEN("Sequential access returns the stored moves") {
+			size_t i = 0;
+			for (const GCodeProcessor::MoveVertex &move : vertices)
+				REQUIRE(same_move(move, moves[i ++]));
+			REQUIRE(i == moves.size());
+		}
+		THEN("The attributes are stored once per run of moves") {
+			REQUIRE(vertices.runs().size() < moves.size() / 10);
+			REQUIRE(vertices.memsize() < moves.size() * sizeof(GCodeProcessor::MoveVertex) / 2);
+		}
+	}
+}
+
+SCENARIO("GCodeProcessor fed while exporting matches the processing of the exported file", "[GCode]") {
+	GIVEN("A Marlin print with the machine envelope exported to a file") {
+		DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+		// The remaining times are not exported, so that the file is not modified by the post-processing.
+		config.set_deserialize({
+			{ "gcode_flavor", 		"marlin" },
+			{ "remaining_times", 	"0" },
+			{ "silent_mode", 		"1" },
+			{ "skirts", 			"1" },
+			{ "fan_always_on", 		"1" }
+		});
+		Print print;
+		Model model;
+		Test::init_print({ Test::TestMesh::cube_20x20x20, Test::TestMesh::pyramid }, print, model, config);
+		print.set_status_silent();
+		print.process();
+		std::string path = boost::filesystem::unique_path().string();
+		GCodeProcessor::Result streamed;
+		print.export_gcode(path, &streamed);
+		WHEN("The exported file is processed by GCodeProcessor::process_file()") {
+			GCodeProcessor processor;
+			processor.reset();
+			processor.apply_config(print.config());
+			processor.enable_stealth_time_estimator(true);
+			processor.process_file(path);
+			const GCodeProcessor::Result &processed = processor.get_result();
+			THEN("The moves are the same") {
+				REQUIRE(streamed.moves.size() > 1);
+				REQUIRE(streamed.moves.size() == processed.moves.size());
+				auto it = processed.moves.begin();
+				for (const GCodeProcessor::MoveVertex &move : streamed.moves) {
+					REQUIRE(same_move(move, *it));
+					++ it;
+				}
+			}
+			THEN("The estimated times are the same") {
+				for (size_t i = 0; i < streamed.time_statistics.modes.size(); ++ i) {
+					const PrintEstimatedTimeStatistics::Mode &lhs = streamed.time_statistics.modes[i];
+					const PrintEstimatedTimeStatistics::Mode &rhs = processed.time_statistics.modes[i];
+					REQUIRE(lhs.time > 0.f);
+					REQUIRE(lhs.time == rhs.time);
+					REQUIRE(lhs.custom_gcode_times == rhs.custom_gcode_times);
+					REQUIRE(lhs.moves_times == rhs.moves_times);
+					REQUIRE(lhs.roles_times == rhs.roles_times);
+					REQUIRE(lhs.layers_times == rhs.layers_times);
+				}
+			}
+		}
+		boost::nowide::remove(path.c_str());
+	}
+}
@@ -0,0 +1,190 @@
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/nowide/cstdio.hpp>
+
+#include "libslic3r/GCodeReader.hpp"
+
+#ifdef TEST_PERFORMANCE
+#include <libnest2d/tools/benchmark.h>
+#endif // TEST_PERFORMANCE
+
+using namespace Slic3r;
+
+struct ParsedLine
+{
+    std::string raw;
+    float       axes[NUM_AXES];
+    uint32_t    mask;
+
+    bool operator==(const ParsedLine &rhs) const
+        { return raw == rhs.raw && mask == rhs.mask && memcmp(axes, rhs.axes, sizeof(axes)) == 0; }
+};
+
+static ParsedLine make_parsed_line(const GCodeReader &, const GCodeReader::GCodeLine &line)
+{
+    ParsedLine out;
+    out.raw  = line.raw();
+    out.mask = 0;
+    for (int i = 0; i < int(NUM_AXES); ++ i) {
+        out.axes[i] = 0.f;
+        if (line.has(Axis(i))) {
+            out.axes[i] = line.value(Axis(i));
+            out.mask |= 1 << i;
+        }
+    }
+    return out;
+}
+
+static void write_file(const std::string &path, const std::string &data)
+{
+    FILE *f = boost::nowide::fopen(path.c_str(), "wb");
+    REQUIRE(f != nullptr);
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+}
+
+static std::string random_gcode(size_t num_lines)
+{
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> dist(-300., 300.);
+    std::string gcode;
+    char buf[256];
+    for (size_t i = 0; i < num_lines; ++ i) {
+        switch (rng() % 6) {
+        case 0: sprintf(buf, "G1 X%.3f Y%.3f E%.5f\n", dist(rng), dist(rng), dist(rng)); break;
+        case 1: sprintf(buf, "G1 Z%.3f F%.3f ; move to next layer (%d)\r\n", dist(rng), dist(rng), int(i)); break;
+        case 2: sprintf(buf, ";TYPE:Perimeter\n"); break;
+        case 3: sprintf(buf, "  G0\tX%g Y%.1e\n", dist(rng), dist(rng)); break;
+        case 4: sprintf(buf, "M204 S%d\n\n", int(rng() % 2000)); break;
+        default: sprintf(buf, "G92 E0 X Y.5 Z1e A12a\n"); break;
+        }
+        gcode += buf;
+    }
+    return gcode;
+}
+
+TEST_CASE("GCodeReader parses numbers the same way as strtod", "[GCodeReader]") {
+    std::vector<std::string> numbers { "0", "-0", "+1", ".5", "5.", "-.5", "1e5", "1e-5", "1.5E+3", "0x10", "00001.0000",
+        "123456789012345678901234", "1e400", "9007199254740993", "0.1", "3.14159265358979323846", "1e22", "1e23", "-1.5e-22" };
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> dist(-1000., 1000.);
+    char buf[64];
+    for (size_t i = 0; i < 10000; ++ i) {
+        sprintf(buf, "%.*f", int(rng() % 10), dist(rng));
+        numbers.emplace_back(buf);
+    }
+    GCodeReader reader;
+    for (const std::string &number : numbers) {
+        float x = 0.f;
+        bool  has_x = false;
+        reader.parse_line("G1 X" + number + " ; comment", [&x, &has_x](GCodeReader&, const GCodeReader::GCodeLine &line) {
+            has_x = line.has_x();
+            x     = line.x();
+        });
+        REQUIRE(has_x);
+        REQUIRE(x == float(strtod(number.c_str(), nullptr)));
+    }
+}
+
+SCENARIO("GCodeReader::parse_file produces the same lines as parse_buffer", "[GCodeReader]") {
+    GIVEN("G-code with comments, empty lines and mixed line endings") {
+        // More than the size of the block, in which the file is read.
+        std::string gcode = random_gcode(500000);
+        REQUIRE(gcode.size() > 8 * 1024 * 1024);
+        std::string path = boost::filesystem::unique_path().string();
+        WHEN("The G-code ends with a new line") {
+            write_file(path, gcode);
+            THEN("The lines are parsed the same") {
+                std::vector<ParsedLine> from_buffer, from_file;
+                GCodeReader().parse_buffer(gcode, [&from_buffer](GCodeReader &reader, const GCodeReader::GCodeLine &line) { from_buffer.emplace_back(make_parsed_line(reader, line)); });
+                GCodeReader().parse_file(path, [&from_file](GCodeReader &reader, const GCodeReader::GCodeLine &line) { from_file.emplace_back(make_parsed_line(reader, line)); });
+                REQUIRE(from_file.size() == from_buffer.size());
+                REQUIRE(from_file == from_buffer);
+            }
+        }
+        WHEN("The G-code is read line by line") {
+            write_file(path, gcode);
+            THEN("The lines are parsed the same as by the serial reader") {
+                std::vector<ParsedLine> serial, from_file;
+                GCodeReader             serial_reader;
+                std::istringstream      is(gcode);
+                for (std::string line; std::getline(is, line);)
+                    serial_reader.parse_line(line, [&serial](GCodeReader &reader, const GCodeReader::GCodeLine &line) { serial.emplace_back(make_parsed_line(reader, line)); });
+                GCodeReader().parse_file(path, [&from_file](GCodeReader &reader, const GCodeReader::GCodeLine &line) { from_file.emplace_back(make_parsed_line(reader, line)); });
+                REQUIRE(from_file.size() == serial.size());
+                REQUIRE(from_file == serial);
+            }
+        }
+#if ENABLE_GCODE_VIEWER
+        WHEN("The parsing is quit from the callback") {
+            write_file(path, gcode);
+            THEN("No line is passed to the callback after the parsing was quit") {
+                for (size_t quit_line : { size_t(0), size_t(10), size_t(100000) }) {
+                    std::vector<ParsedLine> from_file;
+                    GCodeReader             reader;
+                    reader.parse_file(path, [&from_file, quit_line](GCodeReader &reader, const GCodeReader::GCodeLine &line) {
+                        from_file.emplace_back(make_parsed_line(reader, line));
+                        if (from_file.size() == quit_line + 1)
+                            reader.quit_parsing_file();
+                    });
+                    REQUIRE(from_file.size() == quit_line + 1);
+                    // The state of the reader is updated up to the last line passed to the callback.
+                    std::vector<ParsedLine> from_buffer;
+                    GCodeReader             buffer_reader;
+                    buffer_reader.parse_buffer(gcode, [&from_buffer, quit_line](GCodeReader &reader, const GCodeReader::GCodeLine &line) {
+                        if (from_buffer.size() <= quit_line)
+                            from_buffer.emplace_back(make_parsed_line(reader, line));
+                    });
+                    from_buffer.resize(quit_line + 1);
+                    REQUIRE(from_file == from_buffer);
+                }
+            }
+        }
+#endif // ENABLE_GCODE_VIEWER
+        WHEN("The last line of the G-code is not terminated") {
+            gcode += "G1 X1 Y2";
+            write_file(path, gcode);
+            THEN("The last line is parsed as well") {
+                std::vector<ParsedLine> from_file;
+                GCodeReader().parse_file(path, [&from_file](GCodeReader &reader, const GCodeReader::GCodeLine &line) { from_file.emplace_back(make_parsed_line(reader, line)); });
+                REQUIRE(! from_file.empty());
+                REQUIRE(from_file.back().raw == "G1 X1 Y2");
+            }
+        }
+        boost::nowide::remove(path.c_str());
+    }
+}
+
+#ifdef TEST_PERFORMANCE
+TEST_CASE("GCodeReader: parsing throughput", "[GCodeReader]") {
+    std::string gcode = random_gcode(5000000);
+    std::string path  = boost::filesystem::unique_path().string();
+    write_file(path, gcode);
+
+    size_t num_lines = 0;
+    Benchmark bench;
+    bench.start();
+    GCodeReader().parse_file(path, [&num_lines](GCodeReader&, const GCodeReader::GCodeLine&) { ++ num_lines; });
+    bench.stop();
+    std::cout << "GCodeReader::parse_file: " << num_lines << " lines, " <<
+        double(gcode.size()) / (1024. * 1024.) / bench.getElapsedSec() << " MB/s" << std::endl;
+
+    num_lines = 0;
+    bench.start();
+    GCodeReader().parse_buffer(gcode, [&num_lines](GCodeReader&, const GCodeReader::GCodeLine&) { ++ num_lines; });
+    bench.stop();
+    std::cout << "GCodeReader::parse_buffer: " << num_lines << " lines, " <<
+        double(gcode.size()) / (1024. * 1024.) / bench.getElapsedSec() << " MB/s" << std::endl;
+
+    boost::nowide::remove(path.c_str());
+}
+#endif // TEST_PERFORMANCE
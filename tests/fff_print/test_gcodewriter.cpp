@@ -1,9 +1,18 @@
 #include <catch2/catch.hpp>
 
+#include <cstdio>
+#include <iomanip>
+#include <limits>
 #include <memory>
+#include <random>
+#include <sstream>
 
 #include "libslic3r/GCodeWriter.hpp"
 
+#ifdef TEST_PERFORMANCE
+#include <libnest2d/tools/benchmark.h>
+#endif // TEST_PERFORMANCE
+
 using namespace Slic3r;
 
 SCENARIO("lift() is not ignored after unlift() at normal values of Z", "[GCodeWriter]") {
@@ -94,3 +103,98 @@ SCENARIO("set_speed emits values with fixed-point output.", "[GCodeWriter]") {
         }
     }
 }
+
+static std::string format_fixed_printf(double v, int digits)
+{
+    char buf[512];
+    ::snprintf(buf, sizeof(buf), "%.*f", digits, v);
+    return buf;
+}
+
+static std::string format_fixed(double v, int digits)
+{
+    std::string out;
+    GCodeFormatter::append_fixed(out, v, digits);
+    return out;
+}
+
+TEST_CASE("GCodeFormatter::append_fixed matches printf", "[GCodeWriter]") {
+    SECTION("Special values and ties") {
+        for (double v : { 0., -0., 1., -1., 0.0625, -0.0625, 0.0005, -0.0004, 2.5, 0.125, 203.200522, 99999.123, 1e20, -1e300,
+                          1e-320, std::numeric_limits<double>::infinity(), - std::numeric_limits<double>::infinity(), std::numeric_limits<double>::quiet_NaN() })
+            for (int digits = 0; digits <= 9; ++ digits)
+                REQUIRE(format_fixed(v, digits) == format_fixed_printf(v, digits));
+    }
+    SECTION("Random coordinates") {
+        std::mt19937_64 rng(0);
+        std::uniform_real_distribution<double> dist(-1000., 1000.);
+        for (size_t i = 0; i < 100000; ++ i) {
+            double v = dist(rng);
+            REQUIRE(format_fixed(v, GCodeFormatter::XYZF_EXPORT_DIGITS) == format_fixed_printf(v, GCodeFormatter::XYZF_EXPORT_DIGITS));
+            REQUIRE(format_fixed(v, GCodeFormatter::E_EXPORT_DIGITS) == format_fixed_printf(v, GCodeFormatter::E_EXPORT_DIGITS));
+            // Numbers close to the rounding ties of the exported precision.
+            double t = std::floor(v * 1000.) / 1000. + 0.0005;
+            REQUIRE(format_fixed(t, GCodeFormatter::XYZF_EXPORT_DIGITS) == format_fixed_printf(t, GCodeFormatter::XYZF_EXPORT_DIGITS));
+        }
+    }
+}
+
+SCENARIO("Moves appended to a buffer are the same as the moves returned as strings.", "[GCodeWriter]") {
+    GIVEN("Two GCodeWriter instances with a single extruder") {
+        auto make_writer = []() {
+            auto writer = std::make_unique<GCodeWriter>();
+            writer->config.gcode_comments.value = true;
+            writer->set_extruders({ 0 });
+            writer->set_extruder(0);
+            return writer;
+        };
+        std::unique_ptr<GCodeWriter> writer1 = make_writer();
+        std::unique_ptr<GCodeWriter> writer2 = make_writer();
+        WHEN("A sequence of travel and extrusion moves is generated") {
+            std::string gcode1, gcode2;
+            for (int i = 0; i < 100; ++ i) {
+                Vec2d pt(0.1 * i - 3.3333, 7.77777 - 0.05 * i);
+                gcode1 += writer1->travel_to_xy(pt, "travel");
+                writer2->travel_to_xy(gcode2, pt, "travel");
+                gcode1 += writer1->extrude_to_xy(pt + Vec2d(0.5, 0.5), 0.0123456, "extrude");
+                writer2->extrude_to_xy(gcode2, pt + Vec2d(0.5, 0.5), 0.0123456, "extrude");
+            }
+            THEN("The G-code is the same") {
+                REQUIRE(gcode1 == gcode2);
+                REQUIRE(gcode1.substr(0, gcode1.find('\n') + 1) == "G1 X-3.333 Y7.778 F7800.000 ; travel\n");
+            }
+        }
+    }
+}
+
+#ifdef TEST_PERFORMANCE
+TEST_CASE("GCodeFormatter: performance compared to iostreams", "[GCodeWriter]") {
+    std::mt19937_64 rng(0);
+    std::uniform_real_distribution<double> dist(0., 250.);
+    std::vector<Vec2d> points(1000000);
+    for (Vec2d &pt : points)
+        pt = Vec2d(dist(rng), dist(rng));
+
+    Benchmark bench;
+    bench.start();
+    std::string gcode_stream;
+    double e = 0.;
+    for (const Vec2d &pt : points) {
+        std::ostringstream ss;
+        ss << "G1 X" << std::fixed << std::setprecision(3) << pt.x() << " Y" << pt.y() << " E" << std::setprecision(5) << (e += 0.01) << "\n";
+        gcode_stream += ss.str();
+    }
+    bench.stop();
+    std::cout << "ostringstream: " << bench.getElapsedSec() << " s" << std::endl;
+
+    bench.start();
+    std::string gcode;
+    e = 0.;
+    for (const Vec2d &pt : points)
+        GCodeFormatter(gcode).emit("G1").emit_xy(pt).emit_axis(" E", e += 0.01, GCodeFormatter::E_EXPORT_DIGITS).end_line();
+    bench.stop();
+    std::cout << "GCodeFormatter: " << bench.getElapsedSec() << " s" << std::endl;
+
+    REQUIRE(gcode == gcode_stream);
+}
+#endif // TEST_PERFORMANCE
@@ -6,7 +6,14 @@
 #include "test_data.hpp"
 
 #include <algorithm>
+#include <sstream>
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/regex.hpp>
+#include <tbb/task_arena.h>
+
+#ifdef TEST_PERFORMANCE
+#include <libnest2d/tools/benchmark.h>
+#endif // TEST_PERFORMANCE
 
 using namespace Slic3r;
 using namespace Slic3r::Test;
@@ -268,3 +275,90 @@ SCENARIO( "PrintGCode basic functionality", "[PrintGCode]") {
         }
     }
 }
+
+// G-code without the line with the time of the export.
+static std::string gcode_without_timestamp(const std::string &gcode)
+{
+    std::string out;
+    std::istringstream stream(gcode);
+    for (std::string line; std::getline(stream, line);)
+        if (! boost::starts_with(line, "; generated by "))
+            out += line + "\n";
+    return out;
+}
+
+// Export the G-code with multiple threads and with a single thread, with which the pipeline processes the layers one by one.
+static std::pair<std::string, std::string> gcode_parallel_and_serial(bool complete_objects)
+{
+    Slic3r::Print print;
+    Slic3r::Model model;
+    Slic3r::Test::init_print({ TestMesh::cube_20x20x20, TestMesh::overhang, TestMesh::pyramid }, print, model, {
+        { "complete_objects",           complete_objects },
+        { "gcode_comments",             true },
+        { "layer_height",               0.3 },
+        { "support_material",           true },
+        { "cooling",                    true },
+        { "fan_always_on",              true },
+        { "slowdown_below_layer_time",  20 },
+        { "layer_gcode",                ";Layer:[layer_num] ([layer_z] mm)" }
+        });
+    std::string gcode_parallel = gcode_without_timestamp(Slic3r::Test::gcode(print));
+    std::string gcode_serial;
+    tbb::task_arena arena(1);
+    arena.execute([&print, &gcode_serial]() { gcode_serial = gcode_without_timestamp(Slic3r::Test::gcode(print)); });
+    return { gcode_parallel, gcode_serial };
+}
+
+SCENARIO("PrintGCode: the layers processed in parallel produce the same G-code", "[PrintGCode]") {
+    GIVEN("Three objects with support material and cooling") {
+        WHEN("The objects are printed layer by layer") {
+            std::pair<std::string, std::string> gcode = gcode_parallel_and_serial(false);
+            THEN("The G-code exported with multiple threads is the same as with a single thread") {
+                REQUIRE(! gcode.first.empty());
+                REQUIRE(gcode.first == gcode.second);
+            }
+        }
+        WHEN("The objects are printed one by one") {
+            std::pair<std::string, std::string> gcode = gcode_parallel_and_serial(true);
+            THEN("The G-code exported with multiple threads is the same as with a single thread") {
+                REQUIRE(! gcode.first.empty());
+                REQUIRE(gcode.first == gcode.second);
+            }
+        }
+    }
+}
+
+#ifdef TEST_PERFORMANCE
+TEST_CASE("PrintGCode: multi-material export of many objects", "[PrintGCode]") {
+    // 4 extruders changing at each layer, the wipe tower purging into the infill and the perimeters of 16 objects.
+    DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+    config.set_num_extruders(4);
+    config.set_deserialize({
+        { "layer_height",               0.2 },
+        { "first_layer_height",         0.2 },
+        { "perimeter_extruder",         1 },
+        { "infill_extruder",            2 },
+        { "solid_infill_extruder",      3 },
+        { "wipe_tower",                 true },
+        { "wipe_into_infill",           true },
+        { "wipe_into_objects",          true },
+        { "support_material",           true },
+        { "support_material_extruder",  4 },
+        { "support_material_interface_extruder", 4 }
+    });
+    std::vector<TriangleMesh> meshes;
+    for (size_t i = 0; i < 16; ++ i)
+        meshes.emplace_back(Slic3r::Test::mesh(TestMesh::overhang));
+    Slic3r::Print print;
+    Slic3r::Model model;
+    Slic3r::Test::init_print(std::move(meshes), print, model, config);
+    print.process();
+
+    Benchmark bench;
+    bench.start();
+    std::string gcode = Slic3r::Test::gcode(print);
+    bench.stop();
+    REQUIRE(! gcode.empty());
+    std::cout << "Multi-material G-code export of 16 objects: " << bench.getElapsedSec() << " s" << std::endl;
+}
+#endif // TEST_PERFORMANCE
@@ -9,6 +9,11 @@
 #include <algorithm>
 #include <future>
 #include <chrono>
+#include <thread>
+
+#include <tbb/task_arena.h>
+
+#include <libnest2d/tools/benchmark.h>
 
 //#include "test_options.hpp"
 #include "test_data.hpp"
@@ -228,6 +233,58 @@ SCENARIO( "TriangleMesh: slice behavior.") {
     }
 }
 
+// Slice the mesh using an arena limited to the given number of threads.
+static std::vector<Polygons> slice_with_threads(const TriangleMesh &mesh, const std::vector<float> &z, int num_threads)
+{
+    std::vector<Polygons> layers;
+    tbb::task_arena arena(num_threads);
+    arena.execute([&mesh, &z, &layers]() {
+        TriangleMeshSlicer slicer(&mesh);
+        slicer.slice(z, SlicingMode::Regular, &layers, [](){});
+    });
+    return layers;
+}
+
+static std::vector<float> slicing_planes(const TriangleMesh &mesh, float layer_height)
+{
+    BoundingBoxf3 bb = mesh.bounding_box();
+    std::vector<float> z;
+    for (double zz = bb.min.z() + 0.5 * layer_height; zz < bb.max.z(); zz += layer_height)
+        z.emplace_back(float(zz));
+    return z;
+}
+
+TEST_CASE("TriangleMeshSlicer: slices do not depend on the number of threads", "[TriangleMeshSlicer]") {
+    TriangleMesh mesh = Test::mesh(Test::TestMesh::sphere_50mm);
+    mesh.require_shared_vertices();
+    std::vector<float> z = slicing_planes(mesh, 0.2f);
+    std::vector<Polygons> serial   = slice_with_threads(mesh, z, 1);
+    std::vector<Polygons> parallel = slice_with_threads(mesh, z, tbb::task_arena::automatic);
+    REQUIRE(serial.size() == z.size());
+    REQUIRE(serial == parallel);
+}
+
+TEST_CASE("TriangleMeshSlicer: slicing in bands produces the same slices", "[TriangleMeshSlicer]") {
+    TriangleMesh mesh = Test::mesh(Test::TestMesh::ipadstand);
+    mesh.require_shared_vertices();
+    std::vector<float> z = slicing_planes(mesh, 0.2f);
+    TriangleMeshSlicer slicer(&mesh);
+    std::vector<Polygons> layers;
+    slicer.slice(z, SlicingMode::Regular, &layers, [](){});
+    for (size_t layers_per_band : { size_t(1), size_t(7), z.size() }) {
+        std::vector<Polygons> banded(z.size());
+        size_t                next_layer = 0;
+        slicer.slice_bands(z, SlicingMode::Regular, layers_per_band, [&banded, &next_layer](size_t first_layer, std::vector<Polygons> &&band) {
+            // Bands are delivered in the order of increasing Z.
+            REQUIRE(first_layer == next_layer);
+            next_layer = first_layer + band.size();
+            std::move(band.begin(), band.end(), banded.begin() + first_layer);
+        }, [](){});
+        REQUIRE(next_layer == z.size());
+        REQUIRE(banded == layers);
+    }
+}
+
 SCENARIO( "make_xxx functions produce meshes.") {
     GIVEN("make_cube() function") {
         WHEN("make_cube() is called with arguments 20,20,20") {
@@ -432,3 +489,26 @@ TEST_CASE("Profile test for issue #4486 - files take forever to slice") {
 
 }
 #endif //BUILD_PROFILE
+
+#ifdef TEST_PERFORMANCE
+TEST_CASE("TriangleMeshSlicer: scaling of slicing with the number of threads", "[TriangleMeshSlicer]") {
+    // Roughly a million triangles.
+    TriangleMesh mesh = make_sphere(50., 2. * PI / 1000.);
+    mesh.require_shared_vertices();
+    std::vector<float> z = slicing_planes(mesh, 0.05f);
+
+    std::vector<Polygons> reference;
+    for (int num_threads = 1; num_threads <= int(std::thread::hardware_concurrency()); num_threads *= 2) {
+        Benchmark bench;
+        bench.start();
+        std::vector<Polygons> layers = slice_with_threads(mesh, z, num_threads);
+        bench.stop();
+        std::cout << "Slicing " << mesh.facets_count() << " facets into " << z.size() << " layers with " <<
+            num_threads << " threads: " << bench.getElapsedSec() << " s" << std::endl;
+        if (reference.empty())
+            reference = std::move(layers);
+        else
+            REQUIRE(layers == reference);
+    }
+}
+#endif // TEST_PERFORMANCE
@@ -2,6 +2,8 @@
 
 #include "libslic3r/Utils.hpp"
 
+#include <random>
+
 namespace {
 
 TEST_CASE("sort_remove_duplicates", "[utils]") {
@@ -38,4 +40,27 @@ TEST_CASE("string_printf", "[utils]") {
     }
 }
 
+TEST_CASE("string_to_double_decimal_point", "[utils]") {
+    SECTION("Numbers are parsed the same way as with strtod in the C locale") {
+        std::vector<std::string> numbers { "0", "-0", "+1", ".5", "5.", "-.5", "1e5", "1e-5", "1.5E+3", "00001.0000", "  12.5",
+            "123456789012345678901234", "1e400", "9007199254740993", "0.1", "3.14159265358979323846", "1e22", "1e23", "-1.5e-22",
+            "0.30000000000000004", "2.2250738585072014e-308", "1.7976931348623157e308", "12.5mm", "1.5 2.5" };
+        std::mt19937 rng(0);
+        std::uniform_real_distribution<double> dist(-1000., 1000.);
+        char buf[64];
+        for (size_t i = 0; i < 10000; ++ i) {
+            sprintf(buf, (i & 1) ? "%.*f" : "%.*g", int(rng() % 17), dist(rng));
+            numbers.emplace_back(buf);
+        }
+        for (const std::string &number : numbers) {
+            char *end_expected = nullptr;
+            char *end          = nullptr;
+            double expected = strtod(number.c_str(), &end_expected);
+            double value    = Slic3r::string_to_double_decimal_point(number.c_str(), &end);
+            REQUIRE(value == expected);
+            REQUIRE(end == end_expected);
+        }
+    }
+}
+
 }
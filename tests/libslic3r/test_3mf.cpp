@@ -6,6 +6,10 @@
 
 #include <boost/filesystem/operations.hpp>
 
+#ifdef TEST_PERFORMANCE
+#include <libnest2d/tools/benchmark.h>
+#endif // TEST_PERFORMANCE
+
 using namespace Slic3r;
 
 SCENARIO("Reading 3mf file", "[3mf]") {
@@ -85,3 +89,101 @@ SCENARIO("Export+Import geometry to/from 3mf file cycle", "[3mf]") {
         }
     }
 }
+
+SCENARIO("Export+Import of a model file written in several chunks", "[3mf]") {
+    GIVEN("an object of two volumes with more triangles than fit a single chunk") {
+        Model src_model;
+        ModelObject* src_object = src_model.add_object();
+        TriangleMesh sphere = make_sphere(10., 2. * PI / 720.);
+        sphere.repair();
+        src_object->add_volume(std::move(sphere));
+        TriangleMesh cube = make_cube(10., 20., 30.);
+        cube.repair();
+        src_object->add_volume(std::move(cube))->set_offset(Vec3d(30., 0., 0.));
+        // Custom supports of the triangles in the chunks after the first one.
+        src_object->volumes[0]->m_supported_facets.set_triangle_from_string(40000, "4");
+        src_object->volumes[0]->m_supported_facets.set_triangle_from_string(200000, "8");
+        src_object->add_instance();
+        src_object->add_instance()->set_offset(Vec3d(50., 50., 0.));
+        REQUIRE(src_object->volumes[0]->mesh().its.indices.size() > 200000);
+
+        WHEN("model is saved+loaded to/from 3mf file") {
+            std::string test_file = std::string(TEST_DATA_DIR) + "/test_3mf/chunks.3mf";
+            REQUIRE(store_3mf(test_file.c_str(), &src_model, nullptr, false));
+
+            Model dst_model;
+            DynamicPrintConfig dst_config;
+            bool loaded = load_3mf(test_file.c_str(), &dst_config, &dst_model, false);
+            boost::filesystem::remove(test_file);
+
+            THEN("the volumes, their triangles and custom supports match") {
+                REQUIRE(loaded);
+                REQUIRE(dst_model.objects.size() == 1);
+                const ModelObject* dst_object = dst_model.objects.front();
+                REQUIRE(dst_object->instances.size() == 2);
+                REQUIRE(dst_object->volumes.size() == 2);
+                for (size_t i = 0; i < 2; ++ i) {
+                    const ModelVolume *src_volume = src_object->volumes[i];
+                    const ModelVolume *dst_volume = dst_object->volumes[i];
+                    const indexed_triangle_set &src_its = src_volume->mesh().its;
+                    const indexed_triangle_set &dst_its = dst_volume->mesh().its;
+                    REQUIRE(dst_its.indices.size() == src_its.indices.size());
+                    bool res = true;
+                    for (size_t j = 0; j < src_its.indices.size(); ++ j)
+                        for (int k = 0; k < 3; ++ k)
+                            res &= (dst_volume->get_matrix() * dst_its.vertices[dst_its.indices[j](k)].cast<double>()).isApprox(
+                                    src_volume->get_matrix() * src_its.vertices[src_its.indices[j](k)].cast<double>(), 1e-5);
+                    REQUIRE(res);
+                    REQUIRE(dst_volume->m_supported_facets.get_data() == src_volume->m_supported_facets.get_data());
+                }
+            }
+        }
+    }
+}
+
+#ifdef TEST_PERFORMANCE
+TEST_CASE("3MF: export throughput", "[3mf]") {
+    Model model;
+    ModelObject* object = model.add_object();
+    TriangleMesh sphere = make_sphere(10., 2. * PI / 4000.);
+    sphere.repair();
+    object->add_volume(std::move(sphere));
+    object->add_instance();
+
+    std::string test_file = std::string(TEST_DATA_DIR) + "/test_3mf/throughput.3mf";
+    Benchmark bench;
+    bench.start();
+    bool stored = store_3mf(test_file.c_str(), &model, nullptr, false);
+    bench.stop();
+    REQUIRE(stored);
+    std::cout << "store_3mf: " << object->volumes.front()->mesh().its.indices.size() << " triangles in " <<
+        bench.getElapsedSec() << " s, " << boost::filesystem::file_size(test_file) / (1024 * 1024) << " MB" << std::endl;
+    boost::filesystem::remove(test_file);
+}
+
+TEST_CASE("3MF: import throughput", "[3mf]") {
+    Model model;
+    for (size_t i = 0; i < 4; ++ i) {
+        ModelObject* object = model.add_object();
+        TriangleMesh sphere = make_sphere(10., 2. * PI / 2000.);
+        sphere.repair();
+        object->add_volume(std::move(sphere));
+        object->add_instance();
+    }
+
+    std::string test_file = std::string(TEST_DATA_DIR) + "/test_3mf/throughput.3mf";
+    REQUIRE(store_3mf(test_file.c_str(), &model, nullptr, false));
+
+    Model dst_model;
+    DynamicPrintConfig dst_config;
+    Benchmark bench;
+    bench.start();
+    bool loaded = load_3mf(test_file.c_str(), &dst_config, &dst_model, false);
+    bench.stop();
+    REQUIRE(loaded);
+    REQUIRE(dst_model.objects.size() == model.objects.size());
+    std::cout << "load_3mf: " << dst_model.objects.size() << " objects of " <<
+        dst_model.objects.front()->volumes.front()->mesh().its.indices.size() << " triangles in " << bench.getElapsedSec() << " s" << std::endl;
+    boost::filesystem::remove(test_file);
+}
+#endif // TEST_PERFORMANCE
@@ -1,8 +1,18 @@
 #include <catch2/catch.hpp>
 #include <test_utils.hpp>
 
+#include <cstring>
+#include <random>
+
+#include <tbb/task_arena.h>
+
 #include <libslic3r/TriangleMesh.hpp>
 #include <libslic3r/AABBTreeIndirect.hpp>
+#include <libslic3r/AABBTreeWide.hpp>
+
+#ifdef TEST_PERFORMANCE
+#include <libnest2d/tools/benchmark.h>
+#endif // TEST_PERFORMANCE
 
 using namespace Slic3r;
 
@@ -59,3 +69,271 @@ TEST_CASE("Building a tree over a box, ray caster and closest query", "[AABBIndi
     REQUIRE(closest_point.y() == Approx(0.5));
     REQUIRE(closest_point.z() == Approx(1.));
 }
+
+// Rays shot from the mesh vertices. If coherent, each vertex shoots a ring of parallel rays
+// the way the SLA support tree probes the space around a support head, otherwise the rays
+// go in random directions the way the ambient occlusion is sampled.
+static void vertex_rays(const TriangleMesh &mesh, bool coherent, std::vector<Vec3d> &origins, std::vector<Vec3d> &dirs)
+{
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> dist(-1., 1.);
+    for (const Vec3f &v : mesh.its.vertices) {
+        Vec3d d = Vec3d(dist(rng), dist(rng), dist(rng)).normalized();
+        Vec3d a = d.cross(Vec3d(0., 0., 1.)).normalized();
+        Vec3d b = d.cross(a);
+        for (size_t i = 0; i < 8; ++ i) {
+            if (coherent) {
+                double phi = double(i) * PI / 4.;
+                origins.emplace_back(v.cast<double>() + 0.5 * (cos(phi) * a + sin(phi) * b));
+            } else {
+                // Some of the rays are axis aligned to exercise the infinite inverse directions.
+                if (i > 1)
+                    d = Vec3d(dist(rng), dist(rng), dist(rng)).normalized();
+                else
+                    d = i == 0 ? Vec3d(0., 0., -1.) : Vec3d(1., 0., 0.);
+                origins.emplace_back(v.cast<double>() + 1e-4 * d);
+            }
+            dirs.emplace_back(d);
+        }
+    }
+}
+
+TEST_CASE("Ray packets find the same hits as single rays", "[AABBIndirect]")
+{
+    TriangleMesh mesh = load_model("extruder_idler.obj");
+    auto tree = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(mesh.its.vertices, mesh.its.indices);
+
+    for (bool coherent : { false, true }) {
+        std::vector<Vec3d> origins, dirs;
+        vertex_rays(mesh, coherent, origins, dirs);
+        // Not a multiple of the packet size.
+        origins.pop_back();
+        dirs.pop_back();
+
+        std::vector<igl::Hit> hits;
+        size_t num_hits = AABBTreeIndirect::intersect_rays_first_hit(mesh.its.vertices, mesh.its.indices, tree, origins, dirs, hits);
+        REQUIRE(hits.size() == origins.size());
+
+        size_t num_hits_single = 0;
+        for (size_t i = 0; i < origins.size(); ++ i) {
+            igl::Hit hit;
+            bool intersected = AABBTreeIndirect::intersect_ray_first_hit(mesh.its.vertices, mesh.its.indices, tree, origins[i], dirs[i], hit);
+            REQUIRE(intersected == (hits[i].id >= 0));
+            if (intersected) {
+                ++ num_hits_single;
+                REQUIRE(hits[i].id == hit.id);
+                REQUIRE(hits[i].t == hit.t);
+            } else
+                REQUIRE(std::isinf(hits[i].t));
+        }
+        REQUIRE(num_hits > 0);
+        REQUIRE(num_hits == num_hits_single);
+    }
+}
+
+TEST_CASE("Wide tree answers the queries the same as the binary tree", "[AABBIndirect]")
+{
+    TriangleMesh mesh = load_model("extruder_idler.obj");
+    auto tree  = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(mesh.its.vertices, mesh.its.indices);
+    auto tree4 = AABBTreeIndirect::build_wide_aabb_tree_over_indexed_triangle_set<4>(mesh.its.vertices, mesh.its.indices);
+    auto tree8 = AABBTreeIndirect::build_wide_aabb_tree_over_indexed_triangle_set<8>(mesh.its.vertices, mesh.its.indices);
+    REQUIRE(tree4.entities().size() == mesh.its.indices.size());
+    REQUIRE(tree8.entities().size() == mesh.its.indices.size());
+
+    // Random rays only, the binary tree misses some hits of axis aligned rays starting at a bounding box.
+    std::vector<Vec3d> origins, dirs;
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> dist(-1., 1.);
+    for (const Vec3f &v : mesh.its.vertices) {
+        dirs.emplace_back(Vec3d(dist(rng), dist(rng), dist(rng)).normalized());
+        origins.emplace_back(v.cast<double>() + 1e-4 * dirs.back());
+    }
+
+    auto check_tree = [&mesh, &tree, &origins, &dirs](const auto &wide_tree) {
+        for (size_t i = 0; i < origins.size(); ++ i) {
+            igl::Hit hit, wide_hit;
+            bool intersected      = AABBTreeIndirect::intersect_ray_first_hit(mesh.its.vertices, mesh.its.indices, tree, origins[i], dirs[i], hit);
+            bool wide_intersected = AABBTreeIndirect::intersect_ray_first_hit(mesh.its.vertices, mesh.its.indices, wide_tree, origins[i], dirs[i], wide_hit);
+            REQUIRE(intersected == wide_intersected);
+            if (intersected)
+                REQUIRE(hit.t == wide_hit.t);
+
+            std::vector<igl::Hit> hits, wide_hits;
+            AABBTreeIndirect::intersect_ray_all_hits(mesh.its.vertices, mesh.its.indices, tree, origins[i], dirs[i], hits);
+            AABBTreeIndirect::intersect_ray_all_hits(mesh.its.vertices, mesh.its.indices, wide_tree, origins[i], dirs[i], wide_hits);
+            REQUIRE(hits.size() == wide_hits.size());
+
+            // Query points around the mesh.
+            Vec3d  pt = origins[i] + 3. * dirs[i];
+            size_t hit_idx, wide_hit_idx;
+            Vec3d  closest_point, wide_closest_point;
+            double squared_distance      = AABBTreeIndirect::squared_distance_to_indexed_triangle_set(
+                mesh.its.vertices, mesh.its.indices, tree, pt, hit_idx, closest_point);
+            double wide_squared_distance = AABBTreeIndirect::squared_distance_to_indexed_triangle_set(
+                mesh.its.vertices, mesh.its.indices, wide_tree, pt, wide_hit_idx, wide_closest_point);
+            // Multiple triangles sharing the closest point may be found, their distances differ by rounding.
+            REQUIRE(wide_squared_distance == Approx(squared_distance));
+
+            for (double radius : { 0.1, 1., 4. }) {
+                double max_distance = radius;
+                REQUIRE(AABBTreeIndirect::is_any_triangle_in_radius(mesh.its.vertices, mesh.its.indices, tree, pt, max_distance) ==
+                        AABBTreeIndirect::is_any_triangle_in_radius(mesh.its.vertices, mesh.its.indices, wide_tree, pt, max_distance));
+            }
+        }
+    };
+    check_tree(tree4);
+    check_tree(tree8);
+}
+
+// Height field over a grid of n x n squares, each split into two triangles.
+static indexed_triangle_set grid_mesh(size_t n)
+{
+    indexed_triangle_set its;
+    for (size_t y = 0; y <= n; ++ y)
+        for (size_t x = 0; x <= n; ++ x)
+            its.vertices.emplace_back(float(x), float(y), 5.f * std::sin(0.1f * float(x)) * std::cos(0.13f * float(y)));
+    for (size_t y = 0; y < n; ++ y)
+        for (size_t x = 0; x < n; ++ x) {
+            int a = int(y * (n + 1) + x);
+            its.indices.emplace_back(a, a + 1, a + int(n) + 2);
+            its.indices.emplace_back(a, a + int(n) + 2, a + int(n) + 1);
+        }
+    return its;
+}
+
+TEST_CASE("Trees built in parallel do not depend on the number of threads", "[AABBIndirect]")
+{
+    // Large enough to build the top level subtrees in parallel.
+    indexed_triangle_set its = grid_mesh(300);
+
+    AABBTreeIndirect::Tree3f     tree, tree_single;
+    AABBTreeIndirect::WideTree4f tree4, tree4_single;
+    tree  = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(its.vertices, its.indices);
+    tree4 = AABBTreeIndirect::build_wide_aabb_tree_over_indexed_triangle_set<4>(its.vertices, its.indices);
+    tbb::task_arena arena(1);
+    arena.execute([&its, &tree_single, &tree4_single]() {
+        tree_single  = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(its.vertices, its.indices);
+        tree4_single = AABBTreeIndirect::build_wide_aabb_tree_over_indexed_triangle_set<4>(its.vertices, its.indices);
+    });
+
+    REQUIRE(tree.nodes().size() == tree_single.nodes().size());
+    for (size_t i = 0; i < tree.nodes().size(); ++ i) {
+        const auto &node = tree.node(i);
+        const auto &node_single = tree_single.node(i);
+        REQUIRE(node.idx == node_single.idx);
+        if (node.is_valid()) {
+            REQUIRE(node.bbox.min() == node_single.bbox.min());
+            REQUIRE(node.bbox.max() == node_single.bbox.max());
+        }
+    }
+
+    REQUIRE(tree4.entities() == tree4_single.entities());
+    REQUIRE(tree4.nodes().size() == tree4_single.nodes().size());
+    REQUIRE(memcmp(tree4.nodes().data(), tree4_single.nodes().data(), tree4.nodes().size() * sizeof(AABBTreeIndirect::WideTree4f::Node)) == 0);
+
+    // Each triangle is referenced by the wide tree exactly once.
+    std::vector<size_t> entities = tree4.entities();
+    std::sort(entities.begin(), entities.end());
+    REQUIRE(entities.size() == its.indices.size());
+    REQUIRE(std::adjacent_find(entities.begin(), entities.end()) == entities.end());
+}
+
+#ifdef TEST_PERFORMANCE
+TEST_CASE("Ray packets: casting throughput", "[AABBIndirect]")
+{
+    for (const char *model : { "frog_legs.obj", "extruder_idler.obj", "A.obj" }) {
+        TriangleMesh mesh = load_model(model);
+        auto tree = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(mesh.its.vertices, mesh.its.indices);
+        for (bool coherent : { false, true }) {
+            std::vector<Vec3d> origins, dirs;
+            vertex_rays(mesh, coherent, origins, dirs);
+
+            Benchmark bench;
+            size_t num_hits = 0;
+            bench.start();
+            for (size_t i = 0; i < origins.size(); ++ i) {
+                igl::Hit hit;
+                if (AABBTreeIndirect::intersect_ray_first_hit(mesh.its.vertices, mesh.its.indices, tree, origins[i], dirs[i], hit))
+                    ++ num_hits;
+            }
+            bench.stop();
+            double single = double(origins.size()) / bench.getElapsedSec();
+
+            std::vector<igl::Hit> hits;
+            bench.start();
+            size_t num_hits_packets = AABBTreeIndirect::intersect_rays_first_hit(mesh.its.vertices, mesh.its.indices, tree, origins, dirs, hits);
+            bench.stop();
+            double packets = double(origins.size()) / bench.getElapsedSec();
+
+            REQUIRE(num_hits == num_hits_packets);
+            std::cout << model << (coherent ? ", coherent rays: " : ", random rays: ") <<
+                single << " rays/s single, " << packets << " rays/s in packets" << std::endl;
+        }
+    }
+}
+
+TEST_CASE("Wide tree: build and query throughput", "[AABBIndirect]")
+{
+    for (const char *model : { "frog_legs.obj", "extruder_idler.obj", "A.obj" }) {
+        TriangleMesh mesh = load_model(model);
+        std::vector<Vec3d> origins, dirs;
+        vertex_rays(mesh, false, origins, dirs);
+
+        auto benchmark = [&mesh, &origins, &dirs, model](const char *name, auto build) {
+            Benchmark bench;
+            bench.start();
+            auto tree = build();
+            bench.stop();
+            double build_time = bench.getElapsedSec();
+
+            size_t num_hits = 0;
+            bench.start();
+            for (size_t i = 0; i < origins.size(); ++ i) {
+                igl::Hit hit;
+                if (AABBTreeIndirect::intersect_ray_first_hit(mesh.its.vertices, mesh.its.indices, tree, origins[i], dirs[i], hit))
+                    ++ num_hits;
+            }
+            bench.stop();
+            double rays = double(origins.size()) / bench.getElapsedSec();
+
+            bench.start();
+            for (size_t i = 0; i < origins.size(); ++ i) {
+                size_t hit_idx;
+                Vec3d  closest_point;
+                AABBTreeIndirect::squared_distance_to_indexed_triangle_set(mesh.its.vertices, mesh.its.indices, tree,
+                    Vec3d(origins[i] + 3. * dirs[i]), hit_idx, closest_point);
+            }
+            bench.stop();
+            double queries = double(origins.size()) / bench.getElapsedSec();
+
+            std::cout << model << ", " << name << ": build " << build_time << " s, " << rays << " rays/s, " <<
+                queries << " distance queries/s" << std::endl;
+        };
+        benchmark("binary tree", [&mesh]() { return AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(mesh.its.vertices, mesh.its.indices); });
+        benchmark("wide tree 4", [&mesh]() { return AABBTreeIndirect::build_wide_aabb_tree_over_indexed_triangle_set<4>(mesh.its.vertices, mesh.its.indices); });
+        benchmark("wide tree 8", [&mesh]() { return AABBTreeIndirect::build_wide_aabb_tree_over_indexed_triangle_set<8>(mesh.its.vertices, mesh.its.indices); });
+    }
+}
+
+TEST_CASE("Trees: build time", "[AABBIndirect]")
+{
+    for (size_t n : { 224, 707, 2236 }) {
+        indexed_triangle_set its = grid_mesh(n);
+        auto benchmark = [&its](const char *name, auto build) {
+            Benchmark bench;
+            tbb::task_arena arena(1);
+            bench.start();
+            arena.execute(build);
+            bench.stop();
+            double single = bench.getElapsedSec();
+            bench.start();
+            build();
+            bench.stop();
+            std::cout << its.indices.size() << " triangles, " << name << ": " << single << " s single threaded, " <<
+                bench.getElapsedSec() << " s parallel" << std::endl;
+        };
+        benchmark("binary tree", [&its]() { AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(its.vertices, its.indices); });
+        benchmark("wide tree 4", [&its]() { AABBTreeIndirect::build_wide_aabb_tree_over_indexed_triangle_set<4>(its.vertices, its.indices); });
+    }
+}
+#endif // TEST_PERFORMANCE
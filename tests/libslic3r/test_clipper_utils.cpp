@@ -2,12 +2,17 @@
 
 #include <numeric>
 #include <iostream>
+#include <random>
 #include <boost/filesystem.hpp>
 
 #include "libslic3r/ClipperUtils.hpp"
 #include "libslic3r/ExPolygon.hpp"
 #include "libslic3r/SVG.hpp"
 
+#ifdef TEST_PERFORMANCE
+#include <libnest2d/tools/benchmark.h>
+#endif // TEST_PERFORMANCE
+
 using namespace Slic3r;
 
 SCENARIO("Various Clipper operations - xs/t/11_clipper.t", "[ClipperUtils]") {
@@ -299,3 +304,156 @@ TEST_CASE("Traversing Clipper PolyTree", "[ClipperUtils]") {
         REQUIRE(count_polys(output) == reference.size());
     }
 }
+
+// Perimeter like input: many slightly noisy circles of varying radii.
+static Polygons random_circles(size_t num_circles, size_t num_points, std::mt19937 &rng)
+{
+    std::uniform_real_distribution<double> center(0., scale_(100.));
+    std::uniform_real_distribution<double> radius(scale_(1.), scale_(20.));
+    std::uniform_real_distribution<double> noise(0.97, 1.03);
+    Polygons out;
+    out.reserve(num_circles);
+    for (size_t i = 0; i < num_circles; ++ i) {
+        Vec2d  c = Vec2d(center(rng), center(rng));
+        double r = radius(rng);
+        Polygon poly;
+        poly.points.reserve(num_points);
+        for (size_t j = 0; j < num_points; ++ j) {
+            double angle = 2. * PI * double(j) / double(num_points);
+            double rr    = r * noise(rng);
+            poly.points.emplace_back(coord_t(c.x() + rr * cos(angle)), coord_t(c.y() + rr * sin(angle)));
+        }
+        out.emplace_back(std::move(poly));
+    }
+    return out;
+}
+
+// Reference implementation going through ClipperLib::Paths.
+static Polygons clipper_through_paths(ClipperLib::ClipType clip_type, const Polygons &subject, const Polygons &clip)
+{
+    ClipperLib::Clipper clipper;
+    clipper.AddPaths(Slic3rMultiPoints_to_ClipperPaths(subject), ClipperLib::ptSubject, true);
+    clipper.AddPaths(Slic3rMultiPoints_to_ClipperPaths(clip), ClipperLib::ptClip, true);
+    ClipperLib::Paths output;
+    clipper.Execute(clip_type, output, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+    return ClipperPaths_to_Slic3rPolygons(output);
+}
+
+SCENARIO("Clipper fed with Slic3r points directly", "[ClipperUtils]") {
+    std::mt19937 rng(0);
+    GIVEN("Overlapping perimeter like polygons") {
+        Polygons subject = random_circles(50, 64, rng);
+        Polygons clip    = random_circles(50, 64, rng);
+        THEN("union_ produces the same polygons as going through ClipperLib::Paths") {
+            REQUIRE(union_(subject) == clipper_through_paths(ClipperLib::ctUnion, subject, Polygons()));
+        }
+        THEN("diff produces the same polygons as going through ClipperLib::Paths") {
+            REQUIRE(diff(subject, clip) == clipper_through_paths(ClipperLib::ctDifference, subject, clip));
+        }
+        THEN("intersection produces the same polygons as going through ClipperLib::Paths") {
+            REQUIRE(intersection(subject, clip) == clipper_through_paths(ClipperLib::ctIntersection, subject, clip));
+        }
+        THEN("ExPolygons are fed with their holes") {
+            ExPolygons expolys = union_ex(subject);
+            ClipperLib::PolyTree tree = union_pt(expolys);
+            ClipperLib::Clipper clipper;
+            clipper.AddPaths(Slic3rMultiPoints_to_ClipperPaths(expolys), ClipperLib::ptSubject, true);
+            ClipperLib::PolyTree tree_reference;
+            clipper.Execute(ClipperLib::ctUnion, tree_reference, ClipperLib::pftEvenOdd, ClipperLib::pftEvenOdd);
+            REQUIRE(PolyTreeToExPolygons(tree) == PolyTreeToExPolygons(tree_reference));
+        }
+    }
+    GIVEN("Degenerate paths") {
+        Polygons subject { Polygon(), Polygon { { 0, 0 }, { 10, 0 } }, Polygon { { 0, 0 }, { 100, 0 }, { 100, 100 }, { 100, 100 }, { 0, 0 } } };
+        THEN("they are filtered out the same way as going through ClipperLib::Paths") {
+            REQUIRE(union_(subject) == clipper_through_paths(ClipperLib::ctUnion, subject, Polygons()));
+        }
+    }
+}
+
+SCENARIO("Clipper engines reused for many operations", "[ClipperUtils]") {
+    std::mt19937 rng(0);
+    GIVEN("Many small islands followed by large ones") {
+        std::vector<Polygons> inputs;
+        for (size_t i = 0; i < 200; ++ i)
+            inputs.emplace_back(random_circles(i % 50 == 0 ? 200 : 3, 32, rng));
+        THEN("A reused Clipper and ClipperOffset produce the same output as fresh ones") {
+            ClipperLib::Clipper       clipper;
+            ClipperLib::ClipperOffset co;
+            for (const Polygons &input : inputs) {
+                ClipperLib::Paths paths = Slic3rMultiPoints_to_ClipperPaths(input);
+                ClipperLib::Paths out_reused, out_fresh;
+                clipper.Clear();
+                clipper.AddPaths(paths, ClipperLib::ptSubject, true);
+                clipper.Execute(ClipperLib::ctUnion, out_reused, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+                {
+                    ClipperLib::Clipper fresh;
+                    fresh.AddPaths(paths, ClipperLib::ptSubject, true);
+                    fresh.Execute(ClipperLib::ctUnion, out_fresh, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+                }
+                REQUIRE(out_reused == out_fresh);
+                co.Clear();
+                co.AddPaths(out_reused, ClipperLib::jtMiter, ClipperLib::etClosedPolygon);
+                co.Execute(out_reused, - scale_(0.2));
+                {
+                    ClipperLib::ClipperOffset fresh;
+                    fresh.AddPaths(out_fresh, ClipperLib::jtMiter, ClipperLib::etClosedPolygon);
+                    fresh.Execute(out_fresh, - scale_(0.2));
+                }
+                REQUIRE(out_reused == out_fresh);
+            }
+        }
+        THEN("ClipperUtils results do not depend on the previous operations of the cached engines") {
+            auto process = [](const Polygons &input) {
+                // diff() with the safety offset nests an offset inside of a Clipper operation.
+                return diff(offset(input, scale_(0.5), ClipperLib::jtRound, scale_(0.01)), offset2(input, - scale_(0.2), scale_(0.1)), true);
+            };
+            std::vector<Polygons> forward, backward(inputs.size());
+            for (const Polygons &input : inputs)
+                forward.emplace_back(process(input));
+            for (size_t i = inputs.size(); i > 0; -- i)
+                backward[i - 1] = process(inputs[i - 1]);
+            REQUIRE(forward == backward);
+        }
+    }
+}
+
+#ifdef TEST_PERFORMANCE
+TEST_CASE("ClipperUtils on many small islands", "[ClipperUtils]") {
+    std::mt19937 rng(0);
+    std::vector<Polygons> islands;
+    for (size_t i = 0; i < 20000; ++ i)
+        islands.emplace_back(random_circles(1, 64, rng));
+
+    // Perimeter generator like sequence of operations on each island.
+    Benchmark bench;
+    bench.start();
+    size_t num_polygons = 0;
+    for (const Polygons &island : islands) {
+        Polygons perimeter = offset(island, - scale_(0.2));
+        Polygons inner     = offset2(perimeter, - scale_(0.45), scale_(0.05));
+        num_polygons += diff(perimeter, inner).size() + union_ex(inner).size();
+    }
+    bench.stop();
+    std::cout << "ClipperUtils on " << islands.size() << " islands: " << bench.getElapsedSec() << " s, " << num_polygons << " polygons" << std::endl;
+}
+
+TEST_CASE("Clipper with Slic3r points vs. ClipperLib::Paths", "[ClipperUtils]") {
+    std::mt19937 rng(0);
+    Polygons subject = random_circles(2000, 128, rng);
+    Polygons clip    = random_circles(2000, 128, rng);
+
+    Benchmark bench;
+    bench.start();
+    Polygons result_paths = clipper_through_paths(ClipperLib::ctDifference, subject, clip);
+    bench.stop();
+    std::cout << "diff through ClipperLib::Paths: " << bench.getElapsedSec() << " s" << std::endl;
+
+    bench.start();
+    Polygons result_direct = diff(subject, clip);
+    bench.stop();
+    std::cout << "diff with Slic3r points fed directly: " << bench.getElapsedSec() << " s" << std::endl;
+
+    REQUIRE(result_direct == result_paths);
+}
+#endif // TEST_PERFORMANCE
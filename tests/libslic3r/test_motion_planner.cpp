@@ -0,0 +1,104 @@
+#include <catch2/catch.hpp>
+
+#include <random>
+
+#include <libslic3r/MotionPlanner.hpp>
+
+#ifdef TEST_PERFORMANCE
+#include <libnest2d/tools/benchmark.h>
+#endif // TEST_PERFORMANCE
+
+using namespace Slic3r;
+
+// Square of 100mm with a hole of 20mm in its center.
+static ExPolygon square_with_hole(const Point &offset = Point(0, 0))
+{
+    ExPolygon expoly;
+    expoly.contour = Polygon::new_scale({ { 100, 100 }, { 200, 100 }, { 200, 200 }, { 100, 200 } });
+    expoly.holes.emplace_back(Polygon::new_scale({ { 140, 140 }, { 140, 160 }, { 160, 160 }, { 160, 140 } }));
+    expoly.translate(offset.x(), offset.y());
+    return expoly;
+}
+
+SCENARIO("MotionPlanner: travel around the obstacles", "[MotionPlanner]") {
+    GIVEN("A square with a hole") {
+        ExPolygon     expoly = square_with_hole();
+        MotionPlanner mp({ expoly });
+        WHEN("travelling across the hole") {
+            Point    from = Point::new_scale(120, 120);
+            Point    to   = Point::new_scale(180, 180);
+            Polyline path = mp.shortest_path(from, to);
+            THEN("the path is longer than a straight line") {
+                REQUIRE(path.is_valid());
+                REQUIRE(path.length() > (to - from).cast<double>().norm());
+            }
+            THEN("the path starts and ends at the end points") {
+                REQUIRE(path.first_point() == from);
+                REQUIRE(path.last_point() == to);
+            }
+            THEN("the path does not cross the island boundary") {
+                REQUIRE(expoly.contains(path));
+            }
+        }
+        WHEN("travelling around the square") {
+            Point    from = Point::new_scale(80, 100);
+            Point    to   = Point::new_scale(220, 200);
+            Polyline path = mp.shortest_path(from, to);
+            THEN("the path does not enter the square") {
+                REQUIRE(path.is_valid());
+                REQUIRE(path.first_point() == from);
+                REQUIRE(path.last_point() == to);
+                REQUIRE(intersection_pl(path, to_polygons(expoly)).empty());
+            }
+        }
+    }
+    GIVEN("Two squares") {
+        MotionPlanner mp({ square_with_hole(), square_with_hole(Point::new_scale(300, 0)) });
+        WHEN("travelling from one square to the other") {
+            Polyline path = mp.shortest_path(Point::new_scale(120, 120), Point::new_scale(420, 120));
+            THEN("a path is returned") {
+                REQUIRE(path.is_valid());
+            }
+        }
+    }
+}
+
+#ifdef TEST_PERFORMANCE
+TEST_CASE("MotionPlanner: travel planning on a plate of 50 objects", "[MotionPlanner]")
+{
+    // 10x5 objects of 20mm squares with holes, printed over 200 layers of the same shape.
+    ExPolygons islands;
+    for (int row = 0; row < 5; ++ row)
+        for (int col = 0; col < 10; ++ col) {
+            ExPolygon expoly = square_with_hole(Point::new_scale(25 * col - 100, 25 * row - 100));
+            expoly.scale(0.2);
+            islands.emplace_back(std::move(expoly));
+        }
+    BoundingBox bbox = get_extents(islands);
+
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<coord_t> dist_x(bbox.min.x(), bbox.max.x());
+    std::uniform_int_distribution<coord_t> dist_y(bbox.min.y(), bbox.max.y());
+    std::vector<std::pair<Point, Point>> travels;
+    for (size_t i = 0; i < 500; ++ i)
+        travels.emplace_back(Point(dist_x(rng), dist_y(rng)), Point(dist_x(rng), dist_y(rng)));
+
+    // Either a new motion planner for each layer, or a single motion planner reused by the layers of the same shape.
+    for (bool reuse : { false, true }) {
+        Benchmark bench;
+        bench.start();
+        double length = 0.;
+        std::unique_ptr<MotionPlanner> mp;
+        for (size_t layer = 0; layer < 200; ++ layer) {
+            if (! mp || ! reuse)
+                mp = Slic3r::make_unique<MotionPlanner>(islands);
+            for (size_t i = layer % 10; i < travels.size(); i += 10)
+                length += mp->shortest_path(travels[i].first, travels[i].second).length();
+        }
+        bench.stop();
+        REQUIRE(length > 0.);
+        std::cout << "Travel planning over 200 layers of 50 objects, " << (reuse ? "reusing the motion planner: " : "motion planner per layer: ") <<
+            bench.getElapsedSec() << " s" << std::endl;
+    }
+}
+#endif // TEST_PERFORMANCE
@@ -62,6 +62,40 @@ SCENARIO("Placeholder parser scripting", "[PlaceholderParser]") {
     // The PlaceholderParser has no way to know which extrusion type the caller has in mind, therefore it throws.
     SECTION("first_layer_speed") { REQUIRE_THROWS(parser.process("{first_layer_speed}")); }
 
+    // Test the compiled templates, which shall produce the same output as the macro processor.
+    parser.set("extruder_temperatures", new ConfigOptionInts({ 357, 359, 363, 378 }));
+    auto compiled = [&parser](const std::string &templ, unsigned int extruder_id = 0, const DynamicConfig *config_override = nullptr) {
+        PlaceholderParser::Template compiled_templ = PlaceholderParser::compile(templ);
+        return parser.process(compiled_templ, extruder_id, config_override);
+    };
+    SECTION("compiled: text only") { REQUIRE(PlaceholderParser::compile("G28 ; home\nG1 Z5").compiled()); }
+    SECTION("compiled: leading whitespaces are skipped") { REQUIRE(compiled(" \n G1 X[bar]") == parser.process(" \n G1 X[bar]")); }
+    SECTION("compiled: legacy variable per extruder") { REQUIRE(compiled("M104 S[extruder_temperatures]", 2) == "M104 S363"); }
+    SECTION("compiled: legacy vector indexing") { REQUIRE(compiled("M104 S[extruder_temperatures_3]") == "M104 S378"); }
+    SECTION("compiled: array reference") { REQUIRE(compiled("{extruder_temperatures[1]} { extruder_temperatures [ bar ] }") == "359 363"); }
+    SECTION("compiled: nested legacy syntax is left to the macro processor") {
+        REQUIRE(! PlaceholderParser::compile("[extruder_temperatures_[foo]]").compiled());
+        REQUIRE(compiled("[extruder_temperatures_[foo]]") == "357");
+    }
+    SECTION("compiled: math is left to the macro processor") { REQUIRE(compiled("{2*bar*(3-12)}") == "-36"); }
+    SECTION("compiled: coFloatOrPercent is left to the macro processor") { REQUIRE(std::stod(compiled("{first_layer_extrusion_width}")) == Approx(0.9)); }
+    SECTION("compiled: errors are reported by the macro processor") { REQUIRE_THROWS(compiled("{first_layer_speed}")); }
+    SECTION("compiled: config override") {
+        DynamicConfig config_override;
+        config_override.set_key_value("bar", new ConfigOptionInt(3));
+        REQUIRE(compiled("{extruder_temperatures[bar]} [bar]", 0, &config_override) == "378 3");
+    }
+    SECTION("compiled: rebound after the config changes") {
+        PlaceholderParser::Template templ = PlaceholderParser::compile("{bar} {extruder_temperatures[bar]}");
+        REQUIRE(parser.process(templ) == "2 363");
+        parser.set("bar", 1);
+        REQUIRE(parser.process(templ) == "1 359");
+        PlaceholderParser parser2 = parser;
+        parser2.set("bar", 0);
+        REQUIRE(parser2.process(templ) == "0 357");
+        REQUIRE(parser.process(templ) == "1 359");
+    }
+
     // Test the boolean expression parser.
     auto boolean_expression = [&parser](const std::string& templ) { return parser.evaluate_boolean_expression(templ, parser.config()); };
 
@@ -2,11 +2,17 @@
 #include <catch2/catch.hpp>
 
 #include <numeric>
+#include <random>
+#include <cmath>
 
 #include "libslic3r/PNGRead.hpp"
 #include "libslic3r/SLA/AGGRaster.hpp"
 #include "libslic3r/BoundingBox.hpp"
 
+#ifdef TEST_PERFORMANCE
+#include <libnest2d/tools/benchmark.h>
+#endif // TEST_PERFORMANCE
+
 using namespace Slic3r;
 
 static sla::RasterGrayscaleAA create_raster(const sla::RasterBase::Resolution &res)
@@ -53,3 +59,74 @@ TEST_CASE("PNG read", "[PNG]") {
         REQUIRE(sum == rstsum);
     }
 }
+
+// A mask resembling a sliced layer: black background with a few anti-aliased
+// discs and an irregular row of pixels in the middle.
+static std::vector<uint8_t> mask_image(size_t w, size_t h)
+{
+    std::vector<uint8_t> img(w * h, 0);
+    std::mt19937 rng(unsigned(w * h));
+    for (int i = 0; i < 10; ++ i) {
+        double cx = double(rng() % w), cy = double(rng() % h), r = 5. + double(rng() % (w / 4 + 1));
+        for (size_t y = 0; y < h; ++ y)
+            for (size_t x = 0; x < w; ++ x) {
+                double d = std::hypot(double(x) - cx, double(y) - cy) - r;
+                uint8_t &px = img[y * w + x];
+                if (d < -.5) px = 255;
+                else if (d < .5) px = std::max(px, uint8_t(255. * (.5 - d)));
+            }
+    }
+    for (size_t x = 0; x < w; ++ x)
+        img[(h / 2) * w + x] = uint8_t(rng());
+    return img;
+}
+
+TEST_CASE("Greyscale PNG encoder output should decode to the original", "[PNG]") {
+    for (auto res : { sla::RasterBase::Resolution{1, 1}, {7, 3}, {640, 360}, {1440, 2560} }) {
+        std::vector<uint8_t> img = mask_image(res.width_px, res.height_px);
+        for (int level : { 0, 1, 4, 9 })
+            for (size_t block_size : { size_t(0), size_t(1000), size_t(1024 * 1024) }) {
+                sla::GrayscalePNGRasterEncoder encoder;
+                encoder.level      = level;
+                encoder.block_size = block_size;
+                auto enc_rst = encoder(img.data(), res.width_px, res.height_px, 1);
+                REQUIRE(Slic3r::png::is_png({enc_rst.data(), enc_rst.size()}));
+
+                png::ImageGreyscale decoded;
+                REQUIRE(png::decode_png({enc_rst.data(), enc_rst.size()}, decoded));
+                REQUIRE(decoded.cols == res.width_px);
+                REQUIRE(decoded.rows == res.height_px);
+                REQUIRE(decoded.buf == img);
+            }
+    }
+}
+
+#ifdef TEST_PERFORMANCE
+TEST_CASE("Greyscale PNG encoder throughput", "[PNG]") {
+    const size_t w = 2560, h = 1620, num_layers = 20;
+    std::vector<uint8_t> img = mask_image(w, h);
+
+    auto measure = [&](const char *name, sla::RasterEncoder encoder) {
+        size_t  size = 0;
+        Benchmark bench;
+        bench.start();
+        for (size_t i = 0; i < num_layers; ++ i)
+            size += encoder(img.data(), w, h, 1).size();
+        bench.stop();
+        std::cout << name << ": " <<
+            double(w * h * num_layers) / (1024. * 1024.) / bench.getElapsedSec() << " MPixel/s, " <<
+            size / num_layers << " bytes per layer" << std::endl;
+    };
+
+    measure("PNGRasterEncoder", sla::PNGRasterEncoder{});
+    for (int level : { 1, 4, 6 }) {
+        sla::GrayscalePNGRasterEncoder encoder;
+        encoder.level = level;
+        std::string name = "GrayscalePNGRasterEncoder level " + std::to_string(level);
+        measure(name.c_str(), encoder);
+        encoder.block_size = 0;
+        name += " single block";
+        measure(name.c_str(), encoder);
+    }
+}
+#endif // TEST_PERFORMANCE
@@ -2,9 +2,16 @@
 #include <unordered_map>
 #include <random>
 
+#include <tbb/task_arena.h>
+
 #include "sla_test_utils.hpp"
 
 #include <libslic3r/SLA/SupportTreeMesher.hpp>
+#include <libslic3r/SLAPrint.hpp>
+#include <libslic3r/SLA/RasterRLE.hpp>
+#include <libslic3r/Format/SL1.hpp>
+
+#include <boost/filesystem/operations.hpp>
 
 namespace {
 
@@ -84,6 +91,44 @@ TEST_CASE("Support point generator should be deterministic if seeded",
     }
 }
 
+TEST_CASE("Support points should not depend on the number of threads",
+          "[SLASupportGeneration], [SLAPointGen]") {
+    // Several copies of the model next to each other produce layers with many
+    // islands, some of them close enough to interact.
+    TriangleMesh part = load_model("A_upsidedown.obj");
+    TriangleMesh mesh;
+    BoundingBoxf3 partbb = part.bounding_box();
+    for (int i = 0; i < 6; ++ i) {
+        TriangleMesh copy = part;
+        copy.translate(float(i * (partbb.size().x() + (i % 2 ? 0.5 : 10.))), 0.f, 0.f);
+        mesh.merge(copy);
+    }
+
+    sla::IndexedMesh emesh{mesh};
+    sla::SupportPointGenerator::Config autogencfg;
+
+    TriangleMeshSlicer slicer{&mesh};
+    auto bb = mesh.bounding_box();
+    auto slicegrid = grid(float(bb.min.z()), float(bb.max.z()), 0.05f);
+    std::vector<ExPolygons> slices;
+    slicer.slice(slicegrid, SlicingMode::Regular, CLOSING_RADIUS, &slices, []{});
+
+    auto generate = [&](int num_threads) {
+        sla::SupportPointGenerator point_gen{emesh, autogencfg, [] {}, [](int) {}};
+        point_gen.seed(0);
+        tbb::task_arena arena(num_threads);
+        arena.execute([&] { point_gen.execute(slices, slicegrid); });
+        return point_gen.output();
+    };
+
+    std::vector<sla::SupportPoint> serial = generate(1);
+    std::vector<sla::SupportPoint> parallel = generate(tbb::task_arena::automatic);
+    REQUIRE(! serial.empty());
+    REQUIRE(serial.size() == parallel.size());
+    for (size_t i = 0; i < serial.size(); ++ i)
+        REQUIRE(serial[i] == parallel[i]);
+}
+
 TEST_CASE("Flat pad geometry is valid", "[SLASupportGeneration]") {
     sla::PadConfig padcfg;
     
@@ -221,6 +266,139 @@ TEST_CASE("RasterizedPolygonAreaShouldMatch", "[SLARasterOutput]") {
     REQUIRE(raster_pxsum(raster0) == 0);
 }
 
+TEST_CASE("RLE raster should be pixel exact with the AGG raster", "[SLARasterOutput]") {
+    double disp_w = 120., disp_h = 68.;
+    sla::RasterBase::Resolution res{640, 360};
+    sla::RasterBase::PixelDim pixdim{disp_w / res.width_px, disp_h / res.height_px};
+    auto bb = BoundingBox({0, 0}, {scaled(disp_w), scaled(disp_h)});
+
+    // Random star shaped polygons with holes, overlapping each other and
+    // crossing the borders of the display.
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> pos(-10., 130.), radius(.2, 25.), jitter(.5, 1.);
+    ExPolygons polys;
+    for (int i = 0; i < 30; ++ i) {
+        Vec2d c(pos(rng), pos(rng) * disp_h / disp_w);
+        double r = radius(rng);
+        size_t n = 3 + rng() % 60;
+        ExPolygon poly;
+        Polygon hole;
+        for (size_t j = 0; j < n; ++ j) {
+            double a = 2. * PI * double(j) / double(n);
+            Vec2d  d(std::cos(a), std::sin(a));
+            poly.contour.points.emplace_back(scaled(Vec2d(c + r * jitter(rng) * d)));
+            hole.points.emplace_back(scaled(Vec2d(c + .3 * r * d)));
+        }
+        if (i % 2) {
+            hole.reverse();
+            poly.holes.emplace_back(hole);
+        }
+        polys.emplace_back(poly);
+    }
+
+    for (auto orientation : { sla::RasterBase::roLandscape, sla::RasterBase::roPortrait })
+        for (bool mirror_x : { false, true })
+            for (double gamma : { 0., 1., 2.2 }) {
+                sla::RasterBase::Trafo trafo{orientation, {mirror_x, false}};
+                trafo.center_x = bb.center().x();
+                trafo.center_y = bb.center().y();
+
+                auto agg_raster = sla::create_raster_grayscale_aa(res, pixdim, gamma, trafo);
+                auto rle_raster = sla::create_raster_grayscale_rle(res, pixdim, gamma, trafo);
+                for (const ExPolygon &poly : polys) {
+                    agg_raster->draw(poly);
+                    rle_raster->draw(poly);
+                }
+
+                auto agg_px = agg_raster->encode(sla::PPMRasterEncoder{});
+                auto rle_px = rle_raster->encode(sla::PPMRasterEncoder{});
+                REQUIRE(agg_px.size() == rle_px.size());
+                REQUIRE(std::memcmp(agg_px.data(), rle_px.data(), agg_px.size()) == 0);
+
+                auto &rle = dynamic_cast<const sla::RasterGrayscaleRLE&>(*rle_raster);
+                auto &agg = dynamic_cast<const sla::RasterGrayscaleAA&>(*agg_raster);
+                size_t num_runs = 0;
+                for (size_t r = 0; r < res.height_px; ++ r) {
+                    num_runs += rle.row(r).size();
+                    for (size_t c = 0; c < res.width_px; ++ c)
+                        REQUIRE(rle.read_pixel(c, r) == agg.read_pixel(c, r));
+                }
+                // Sanity check that the runs really are sparse.
+                REQUIRE(num_runs < res.pixels() / 4);
+            }
+}
+
+namespace {
+
+class TestSLAPrinter: public SLAPrinter {
+protected:
+    uqptr<sla::RasterBase> create_raster() const override
+    {
+        sla::RasterBase::Resolution res{640, 360};
+        sla::RasterBase::PixelDim   pixdim{120. / res.width_px, 68. / res.height_px};
+        return sla::create_raster_grayscale_aa(res, pixdim, 1., {});
+    }
+    sla::RasterEncoder get_encoder() const override { return sla::PNGRasterEncoder{}; }
+
+public:
+    void apply(const SLAPrinterConfig &) override {}
+    const std::vector<sla::EncodedRaster>& layers() const { return m_layers; }
+};
+
+} // namespace
+
+TEST_CASE("Streamed layers should match the stored ones", "[SLARasterOutput]") {
+    const size_t num_layers = 50;
+    auto drawfn = [](sla::RasterBase &raster, size_t idx) {
+        ExPolygon poly = square_with_hole(1. + double(idx));
+        poly.translate(scaled(60.), scaled(34.));
+        raster.draw(poly);
+    };
+    
+    TestSLAPrinter stored;
+    stored.draw_layers(num_layers, drawfn);
+    REQUIRE(stored.layers().size() == num_layers);
+    
+    TestSLAPrinter streamed;
+    std::vector<size_t> order;
+    std::vector<sla::EncodedRaster> layers;
+    streamed.set_layer_sink([&order, &layers](size_t idx, sla::EncodedRaster &&rst) {
+        order.emplace_back(idx);
+        layers.emplace_back(std::move(rst));
+    }, 4);
+    streamed.draw_layers(num_layers, drawfn);
+    
+    REQUIRE(streamed.layers().empty());
+    REQUIRE(layers.size() == num_layers);
+    for (size_t i = 0; i < num_layers; ++ i) {
+        REQUIRE(order[i] == i);
+        REQUIRE(layers[i].size() == stored.layers()[i].size());
+        REQUIRE(std::memcmp(layers[i].data(), stored.layers()[i].data(), layers[i].size()) == 0);
+    }
+}
+
+TEST_CASE("Canceled streamed export should not leave a partial archive", "[SLARasterOutput]") {
+    const size_t num_layers = 50;
+    std::string path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("sla_stream_%%%%-%%%%.sl1")).string();
+    bool opened = false;
+    
+    SL1Archive archive{SLAPrinterConfig{}};
+    archive.start_streaming_export([&path, &opened]() { opened = true; return path; });
+    auto drawfn = [num_layers](sla::RasterBase &raster, size_t idx) {
+        if (idx + 1 == num_layers)
+            throw std::runtime_error("Canceled");
+        raster.draw(square_with_hole(10.));
+    };
+    // A single thread, so that the first layers are zipped before the last one is drawn.
+    tbb::task_arena arena(1);
+    arena.execute([&archive, &drawfn]() {
+        REQUIRE_THROWS_AS(archive.draw_layers(num_layers, drawfn), std::runtime_error);
+    });
+    
+    REQUIRE(opened);
+    REQUIRE(! boost::filesystem::exists(path));
+}
+
 TEST_CASE("Triangle mesh conversions should be correct", "[SLAConversions]")
 {
     sla::Contour3D cntr;
@@ -0,0 +1,90 @@
+#include <catch2/catch.hpp>
+#include <test_utils.hpp>
+
+#include <libnest2d/optimizers/nlopt/genetic.hpp>
+#include <libslic3r/Model.hpp>
+#include <libslic3r/SLA/Rotfinder.hpp>
+
+using namespace Slic3r;
+
+static Transform3d rotation(double rx, double ry, double rz)
+{
+    Transform3d rt = Transform3d::Identity();
+    rt.rotate(Eigen::AngleAxisd(rz, Vec3d::UnitZ()));
+    rt.rotate(Eigen::AngleAxisd(ry, Vec3d::UnitY()));
+    rt.rotate(Eigen::AngleAxisd(rx, Vec3d::UnitX()));
+    return rt;
+}
+
+// The score of a rotation as calculated by find_best_rotation() before the
+// normal histogram was introduced, facet by facet.
+static double per_facet_score(const TriangleMesh &mesh, const Transform3d &rt)
+{
+    double score = 0;
+    for (const stl_facet &facet : mesh.stl.facet_start) {
+        Vec3d n = rt * facet.normal.cast<double>();
+        score += std::abs(n.dot(Vec3d::UnitX()));
+        score += std::abs(n.dot(Vec3d::UnitY()));
+        score += std::abs(n.dot(Vec3d::UnitZ()));
+    }
+    return score;
+}
+
+TEST_CASE("Normal histogram scores rotations as the per facet loop", "[SLARotfinder]")
+{
+    auto filename = GENERATE(as<std::string>{}, "20mm_cube.obj", "frog_legs.obj", "extruder_idler.obj");
+    TriangleMesh mesh = load_model(filename);
+    sla::NormalHistogram normals(mesh);
+
+    REQUIRE(normals.size() > 0);
+    REQUIRE(normals.size() <= mesh.stl.facet_start.size());
+    REQUIRE(normals.w.sum() == Approx(double(mesh.stl.facet_start.size())));
+
+    for (const Vec3d &angles : { Vec3d(0., 0., 0.), Vec3d(PI / 4., 0., 0.), Vec3d(0.1, -0.7, 1.3),
+                                 Vec3d(-PI / 2., PI / 3., -PI / 6.), Vec3d(1.5, 1.5, -1.5) }) {
+        Transform3d rt = rotation(angles.x(), angles.y(), angles.z());
+        REQUIRE(sla::rotated_normals_score(normals, rt.linear().cast<float>()) ==
+                Approx(per_facet_score(mesh, rt)).epsilon(1e-5));
+    }
+}
+
+TEST_CASE("Only the equal normals are merged by the histogram", "[SLARotfinder]")
+{
+    TriangleMesh cube = load_model("20mm_cube.obj");
+    // All the facets of a cube share one of its six face normals.
+    REQUIRE(sla::NormalHistogram(cube).size() == 6);
+}
+
+TEST_CASE("find_best_rotation finds the optimum of the per facet score", "[SLARotfinder]")
+{
+    using namespace libnest2d::opt;
+
+    TriangleMesh mesh = load_model("frog_legs.obj");
+    Model model;
+    ModelObject *object = model.add_object();
+    object->add_volume(mesh);
+    object->add_instance();
+
+    const float accuracy = 0.01f;
+    // The genetic optimizer is randomized, start both of the searches from the same seed.
+    const unsigned long seed = 1;
+
+    GeneticOptimizer().seed(seed);
+    std::array<double, 3> rot = sla::find_best_rotation(*object, accuracy);
+
+    // The search of find_best_rotation() before the normal histogram was introduced.
+    StopCriteria stc;
+    stc.max_iterations = unsigned(accuracy * 100000);
+    stc.relative_score_difference = 1e-3;
+    TOptimizer<Method::G_GENETIC> solver(stc);
+    solver.seed(seed);
+    auto b = bound(-PI / 2, PI / 2);
+    auto result = solver.optimize_max([&mesh](double rx, double ry, double rz) { return per_facet_score(mesh, rotation(rx, ry, rz)); },
+                                      initvals(0.0, 0.0, 0.0), b, b, b);
+
+    // Symmetric rotations score the same, compare the scores instead of the angles.
+    double score     = per_facet_score(mesh, rotation(rot[0], rot[1], rot[2]));
+    double ref_score = per_facet_score(mesh, rotation(std::get<0>(result.optimum), std::get<1>(result.optimum), std::get<2>(result.optimum)));
+    REQUIRE(score == Approx(ref_score).epsilon(1e-2));
+    REQUIRE(score >= per_facet_score(mesh, Transform3d::Identity()));
+}
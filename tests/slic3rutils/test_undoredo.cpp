@@ -0,0 +1,116 @@
+#include <catch2/catch.hpp>
+
+#include <type_traits>
+
+#include "libslic3r/Model.hpp"
+#include "libslic3r/TriangleMesh.hpp"
+#include "slic3r/GUI/GLCanvas3D.hpp"
+#include "slic3r/GUI/Selection.hpp"
+#include "slic3r/GUI/Gizmos/GLGizmosManager.hpp"
+#include "slic3r/Utils/UndoRedo.hpp"
+
+using namespace Slic3r;
+
+// The gizmos manager keeps a reference to its canvas, which is not accessed when taking or loading a snapshot.
+static GUI::GLCanvas3D& canvas_placeholder()
+{
+    static std::aligned_storage_t<sizeof(GUI::GLCanvas3D), alignof(GUI::GLCanvas3D)> storage;
+    return *reinterpret_cast<GUI::GLCanvas3D*>(&storage);
+}
+
+// Sphere of several MB serialized, with repair statistics, which are to survive Undo / Redo.
+static TriangleMesh repaired_sphere()
+{
+    TriangleMesh mesh = make_sphere(10., 2. * PI / 360.);
+    mesh.repair();
+    mesh.stl.stats.facets_reversed = 3;
+    mesh.stl.stats.edges_fixed     = 5;
+    return mesh;
+}
+
+static bool same_mesh(const TriangleMesh &lhs, const TriangleMesh &rhs)
+{
+    if (lhs.stl.facet_start.size() != rhs.stl.facet_start.size())
+        return false;
+    for (size_t i = 0; i < lhs.stl.facet_start.size(); ++ i)
+        for (size_t j = 0; j < 3; ++ j)
+            if (lhs.stl.facet_start[i].vertex[j] != rhs.stl.facet_start[i].vertex[j])
+                return false;
+    return lhs.stl.stats.facets_reversed == rhs.stl.stats.facets_reversed && lhs.stl.stats.edges_fixed == rhs.stl.stats.edges_fixed &&
+        lhs.stl.stats.number_of_parts == rhs.stl.stats.number_of_parts && lhs.stl.stats.volume == rhs.stl.stats.volume &&
+        lhs.repaired == rhs.repaired && lhs.its.vertices.size() == rhs.its.vertices.size() && lhs.its.indices.size() == rhs.its.indices.size();
+}
+
+SCENARIO("Undo / Redo stack compresses the meshes referenced by the stack only", "[UndoRedo]") {
+    GIVEN("Two objects of the same mesh content, deleted from the scene") {
+        TriangleMesh sphere = repaired_sphere();
+        sphere.require_shared_vertices();
+        // More than a single chunk of the serialized data.
+        REQUIRE(sphere.stl.facet_start.size() * SIZEOF_STL_FACET > 2 * 1024 * 1024);
+
+        Model model;
+        for (size_t i = 0; i < 2; ++ i) {
+            ModelObject *object = model.add_object();
+            object->add_volume(sphere);
+            object->add_instance();
+        }
+        // Two distinct meshes of the same content.
+        REQUIRE(&model.objects.front()->volumes.front()->mesh() != &model.objects.back()->volumes.front()->mesh());
+
+        UndoRedo::Stack          stack;
+        GUI::Selection           selection;
+        GUI::GLGizmosManager     gizmos(canvas_placeholder());
+        UndoRedo::SnapshotData   snapshot_data;
+        stack.take_snapshot("Two spheres", model, selection, gizmos, snapshot_data);
+        const size_t time_two_spheres = stack.snapshots().front().timestamp;
+        model.clear_objects();
+        stack.take_snapshot("Deleted", model, selection, gizmos, snapshot_data);
+        REQUIRE(stack.snapshots().size() == 3);
+
+        auto check_undo = [&]() {
+            REQUIRE(stack.undo(model, selection, gizmos, snapshot_data, time_two_spheres));
+            REQUIRE(model.objects.size() == 2);
+            for (const ModelObject *object : model.objects) {
+                REQUIRE(object->volumes.size() == 1);
+                REQUIRE(same_mesh(object->volumes.front()->mesh(), sphere));
+            }
+        };
+
+        WHEN("The stack exceeds its memory limit") {
+            // Releases the optional data (convex hulls, shared vertices), starts compressing the meshes in the background.
+            stack.set_memory_limit(1);
+            stack.release_least_recently_used();
+            THEN("No snapshot is released before the compression finishes") {
+                REQUIRE(stack.snapshots().size() == 3);
+            }
+            size_t memsize_uncompressed = stack.memsize();
+            REQUIRE(memsize_uncompressed > 2 * sphere.stl.facet_start.size() * SIZEOF_STL_FACET);
+            // Waits for the compression started above.
+            stack.set_memory_limit(memsize_uncompressed * 3 / 4);
+            stack.release_least_recently_used();
+            THEN("The meshes are compressed and their chunks are shared") {
+                REQUIRE(stack.snapshots().size() == 3);
+                REQUIRE(stack.memsize() < memsize_uncompressed * 55 / 100);
+            }
+            THEN("Undo restores the meshes with their repair statistics") {
+                check_undo();
+            }
+            THEN("The restored meshes are not stored again by the next snapshot") {
+                check_undo();
+                model.clear_objects();
+                stack.take_snapshot("Deleted again", model, selection, gizmos, snapshot_data);
+                // Both meshes are referenced by the stack only, each of them by a single history.
+                // A second history of the same mesh would share it, and the mesh would not be accounted for.
+                REQUIRE(stack.memsize() > 2 * sphere.stl.facet_start.size() * SIZEOF_STL_FACET);
+                check_undo();
+            }
+        }
+        WHEN("Undo is called while the meshes are being compressed") {
+            stack.set_memory_limit(1);
+            stack.release_least_recently_used();
+            THEN("Undo waits for the compression and restores the meshes") {
+                check_undo();
+            }
+        }
+    }
+}